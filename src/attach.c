@@ -296,6 +296,9 @@ static void detachFunc(
     goto detach_error;
   }
 
+#ifndef SQLITE_OMIT_WAL
+  sqlite3WalBackground(db, i, 0);
+#endif
   sqlite3BtreeClose(pDb->pBt);
   pDb->pBt = 0;
   pDb->pSchema = 0;
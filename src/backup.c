@@ -38,6 +38,15 @@ struct sqlite3_backup {
 
   int isAttached;          /* True once backup has been registered with pager */
   sqlite3_backup *pNext;   /* Next backup associated with source pager */
+
+#ifdef SQLITE_HAS_CODEC
+  /* These are used when the destination is encrypted and its page size
+  ** differs from the source page size. See backupTranscodeBegin().
+  */
+  int bTranscode;          /* True if pages are written to pDest directly */
+  u8 *aTranscode;          /* Buffer for a page encrypted for pDest */
+  int nTranscode;          /* Size of buffer aTranscode in bytes */
+#endif
 };
 
 /*
@@ -226,6 +235,387 @@ static int isFatalError(int rc){
   return (rc!=SQLITE_OK && rc!=SQLITE_BUSY && ALWAYS(rc!=SQLITE_LOCKED));
 }
 
+#ifdef SQLITE_HAS_CODEC
+/*
+** A page of an encrypted database can only be encrypted as a whole, so
+** a backup into an encrypted destination cannot split or merge pages the
+** way backupOnePage() does when the page sizes differ. Instead, the
+** destination takes on the page size and reserve of the source: each
+** source page is encrypted by the codec of the destination with the
+** geometry of the source, and written directly to the destination file.
+**
+** Before the first page is written, this function journals the entire
+** content of the destination database and syncs the journal, so that
+** the original database can be restored if the backup fails. The
+** destination transaction is then committed by backupTranscodeEnd().
+*/
+static int backupTranscodeBegin(sqlite3_backup *p){
+  Pager * const pDestPager = sqlite3BtreePager(p->pDest);
+  int nDstPage;
+  Pgno iPg;
+  int rc = SQLITE_OK;
+
+  assert( p->bDestLocked && p->bTranscode==0 );
+  sqlite3PagerPagecount(pDestPager, &nDstPage);
+  for(iPg=1; rc==SQLITE_OK && iPg<=(Pgno)nDstPage; iPg++){
+    if( iPg!=PENDING_BYTE_PAGE(p->pDest->pBt) ){
+      DbPage *pPg;
+      rc = sqlite3PagerGet(pDestPager, iPg, &pPg, 0);
+      if( rc==SQLITE_OK ){
+        rc = sqlite3PagerWrite(pPg);
+        sqlite3PagerUnref(pPg);
+      }
+    }
+  }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3PagerCommitPhaseOne(pDestPager, 0, 1);
+  }
+  if( rc==SQLITE_OK ){
+    p->bTranscode = 1;
+  }
+  return rc;
+}
+
+/*
+** Encrypt page iSrcPg of the source database with the codec of the
+** destination and write it to the destination file. The page size and
+** reserve of the source are used for both. zSrcData is the content of
+** the page, or NULL to read the page from the source pager.
+*/
+static int backupTranscodePage(
+  sqlite3_backup *p,              /* Backup handle */
+  Pgno iSrcPg,                    /* Source database page to write */
+  const u8 *zSrcData              /* Source database page data, or NULL */
+){
+  Pager * const pDestPager = sqlite3BtreePager(p->pDest);
+  const int nSrcPgsz = sqlite3BtreeGetPageSize(p->pSrc);
+  const int nSrcReserve = sqlite3BtreeGetReserveNoMutex(p->pSrc);
+  DbPage *pSrcPg = 0;
+  int rc = SQLITE_OK;
+
+  if( p->nTranscode<nSrcPgsz ){
+    u8 *aNew = (u8*)sqlite3_realloc(p->aTranscode, nSrcPgsz);
+    if( aNew==0 ) return SQLITE_NOMEM_BKPT;
+    p->aTranscode = aNew;
+    p->nTranscode = nSrcPgsz;
+  }
+  if( zSrcData==0 ){
+    rc = sqlite3PagerGet(sqlite3BtreePager(p->pSrc), iSrcPg, &pSrcPg,
+                         PAGER_GET_READONLY);
+    if( rc==SQLITE_OK ) zSrcData = sqlite3PagerGetData(pSrcPg);
+  }
+  if( rc==SQLITE_OK ){
+    memcpy(p->aTranscode, zSrcData, nSrcPgsz);
+    if( iSrcPg==1 ){
+      /* Take over the change counter of the destination, which was
+      ** incremented when the transaction was committed to the journal,
+      ** so that other connections do not reuse their cached pages. */
+      const u8 *aDest1 = p->pDest->pBt->pPage1->aData;
+      memcpy(&p->aTranscode[24], &aDest1[24], 4);
+      memcpy(&p->aTranscode[92], &aDest1[24], 4);
+      sqlite3Put4byte(&p->aTranscode[28], sqlite3BtreeLastPage(p->pSrc));
+      sqlite3Put4byte(&p->aTranscode[40], p->iDestSchema+1);
+    }
+    sqlite3PagerCodecSize(pDestPager, nSrcPgsz, nSrcReserve);
+    rc = sqlite3PagerCodecPage(pDestPager, p->aTranscode, iSrcPg, 1);
+    sqlite3PagerCodecSize(pDestPager, 0, 0);
+  }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3OsWrite(sqlite3PagerFile(pDestPager), p->aTranscode,
+                        nSrcPgsz, (i64)(iSrcPg-1)*nSrcPgsz);
+  }
+  sqlite3PagerUnref(pSrcPg);
+  return rc;
+}
+
+/*
+** Pages are transcoded in runs of contiguous pages. Each of the threads
+** transcodes up to SQLITE_BACKUP_BATCH_PAGES pages of a run.
+*/
+#ifndef SQLITE_BACKUP_BATCH_PAGES
+# define SQLITE_BACKUP_BATCH_PAGES 64
+#endif
+
+/*
+** A VFS need not handle more than 128KiB per read or write, so runs are
+** read and written in chunks of BACKUP_IO_SIZE bytes, which is a multiple
+** of any page size.
+*/
+#define BACKUP_IO_SIZE 65536
+
+/*
+** The part of a run of pages transcoded by a single thread.
+*/
+typedef struct BackupTask BackupTask;
+struct BackupTask {
+  sqlite3_backup *p;       /* Backup handle */
+  u8 *aData;               /* Image of the first page */
+  Pgno iFirst;             /* Page number of the first page */
+  int nPg;                 /* Number of pages */
+  int szPage;              /* Page size */
+  int bDecode;             /* True to decrypt the pages for the source first */
+};
+
+/*
+** A run of contiguous source pages. The pages are read by the thread that
+** runs the backup, transcoded by the threads of the tasks and written to
+** the destination file sequentially.
+*/
+typedef struct BackupRun BackupRun;
+struct BackupRun {
+  Pgno iFirst;             /* Page number of the first page */
+  int nPg;                 /* Number of pages, 0 if the run is empty */
+  int bDecode;             /* True if the pages are still encrypted */
+  u8 *aBuf;                /* Page images */
+  int nTask;               /* Number of entries in aTask[] in use */
+  BackupTask aTask[SQLITE_MAX_WORKER_THREADS+1];
+#if SQLITE_MAX_WORKER_THREADS>0
+  SQLiteThread *apThread[SQLITE_MAX_WORKER_THREADS+1];
+#endif
+};
+
+/*
+** Thread routine: decrypt the pages of a BackupTask with the codec of the
+** source, if they are still encrypted, and encrypt them in place with the
+** codec of the destination.
+*/
+static void *backupTranscodeTask(void *pCtx){
+  BackupTask *pTask = (BackupTask*)pCtx;
+  Pager * const pSrcPager = sqlite3BtreePager(pTask->p->pSrc);
+  Pager * const pDestPager = sqlite3BtreePager(pTask->p->pDest);
+  int rc = SQLITE_OK;
+  int i;
+  for(i=0; rc==SQLITE_OK && i<pTask->nPg; i++){
+    u8 *aPg = &pTask->aData[i*(i64)pTask->szPage];
+    if( pTask->bDecode ){
+      rc = sqlite3PagerCodecPage(pSrcPager, aPg, pTask->iFirst+i, 0);
+    }
+    if( rc==SQLITE_OK ){
+      rc = sqlite3PagerCodecPage(pDestPager, aPg, pTask->iFirst+i, 1);
+    }
+  }
+  return SQLITE_INT_TO_PTR(rc);
+}
+
+/*
+** Read (bWrite==0) or write (bWrite!=0) nByte bytes at offset iOff of file
+** pFd in chunks of at most BACKUP_IO_SIZE bytes.
+*/
+static int backupRunIo(
+  sqlite3_file *pFd,              /* File to read or write */
+  u8 *aBuf,                       /* Buffer */
+  i64 nByte,                      /* Number of bytes */
+  i64 iOff,                       /* Offset in the file */
+  int bWrite                      /* True to write, false to read */
+){
+  int rc = SQLITE_OK;
+  while( rc==SQLITE_OK && nByte>0 ){
+    int n = (int)MIN(nByte, BACKUP_IO_SIZE);
+    if( bWrite ){
+      rc = sqlite3OsWrite(pFd, aBuf, n, iOff);
+    }else{
+      rc = sqlite3OsRead(pFd, aBuf, n, iOff);
+    }
+    aBuf += n;
+    iOff += n;
+    nByte -= n;
+  }
+  return rc;
+}
+
+/*
+** Read the next run of at most nMax pages, up to page iLast, into pRun
+** and advance p->iNext past it. Page 1, which is written by
+** backupTranscodeEnd(), and the pending-byte page are skipped.
+**
+** If bRaw is true, the run is read from the source file sequentially and
+** is left encrypted. Otherwise, or if the file is too short,
+** each page is read through the source pager.
+*/
+static int backupReadRun(
+  sqlite3_backup *p,              /* Backup handle */
+  BackupRun *pRun,                /* Run to fill */
+  Pgno iLast,                     /* Last page to read */
+  int nMax,                       /* Maximum number of pages in the run */
+  int bRaw                        /* True to read from the file directly */
+){
+  Pager * const pSrcPager = sqlite3BtreePager(p->pSrc);
+  const Pgno iPending = PENDING_BYTE_PAGE(p->pSrc->pBt);
+  const int szPage = sqlite3BtreeGetPageSize(p->pSrc);
+  int rc = SQLITE_OK;
+  int i;
+
+  while( p->iNext<=iLast && (p->iNext==1 || p->iNext==iPending) ){
+    p->iNext++;
+  }
+  pRun->iFirst = p->iNext;
+  pRun->nPg = 0;
+  while( p->iNext<=iLast && p->iNext!=iPending && pRun->nPg<nMax ){
+    pRun->nPg++;
+    p->iNext++;
+  }
+  if( pRun->nPg==0 ) return SQLITE_OK;
+
+  pRun->bDecode = 0;
+  if( bRaw ){
+    rc = backupRunIo(sqlite3PagerFile(pSrcPager), pRun->aBuf,
+                     (i64)pRun->nPg*szPage, (i64)(pRun->iFirst-1)*szPage, 0);
+    if( rc==SQLITE_OK ){
+      pRun->bDecode = 1;
+      return SQLITE_OK;
+    }
+    if( rc!=SQLITE_IOERR_SHORT_READ ) return rc;
+    rc = SQLITE_OK;
+  }
+  for(i=0; rc==SQLITE_OK && i<pRun->nPg; i++){
+    DbPage *pPg;
+    rc = sqlite3PagerGet(pSrcPager, pRun->iFirst+i, &pPg, PAGER_GET_READONLY);
+    if( rc==SQLITE_OK ){
+      memcpy(&pRun->aBuf[i*(i64)szPage], sqlite3PagerGetData(pPg), szPage);
+      sqlite3PagerUnref(pPg);
+    }
+  }
+  return rc;
+}
+
+/*
+** Split run pRun into tasks for nThread threads and start them. With a
+** single thread, or if a thread cannot be started, the task is run by
+** backupRunJoin() instead.
+*/
+static void backupRunStart(sqlite3_backup *p, BackupRun *pRun, int nThread){
+  const int szPage = sqlite3BtreeGetPageSize(p->pSrc);
+  const int nPer = (pRun->nPg + nThread - 1)/nThread;
+  int i;
+  for(i=0; i*nPer<pRun->nPg; i++){
+    BackupTask *pTask = &pRun->aTask[i];
+    pTask->p = p;
+    pTask->aData = &pRun->aBuf[i*(i64)nPer*szPage];
+    pTask->iFirst = pRun->iFirst + i*nPer;
+    pTask->nPg = MIN(nPer, pRun->nPg - i*nPer);
+    pTask->szPage = szPage;
+    pTask->bDecode = pRun->bDecode;
+#if SQLITE_MAX_WORKER_THREADS>0
+    pRun->apThread[i] = 0;
+    if( nThread>1
+     && sqlite3ThreadCreate(&pRun->apThread[i], backupTranscodeTask, pTask)
+    ){
+      pRun->apThread[i] = 0;
+    }
+#endif
+  }
+  pRun->nTask = i;
+}
+
+/*
+** Wait for the tasks of run pRun to finish and return the first error.
+*/
+static int backupRunJoin(BackupRun *pRun){
+  int rc = SQLITE_OK;
+  int i;
+  for(i=0; i<pRun->nTask; i++){
+    int rc2;
+#if SQLITE_MAX_WORKER_THREADS>0
+    if( pRun->apThread[i] ){
+      void *pOut = 0;
+      rc2 = sqlite3ThreadJoin(pRun->apThread[i], &pOut);
+      if( rc2==SQLITE_OK ) rc2 = SQLITE_PTR_TO_INT(pOut);
+    }else
+#endif
+    {
+      rc2 = SQLITE_PTR_TO_INT(backupTranscodeTask(&pRun->aTask[i]));
+    }
+    if( rc==SQLITE_OK ) rc = rc2;
+  }
+  pRun->nTask = 0;
+  return rc;
+}
+
+/*
+** Transcode nPage source pages (all remaining pages if nPage is negative)
+** starting with p->iNext, for a backup written by backupTranscodePage().
+**
+** The pages are processed as a pipeline of runs. While the threads
+** configured for the destination with "PRAGMA codec_threads" transcode
+** one run, the calling thread writes the previous run to the destination
+** file and reads the next one from the source, using large sequential
+** reads and writes. Unless the source is in
+** WAL mode or has uncommitted changes, runs are read from the source
+** file directly and decrypted by the threads too.
+*/
+static int backupTranscodeRuns(sqlite3_backup *p, int nPage, int nSrcPage){
+  Pager * const pSrcPager = sqlite3BtreePager(p->pSrc);
+  Pager * const pDestPager = sqlite3BtreePager(p->pDest);
+  sqlite3_file * const pDestFile = sqlite3PagerFile(pDestPager);
+  const int szPage = sqlite3BtreeGetPageSize(p->pSrc);
+  const int nReserve = sqlite3BtreeGetReserveNoMutex(p->pSrc);
+  int nThread = sqlite3PagerCodecThreads(pDestPager, 0);
+  int nMax;
+  Pgno iLast;
+  int bRaw;
+  BackupRun *aRun;
+  BackupRun *pRead, *pWork, *pWrite;
+  int rc = SQLITE_OK;
+  int i;
+
+  if( sqlite3GlobalConfig.bCoreMutex==0 ) nThread = 1;
+  nMax = nThread*SQLITE_BACKUP_BATCH_PAGES;
+  if( nPage<0 || (i64)p->iNext+nPage-1>nSrcPage ){
+    iLast = (Pgno)nSrcPage;
+  }else{
+    iLast = p->iNext+nPage-1;
+  }
+  bRaw = p->pSrc->pBt->inTransaction!=TRANS_WRITE
+      && !sqlite3PagerIsMemdb(pSrcPager)
+      && sqlite3PagerFile(pSrcPager)->pMethods!=0
+      && sqlite3PagerGetJournalMode(pSrcPager)!=PAGER_JOURNALMODE_WAL;
+
+  aRun = (BackupRun*)sqlite3MallocZero(3*sizeof(BackupRun));
+  if( aRun ) aRun[0].aBuf = (u8*)sqlite3Malloc(3*(i64)nMax*szPage);
+  if( aRun==0 || aRun[0].aBuf==0 ){
+    sqlite3_free(aRun);
+    return SQLITE_NOMEM_BKPT;
+  }
+  for(i=1; i<3; i++){
+    aRun[i].aBuf = &aRun[0].aBuf[i*(i64)nMax*szPage];
+  }
+  pWork = &aRun[0];
+  pRead = &aRun[1];
+  pWrite = 0;
+
+  sqlite3PagerCodecSize(pDestPager, szPage, nReserve);
+  rc = backupReadRun(p, pWork, iLast, nMax, bRaw);
+  while( rc==SQLITE_OK && pWork->nPg>0 ){
+    BackupRun *pNext;
+    int rc2;
+    backupRunStart(p, pWork, nThread);
+    if( pWrite ){
+      rc = backupRunIo(pDestFile, pWrite->aBuf, (i64)pWrite->nPg*szPage,
+                       (i64)(pWrite->iFirst-1)*szPage, 1);
+    }
+    pNext = pWrite ? pWrite : &aRun[2];
+    if( rc==SQLITE_OK ){
+      rc = backupReadRun(p, pRead, iLast, nMax, bRaw);
+    }
+    if( rc!=SQLITE_OK ) pRead->nPg = 0;
+    rc2 = backupRunJoin(pWork);
+    if( rc==SQLITE_OK ) rc = rc2;
+    pWrite = pWork;
+    pWork = pRead;
+    pRead = pNext;
+  }
+  if( rc==SQLITE_OK && pWrite ){
+    rc = backupRunIo(pDestFile, pWrite->aBuf, (i64)pWrite->nPg*szPage,
+                     (i64)(pWrite->iFirst-1)*szPage, 1);
+  }
+  sqlite3PagerCodecSize(pDestPager, 0, 0);
+
+  sqlite3_free(aRun[0].aBuf);
+  sqlite3_free(aRun);
+  return rc;
+}
+#endif /* SQLITE_HAS_CODEC */
+
 /*
 ** Parameter zSrcData points to a buffer containing the data for 
 ** page iSrcPg from the source database. Copy this data into the 
@@ -258,6 +648,13 @@ static int backupOnePage(
   assert( iSrcPg!=PENDING_BYTE_PAGE(p->pSrc->pBt) );
   assert( zSrcData );
 
+#ifdef SQLITE_HAS_CODEC
+  /* Page 1 of a transcoded backup is written by backupTranscodeEnd() */
+  if( p->bTranscode ){
+    return iSrcPg==1 ? SQLITE_OK : backupTranscodePage(p, iSrcPg, zSrcData);
+  }
+#endif
+
   /* Catch the case where the destination is an in-memory database and the
   ** page sizes of the source and destination differ. 
   */
@@ -266,13 +663,6 @@ static int backupOnePage(
   }
 
 #ifdef SQLITE_HAS_CODEC
-  /* Backup is not possible if the page size of the destination is changing
-  ** and a codec is in use.
-  */
-  if( nSrcPgsz!=nDestPgsz && sqlite3PagerGetCodec(pDestPager)!=0 ){
-    rc = SQLITE_READONLY;
-  }
-
   /* Backup is not possible if the number of bytes of reserve space differ
   ** between source and destination.  If there is a difference, try to
   ** fix the destination to agree with the source.  If that is not possible,
@@ -336,6 +726,47 @@ static int backupTruncateFile(sqlite3_file *pFile, i64 iSize){
   return rc;
 }
 
+#ifdef SQLITE_HAS_CODEC
+/*
+** Finish a backup written by backupTranscodePage(). Page 1 is written
+** last, as it carries the page count and the new schema cookie. The
+** destination file is truncated and synced and the transaction opened
+** by backupTranscodeBegin() is committed. Finally the destination b-tree
+** is switched to the geometry of the source, so that the codec decodes
+** the new pages with the right page size.
+*/
+static int backupTranscodeEnd(sqlite3_backup *p, int nSrcPage){
+  Pager * const pDestPager = sqlite3BtreePager(p->pDest);
+  const int nSrcPgsz = sqlite3BtreeGetPageSize(p->pSrc);
+  const int nSrcReserve = sqlite3BtreeGetReserveNoMutex(p->pSrc);
+  int rc;
+
+  assert( p->bTranscode && nSrcPage>0 );
+  rc = backupTranscodePage(p, 1, 0);
+  if( rc==SQLITE_OK ){
+    rc = backupTruncateFile(sqlite3PagerFile(pDestPager),
+                            (i64)nSrcPage*(i64)nSrcPgsz);
+  }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3PagerSync(pDestPager, 0);
+  }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3BtreeCommitPhaseTwo(p->pDest, 0);
+  }
+  if( rc==SQLITE_OK ){
+#ifndef SQLITE_OMIT_VACUUM
+    sqlite3PagerClearCache(pDestPager);
+#endif
+    p->pDest->pBt->btsFlags &= ~BTS_PAGESIZE_FIXED;
+    rc = sqlite3BtreeSetPageSize(p->pDest, nSrcPgsz, nSrcReserve, 0);
+  }
+  if( rc==SQLITE_OK && p->pDestDb ){
+    sqlite3ResetAllSchemasOfConnection(p->pDestDb);
+  }
+  return rc;
+}
+#endif
+
 /*
 ** Register this backup object with the associated source pager for
 ** callbacks when pages are changed or the cache invalidated.
@@ -415,6 +846,27 @@ int sqlite3_backup_step(sqlite3_backup *p, int nPage){
     */
     nSrcPage = (int)sqlite3BtreeLastPage(p->pSrc);
     assert( nSrcPage>=0 );
+
+#ifdef SQLITE_HAS_CODEC
+    /* If the destination is encrypted and the page sizes differ, the
+    ** source pages are encrypted for the destination and written directly
+    ** to the destination file. The same is done to transcode the pages
+    ** of an encrypted source or destination in parallel, if more than one
+    ** thread is configured for the destination with codec_threads. */
+    if( rc==SQLITE_OK && p->bTranscode==0 && nSrcPage>0
+     && !sqlite3PagerIsMemdb(pDestPager)
+     && ((pgszSrc!=pgszDest && sqlite3PagerGetCodec(pDestPager)!=0)
+      || (sqlite3PagerCodecThreads(pDestPager, 0)>1
+       && destMode!=PAGER_JOURNALMODE_WAL
+       && (sqlite3PagerGetCodec(pDestPager)!=0
+        || sqlite3PagerGetCodec(pSrcPager)!=0)))
+    ){
+      rc = backupTranscodeBegin(p);
+    }
+    if( rc==SQLITE_OK && p->bTranscode ){
+      rc = backupTranscodeRuns(p, nPage, nSrcPage);
+    }else
+#endif
     for(ii=0; (nPage<0 || ii<nPage) && p->iNext<=(Pgno)nSrcPage && !rc; ii++){
       const Pgno iSrcPg = p->iNext;                 /* Source page number */
       if( iSrcPg!=PENDING_BYTE_PAGE(p->pSrc->pBt) ){
@@ -442,6 +894,12 @@ int sqlite3_backup_step(sqlite3_backup *p, int nPage){
     ** the case where the source and destination databases have the
     ** same schema version.
     */
+#ifdef SQLITE_HAS_CODEC
+    if( rc==SQLITE_DONE && p->bTranscode ){
+      rc = backupTranscodeEnd(p, nSrcPage);
+      if( rc==SQLITE_OK ) rc = SQLITE_DONE;
+    }else
+#endif
     if( rc==SQLITE_DONE ){
       if( nSrcPage==0 ){
         rc = sqlite3BtreeNewDb(p->pDest);
@@ -624,6 +1082,9 @@ int sqlite3_backup_finish(sqlite3_backup *p){
 
   /* If a transaction is still open on the Btree, roll it back. */
   sqlite3BtreeRollback(p->pDest, SQLITE_OK, 0);
+#ifdef SQLITE_HAS_CODEC
+  sqlite3_free(p->aTranscode);
+#endif
 
   /* Set the error code of the destination database handle. */
   rc = (p->rc==SQLITE_DONE) ? SQLITE_OK : p->rc;
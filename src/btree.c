@@ -2291,6 +2291,7 @@ int sqlite3BtreeOpen(
 #ifdef SQLITE_SECURE_DELETE
     pBt->btsFlags |= BTS_SECURE_DELETE;
 #endif
+    pBt->nBulkFill = SQLITE_DEFAULT_BULK_FILL;
     /* EVIDENCE-OF: R-51873-39618 The page size for a database file is
     ** determined by the 2-byte integer located at an offset of 16 bytes from
     ** the beginning of the database file. */
@@ -2746,6 +2747,23 @@ int sqlite3BtreeSecureDelete(Btree *p, int newFlag){
   return b;
 }
 
+/*
+** Set the percentage of each page that is filled when a b-tree is built
+** from sorted input to nFill, if nFill is between 10 and 100. Any other
+** value makes no changes. Return the setting after the change.
+*/
+int sqlite3BtreeBulkFill(Btree *p, int nFill){
+  int n;
+  if( p==0 ) return 0;
+  sqlite3BtreeEnter(p);
+  if( nFill>=10 && nFill<=100 ){
+    p->pBt->nBulkFill = (u8)nFill;
+  }
+  n = p->pBt->nBulkFill;
+  sqlite3BtreeLeave(p);
+  return n;
+}
+
 /*
 ** Change the 'auto-vacuum' property of the database. If the 'autoVacuum'
 ** parameter is non-zero, then auto-vacuum mode is enabled. If zero, it
@@ -7924,6 +7942,203 @@ static int balance(BtCursor *pCur){
 }
 
 
+/*
+** Return true if a bulk-loaded cell of sz bytes should be appended to
+** pPage rather than starting a new page at the same level. Pages are
+** packed up to BtShared.nBulkFill percent of the usable space, but a
+** page always accepts a second cell if it has room for one, since the
+** promotion in btreeBulkSplit() needs at least two cells to work with.
+*/
+static int btreeBulkFits(MemPage *pPage, int sz){
+  BtShared *pBt = pPage->pBt;
+  int nUsed;
+  if( sz+2>pPage->nFree ) return 0;
+  if( pPage->nCell<2 ) return 1;
+  nUsed = pBt->usableSize - pPage->nFree + sz + 2;
+  return nUsed*100 <= (int)pBt->usableSize*pBt->nBulkFill;
+}
+
+/*
+** Return true if cursor pCur is positioned on the right-most path of
+** its b-tree, so that a new entry sorting after the current one would
+** be appended to the last leaf of the tree.
+*/
+static int btreeCursorAtEnd(BtCursor *pCur){
+  int i;
+  for(i=0; i<pCur->iPage; i++){
+    if( pCur->aiIdx[i]!=pCur->apPage[i]->nCell ) return 0;
+  }
+  return 1;
+}
+
+/*
+** The root page of the tree that pCur is building bottom-up is full.
+** Move its content to a newly allocated page and make the root an
+** interior page with no cells whose right-child is the new page. The
+** cursor stack is shifted down by one level to match.
+*/
+static int btreeBulkDeeper(BtCursor *pCur){
+  BtShared *pBt = pCur->pBt;
+  MemPage *pRoot = pCur->apPage[0];
+  MemPage *pChild = 0;
+  Pgno pgnoChild = 0;
+  int rc;
+
+  if( pCur->iPage>=(BTCURSOR_MAX_DEPTH-1) ){
+    return SQLITE_CORRUPT_BKPT;
+  }
+  rc = sqlite3PagerWrite(pRoot->pDbPage);
+  if( rc==SQLITE_OK ){
+    rc = allocateBtreePage(pBt, &pChild, &pgnoChild, pRoot->pgno, 0);
+    copyNodeContent(pRoot, pChild, &rc);
+  }
+  if( rc ){
+    releasePage(pChild);
+    return rc;
+  }
+  TRACE(("BULKLOAD: copy root %d into %d\n", pRoot->pgno, pgnoChild));
+  zeroPage(pRoot, pChild->aData[0] & ~PTF_LEAF);
+  put4byte(&pRoot->aData[pRoot->hdrOffset+8], pgnoChild);
+
+  memmove(&pCur->apPage[2], &pCur->apPage[1],
+          pCur->iPage*sizeof(pCur->apPage[0]));
+  memmove(&pCur->aiIdx[2], &pCur->aiIdx[1],
+          pCur->iPage*sizeof(pCur->aiIdx[0]));
+  pCur->apPage[1] = pChild;
+  pCur->aiIdx[1] = pCur->aiIdx[0];
+  pCur->aiIdx[0] = 0;
+  pCur->iPage++;
+  return SQLITE_OK;
+}
+
+/*
+** The page iLevel levels above the leaf on the right-most path of the
+** tree that pCur is building is full. Close it off and start a new,
+** empty page at the same level:
+**
+**   *  The last cell of an index page, or of an interior page, is moved
+**      up into the parent, with the page itself as its left child. For
+**      an interior page, the child of that cell becomes the right-child.
+**
+**   *  A table leaf keeps all of its cells. A divider cell holding its
+**      largest rowid is added to the parent instead.
+**
+** If the parent is full too it is closed off first, recursively, so that
+** the tree grows upwards one page at a time and each page is written
+** exactly once. The new page becomes the right-child of the parent and
+** replaces the full page in the cursor stack.
+*/
+static int btreeBulkSplit(BtCursor *pCur, int iLevel){
+  BtShared *pBt = pCur->pBt;
+  MemPage *pPage;                 /* The full page */
+  MemPage *pParent;               /* Parent of pPage */
+  MemPage *pNew = 0;              /* New right-most page at this level */
+  Pgno pgnoNew = 0;               /* Page number of pNew */
+  Pgno pgnoChild = 0;             /* New right-child of interior pPage */
+  u8 *pCell;                      /* Cell to insert into pParent */
+  int szCell;                     /* Size of pCell in bytes */
+  int szDrop = 0;                 /* Size of cell dropped from pPage */
+  u8 aDivider[13];                /* Divider cell for a table leaf */
+  int rc;
+
+  if( pCur->iPage==iLevel ){
+    rc = btreeBulkDeeper(pCur);
+    if( rc ) return rc;
+  }
+  pPage = pCur->apPage[pCur->iPage-iLevel];
+  rc = sqlite3PagerWrite(pPage->pDbPage);
+  if( rc ) return rc;
+
+  if( pPage->intKeyLeaf ){
+    CellInfo info;
+    pPage->xParseCell(pPage, findCell(pPage, pPage->nCell-1), &info);
+    pCell = aDivider;
+    szCell = 4 + putVarint(&aDivider[4], info.nKey);
+  }else{
+    if( pPage->nCell<2 ) return SQLITE_CORRUPT_BKPT;
+    pCell = findCell(pPage, pPage->nCell-1);
+    szCell = szDrop = pPage->xCellSize(pPage, pCell);
+    if( pPage->leaf ){
+      pCell -= 4;
+      szCell += 4;
+    }else{
+      pgnoChild = get4byte(pCell);
+    }
+  }
+
+  pParent = pCur->apPage[pCur->iPage-iLevel-1];
+  if( !btreeBulkFits(pParent, szCell) ){
+    rc = btreeBulkSplit(pCur, iLevel+1);
+    if( rc ) return rc;
+    pParent = pCur->apPage[pCur->iPage-iLevel-1];
+  }
+  insertCell(pParent, pParent->nCell, pCell, szCell, 0, pPage->pgno, &rc);
+  if( szDrop ){
+    dropCell(pPage, pPage->nCell-1, szDrop, &rc);
+    if( pgnoChild ){
+      put4byte(&pPage->aData[pPage->hdrOffset+8], pgnoChild);
+    }
+  }
+  if( rc==SQLITE_OK ){
+    rc = allocateBtreePage(pBt, &pNew, &pgnoNew, pPage->pgno, 0);
+  }
+  if( rc ) return rc;
+  TRACE(("BULKLOAD: page %d full, continue on %d\n", pPage->pgno, pgnoNew));
+  zeroPage(pNew, pPage->aData[pPage->hdrOffset]);
+  put4byte(&pParent->aData[pParent->hdrOffset+8], pgnoNew);
+
+  pCur->aiIdx[pCur->iPage-iLevel-1] = pParent->nCell;
+  pCur->apPage[pCur->iPage-iLevel] = pNew;
+  pCur->aiIdx[pCur->iPage-iLevel] = 0;
+  releasePage(pPage);
+  return SQLITE_OK;
+}
+
+/*
+** Append cell pCell, which sorts after every entry already in the tree,
+** to the b-tree that cursor pCur points into. The cursor must be on the
+** right-most path of the tree (see btreeCursorAtEnd()).
+**
+** This is used instead of insertCell() and balance() by cursors with the
+** BTREE_BULKLOAD hint, such as those used by CREATE INDEX and VACUUM.
+** Instead of splitting and redistributing pages, which reads and writes
+** every leaf page two or three times, the tree is built bottom-up: each
+** leaf is filled to the BtShared.nBulkFill percentage, then closed off
+** by btreeBulkSplit(), and interior pages are filled the same way as
+** the leaves that they point to are completed. The tree is consistent
+** after every call.
+**
+** The cursor is left pointing at the new entry.
+*/
+static int btreeBulkAppend(BtCursor *pCur, u8 *pCell, int szCell, i64 nKey){
+  MemPage *pPage = pCur->apPage[pCur->iPage];
+  int rc = SQLITE_OK;
+
+  if( !btreeBulkFits(pPage, szCell) ){
+    rc = btreeBulkSplit(pCur, 0);
+    if( rc ){
+      pCur->eState = CURSOR_INVALID;
+      return rc;
+    }
+    pPage = pCur->apPage[pCur->iPage];
+  }
+  insertCell(pPage, pPage->nCell, pCell, szCell, 0, 0, &rc);
+  if( rc ){
+    pCur->eState = CURSOR_INVALID;
+    return rc;
+  }
+  pCur->aiIdx[pCur->iPage] = pPage->nCell-1;
+  pCur->eState = CURSOR_VALID;
+  pCur->info.nSize = 0;
+  pCur->curFlags &= ~(BTCF_ValidNKey|BTCF_ValidOvfl);
+  pCur->curFlags |= BTCF_AtLast;
+  if( pPage->intKey ){
+    pCur->info.nKey = nKey;
+    pCur->curFlags |= BTCF_ValidNKey;
+  }
+  return SQLITE_OK;
+}
+
 /*
 ** Insert a new record into the BTree.  The key is given by (pKey,nKey)
 ** and the data is given by (pData,nData).  The cursor is used only to
@@ -8055,6 +8270,11 @@ int sqlite3BtreeInsert(
   }else{
     assert( pPage->leaf );
   }
+  if( (pCur->hints & BTREE_BULKLOAD)!=0 && loc!=0 && idx==pPage->nCell
+   && !ISAUTOVACUUM && btreeCursorAtEnd(pCur) ){
+    rc = btreeBulkAppend(pCur, newCell, szNew, nKey);
+    goto end_insert;
+  }
   insertCell(pPage, idx, newCell, szNew, 0, 0, &rc);
   assert( rc!=SQLITE_OK || pPage->nCell>0 || pPage->nOverflow>0 );
 
@@ -73,6 +73,7 @@ int sqlite3BtreeGetPageSize(Btree*);
 int sqlite3BtreeMaxPageCount(Btree*,int);
 u32 sqlite3BtreeLastPage(Btree*);
 int sqlite3BtreeSecureDelete(Btree*,int);
+int sqlite3BtreeBulkFill(Btree*,int);
 int sqlite3BtreeGetOptimalReserve(Btree*);
 int sqlite3BtreeGetReserveNoMutex(Btree *p);
 int sqlite3BtreeSetAutoVacuum(Btree *, int);
@@ -182,8 +183,10 @@ int sqlite3BtreeNewDb(Btree *p);
 ** Values that may be OR'd together to form the argument to the
 ** BTREE_HINT_FLAGS hint for sqlite3BtreeCursorHint():
 **
-** The BTREE_BULKLOAD flag is set on index cursors when the index is going
-** to be filled with content that is already in sorted order.
+** The BTREE_BULKLOAD flag is set on cursors when the b-tree is going to
+** be filled with content that is mostly or entirely in sorted order. New
+** entries that sort after all existing ones are then appended bottom-up,
+** filling each page to the PRAGMA bulk_fill_factor percentage.
 **
 ** The BTREE_SEEK_EQ flag is set on cursors that will get OP_SeekGE or
 ** OP_SeekLE opcodes for a range search, but where the range of entries
@@ -423,6 +423,7 @@ struct BtShared {
 #endif
   u8 inTransaction;     /* Transaction state */
   u8 max1bytePayload;   /* Maximum first byte of cell for a 1-byte payload */
+  u8 nBulkFill;         /* Percentage of each page filled by bulk loads */
 #ifdef SQLITE_HAS_CODEC
   u8 optimalReserve;    /* Desired amount of reserved space per page */
 #endif
@@ -0,0 +1,324 @@
+/*
+///////////////////////////////////////////////////////////////////////////////
+// Name:        chacha20poly1305.c
+// Purpose:     ChaCha20 stream cipher and Poly1305 authenticator (RFC 8439)
+// Licence:     wxWindows licence
+///////////////////////////////////////////////////////////////////////////////
+
+/// \file chacha20poly1305.c Implementation of the ChaCha20-Poly1305 primitives
+*/
+
+/*
+// Portable implementation, independent of the byte order of the platform.
+// The Poly1305 code follows the 32 bit variant of poly1305-donna
+// (public domain, Andrew Moon), using 26 bit limbs and 64 bit products.
+*/
+
+#include <string.h>
+
+#include "chacha20poly1305.h"
+
+#define CHACHA20_LOAD32(p) \
+  (((unsigned int)(p)[0]) | ((unsigned int)(p)[1] << 8) | \
+   ((unsigned int)(p)[2] << 16) | ((unsigned int)(p)[3] << 24))
+
+#define CHACHA20_STORE32(p, v) \
+  do { (p)[0] = (unsigned char)(v); (p)[1] = (unsigned char)((v) >> 8); \
+       (p)[2] = (unsigned char)((v) >> 16); (p)[3] = (unsigned char)((v) >> 24); } while (0)
+
+#define CHACHA20_ROTL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define CHACHA20_QUARTERROUND(a, b, c, d) \
+  a += b; d ^= a; d = CHACHA20_ROTL(d, 16); \
+  c += d; b ^= c; b = CHACHA20_ROTL(b, 12); \
+  a += b; d ^= a; d = CHACHA20_ROTL(d,  8); \
+  c += d; b ^= c; b = CHACHA20_ROTL(b,  7)
+
+static const unsigned char chacha20Sigma[16] = "expand 32-byte k";
+
+/*
+// Set up the initial state from the key (words 4..11) and the constants
+*/
+static void
+ChaCha20InitState(unsigned int state[16], const unsigned char key[CHACHA20_KEY_SIZE])
+{
+  int j;
+  for (j = 0; j < 4; j++)
+  {
+    state[j] = CHACHA20_LOAD32(chacha20Sigma + 4*j);
+  }
+  for (j = 0; j < 8; j++)
+  {
+    state[4+j] = CHACHA20_LOAD32(key + 4*j);
+  }
+}
+
+/*
+// Apply the 20 rounds of ChaCha20 to x
+*/
+static void
+ChaCha20Rounds(unsigned int x[16])
+{
+  int j;
+  for (j = 0; j < 10; j++)
+  {
+    CHACHA20_QUARTERROUND(x[0], x[4], x[ 8], x[12]);
+    CHACHA20_QUARTERROUND(x[1], x[5], x[ 9], x[13]);
+    CHACHA20_QUARTERROUND(x[2], x[6], x[10], x[14]);
+    CHACHA20_QUARTERROUND(x[3], x[7], x[11], x[15]);
+    CHACHA20_QUARTERROUND(x[0], x[5], x[10], x[15]);
+    CHACHA20_QUARTERROUND(x[1], x[6], x[11], x[12]);
+    CHACHA20_QUARTERROUND(x[2], x[7], x[ 8], x[13]);
+    CHACHA20_QUARTERROUND(x[3], x[4], x[ 9], x[14]);
+  }
+}
+
+static void
+ChaCha20Xor(unsigned char* data, int len,
+            const unsigned char key[CHACHA20_KEY_SIZE],
+            const unsigned char nonce[CHACHA20_NONCE_SIZE],
+            unsigned int counter)
+{
+  unsigned int state[16];
+  unsigned int x[16];
+  unsigned char block[64];
+  int j;
+  int n;
+
+  ChaCha20InitState(state, key);
+  state[12] = counter;
+  state[13] = CHACHA20_LOAD32(nonce + 0);
+  state[14] = CHACHA20_LOAD32(nonce + 4);
+  state[15] = CHACHA20_LOAD32(nonce + 8);
+
+  while (len > 0)
+  {
+    memcpy(x, state, sizeof(x));
+    ChaCha20Rounds(x);
+    for (j = 0; j < 16; j++)
+    {
+      unsigned int v = x[j] + state[j];
+      CHACHA20_STORE32(block + 4*j, v);
+    }
+    n = (len < 64) ? len : 64;
+    for (j = 0; j < n; j++)
+    {
+      data[j] ^= block[j];
+    }
+    data += n;
+    len -= n;
+    state[12]++;
+  }
+  memset(block, 0, sizeof(block));
+}
+
+static void
+HChaCha20(unsigned char out[CHACHA20_KEY_SIZE],
+          const unsigned char key[CHACHA20_KEY_SIZE],
+          const unsigned char nonce[HCHACHA20_NONCE_SIZE])
+{
+  unsigned int x[16];
+  int j;
+
+  ChaCha20InitState(x, key);
+  for (j = 0; j < 4; j++)
+  {
+    x[12+j] = CHACHA20_LOAD32(nonce + 4*j);
+  }
+  ChaCha20Rounds(x);
+  for (j = 0; j < 4; j++)
+  {
+    CHACHA20_STORE32(out + 4*j, x[j]);
+    CHACHA20_STORE32(out + 16 + 4*j, x[12+j]);
+  }
+}
+
+static void
+Poly1305Init(Poly1305Context* ctx, const unsigned char key[POLY1305_KEY_SIZE])
+{
+  /* r &= 0xffffffc0ffffffc0ffffffc0fffffff */
+  ctx->r[0] = (CHACHA20_LOAD32(key +  0)     ) & 0x3ffffff;
+  ctx->r[1] = (CHACHA20_LOAD32(key +  3) >> 2) & 0x3ffff03;
+  ctx->r[2] = (CHACHA20_LOAD32(key +  6) >> 4) & 0x3ffc0ff;
+  ctx->r[3] = (CHACHA20_LOAD32(key +  9) >> 6) & 0x3f03fff;
+  ctx->r[4] = (CHACHA20_LOAD32(key + 12) >> 8) & 0x00fffff;
+
+  ctx->h[0] = ctx->h[1] = ctx->h[2] = ctx->h[3] = ctx->h[4] = 0;
+
+  ctx->pad[0] = CHACHA20_LOAD32(key + 16);
+  ctx->pad[1] = CHACHA20_LOAD32(key + 20);
+  ctx->pad[2] = CHACHA20_LOAD32(key + 24);
+  ctx->pad[3] = CHACHA20_LOAD32(key + 28);
+
+  ctx->leftover = 0;
+}
+
+/*
+// Process full 16 byte blocks; hibit is 0 for the padded final block
+*/
+static void
+Poly1305Blocks(Poly1305Context* ctx, const unsigned char* m, int len, unsigned int hibit)
+{
+  const unsigned int r0 = ctx->r[0], r1 = ctx->r[1], r2 = ctx->r[2], r3 = ctx->r[3], r4 = ctx->r[4];
+  const unsigned int s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+  unsigned int h0 = ctx->h[0], h1 = ctx->h[1], h2 = ctx->h[2], h3 = ctx->h[3], h4 = ctx->h[4];
+  sqlite3_uint64 d0, d1, d2, d3, d4;
+  unsigned int c;
+
+  while (len >= 16)
+  {
+    /* h += m[i] */
+    h0 += (CHACHA20_LOAD32(m +  0)     ) & 0x3ffffff;
+    h1 += (CHACHA20_LOAD32(m +  3) >> 2) & 0x3ffffff;
+    h2 += (CHACHA20_LOAD32(m +  6) >> 4) & 0x3ffffff;
+    h3 += (CHACHA20_LOAD32(m +  9) >> 6) & 0x3ffffff;
+    h4 += (CHACHA20_LOAD32(m + 12) >> 8) | hibit;
+
+    /* h *= r */
+    d0 = ((sqlite3_uint64)h0 * r0) + ((sqlite3_uint64)h1 * s4) + ((sqlite3_uint64)h2 * s3) +
+         ((sqlite3_uint64)h3 * s2) + ((sqlite3_uint64)h4 * s1);
+    d1 = ((sqlite3_uint64)h0 * r1) + ((sqlite3_uint64)h1 * r0) + ((sqlite3_uint64)h2 * s4) +
+         ((sqlite3_uint64)h3 * s3) + ((sqlite3_uint64)h4 * s2);
+    d2 = ((sqlite3_uint64)h0 * r2) + ((sqlite3_uint64)h1 * r1) + ((sqlite3_uint64)h2 * r0) +
+         ((sqlite3_uint64)h3 * s4) + ((sqlite3_uint64)h4 * s3);
+    d3 = ((sqlite3_uint64)h0 * r3) + ((sqlite3_uint64)h1 * r2) + ((sqlite3_uint64)h2 * r1) +
+         ((sqlite3_uint64)h3 * r0) + ((sqlite3_uint64)h4 * s4);
+    d4 = ((sqlite3_uint64)h0 * r4) + ((sqlite3_uint64)h1 * r3) + ((sqlite3_uint64)h2 * r2) +
+         ((sqlite3_uint64)h3 * r1) + ((sqlite3_uint64)h4 * r0);
+
+    /* (partial) h %= p */
+                  c = (unsigned int)(d0 >> 26); h0 = (unsigned int)d0 & 0x3ffffff;
+    d1 += c;      c = (unsigned int)(d1 >> 26); h1 = (unsigned int)d1 & 0x3ffffff;
+    d2 += c;      c = (unsigned int)(d2 >> 26); h2 = (unsigned int)d2 & 0x3ffffff;
+    d3 += c;      c = (unsigned int)(d3 >> 26); h3 = (unsigned int)d3 & 0x3ffffff;
+    d4 += c;      c = (unsigned int)(d4 >> 26); h4 = (unsigned int)d4 & 0x3ffffff;
+    h0 += c * 5;  c = (h0 >> 26); h0 = h0 & 0x3ffffff;
+    h1 += c;
+
+    m += 16;
+    len -= 16;
+  }
+
+  ctx->h[0] = h0;
+  ctx->h[1] = h1;
+  ctx->h[2] = h2;
+  ctx->h[3] = h3;
+  ctx->h[4] = h4;
+}
+
+static void
+Poly1305Update(Poly1305Context* ctx, const unsigned char* data, int len)
+{
+  int j;
+  int n;
+
+  if (ctx->leftover > 0)
+  {
+    n = 16 - ctx->leftover;
+    if (n > len) n = len;
+    for (j = 0; j < n; j++)
+    {
+      ctx->buffer[ctx->leftover + j] = data[j];
+    }
+    len -= n;
+    data += n;
+    ctx->leftover += n;
+    if (ctx->leftover < 16) return;
+    Poly1305Blocks(ctx, ctx->buffer, 16, 1 << 24);
+    ctx->leftover = 0;
+  }
+
+  if (len >= 16)
+  {
+    n = len & ~15;
+    Poly1305Blocks(ctx, data, n, 1 << 24);
+    data += n;
+    len -= n;
+  }
+
+  for (j = 0; j < len; j++)
+  {
+    ctx->buffer[j] = data[j];
+  }
+  ctx->leftover = len;
+}
+
+static void
+Poly1305Final(Poly1305Context* ctx, unsigned char tag[POLY1305_TAG_SIZE])
+{
+  unsigned int h0, h1, h2, h3, h4, c;
+  unsigned int g0, g1, g2, g3, g4;
+  unsigned int mask;
+  sqlite3_uint64 f;
+
+  /* Process the remaining block */
+  if (ctx->leftover > 0)
+  {
+    int j = ctx->leftover;
+    ctx->buffer[j++] = 1;
+    for (; j < 16; j++)
+    {
+      ctx->buffer[j] = 0;
+    }
+    Poly1305Blocks(ctx, ctx->buffer, 16, 0);
+  }
+
+  /* Fully carry h */
+  h0 = ctx->h[0]; h1 = ctx->h[1]; h2 = ctx->h[2]; h3 = ctx->h[3]; h4 = ctx->h[4];
+
+               c = h1 >> 26; h1 = h1 & 0x3ffffff;
+  h2 +=     c; c = h2 >> 26; h2 = h2 & 0x3ffffff;
+  h3 +=     c; c = h3 >> 26; h3 = h3 & 0x3ffffff;
+  h4 +=     c; c = h4 >> 26; h4 = h4 & 0x3ffffff;
+  h0 += c * 5; c = h0 >> 26; h0 = h0 & 0x3ffffff;
+  h1 +=     c;
+
+  /* Compute h + -p */
+  g0 = h0 + 5; c = g0 >> 26; g0 &= 0x3ffffff;
+  g1 = h1 + c; c = g1 >> 26; g1 &= 0x3ffffff;
+  g2 = h2 + c; c = g2 >> 26; g2 &= 0x3ffffff;
+  g3 = h3 + c; c = g3 >> 26; g3 &= 0x3ffffff;
+  g4 = h4 + c - (1 << 26);
+
+  /* Select h if h < p, or h + -p if h >= p */
+  mask = (g4 >> 31) - 1;
+  g0 &= mask; g1 &= mask; g2 &= mask; g3 &= mask; g4 &= mask;
+  mask = ~mask;
+  h0 = (h0 & mask) | g0;
+  h1 = (h1 & mask) | g1;
+  h2 = (h2 & mask) | g2;
+  h3 = (h3 & mask) | g3;
+  h4 = (h4 & mask) | g4;
+
+  /* h = h % (2^128) */
+  h0 = ((h0      ) | (h1 << 26));
+  h1 = ((h1 >>  6) | (h2 << 20));
+  h2 = ((h2 >> 12) | (h3 << 14));
+  h3 = ((h3 >> 18) | (h4 <<  8));
+
+  /* tag = (h + pad) % (2^128) */
+  f = (sqlite3_uint64)h0 + ctx->pad[0];             h0 = (unsigned int)f;
+  f = (sqlite3_uint64)h1 + ctx->pad[1] + (f >> 32); h1 = (unsigned int)f;
+  f = (sqlite3_uint64)h2 + ctx->pad[2] + (f >> 32); h2 = (unsigned int)f;
+  f = (sqlite3_uint64)h3 + ctx->pad[3] + (f >> 32); h3 = (unsigned int)f;
+
+  CHACHA20_STORE32(tag +  0, h0);
+  CHACHA20_STORE32(tag +  4, h1);
+  CHACHA20_STORE32(tag +  8, h2);
+  CHACHA20_STORE32(tag + 12, h3);
+
+  memset(ctx, 0, sizeof(Poly1305Context));
+}
+
+static int
+Poly1305TagCompare(const unsigned char a[POLY1305_TAG_SIZE],
+                   const unsigned char b[POLY1305_TAG_SIZE])
+{
+  unsigned int d = 0;
+  int j;
+  for (j = 0; j < POLY1305_TAG_SIZE; j++)
+  {
+    d |= a[j] ^ b[j];
+  }
+  return (d != 0);
+}
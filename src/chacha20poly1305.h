@@ -0,0 +1,60 @@
+/*
+///////////////////////////////////////////////////////////////////////////////
+// Name:        chacha20poly1305.h
+// Purpose:     ChaCha20 stream cipher and Poly1305 authenticator (RFC 8439)
+// Licence:     wxWindows licence
+///////////////////////////////////////////////////////////////////////////////
+
+/// \file chacha20poly1305.h Interface of the ChaCha20-Poly1305 primitives
+*/
+
+#ifndef _CHACHA20POLY1305_H_
+#define _CHACHA20POLY1305_H_
+
+#include "sqlite3.h"
+
+#define CHACHA20_KEY_SIZE    32
+#define CHACHA20_NONCE_SIZE  12
+#define HCHACHA20_NONCE_SIZE 16
+#define POLY1305_KEY_SIZE    32
+#define POLY1305_TAG_SIZE    16
+
+/*
+// State of an incremental Poly1305 computation
+*/
+typedef struct _Poly1305Context
+{
+  unsigned int  r[5];         /* Clamped key part r in 26 bit limbs */
+  unsigned int  h[5];         /* Accumulator in 26 bit limbs */
+  unsigned int  pad[4];       /* Key part s */
+  unsigned char buffer[16];   /* Partial block */
+  int           leftover;     /* Number of bytes in buffer */
+} Poly1305Context;
+
+/*
+// XOR len bytes of data with the ChaCha20 key stream for the given key and
+// nonce, starting at block counter
+*/
+static void ChaCha20Xor(unsigned char* data, int len,
+                        const unsigned char key[CHACHA20_KEY_SIZE],
+                        const unsigned char nonce[CHACHA20_NONCE_SIZE],
+                        unsigned int counter);
+
+/*
+// Derive a subkey from a key and a 16 byte nonce (HChaCha20)
+*/
+static void HChaCha20(unsigned char out[CHACHA20_KEY_SIZE],
+                      const unsigned char key[CHACHA20_KEY_SIZE],
+                      const unsigned char nonce[HCHACHA20_NONCE_SIZE]);
+
+static void Poly1305Init(Poly1305Context* ctx, const unsigned char key[POLY1305_KEY_SIZE]);
+static void Poly1305Update(Poly1305Context* ctx, const unsigned char* data, int len);
+static void Poly1305Final(Poly1305Context* ctx, unsigned char tag[POLY1305_TAG_SIZE]);
+
+/*
+// Compare two tags in constant time, returns 0 if they are equal
+*/
+static int Poly1305TagCompare(const unsigned char a[POLY1305_TAG_SIZE],
+                              const unsigned char b[POLY1305_TAG_SIZE]);
+
+#endif
@@ -40,10 +40,12 @@
 #include "codec.h"
 
 #ifndef SQLITE_USER_AUTHENTICATION
-#if CODEC_TYPE == CODEC_TYPE_AES256
 #include "sha2.h"
 #include "sha2.c"
 #endif
+
+#if CODEC_TYPE == CODEC_TYPE_CHACHA20
+#include "chacha20poly1305.c"
 #endif
 
 /*
@@ -346,6 +348,239 @@ static void MD5Transform(unsigned int buf[4], unsigned int in[16])
   buf[3] += d;
 }
  
+/*
+// AVX2 multi-buffer MD5: eight independent single block messages are
+// hashed at once, one in each 32 bit lane. This is used to derive the keys
+// and initial vectors of several pages in one go.
+// The instructions are selected at runtime via cpuid. Define
+// CODEC_OMIT_AVX2 to build the portable implementation only.
+*/
+#if !defined(CODEC_OMIT_AVX2)
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#include <immintrin.h>
+#define CODEC_AVX2_TARGET
+#elif (defined(__x86_64__) || defined(__i386__)) && \
+      (defined(__clang__) || (__GNUC__ >= 5))
+#include <cpuid.h>
+#include <immintrin.h>
+#define CODEC_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define CODEC_OMIT_AVX2
+#endif
+#endif
+
+#define MD5_LANES 8
+
+#ifndef CODEC_OMIT_AVX2
+
+static int avx2Available = -1;
+
+static int
+CodecAvx2Available(void)
+{
+  if (avx2Available < 0)
+  {
+    unsigned int xcr0 = 0;
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    avx2Available = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+    if (avx2Available)
+    {
+      xcr0 = (unsigned int) _xgetbv(0);
+      __cpuidex(info, 7, 0);
+      avx2Available = (xcr0 & 6) == 6 && (info[1] & (1 << 5)) != 0;
+    }
+#else
+    unsigned int eax, ebx, ecx, edx;
+    avx2Available = __get_cpuid(1, &eax, &ebx, &ecx, &edx) &&
+                    (ecx & (1 << 27)) != 0 && (ecx & (1 << 28)) != 0 &&
+                    __get_cpuid_max(0, 0) >= 7;
+    if (avx2Available)
+    {
+      /* The operating system has to save the YMM registers */
+      __asm__ __volatile__ ("xgetbv" : "=a" (xcr0), "=d" (edx) : "c" (0));
+      __cpuid_count(7, 0, eax, ebx, ecx, edx);
+      avx2Available = (xcr0 & 6) == 6 && (ebx & (1 << 5)) != 0;
+    }
+#endif
+  }
+  return avx2Available;
+}
+
+#define F1X8(x, y, z) _mm256_xor_si256(z, _mm256_and_si256(x, _mm256_xor_si256(y, z)))
+#define F2X8(x, y, z) F1X8(z, x, y)
+#define F3X8(x, y, z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+#define F4X8(x, y, z) _mm256_xor_si256(y, _mm256_or_si256(x, _mm256_xor_si256(z, ones)))
+
+#define MD5X8STEP(f, w, x, y, z, data, t, s) \
+        w = _mm256_add_epi32(w, _mm256_add_epi32(f(x, y, z), \
+                                _mm256_add_epi32(data, _mm256_set1_epi32((int) t)))); \
+        w = _mm256_or_si256(_mm256_slli_epi32(w, s), _mm256_srli_epi32(w, 32-s)); \
+        w = _mm256_add_epi32(w, x)
+
+/*
+// Hash eight padded message blocks, given as 16 little endian words each
+*/
+CODEC_AVX2_TARGET
+static void
+MD5TransformX8(unsigned int in[MD5_LANES][16], unsigned int out[4][MD5_LANES])
+{
+  const __m256i ones = _mm256_set1_epi32(-1);
+  __m256i m[16];
+  __m256i a, b, c, d;
+  int j;
+
+  for (j = 0; j < 16; j++)
+  {
+    m[j] = _mm256_set_epi32((int) in[7][j], (int) in[6][j], (int) in[5][j], (int) in[4][j],
+                            (int) in[3][j], (int) in[2][j], (int) in[1][j], (int) in[0][j]);
+  }
+  a = _mm256_set1_epi32(0x67452301);
+  b = _mm256_set1_epi32((int) 0xefcdab89);
+  c = _mm256_set1_epi32((int) 0x98badcfe);
+  d = _mm256_set1_epi32(0x10325476);
+
+  MD5X8STEP(F1X8, a, b, c, d, m[0], 0xd76aa478, 7);
+  MD5X8STEP(F1X8, d, a, b, c, m[1], 0xe8c7b756, 12);
+  MD5X8STEP(F1X8, c, d, a, b, m[2], 0x242070db, 17);
+  MD5X8STEP(F1X8, b, c, d, a, m[3], 0xc1bdceee, 22);
+  MD5X8STEP(F1X8, a, b, c, d, m[4], 0xf57c0faf, 7);
+  MD5X8STEP(F1X8, d, a, b, c, m[5], 0x4787c62a, 12);
+  MD5X8STEP(F1X8, c, d, a, b, m[6], 0xa8304613, 17);
+  MD5X8STEP(F1X8, b, c, d, a, m[7], 0xfd469501, 22);
+  MD5X8STEP(F1X8, a, b, c, d, m[8], 0x698098d8, 7);
+  MD5X8STEP(F1X8, d, a, b, c, m[9], 0x8b44f7af, 12);
+  MD5X8STEP(F1X8, c, d, a, b, m[10], 0xffff5bb1, 17);
+  MD5X8STEP(F1X8, b, c, d, a, m[11], 0x895cd7be, 22);
+  MD5X8STEP(F1X8, a, b, c, d, m[12], 0x6b901122, 7);
+  MD5X8STEP(F1X8, d, a, b, c, m[13], 0xfd987193, 12);
+  MD5X8STEP(F1X8, c, d, a, b, m[14], 0xa679438e, 17);
+  MD5X8STEP(F1X8, b, c, d, a, m[15], 0x49b40821, 22);
+
+  MD5X8STEP(F2X8, a, b, c, d, m[1], 0xf61e2562, 5);
+  MD5X8STEP(F2X8, d, a, b, c, m[6], 0xc040b340, 9);
+  MD5X8STEP(F2X8, c, d, a, b, m[11], 0x265e5a51, 14);
+  MD5X8STEP(F2X8, b, c, d, a, m[0], 0xe9b6c7aa, 20);
+  MD5X8STEP(F2X8, a, b, c, d, m[5], 0xd62f105d, 5);
+  MD5X8STEP(F2X8, d, a, b, c, m[10], 0x02441453, 9);
+  MD5X8STEP(F2X8, c, d, a, b, m[15], 0xd8a1e681, 14);
+  MD5X8STEP(F2X8, b, c, d, a, m[4], 0xe7d3fbc8, 20);
+  MD5X8STEP(F2X8, a, b, c, d, m[9], 0x21e1cde6, 5);
+  MD5X8STEP(F2X8, d, a, b, c, m[14], 0xc33707d6, 9);
+  MD5X8STEP(F2X8, c, d, a, b, m[3], 0xf4d50d87, 14);
+  MD5X8STEP(F2X8, b, c, d, a, m[8], 0x455a14ed, 20);
+  MD5X8STEP(F2X8, a, b, c, d, m[13], 0xa9e3e905, 5);
+  MD5X8STEP(F2X8, d, a, b, c, m[2], 0xfcefa3f8, 9);
+  MD5X8STEP(F2X8, c, d, a, b, m[7], 0x676f02d9, 14);
+  MD5X8STEP(F2X8, b, c, d, a, m[12], 0x8d2a4c8a, 20);
+
+  MD5X8STEP(F3X8, a, b, c, d, m[5], 0xfffa3942, 4);
+  MD5X8STEP(F3X8, d, a, b, c, m[8], 0x8771f681, 11);
+  MD5X8STEP(F3X8, c, d, a, b, m[11], 0x6d9d6122, 16);
+  MD5X8STEP(F3X8, b, c, d, a, m[14], 0xfde5380c, 23);
+  MD5X8STEP(F3X8, a, b, c, d, m[1], 0xa4beea44, 4);
+  MD5X8STEP(F3X8, d, a, b, c, m[4], 0x4bdecfa9, 11);
+  MD5X8STEP(F3X8, c, d, a, b, m[7], 0xf6bb4b60, 16);
+  MD5X8STEP(F3X8, b, c, d, a, m[10], 0xbebfbc70, 23);
+  MD5X8STEP(F3X8, a, b, c, d, m[13], 0x289b7ec6, 4);
+  MD5X8STEP(F3X8, d, a, b, c, m[0], 0xeaa127fa, 11);
+  MD5X8STEP(F3X8, c, d, a, b, m[3], 0xd4ef3085, 16);
+  MD5X8STEP(F3X8, b, c, d, a, m[6], 0x04881d05, 23);
+  MD5X8STEP(F3X8, a, b, c, d, m[9], 0xd9d4d039, 4);
+  MD5X8STEP(F3X8, d, a, b, c, m[12], 0xe6db99e5, 11);
+  MD5X8STEP(F3X8, c, d, a, b, m[15], 0x1fa27cf8, 16);
+  MD5X8STEP(F3X8, b, c, d, a, m[2], 0xc4ac5665, 23);
+
+  MD5X8STEP(F4X8, a, b, c, d, m[0], 0xf4292244, 6);
+  MD5X8STEP(F4X8, d, a, b, c, m[7], 0x432aff97, 10);
+  MD5X8STEP(F4X8, c, d, a, b, m[14], 0xab9423a7, 15);
+  MD5X8STEP(F4X8, b, c, d, a, m[5], 0xfc93a039, 21);
+  MD5X8STEP(F4X8, a, b, c, d, m[12], 0x655b59c3, 6);
+  MD5X8STEP(F4X8, d, a, b, c, m[3], 0x8f0ccc92, 10);
+  MD5X8STEP(F4X8, c, d, a, b, m[10], 0xffeff47d, 15);
+  MD5X8STEP(F4X8, b, c, d, a, m[1], 0x85845dd1, 21);
+  MD5X8STEP(F4X8, a, b, c, d, m[8], 0x6fa87e4f, 6);
+  MD5X8STEP(F4X8, d, a, b, c, m[15], 0xfe2ce6e0, 10);
+  MD5X8STEP(F4X8, c, d, a, b, m[6], 0xa3014314, 15);
+  MD5X8STEP(F4X8, b, c, d, a, m[13], 0x4e0811a1, 21);
+  MD5X8STEP(F4X8, a, b, c, d, m[4], 0xf7537e82, 6);
+  MD5X8STEP(F4X8, d, a, b, c, m[11], 0xbd3af235, 10);
+  MD5X8STEP(F4X8, c, d, a, b, m[2], 0x2ad7d2bb, 15);
+  MD5X8STEP(F4X8, b, c, d, a, m[9], 0xeb86d391, 21);
+
+  a = _mm256_add_epi32(a, _mm256_set1_epi32(0x67452301));
+  b = _mm256_add_epi32(b, _mm256_set1_epi32((int) 0xefcdab89));
+  c = _mm256_add_epi32(c, _mm256_set1_epi32((int) 0x98badcfe));
+  d = _mm256_add_epi32(d, _mm256_set1_epi32(0x10325476));
+  _mm256_storeu_si256((__m256i*) out[0], a);
+  _mm256_storeu_si256((__m256i*) out[1], b);
+  _mm256_storeu_si256((__m256i*) out[2], c);
+  _mm256_storeu_si256((__m256i*) out[3], d);
+}
+
+#endif /* !CODEC_OMIT_AVX2 */
+
+/*
+// Compute the MD5 digests of n messages of the same length. Messages that
+// fit into a single MD5 block (at most 55 bytes) are hashed eight at a
+// time if AVX2 is available.
+*/
+static void
+CodecGetMD5BinaryBatch(Codec* codec, unsigned char* data[], int length, int n,
+                       unsigned char digest[][MD5_HASHBYTES])
+{
+  int k = 0;
+#ifndef CODEC_OMIT_AVX2
+  if (length <= 55 && n >= MD5_LANES/2 && CodecAvx2Available())
+  {
+    unsigned char block[64];
+    unsigned int in[MD5_LANES][16];
+    unsigned int out[4][MD5_LANES];
+    unsigned int bits = (unsigned int) length << 3;
+    int lane, lanes, j;
+
+    for (; k < n; k += MD5_LANES)
+    {
+      lanes = (n - k < MD5_LANES) ? n - k : MD5_LANES;
+      for (lane = 0; lane < MD5_LANES; lane++)
+      {
+        /* Unused lanes hash the last message once more */
+        unsigned char* msg = data[k + ((lane < lanes) ? lane : lanes - 1)];
+        memset(block, 0, 64);
+        memcpy(block, msg, length);
+        block[length] = 0x80;
+        block[56] = (unsigned char) bits;
+        block[57] = (unsigned char) (bits >> 8);
+        block[58] = (unsigned char) (bits >> 16);
+        block[59] = (unsigned char) (bits >> 24);
+        for (j = 0; j < 16; j++)
+        {
+          in[lane][j] = (unsigned int) block[4*j] | ((unsigned int) block[4*j+1] << 8) |
+                        ((unsigned int) block[4*j+2] << 16) | ((unsigned int) block[4*j+3] << 24);
+        }
+      }
+      MD5TransformX8(in, out);
+      for (lane = 0; lane < lanes; lane++)
+      {
+        for (j = 0; j < 4; j++)
+        {
+          digest[k+lane][4*j+0] = (unsigned char)  out[j][lane];
+          digest[k+lane][4*j+1] = (unsigned char) (out[j][lane] >> 8);
+          digest[k+lane][4*j+2] = (unsigned char) (out[j][lane] >> 16);
+          digest[k+lane][4*j+3] = (unsigned char) (out[j][lane] >> 24);
+        }
+      }
+    }
+  }
+#endif
+  for (; k < n; k++)
+  {
+    CodecGetMD5Binary(codec, data[k], length, digest[k]);
+  }
+}
+
 /*
 // ---------------------------
 // RC4 implementation
@@ -404,7 +639,7 @@ CodecGetMD5Binary(Codec* codec, unsigned char* data, int length, unsigned char*
   MD5Final(digest,&ctx);
 }
 
-#if CODEC_TYPE == CODEC_TYPE_AES256
+#ifdef CODEC_USE_SHA256
 void
 CodecGetSHABinary(Codec* codec, unsigned char* data, int length, unsigned char* digest)
 {
@@ -414,10 +649,9 @@ CodecGetSHABinary(Codec* codec, unsigned char* data, int length, unsigned char*
 
 #define MODMULT(a, b, c, m, s) q = s / a; s = b * (s - a * q) - c * q; if (s < 0) s += m
 
-void
-CodecGenerateInitialVector(Codec* codec, int seed, unsigned char iv[16])
+static void
+CodecInitialVectorSeed(int seed, unsigned char initkey[16])
 {
-  unsigned char initkey[16];
   int j, q;
   int z = seed + 1;
   for (j = 0; j < 4; j++)
@@ -428,56 +662,343 @@ CodecGenerateInitialVector(Codec* codec, int seed, unsigned char iv[16])
     initkey[4*j+2] = 0xff & (z >> 16);
     initkey[4*j+3] = 0xff & (z >> 24);
   }
+}
+
+void
+CodecGenerateInitialVector(Codec* codec, int seed, unsigned char iv[16])
+{
+  unsigned char initkey[16];
+  CodecInitialVectorSeed(seed, initkey);
   CodecGetMD5Binary(codec, (unsigned char*) initkey, 16, iv);
 }
 
+/*
+// Derive the AES keys and initial vectors of n pages at once
+*/
+static void
+CodecGeneratePageKeys(Codec* codec, unsigned char encryptionKey[KEYLENGTH], const int* pages, int n,
+                      unsigned char pagekey[][KEYLENGTH], unsigned char iv[][16])
+{
+  unsigned char nkey[CODEC_KEY_PREFETCH][KEYLENGTH+4+4];
+  unsigned char initkey[CODEC_KEY_PREFETCH][16];
+  unsigned char* input[CODEC_KEY_PREFETCH];
+  int keyLength = KEYLENGTH;
+  int nkeylen = keyLength + 4 + 4;
+  int k;
+
+  for (k = 0; k < n; k++)
+  {
+    int page = pages[k];
+    memcpy(nkey[k], encryptionKey, keyLength);
+    nkey[k][keyLength+0] = 0xff &  page;
+    nkey[k][keyLength+1] = 0xff & (page >>  8);
+    nkey[k][keyLength+2] = 0xff & (page >> 16);
+    nkey[k][keyLength+3] = 0xff & (page >> 24);
+
+    /* AES encryption needs some 'salt' */
+    nkey[k][keyLength+4] = 0x73;
+    nkey[k][keyLength+5] = 0x41;
+    nkey[k][keyLength+6] = 0x6c;
+    nkey[k][keyLength+7] = 0x54;
+  }
+
+#if CODEC_TYPE == CODEC_TYPE_AES256
+  for (k = 0; k < n; k++)
+  {
+    CodecGetSHABinary(codec, nkey[k], nkeylen, pagekey[k]);
+  }
+#else
+  {
+    unsigned char digest[CODEC_KEY_PREFETCH][MD5_HASHBYTES];
+    for (k = 0; k < n; k++)
+    {
+      input[k] = nkey[k];
+    }
+    CodecGetMD5BinaryBatch(codec, input, nkeylen, n, digest);
+    for (k = 0; k < n; k++)
+    {
+      memcpy(pagekey[k], digest[k], MD5_HASHBYTES);
+    }
+  }
+#endif
+
+  for (k = 0; k < n; k++)
+  {
+    CodecInitialVectorSeed(pages[k], initkey[k]);
+    input[k] = initkey[k];
+  }
+  CodecGetMD5BinaryBatch(codec, input, 16, n, iv);
+}
+
+#if CODEC_KEY_CACHE_SIZE > 0
+#define CODEC_KEY_CACHE_HASH(page, keyId, encrypt) \
+  ((((unsigned int) (page) << 2) | ((keyId) << 1) | ((encrypt) != 0)) % CODEC_KEY_CACHE_SIZE)
+
+/*
+// Make an entry of the key cache the most recently used one
+*/
+static void
+CodecKeyCacheTouch(CodecKeyCache* cache, CodecKeyCacheEntry* entry)
+{
+  if (entry == cache->m_lruHead)
+  {
+    return;
+  }
+  if (entry->m_lruPrev != NULL)
+  {
+    /* Unlink from the current LRU position */
+    entry->m_lruPrev->m_lruNext = entry->m_lruNext;
+    if (entry->m_lruNext != NULL)
+    {
+      entry->m_lruNext->m_lruPrev = entry->m_lruPrev;
+    }
+    else
+    {
+      cache->m_lruTail = entry->m_lruPrev;
+    }
+  }
+  entry->m_lruPrev = NULL;
+  entry->m_lruNext = cache->m_lruHead;
+  if (cache->m_lruHead != NULL)
+  {
+    cache->m_lruHead->m_lruPrev = entry;
+  }
+  cache->m_lruHead = entry;
+  if (cache->m_lruTail == NULL)
+  {
+    cache->m_lruTail = entry;
+  }
+}
+#endif
+
+/*
+// Look up the AES state of a page in the key cache of the codec.
+// On a hit the cached state is copied to *aes and 1 is returned.
+*/
+static int
+CodecKeyCacheGet(Codec* codec, int page, int keyId, int encrypt, Rijndael* aes)
+{
+#if CODEC_KEY_CACHE_SIZE > 0
+  CodecKeyCache* cache = &codec->m_keyCache;
+  CodecKeyCacheEntry* entry = NULL;
+  sqlite3_mutex_enter(codec->m_mutex);
+  if (cache->m_apHash != NULL)
+  {
+    for (entry = cache->m_apHash[CODEC_KEY_CACHE_HASH(page, keyId, encrypt)]; entry != NULL; entry = entry->m_hashNext)
+    {
+      if (entry->m_page == page && entry->m_keyId == keyId && entry->m_encrypt == encrypt)
+      {
+        break;
+      }
+    }
+  }
+  if (entry != NULL)
+  {
+    cache->m_nHit++;
+    CodecKeyCacheTouch(cache, entry);
+    memcpy(aes, &entry->m_aes, sizeof(Rijndael));
+  }
+  else
+  {
+    cache->m_nMiss++;
+  }
+  sqlite3_mutex_leave(codec->m_mutex);
+  return entry != NULL;
+#else
+  return 0;
+#endif
+}
+
+/*
+// Check whether a key cache miss continues a run of misses in ascending
+// page order, as caused by a table scan or a backup. If so, the keys of
+// the next n pages are derived at once, and the run continues behind them.
+*/
+static int
+CodecKeyCacheSequential(Codec* codec, int page, int n)
+{
+#if CODEC_KEY_CACHE_SIZE > 0 && CODEC_KEY_PREFETCH > 1
+  int sequential;
+  sqlite3_mutex_enter(codec->m_mutex);
+  sequential = (page == codec->m_keyCache.m_lastMiss + 1);
+  codec->m_keyCache.m_lastMiss = (sequential) ? page + n - 1 : page;
+  sqlite3_mutex_leave(codec->m_mutex);
+  return sequential;
+#else
+  return 0;
+#endif
+}
+
+/*
+// Store the AES state of a page in the key cache of the codec, recycling
+// the least recently used entry if the cache is full. The cache is
+// allocated on first use; if that fails the state is simply not cached.
+*/
+static void
+CodecKeyCachePut(Codec* codec, int page, int keyId, int encrypt, Rijndael* aes)
+{
+#if CODEC_KEY_CACHE_SIZE > 0
+  CodecKeyCache* cache = &codec->m_keyCache;
+  CodecKeyCacheEntry* entry;
+  CodecKeyCacheEntry** ppEntry;
+  unsigned int h = CODEC_KEY_CACHE_HASH(page, keyId, encrypt);
+
+  sqlite3_mutex_enter(codec->m_mutex);
+  if (cache->m_aEntry == NULL)
+  {
+    cache->m_aEntry = (CodecKeyCacheEntry*) sqlite3_malloc(sizeof(CodecKeyCacheEntry) * CODEC_KEY_CACHE_SIZE);
+    cache->m_apHash = (CodecKeyCacheEntry**) sqlite3_malloc(sizeof(CodecKeyCacheEntry*) * CODEC_KEY_CACHE_SIZE);
+    if (cache->m_aEntry == NULL || cache->m_apHash == NULL)
+    {
+      sqlite3_free(cache->m_aEntry);
+      sqlite3_free(cache->m_apHash);
+      cache->m_aEntry = NULL;
+      cache->m_apHash = NULL;
+      sqlite3_mutex_leave(codec->m_mutex);
+      return;
+    }
+    memset(cache->m_apHash, 0, sizeof(CodecKeyCacheEntry*) * CODEC_KEY_CACHE_SIZE);
+    cache->m_nEntry = 0;
+    cache->m_lruHead = cache->m_lruTail = NULL;
+  }
+
+  /* Another thread may have stored the same page in the meantime */
+  for (entry = cache->m_apHash[h]; entry != NULL; entry = entry->m_hashNext)
+  {
+    if (entry->m_page == page && entry->m_keyId == keyId && entry->m_encrypt == encrypt)
+    {
+      sqlite3_mutex_leave(codec->m_mutex);
+      return;
+    }
+  }
+
+  if (cache->m_nEntry < CODEC_KEY_CACHE_SIZE)
+  {
+    entry = &cache->m_aEntry[cache->m_nEntry++];
+    entry->m_lruPrev = entry->m_lruNext = NULL;
+  }
+  else
+  {
+    /* Recycle the least recently used entry */
+    entry = cache->m_lruTail;
+    ppEntry = &cache->m_apHash[CODEC_KEY_CACHE_HASH(entry->m_page, entry->m_keyId, entry->m_encrypt)];
+    while (*ppEntry != entry)
+    {
+      ppEntry = &(*ppEntry)->m_hashNext;
+    }
+    *ppEntry = entry->m_hashNext;
+  }
+  entry->m_page = page;
+  entry->m_keyId = keyId;
+  entry->m_encrypt = encrypt;
+  entry->m_hashNext = cache->m_apHash[h];
+  cache->m_apHash[h] = entry;
+  memcpy(&entry->m_aes, aes, sizeof(Rijndael));
+  CodecKeyCacheTouch(cache, entry);
+  sqlite3_mutex_leave(codec->m_mutex);
+#endif
+}
+
+void
+CodecKeyCacheClear(Codec* codec)
+{
+  CodecKeyCache* cache = &codec->m_keyCache;
+  sqlite3_mutex_enter(codec->m_mutex);
+  if (cache->m_aEntry != NULL)
+  {
+    memset(cache->m_aEntry, 0, sizeof(CodecKeyCacheEntry) * CODEC_KEY_CACHE_SIZE);
+    memset(cache->m_apHash, 0, sizeof(CodecKeyCacheEntry*) * CODEC_KEY_CACHE_SIZE);
+  }
+  cache->m_nEntry = 0;
+  cache->m_lruHead = cache->m_lruTail = NULL;
+  cache->m_lastMiss = 0;
+  sqlite3_mutex_leave(codec->m_mutex);
+}
+
+void
+CodecKeyCacheStat(Codec* codec, int op, int resetFlag, int* pValue)
+{
+  int* pCounter;
+  switch (op)
+  {
+    case SQLITE_DBSTATUS_CODEC_CACHE_HIT:  pCounter = &codec->m_keyCache.m_nHit;  break;
+    case SQLITE_DBSTATUS_CODEC_CACHE_MISS: pCounter = &codec->m_keyCache.m_nMiss; break;
+    case SQLITE_DBSTATUS_CODEC_PAGE_HIT:   pCounter = &codec->m_nPageHit;         break;
+    default:                               pCounter = &codec->m_nPageMiss;        break;
+  }
+  sqlite3_mutex_enter(codec->m_mutex);
+  *pValue += *pCounter;
+  if (resetFlag)
+  {
+    *pCounter = 0;
+  }
+  sqlite3_mutex_leave(codec->m_mutex);
+}
+
 void
 CodecAES(Codec* codec, int page, int encrypt, unsigned char encryptionKey[KEYLENGTH],
          unsigned char* datain, int datalen, unsigned char* dataout)
 {
-  unsigned char initial[16];
-  unsigned char pagekey[KEYLENGTH];
-  unsigned char nkey[KEYLENGTH+4+4];
-  int keyLength = KEYLENGTH;
-  int nkeylen = keyLength + 4 + 4;
-  int j;
+  int pages[CODEC_KEY_PREFETCH];
+  unsigned char initial[CODEC_KEY_PREFETCH][16];
+  unsigned char pagekey[CODEC_KEY_PREFETCH][KEYLENGTH];
+  int nPages = 1;
+  int k;
   int direction = (encrypt) ? RIJNDAEL_Direction_Encrypt : RIJNDAEL_Direction_Decrypt;
   int len = 0;
+  int keyId = -1;
+  int found = 0;
+  Rijndael aesState;
+  Rijndael* aes = &aesState;
 
-  for (j = 0; j < keyLength; j++)
+  /* Only the keys owned by the codec can be cached, since only those are invalidated on change */
+  if (encryptionKey == codec->m_readKey)
   {
-    nkey[j] = encryptionKey[j];
+    keyId = CODEC_KEY_READ;
+  }
+  else if (encryptionKey == codec->m_writeKey)
+  {
+    keyId = CODEC_KEY_WRITE;
+  }
+  if (keyId >= 0)
+  {
+    found = CodecKeyCacheGet(codec, page, keyId, encrypt != 0, aes);
   }
-  nkey[keyLength+0] = 0xff &  page;
-  nkey[keyLength+1] = 0xff & (page >>  8);
-  nkey[keyLength+2] = 0xff & (page >> 16);
-  nkey[keyLength+3] = 0xff & (page >> 24);
-
-  /* AES encryption needs some 'salt' */
-  nkey[keyLength+4] = 0x73;
-  nkey[keyLength+5] = 0x41;
-  nkey[keyLength+6] = 0x6c;
-  nkey[keyLength+7] = 0x54;
 
-#if CODEC_TYPE == CODEC_TYPE_AES256
-  CodecGetSHABinary(codec, nkey, nkeylen, pagekey);
-#else
-  CodecGetMD5Binary(codec, nkey, nkeylen, pagekey);
-#endif  
-  CodecGenerateInitialVector(codec, page, initial);
+  if (!found)
+  {
+    pages[0] = page;
+    if (keyId >= 0 && CodecKeyCacheSequential(codec, page, CODEC_KEY_PREFETCH))
+    {
+      /* Derive the keys of the following pages as well */
+      for (nPages = 1; nPages < CODEC_KEY_PREFETCH; nPages++)
+      {
+        pages[nPages] = page + nPages;
+      }
+    }
+    CodecGeneratePageKeys(codec, encryptionKey, pages, nPages, pagekey, initial);
 
+    /* The state of the requested page is set up last and remains in *aes */
+    for (k = nPages-1; k >= 0; k--)
+    {
 #if CODEC_TYPE == CODEC_TYPE_AES256
-  RijndaelInit(codec->m_aes, RIJNDAEL_Direction_Mode_CBC, direction, pagekey, RIJNDAEL_Direction_KeyLength_Key32Bytes, initial);
+      RijndaelInit(aes, RIJNDAEL_Direction_Mode_CBC, direction, pagekey[k], RIJNDAEL_Direction_KeyLength_Key32Bytes, initial[k]);
 #else
-  RijndaelInit(codec->m_aes, RIJNDAEL_Direction_Mode_CBC, direction, pagekey, RIJNDAEL_Direction_KeyLength_Key16Bytes, initial);
+      RijndaelInit(aes, RIJNDAEL_Direction_Mode_CBC, direction, pagekey[k], RIJNDAEL_Direction_KeyLength_Key16Bytes, initial[k]);
 #endif  
+      if (keyId >= 0)
+      {
+        CodecKeyCachePut(codec, pages[k], keyId, encrypt != 0, aes);
+      }
+    }
+  }
   if (encrypt)
   {
-    len = RijndaelBlockEncrypt(codec->m_aes, datain, datalen*8, dataout);
+    len = RijndaelBlockEncrypt(aes, datain, datalen*8, dataout);
   }
   else
   {
-    len = RijndaelBlockDecrypt(codec->m_aes, datain, datalen*8, dataout);
+    len = RijndaelBlockDecrypt(aes, datain, datalen*8, dataout);
   }
   
   /* It is a good idea to check the error code */
@@ -490,20 +1011,45 @@ CodecAES(Codec* codec, int page, int encrypt, unsigned char encryptionKey[KEYLEN
 static unsigned char padding[] =
   "\x28\xBF\x4E\x5E\x4E\x75\x8A\x41\x64\x00\x4E\x56\xFF\xFA\x01\x08\x2E\x2E\x00\xB6\xD0\x68\x3E\x80\x2F\x0C\xA9\xFE\x64\x53\x69\x7A";
 
-void
+int
 CodecInit(Codec* codec)
 {
   codec->m_isEncrypted = 0;
   codec->m_hasReadKey  = 0;
   codec->m_hasWriteKey = 0;
-  codec->m_aes = (Rijndael*) sqlite3_malloc(sizeof(Rijndael));
-  RijndaelCreate(codec->m_aes);
+  codec->m_kdfIter  = 0;
+  memset(codec->m_kdfSalt, 0, CODEC_SALT_SIZE);
+  codec->m_readRaw  = 0;
+  codec->m_writeRaw = 0;
+  memset(codec->m_readSecret, 0, CODEC_SECRET_SIZE);
+  memset(codec->m_writeSecret, 0, CODEC_SECRET_SIZE);
+  codec->m_rekeyActive   = 0;
+  codec->m_rekeyPage     = 0;
+  codec->m_rekeyPending  = 0;
+  codec->m_rekeyFinal    = 0;
+  codec->m_mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_FAST);
+  memset(&codec->m_keyCache, 0, sizeof(CodecKeyCache));
+  codec->m_nPageHit  = 0;
+  codec->m_nPageMiss = 0;
+  codec->m_pageSize = 0;
+  codec->m_reserved = 0;
+  codec->m_pageBufferSize = 0;
+  codec->m_page = NULL;
+  /* Without core mutexes no mutex is handed out, and none is needed */
+  if (codec->m_mutex == NULL && sqlite3GlobalConfig.bCoreMutex)
+  {
+    return SQLITE_NOMEM;
+  }
+  return SQLITE_OK;
 }
 
 void
 CodecTerm(Codec* codec)
 {
-  sqlite3_free(codec->m_aes);
+  sqlite3_mutex_free(codec->m_mutex);
+  sqlite3_free(codec->m_keyCache.m_aEntry);
+  sqlite3_free(codec->m_keyCache.m_apHash);
+  sqlite3_free(codec->m_page);
 }
 
 void
@@ -557,7 +1103,27 @@ CodecGetBtree(Codec* codec)
 unsigned char*
 CodecGetPageBuffer(Codec* codec)
 {
-  return &codec->m_page[4];
+  return (codec->m_page != NULL) ? &codec->m_page[4] : NULL;
+}
+
+/*
+// Size the page buffer for the given page size.
+// Returns SQLITE_OK, or SQLITE_NOMEM if the buffer could not be allocated.
+*/
+int
+CodecSetPageSize(Codec* codec, int pageSize)
+{
+  if (pageSize != codec->m_pageBufferSize)
+  {
+    unsigned char* page = (unsigned char*) sqlite3_realloc(codec->m_page, pageSize+24);
+    if (page == NULL)
+    {
+      return SQLITE_NOMEM;
+    }
+    codec->m_page = page;
+    codec->m_pageBufferSize = pageSize;
+  }
+  return SQLITE_OK;
 }
 
 void
@@ -570,10 +1136,29 @@ CodecCopy(Codec* codec, Codec* other)
   for (j = 0; j < KEYLENGTH; j++)
   {
     codec->m_readKey[j]  = other->m_readKey[j];
-    codec->m_writeKey[j] = other->m_writeKey[j];
+    /* The new key of a stepwise rekey only applies to the rekeyed database */
+    codec->m_writeKey[j] = (other->m_rekeyActive) ? other->m_readKey[j] : other->m_writeKey[j];
+  }
+  codec->m_kdfIter = other->m_kdfIter;
+  memcpy(codec->m_kdfSalt, other->m_kdfSalt, CODEC_SALT_SIZE);
+  codec->m_readRaw = other->m_readRaw;
+  memcpy(codec->m_readSecret, other->m_readSecret, CODEC_SECRET_SIZE);
+  if (other->m_rekeyActive)
+  {
+    codec->m_writeRaw = other->m_readRaw;
+    memcpy(codec->m_writeSecret, other->m_readSecret, CODEC_SECRET_SIZE);
   }
+  else
+  {
+    codec->m_writeRaw = other->m_writeRaw;
+    memcpy(codec->m_writeSecret, other->m_writeSecret, CODEC_SECRET_SIZE);
+  }
+  codec->m_rekeyActive  = 0;
+  codec->m_rekeyPage    = 0;
+  codec->m_rekeyPending = 0;
+  codec->m_rekeyFinal   = 0;
   codec->m_bt = other->m_bt;
-  RijndaelInvalidate(codec->m_aes);
+  CodecKeyCacheClear(codec);
 }
 
 void
@@ -586,6 +1171,8 @@ CodecCopyKey(Codec* codec, int read2write)
     {
       codec->m_writeKey[j] = codec->m_readKey[j];
     }
+    codec->m_writeRaw = codec->m_readRaw;
+    memcpy(codec->m_writeSecret, codec->m_readSecret, CODEC_SECRET_SIZE);
   }
   else
   {
@@ -593,7 +1180,40 @@ CodecCopyKey(Codec* codec, int read2write)
     {
       codec->m_readKey[j] = codec->m_writeKey[j];
     }
+    codec->m_readRaw = codec->m_writeRaw;
+    memcpy(codec->m_readSecret, codec->m_writeSecret, CODEC_SECRET_SIZE);
   }
+  CodecKeyCacheClear(codec);
+}
+
+/*
+// Check whether a page is encrypted with the write key during a stepwise
+// rekey. Pages up to the watermark use the new (write) key, all other pages
+// the old (read) key. Page 1 keeps the old key until the final rekey step.
+// If pending is true, the watermark of the current write transaction is
+// used, otherwise the one of the committed database.
+*/
+int
+CodecRekeyUsesWriteKey(Codec* codec, int page, int pending)
+{
+  if (page == 1)
+  {
+    return pending && codec->m_rekeyFinal;
+  }
+  return page <= ((pending) ? codec->m_rekeyPending : codec->m_rekeyPage);
+}
+
+/*
+// Compute the check value stored in the database header to identify the
+// new key of an interrupted stepwise rekey
+*/
+unsigned int
+CodecRekeyCheck(Codec* codec, unsigned char key[KEYLENGTH])
+{
+  unsigned char digest[MD5_HASHBYTES];
+  CodecGetMD5Binary(codec, key, KEYLENGTH, digest);
+  return ((unsigned int) digest[0] << 24) | ((unsigned int) digest[1] << 16) |
+         ((unsigned int) digest[2] <<  8) |  (unsigned int) digest[3];
 }
 
 void
@@ -614,23 +1234,311 @@ CodecPadPassword(Codec* codec, char* password, int pswdlen, unsigned char pswd[3
   }
 }
 
+/*
+// PBKDF2 with HMAC-SHA256 as pseudo random function (RFC 8018).
+// The inner and outer hash states of the HMAC are computed once.
+*/
+void
+CodecPbkdf2(const unsigned char* password, int passwordLength,
+            const unsigned char* salt, int saltLength, int iter,
+            unsigned char* key, int keyLength)
+{
+  sha256_ctx inner;
+  sha256_ctx outer;
+  sha256_ctx ctx;
+  unsigned char pad[SHA256_BLOCK_SIZE];
+  unsigned char hashedPassword[SHA256_DIGEST_SIZE];
+  unsigned char u[SHA256_DIGEST_SIZE];
+  unsigned char t[SHA256_DIGEST_SIZE];
+  unsigned char counter[4];
+  unsigned int block;
+  int j, k, n;
+
+  if (passwordLength > SHA256_BLOCK_SIZE)
+  {
+    sha256(password, passwordLength, hashedPassword);
+    password = hashedPassword;
+    passwordLength = SHA256_DIGEST_SIZE;
+  }
+  memset(pad, 0x36, SHA256_BLOCK_SIZE);
+  for (j = 0; j < passwordLength; j++)
+  {
+    pad[j] ^= password[j];
+  }
+  sha256_init(&inner);
+  sha256_update(&inner, pad, SHA256_BLOCK_SIZE);
+  memset(pad, 0x5c, SHA256_BLOCK_SIZE);
+  for (j = 0; j < passwordLength; j++)
+  {
+    pad[j] ^= password[j];
+  }
+  sha256_init(&outer);
+  sha256_update(&outer, pad, SHA256_BLOCK_SIZE);
+
+  for (block = 1; keyLength > 0; block++)
+  {
+    sqlite3Put4byte(counter, block);
+    ctx = inner;
+    sha256_update(&ctx, salt, saltLength);
+    sha256_update(&ctx, counter, 4);
+    sha256_final(&ctx, u);
+    ctx = outer;
+    sha256_update(&ctx, u, SHA256_DIGEST_SIZE);
+    sha256_final(&ctx, u);
+    memcpy(t, u, SHA256_DIGEST_SIZE);
+    for (k = 1; k < iter; k++)
+    {
+      ctx = inner;
+      sha256_update(&ctx, u, SHA256_DIGEST_SIZE);
+      sha256_final(&ctx, u);
+      ctx = outer;
+      sha256_update(&ctx, u, SHA256_DIGEST_SIZE);
+      sha256_final(&ctx, u);
+      for (j = 0; j < SHA256_DIGEST_SIZE; j++)
+      {
+        t[j] ^= u[j];
+      }
+    }
+    n = (keyLength < SHA256_DIGEST_SIZE) ? keyLength : SHA256_DIGEST_SIZE;
+    memcpy(key, t, n);
+    key += n;
+    keyLength -= n;
+  }
+  memset(pad, 0, SHA256_BLOCK_SIZE);
+  memset(u, 0, SHA256_DIGEST_SIZE);
+  memset(t, 0, SHA256_DIGEST_SIZE);
+}
+
+/*
+// Process-wide cache of derived keys. Connections to the same database
+// derive the same key from the same password, so that only the first one
+// has to run the (deliberately slow) key derivation. An entry is identified
+// by a hash of the password secret, the salt and the iteration count; the
+// salt is unique per database file. Entries are replaced round-robin.
+*/
+#if CODEC_KDF_CACHE_SIZE > 0
+typedef struct _CodecKdfCacheEntry
+{
+  int           m_used;
+  unsigned char m_id[SHA256_DIGEST_SIZE];
+  unsigned char m_key[KEYLENGTH];
+} CodecKdfCacheEntry;
+
+static CodecKdfCacheEntry codecKdfCache[CODEC_KDF_CACHE_SIZE];
+static int codecKdfCacheNext = 0;
+#endif
+
+static void
+CodecKdfId(const unsigned char secret[CODEC_SECRET_SIZE], int iter,
+           const unsigned char salt[CODEC_SALT_SIZE], unsigned char id[SHA256_DIGEST_SIZE])
+{
+  sha256_ctx ctx;
+  unsigned char iterBytes[4];
+  sqlite3Put4byte(iterBytes, (u32) iter);
+  sha256_init(&ctx);
+  sha256_update(&ctx, secret, CODEC_SECRET_SIZE);
+  sha256_update(&ctx, salt, CODEC_SALT_SIZE);
+  sha256_update(&ctx, iterBytes, 4);
+  sha256_final(&ctx, id);
+}
+
+/*
+// Derive a key from a password using the key derivation parameters of the
+// codec. The legacy key derivation needs the password itself, the salted
+// one only the secret (SHA-256 of the password), so that a key for a
+// different salt can be derived later without keeping the password.
+// Returns 0 if the key can't be derived.
+*/
+static int
+CodecDeriveKey(Codec* codec, char* userPassword, int passwordLength,
+               const unsigned char secret[CODEC_SECRET_SIZE], unsigned char key[KEYLENGTH])
+{
+#if CODEC_KDF_CACHE_SIZE > 0
+  sqlite3_mutex* mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_MASTER);
+  CodecKdfCacheEntry* entry;
+  unsigned char id[SHA256_DIGEST_SIZE];
+  int j;
+
+  CodecKdfId(secret, codec->m_kdfIter, codec->m_kdfSalt, id);
+  sqlite3_mutex_enter(mutex);
+  for (j = 0; j < CODEC_KDF_CACHE_SIZE; j++)
+  {
+    entry = &codecKdfCache[j];
+    if (entry->m_used && memcmp(entry->m_id, id, SHA256_DIGEST_SIZE) == 0)
+    {
+      memcpy(key, entry->m_key, KEYLENGTH);
+      sqlite3_mutex_leave(mutex);
+      return 1;
+    }
+  }
+  sqlite3_mutex_leave(mutex);
+#endif
+
+  /* The derivation runs without holding the mutex */
+  if (codec->m_kdfIter > 0)
+  {
+    CodecPbkdf2(secret, CODEC_SECRET_SIZE, codec->m_kdfSalt, CODEC_SALT_SIZE,
+                codec->m_kdfIter, key, KEYLENGTH);
+  }
+  else if (userPassword != NULL)
+  {
+    CodecGenerateEncryptionKey(codec, userPassword, passwordLength, key);
+  }
+  else
+  {
+    return 0;
+  }
+
+#if CODEC_KDF_CACHE_SIZE > 0
+  sqlite3_mutex_enter(mutex);
+  entry = &codecKdfCache[codecKdfCacheNext];
+  codecKdfCacheNext = (codecKdfCacheNext + 1) % CODEC_KDF_CACHE_SIZE;
+  entry->m_used = 1;
+  memcpy(entry->m_id, id, SHA256_DIGEST_SIZE);
+  memcpy(entry->m_key, key, KEYLENGTH);
+  sqlite3_mutex_leave(mutex);
+#endif
+  return 1;
+}
+
+/*
+// Derive the secret and the key of a password with the key derivation
+// parameters of the codec, without changing the keys of the codec
+*/
+void
+CodecGeneratePasswordKey(Codec* codec, char* userPassword, int passwordLength,
+                         unsigned char secret[CODEC_SECRET_SIZE], unsigned char key[KEYLENGTH])
+{
+  sha256((unsigned char*) userPassword, passwordLength, secret);
+  CodecDeriveKey(codec, userPassword, passwordLength, secret, key);
+}
+
 void
 CodecGenerateReadKey(Codec* codec, char* userPassword, int passwordLength)
 {
-  CodecGenerateEncryptionKey(codec, userPassword, passwordLength, codec->m_readKey);
+  codec->m_readRaw = 0;
+  CodecGeneratePasswordKey(codec, userPassword, passwordLength, codec->m_readSecret, codec->m_readKey);
+  CodecKeyCacheClear(codec);
 }
 
 void
 CodecGenerateWriteKey(Codec* codec, char* userPassword, int passwordLength)
 {
-  CodecGenerateEncryptionKey(codec, userPassword, passwordLength, codec->m_writeKey);
+  codec->m_writeRaw = 0;
+  CodecGeneratePasswordKey(codec, userPassword, passwordLength, codec->m_writeSecret, codec->m_writeKey);
+  CodecKeyCacheClear(codec);
+}
+
+void
+CodecSetRawReadKey(Codec* codec, const unsigned char* key)
+{
+  memcpy(codec->m_readKey, key, KEYLENGTH);
+  memset(codec->m_readSecret, 0, CODEC_SECRET_SIZE);
+  codec->m_readRaw = 1;
+  CodecKeyCacheClear(codec);
+}
+
+void
+CodecSetRawWriteKey(Codec* codec, const unsigned char* key)
+{
+  memcpy(codec->m_writeKey, key, KEYLENGTH);
+  memset(codec->m_writeSecret, 0, CODEC_SECRET_SIZE);
+  codec->m_writeRaw = 1;
+  CodecKeyCacheClear(codec);
+}
+
+/*
+// Read the key derivation parameters from the header of page 1 as stored
+// in the database file. Returns 1 if the database uses the salted key
+// derivation, 0 otherwise.
+*/
+int
+CodecGetKdfHeader(const unsigned char* header, int* iter, unsigned char salt[CODEC_SALT_SIZE])
+{
+  int pageSize = (header[16] << 8) | (header[17] << 16);
+  if (header[21] == CODEC_KDF_MARKER && pageSize >= 512 && pageSize <= SQLITE_MAX_PAGE_SIZE &&
+      ((pageSize-1) & pageSize) == 0 && (header[22] | header[23]) != 0)
+  {
+    *iter = ((header[22] << 8) | header[23]) * CODEC_KDF_ITER_UNIT;
+    memcpy(salt, header, CODEC_SALT_SIZE);
+    return 1;
+  }
+  *iter = 0;
+  memset(salt, 0, CODEC_SALT_SIZE);
+  return 0;
+}
+
+void
+CodecSetKdf(Codec* codec, int iter, const unsigned char salt[CODEC_SALT_SIZE])
+{
+#ifdef WXSQLITE3_USE_OLD_ENCRYPTION_SCHEME
+  /* The previous encryption scheme encrypts the whole header */
+  iter = 0;
+#endif
+  codec->m_kdfIter = iter;
+  if (iter > 0)
+  {
+    memcpy(codec->m_kdfSalt, salt, CODEC_SALT_SIZE);
+  }
+  else
+  {
+    memset(codec->m_kdfSalt, 0, CODEC_SALT_SIZE);
+  }
+}
+
+/*
+// Select the key derivation for a database without encrypted content,
+// using a fresh salt for the salted key derivation
+*/
+void
+CodecNewKdf(Codec* codec, int iter)
+{
+  unsigned char salt[CODEC_SALT_SIZE];
+  sqlite3_randomness(CODEC_SALT_SIZE, salt);
+  CodecSetKdf(codec, iter, salt);
+}
+
+/*
+// Adopt the key derivation parameters found in the header of page 1 as
+// stored in the database file, deriving the keys anew if they changed.
+// This happens if another connection created the database with different
+// parameters. A key given as password can only be derived anew for the
+// salted key derivation, the legacy one needs the password itself.
+// Returns 1 if the keys changed.
+*/
+int
+CodecUpdateKdf(Codec* codec, const unsigned char* header)
+{
+  int iter;
+  unsigned char salt[CODEC_SALT_SIZE];
+  CodecGetKdfHeader(header, &iter, salt);
+  if (iter == codec->m_kdfIter && memcmp(salt, codec->m_kdfSalt, CODEC_SALT_SIZE) == 0)
+  {
+    return 0;
+  }
+  if (iter == 0 && ((codec->m_hasReadKey && !codec->m_readRaw) ||
+                    (codec->m_hasWriteKey && !codec->m_writeRaw)))
+  {
+    return 0;
+  }
+  CodecSetKdf(codec, iter, salt);
+  if (codec->m_hasReadKey && !codec->m_readRaw)
+  {
+    CodecDeriveKey(codec, NULL, 0, codec->m_readSecret, codec->m_readKey);
+  }
+  if (codec->m_hasWriteKey && !codec->m_writeRaw)
+  {
+    CodecDeriveKey(codec, NULL, 0, codec->m_writeSecret, codec->m_writeKey);
+  }
+  CodecKeyCacheClear(codec);
+  return 1;
 }
 
 void
 CodecGenerateEncryptionKey(Codec* codec, char* userPassword, int passwordLength, 
                            unsigned char encryptionKey[KEYLENGTH])
 {
-#if CODEC_TYPE == CODEC_TYPE_AES256
+#ifdef CODEC_USE_SHA256
   unsigned char userPad[32];
   unsigned char digest[KEYLENGTH];
   int keyLength = KEYLENGTH;
@@ -701,6 +1609,164 @@ CodecGenerateEncryptionKey(Codec* codec, char* userPassword, int passwordLength,
 #endif  
 }
 
+/*
+// Store the parameters of the salted key derivation in an encrypted page 1
+*/
+static void
+CodecStampKdf(Codec* codec, unsigned char* data)
+{
+  int units = codec->m_kdfIter / CODEC_KDF_ITER_UNIT;
+  if (units > 0)
+  {
+    memcpy(data, codec->m_kdfSalt, CODEC_SALT_SIZE);
+    data[21] = CODEC_KDF_MARKER;
+    data[22] = (unsigned char) (units >> 8);
+    data[23] = (unsigned char) units;
+  }
+}
+
+/*
+// Restore the standard payload fractions (header bytes 21..23) in the
+// unencrypted header bytes 16..23 of page 1, if they hold the parameters
+// of the salted key derivation
+*/
+static void
+CodecUnstampKdf(unsigned char dbHeader[8])
+{
+  if (dbHeader[5] == CODEC_KDF_MARKER)
+  {
+    dbHeader[5] = 0x40;
+    dbHeader[6] = 0x20;
+    dbHeader[7] = 0x20;
+  }
+}
+
+#if CODEC_TYPE == CODEC_TYPE_CHACHA20
+/*
+// ChaCha20-Poly1305 page encryption
+//
+// The last CODEC_RESERVED bytes of a page hold a random nonce followed by
+// the authentication tag. The page is encrypted with a subkey derived from
+// the key and the nonce (HChaCha20), so that random nonces can be used
+// safely. The page number is authenticated as additional data, so that
+// pages can't be swapped. Bytes 16..23 of page 1 remain unencrypted, as
+// SQLite has to read them before the key is applied, but they are
+// authenticated as well.
+*/
+static const unsigned char codecZeroNonce[CHACHA20_NONCE_SIZE] = { 0 };
+
+static void
+CodecChaCha20Tag(unsigned char subkey[CHACHA20_KEY_SIZE], int page,
+                 unsigned char* data, int len, unsigned char tag[CODEC_TAG_SIZE])
+{
+  unsigned char polyKey[POLY1305_KEY_SIZE];
+  unsigned char block[16];
+  Poly1305Context ctx;
+
+  /* The one-time Poly1305 key is the first half of key stream block 0 */
+  memset(polyKey, 0, POLY1305_KEY_SIZE);
+  ChaCha20Xor(polyKey, POLY1305_KEY_SIZE, subkey, codecZeroNonce, 0);
+  Poly1305Init(&ctx, polyKey);
+
+  /* Additional data: the page number, padded to 16 bytes */
+  memset(block, 0, 16);
+  block[0] = 0xff &  page;
+  block[1] = 0xff & (page >>  8);
+  block[2] = 0xff & (page >> 16);
+  block[3] = 0xff & (page >> 24);
+  Poly1305Update(&ctx, block, 16);
+
+  /* Cipher text, padded to 16 bytes */
+  Poly1305Update(&ctx, data, len);
+  if ((len % 16) != 0)
+  {
+    memset(block, 0, 16);
+    Poly1305Update(&ctx, block, 16 - (len % 16));
+  }
+
+  /* Lengths of additional data and cipher text */
+  memset(block, 0, 16);
+  block[0] = 4;
+  block[8]  = 0xff &  len;
+  block[9]  = 0xff & (len >>  8);
+  block[10] = 0xff & (len >> 16);
+  block[11] = 0xff & (len >> 24);
+  Poly1305Update(&ctx, block, 16);
+
+  Poly1305Final(&ctx, tag);
+  memset(polyKey, 0, POLY1305_KEY_SIZE);
+}
+
+void
+CodecEncrypt(Codec* codec, int page, unsigned char* data, int len, int useWriteKey)
+{
+  unsigned char subkey[CHACHA20_KEY_SIZE];
+  unsigned char dbHeader[8];
+  unsigned char* key = (useWriteKey) ? codec->m_writeKey : codec->m_readKey;
+  int n = len - CODEC_RESERVED;
+  unsigned char* nonce = data + n;
+
+  sqlite3_randomness(CODEC_NONCE_SIZE, nonce);
+  HChaCha20(subkey, key, nonce);
+  if (page == 1)
+  {
+    memcpy(dbHeader, data+16, 8);
+  }
+  ChaCha20Xor(data, n, subkey, codecZeroNonce, 1);
+  if (page == 1)
+  {
+    memcpy(data+16, dbHeader, 8);
+    CodecStampKdf(codec, data);
+  }
+  CodecChaCha20Tag(subkey, page, data, n, nonce + CODEC_NONCE_SIZE);
+  memset(subkey, 0, CHACHA20_KEY_SIZE);
+}
+
+/*
+// Verify and decrypt a page in place. Returns 0, leaving the page unchanged,
+// if the page fails authentication. Pages beyond the end of the file, which
+// have never been written, are not passed to the codec by the pager.
+*/
+int
+CodecDecrypt(Codec* codec, int page, unsigned char* data, int len, int useWriteKey)
+{
+  unsigned char subkey[CHACHA20_KEY_SIZE];
+  unsigned char tag[CODEC_TAG_SIZE];
+  unsigned char dbHeader[8];
+  unsigned char* key = (useWriteKey) ? codec->m_writeKey : codec->m_readKey;
+  int n = len - CODEC_RESERVED;
+  unsigned char* nonce = data + n;
+  int ok;
+
+  if (page == 1 && data[20] < CODEC_RESERVED)
+  {
+    /* Header byte 20 is the number of reserved bytes per page */
+    return 0;
+  }
+
+  HChaCha20(subkey, key, nonce);
+  CodecChaCha20Tag(subkey, page, data, n, tag);
+  ok = (Poly1305TagCompare(tag, nonce + CODEC_NONCE_SIZE) == 0);
+  if (ok)
+  {
+    if (page == 1)
+    {
+      memcpy(dbHeader, data+16, 8);
+    }
+    ChaCha20Xor(data, n, subkey, codecZeroNonce, 1);
+    if (page == 1)
+    {
+      CodecUnstampKdf(dbHeader);
+      memcpy(data, SQLITE_FILE_HEADER, 16);
+      memcpy(data+16, dbHeader, 8);
+    }
+  }
+  memset(subkey, 0, CHACHA20_KEY_SIZE);
+  return ok;
+}
+
+#else /* CODEC_TYPE != CODEC_TYPE_CHACHA20 */
+
 void
 CodecEncrypt(Codec* codec, int page, unsigned char* data, int len, int useWriteKey)
 {
@@ -726,24 +1792,34 @@ CodecEncrypt(Codec* codec, int page, unsigned char* data, int len, int useWriteK
     memcpy(data+8,  data+16,  8);
 	/* Restore the unencrypted header bytes 16..23 */
     memcpy(data+16, dbHeader, 8);
+    CodecStampKdf(codec, data);
   }
 #endif
 }
 
-void
-CodecDecrypt(Codec* codec, int page, unsigned char* data, int len)
+/*
+// Decrypt a page in place. For page 1 the return value tells whether the
+// decrypted database header is valid, that is whether the key was correct.
+// For all other pages 1 is returned.
+*/
+int
+CodecDecrypt(Codec* codec, int page, unsigned char* data, int len, int useWriteKey)
 {
 #ifdef WXSQLITE3_USE_OLD_ENCRYPTION_SCHEME
   /* Use the previous encryption scheme */
-  CodecAES(codec, page, 0, codec->m_readKey, data, len, data);
+  unsigned char* key = (useWriteKey) ? codec->m_writeKey : codec->m_readKey;
+  CodecAES(codec, page, 0, key, data, len, data);
+  return (page != 1 || memcmp(data, SQLITE_FILE_HEADER, 16) == 0);
 #else
   unsigned char dbHeader[8];
   int dbPageSize;
   int offset = 0;
+  unsigned char* key = (useWriteKey) ? codec->m_writeKey : codec->m_readKey;
   if (page == 1)
   {
     /* Save (unencrypted) header bytes 16..23 */
     memcpy(dbHeader, data+16, 8);
+    CodecUnstampKdf(dbHeader);
 	/* Determine page size */
     dbPageSize = (dbHeader[0] << 8) | (dbHeader[1] << 16);
 	/* Check whether the database header is valid */
@@ -756,7 +1832,7 @@ CodecDecrypt(Codec* codec, int page, unsigned char* data, int len)
       offset = 16;
     }
   }
-  CodecAES(codec, page, 0, codec->m_readKey, data+offset, len-offset, data+offset);
+  CodecAES(codec, page, 0, key, data+offset, len-offset, data+offset);
   if (page == 1 && offset != 0)
   {
     /* Verify the database header */
@@ -765,6 +1841,316 @@ CodecDecrypt(Codec* codec, int page, unsigned char* data, int len)
       memcpy(data, SQLITE_FILE_HEADER, 16);
     }
   }
+  return (page != 1 || memcmp(data, SQLITE_FILE_HEADER, 16) == 0);
 #endif
 }
 
+#endif /* CODEC_TYPE */
+
+/*
+// Process-wide cache of decrypted pages, shared by all connections. Pooled
+// connections to the same encrypted database decrypt the same hot pages
+// (schema, interior B-tree pages) over and over. An entry holds the encrypted
+// and the decrypted image of a page and is identified by the key that
+// decrypted it and the page number. It is only used if the encrypted image
+// read by the pager is identical to the stored one, so that an entry never
+// has to be invalidated: a page changed by any connection or process, in
+// the WAL or in the database file, simply doesn't match anymore. A connection
+// using a different key never matches the entries of another key. Page 1 is
+// not cached, since its decryption updates the key derivation and the rekey
+// state of the codec. Entries are replaced in LRU order.
+*/
+typedef struct _CodecPageCacheEntry
+{
+  int           m_page;     /* Page number */
+  int           m_len;      /* Page size */
+  unsigned char m_key[KEYLENGTH];  /* Key used to decrypt the page */
+  struct _CodecPageCacheEntry* m_hashNext;  /* Next entry in hash chain */
+  struct _CodecPageCacheEntry* m_lruNext;   /* Next (older) entry in LRU list */
+  struct _CodecPageCacheEntry* m_lruPrev;   /* Previous (newer) entry */
+  unsigned char* m_cipher;  /* Encrypted image of the page */
+  unsigned char* m_plain;   /* Decrypted image of the page */
+} CodecPageCacheEntry;
+
+typedef struct _CodecPageCache
+{
+  sqlite3_mutex*        m_mutex;   /* Allocated on first use */
+  int                   m_nMax;    /* Maximum number of entries, 0 if disabled */
+  int                   m_nEntry;  /* Number of entries in use */
+  int                   m_nHash;   /* Number of hash slots, a power of 2 */
+  CodecPageCacheEntry** m_apHash;  /* Hash table, allocated on first use */
+  CodecPageCacheEntry*  m_lruHead; /* Most recently used entry */
+  CodecPageCacheEntry*  m_lruTail; /* Least recently used entry */
+} CodecPageCache;
+
+#define CODEC_PAGE_CACHE_MAX 0x100000
+
+static CodecPageCache codecPageCache = { NULL, CODEC_PAGE_CACHE_SIZE, 0, 0, NULL, NULL, NULL };
+
+static sqlite3_mutex*
+CodecPageCacheMutex(void)
+{
+  if (codecPageCache.m_mutex == NULL)
+  {
+    sqlite3_mutex* master = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_MASTER);
+    sqlite3_mutex_enter(master);
+    if (codecPageCache.m_mutex == NULL)
+    {
+      sqlite3_mutex* mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_FAST);
+      sqlite3MemoryBarrier();
+      codecPageCache.m_mutex = mutex;
+    }
+    sqlite3_mutex_leave(master);
+  }
+  return codecPageCache.m_mutex;
+}
+
+static int
+CodecPageCacheHash(CodecPageCache* cache, const unsigned char* key, int page)
+{
+  unsigned int h = (unsigned int) page * 0x9e3779b1u;
+  h ^= ((unsigned int) key[0] << 24) | (key[1] << 16) | (key[2] << 8) | key[3];
+  return (int) (h & (unsigned int) (cache->m_nHash - 1));
+}
+
+/*
+// Find the entry of a page. The cache mutex must be held.
+*/
+static CodecPageCacheEntry*
+CodecPageCacheFind(CodecPageCache* cache, const unsigned char* key, int page,
+                   const unsigned char* cipher, int len)
+{
+  CodecPageCacheEntry* entry = cache->m_apHash[CodecPageCacheHash(cache, key, page)];
+  while (entry != NULL &&
+         (entry->m_page != page || entry->m_len != len ||
+          memcmp(entry->m_key, key, KEYLENGTH) != 0 ||
+          memcmp(entry->m_cipher, cipher, len) != 0))
+  {
+    entry = entry->m_hashNext;
+  }
+  return entry;
+}
+
+static void
+CodecPageCacheLink(CodecPageCache* cache, CodecPageCacheEntry* entry)
+{
+  CodecPageCacheEntry** slot = &cache->m_apHash[CodecPageCacheHash(cache, entry->m_key, entry->m_page)];
+  entry->m_hashNext = *slot;
+  *slot = entry;
+  entry->m_lruPrev = NULL;
+  entry->m_lruNext = cache->m_lruHead;
+  if (cache->m_lruHead != NULL)
+  {
+    cache->m_lruHead->m_lruPrev = entry;
+  }
+  else
+  {
+    cache->m_lruTail = entry;
+  }
+  cache->m_lruHead = entry;
+  cache->m_nEntry++;
+}
+
+static void
+CodecPageCacheUnlink(CodecPageCache* cache, CodecPageCacheEntry* entry)
+{
+  CodecPageCacheEntry** pp = &cache->m_apHash[CodecPageCacheHash(cache, entry->m_key, entry->m_page)];
+  while (*pp != entry)
+  {
+    pp = &(*pp)->m_hashNext;
+  }
+  *pp = entry->m_hashNext;
+  if (entry->m_lruPrev != NULL)
+  {
+    entry->m_lruPrev->m_lruNext = entry->m_lruNext;
+  }
+  else
+  {
+    cache->m_lruHead = entry->m_lruNext;
+  }
+  if (entry->m_lruNext != NULL)
+  {
+    entry->m_lruNext->m_lruPrev = entry->m_lruPrev;
+  }
+  else
+  {
+    cache->m_lruTail = entry->m_lruPrev;
+  }
+  cache->m_nEntry--;
+}
+
+/*
+// Set the maximum number of pages of the shared page cache, if nPage >= 0.
+// Changing the size empties the cache. Returns the current size.
+*/
+int
+CodecPageCacheSize(int nPage)
+{
+  CodecPageCache* cache = &codecPageCache;
+  sqlite3_mutex* mutex = CodecPageCacheMutex();
+  int nHash;
+
+  sqlite3_mutex_enter(mutex);
+  if (nPage >= 0 && nPage != cache->m_nMax)
+  {
+    while (cache->m_lruHead != NULL)
+    {
+      CodecPageCacheEntry* entry = cache->m_lruHead;
+      CodecPageCacheUnlink(cache, entry);
+      sqlite3_free(entry);
+    }
+    sqlite3_free(cache->m_apHash);
+    cache->m_apHash = NULL;
+    cache->m_nHash = 0;
+    cache->m_nMax = (nPage > CODEC_PAGE_CACHE_MAX) ? CODEC_PAGE_CACHE_MAX : nPage;
+  }
+  if (cache->m_nMax > 0 && cache->m_apHash == NULL)
+  {
+    for (nHash = 64; nHash < cache->m_nMax; nHash *= 2);
+    cache->m_apHash = (CodecPageCacheEntry**) sqlite3MallocZero(sizeof(CodecPageCacheEntry*) * nHash);
+    cache->m_nHash = (cache->m_apHash != NULL) ? nHash : 0;
+    if (cache->m_apHash == NULL)
+    {
+      cache->m_nMax = 0;
+    }
+  }
+  nPage = cache->m_nMax;
+  sqlite3_mutex_leave(mutex);
+  return nPage;
+}
+
+/*
+// Decrypt a page in place like CodecDecrypt, taking the decrypted page from
+// the shared page cache if another connection decrypted the same encrypted
+// image with the same key before.
+*/
+int
+CodecDecryptShared(Codec* codec, int page, unsigned char* data, int len, int useWriteKey)
+{
+  CodecPageCache* cache = &codecPageCache;
+  unsigned char* key = (useWriteKey) ? codec->m_writeKey : codec->m_readKey;
+  CodecPageCacheEntry* entry;
+  sqlite3_mutex* mutex;
+  int ok;
+
+  if (cache->m_nMax == 0 || page == 1)
+  {
+    return CodecDecrypt(codec, page, data, len, useWriteKey);
+  }
+
+  mutex = CodecPageCacheMutex();
+  sqlite3_mutex_enter(mutex);
+  if (cache->m_apHash == NULL)
+  {
+    /* The compile-time default size has not been applied yet */
+    sqlite3_mutex_leave(mutex);
+    if (CodecPageCacheSize(-1) == 0)
+    {
+      return CodecDecrypt(codec, page, data, len, useWriteKey);
+    }
+    sqlite3_mutex_enter(mutex);
+  }
+  entry = (cache->m_nHash > 0) ? CodecPageCacheFind(cache, key, page, data, len) : NULL;
+  if (entry != NULL)
+  {
+    memcpy(data, entry->m_plain, len);
+    CodecPageCacheUnlink(cache, entry);
+    CodecPageCacheLink(cache, entry);
+    sqlite3_mutex_leave(mutex);
+    codec->m_nPageHit++;
+    return 1;
+  }
+  /* Take over the least recently used entry if the cache is full */
+  if (cache->m_nEntry > 0 && cache->m_nEntry >= cache->m_nMax)
+  {
+    entry = cache->m_lruTail;
+    CodecPageCacheUnlink(cache, entry);
+  }
+  sqlite3_mutex_leave(mutex);
+  codec->m_nPageMiss++;
+
+  /* The page is decrypted without holding the mutex */
+  if (entry != NULL && entry->m_len != len)
+  {
+    sqlite3_free(entry);
+    entry = NULL;
+  }
+  if (entry == NULL)
+  {
+    entry = (CodecPageCacheEntry*) sqlite3_malloc(sizeof(CodecPageCacheEntry) + 2 * len);
+    if (entry != NULL)
+    {
+      entry->m_len = len;
+      entry->m_cipher = (unsigned char*) &entry[1];
+      entry->m_plain = entry->m_cipher + len;
+    }
+  }
+  if (entry != NULL)
+  {
+    memcpy(entry->m_cipher, data, len);
+  }
+  ok = CodecDecrypt(codec, page, data, len, useWriteKey);
+  if (entry != NULL && ok)
+  {
+    entry->m_page = page;
+    memcpy(entry->m_key, key, KEYLENGTH);
+    memcpy(entry->m_plain, data, len);
+    sqlite3_mutex_enter(mutex);
+    if (cache->m_nHash > 0)
+    {
+      /* Drop the outdated images of the page. Another connection may */
+      /* have added the same image meanwhile. */
+      CodecPageCacheEntry* other = cache->m_apHash[CodecPageCacheHash(cache, key, page)];
+      while (other != NULL)
+      {
+        CodecPageCacheEntry* next = other->m_hashNext;
+        if (other->m_page == page && memcmp(other->m_key, key, KEYLENGTH) == 0)
+        {
+          CodecPageCacheUnlink(cache, other);
+          sqlite3_free(other);
+        }
+        other = next;
+      }
+    }
+    /* The cache may have been resized meanwhile */
+    if (cache->m_nEntry < cache->m_nMax)
+    {
+      CodecPageCacheLink(cache, entry);
+      entry = NULL;
+    }
+    sqlite3_mutex_leave(mutex);
+  }
+  sqlite3_free(entry);
+  return ok;
+}
+
+/*
+// Wipe and free the process-wide caches of derived keys and decrypted
+// pages, and the mutex of the page cache, so that neither key material
+// nor plaintext outlives the memory allocator. The size of the page cache
+// is kept. (called from sqlite3_shutdown)
+*/
+void
+CodecShutdown(void)
+{
+  CodecPageCache* cache = &codecPageCache;
+  while (cache->m_lruHead != NULL)
+  {
+    CodecPageCacheEntry* entry = cache->m_lruHead;
+    CodecPageCacheUnlink(cache, entry);
+    memset(entry, 0, sizeof(CodecPageCacheEntry) + 2 * entry->m_len);
+    sqlite3_free(entry);
+  }
+  sqlite3_free(cache->m_apHash);
+  cache->m_apHash = NULL;
+  cache->m_nHash = 0;
+  if (cache->m_mutex != NULL)
+  {
+    sqlite3_mutex_free(cache->m_mutex);
+    cache->m_mutex = NULL;
+  }
+#if CODEC_KDF_CACHE_SIZE > 0
+  memset(codecKdfCache, 0, sizeof(codecKdfCache));
+  codecKdfCacheNext = 0;
+#endif
+}
@@ -42,18 +42,139 @@ extern "C" {
 #include "btreeInt.h"
 #define CODEC_TYPE_AES128 1
 #define CODEC_TYPE_AES256 2
+#define CODEC_TYPE_CHACHA20 3
 
 #ifndef CODEC_TYPE
 #define CODEC_TYPE CODEC_TYPE_AES128
 #endif
 
-#if CODEC_TYPE == CODEC_TYPE_AES256
+#if CODEC_TYPE == CODEC_TYPE_AES256 || CODEC_TYPE == CODEC_TYPE_CHACHA20
 #define KEYLENGTH 32
 #define CODEC_SHA_ITER 4001
+#define CODEC_USE_SHA256 1
 #else
 #define KEYLENGTH 16
 #endif
 
+/*
+// Bytes reserved at the end of each page. The authenticated cipher
+// ChaCha20-Poly1305 stores the random nonce and the tag of a page there.
+*/
+#if CODEC_TYPE == CODEC_TYPE_CHACHA20
+#define CODEC_NONCE_SIZE 16
+#define CODEC_TAG_SIZE   16
+#define CODEC_RESERVED   (CODEC_NONCE_SIZE + CODEC_TAG_SIZE)
+#else
+#define CODEC_RESERVED   0
+#endif
+
+/*
+// Number of per-page AES key schedules kept by each codec.
+// Define as 0 to derive the page key on every page access.
+*/
+#ifndef CODEC_KEY_CACHE_SIZE
+#define CODEC_KEY_CACHE_SIZE 256
+#endif
+
+/*
+// Number of consecutive pages whose keys are derived at once when the key
+// cache misses pages in ascending order. Define as 1 to derive the key of
+// the requested page only.
+*/
+#ifndef CODEC_KEY_PREFETCH
+#define CODEC_KEY_PREFETCH 8
+#endif
+
+#define CODEC_KEY_READ  0
+#define CODEC_KEY_WRITE 1
+
+/*
+// Salted key derivation (PBKDF2-HMAC-SHA256). A database using it stores
+// the salt in bytes 0..7 of page 1, which hold no information in the
+// encrypted page, the marker CODEC_KDF_MARKER in header byte 21 and the
+// number of iterations in units of CODEC_KDF_ITER_UNIT in bytes 22..23.
+// The codec restores the standard values of these bytes on decryption.
+// Databases without the marker use the legacy unsalted key derivation.
+*/
+#define CODEC_SALT_SIZE      8
+#define CODEC_KDF_MARKER     0x50
+#define CODEC_KDF_ITER_UNIT  1000
+#define CODEC_KDF_ITER_MAX   (0xffff * CODEC_KDF_ITER_UNIT)
+
+/*
+// Default number of iterations of the salted key derivation for new
+// databases, 0 to use the legacy key derivation
+*/
+#ifndef CODEC_KDF_ITER
+#define CODEC_KDF_ITER 0
+#endif
+
+/*
+// Number of derived keys kept in the process-wide key derivation cache.
+// Define as 0 to run the key derivation on every key setup.
+*/
+#ifndef CODEC_KDF_CACHE_SIZE
+#define CODEC_KDF_CACHE_SIZE 16
+#endif
+
+#define CODEC_SECRET_SIZE 32
+
+/*
+// Default number of decrypted pages kept in the process-wide page cache
+// shared by all connections (see PRAGMA codec_page_cache).
+// Define as 0 to leave the cache disabled until it is sized at run time.
+*/
+#ifndef CODEC_PAGE_CACHE_SIZE
+#define CODEC_PAGE_CACHE_SIZE 0
+#endif
+
+/*
+// Offsets of the stepwise rekey state in the database header (page 1).
+// The bytes are part of the area SQLite reserves for expansion. They are
+// only set on disk while a rekey is in progress and are written by the codec.
+*/
+#define CODEC_REKEY_PAGE_OFFSET  72
+#define CODEC_REKEY_CHECK_OFFSET 76
+
+/*
+// Cached AES state of a single page: the page key and the initial vector
+// derived from the master key, expanded into the round keys of one direction
+*/
+typedef struct _CodecKeyCacheEntry
+{
+  int           m_page;     /* Page number, 0 if the entry is not in use */
+  int           m_keyId;    /* CODEC_KEY_READ or CODEC_KEY_WRITE */
+  int           m_encrypt;  /* True if the schedule is for encryption */
+  struct _CodecKeyCacheEntry* m_hashNext;  /* Next entry in hash chain */
+  struct _CodecKeyCacheEntry* m_lruNext;   /* Next (older) entry in LRU list */
+  struct _CodecKeyCacheEntry* m_lruPrev;   /* Previous (newer) entry */
+  Rijndael      m_aes;
+} CodecKeyCacheEntry;
+
+/*
+// Bounded LRU cache of page key schedules, allocated on first use.
+// The cache is protected by the mutex of the codec.
+*/
+typedef struct _CodecKeyCache
+{
+  int                  m_nEntry;  /* Number of entries in use */
+  CodecKeyCacheEntry*  m_aEntry;  /* Array of CODEC_KEY_CACHE_SIZE entries */
+  CodecKeyCacheEntry** m_apHash;  /* Hash table of CODEC_KEY_CACHE_SIZE slots */
+  CodecKeyCacheEntry*  m_lruHead; /* Most recently used entry */
+  CodecKeyCacheEntry*  m_lruTail; /* Least recently used entry */
+  int                  m_nHit;    /* Number of cache hits */
+  int                  m_nMiss;   /* Number of cache misses */
+  int                  m_lastMiss; /* Last page of the current run of misses */
+} CodecKeyCache;
+
+/*
+// The key material of a codec is only modified while no page is being
+// processed (key setup and rekey). Encryption and decryption keep their
+// cipher state on the stack of the caller, and the key cache has its own
+// mutex, so several threads may encrypt or decrypt pages of the same codec
+// at once. The page buffer is only used by sqlite3Codec for the pager, which
+// serializes its calls.
+*/
 typedef struct _Codec
 {
   int           m_isEncrypted;
@@ -61,27 +182,70 @@ typedef struct _Codec
   unsigned char m_readKey[KEYLENGTH];
   int           m_hasWriteKey;
   unsigned char m_writeKey[KEYLENGTH];
-  Rijndael*     m_aes;
+  int           m_kdfIter;         /* PBKDF2 iterations, 0 for the legacy key derivation */
+  unsigned char m_kdfSalt[CODEC_SALT_SIZE];
+  int           m_readRaw;         /* True if the read key was given as raw key */
+  unsigned char m_readSecret[CODEC_SECRET_SIZE];   /* SHA-256 of the read password */
+  int           m_writeRaw;        /* True if the write key was given as raw key */
+  unsigned char m_writeSecret[CODEC_SECRET_SIZE];  /* SHA-256 of the write password */
+  sqlite3_mutex* m_mutex;   /* Protects m_keyCache */
+  CodecKeyCache m_keyCache;
+  int           m_nPageHit;   /* Pages found in the shared page cache */
+  int           m_nPageMiss;  /* Pages decrypted while the shared cache is enabled */
+
+  int           m_rekeyActive;   /* True while a stepwise rekey is in progress */
+  int           m_rekeyPage;     /* Last page encrypted with the write key */
+  int           m_rekeyPending;  /* Same, for pages written by the current transaction */
+  int           m_rekeyFinal;    /* True if the current transaction switches page 1 */
 
   Btree*        m_bt; /* Pointer to B-tree used by DB */
-  unsigned char m_page[SQLITE_MAX_PAGE_SIZE+24];
+  int           m_pageSize;        /* Page size reported by the pager, 0 if unknown */
+  int           m_reserved;        /* Reserved bytes per page */
+  int           m_pageBufferSize;  /* Usable size of m_page */
+  unsigned char* m_page;           /* Output buffer for encrypted pages */
 } Codec;
 
-void CodecInit(Codec* codec);
+int CodecInit(Codec* codec);
 void CodecTerm(Codec* codec);
 
 void CodecCopy(Codec* codec, Codec* other);
 
+void CodecGeneratePasswordKey(Codec* codec, char* userPassword, int passwordLength,
+                              unsigned char secret[CODEC_SECRET_SIZE], unsigned char key[KEYLENGTH]);
+
 void CodecGenerateReadKey(Codec* codec, char* userPassword, int passwordLength);
 
 void CodecGenerateWriteKey(Codec* codec, char* userPassword, int passwordLength);
 
+void CodecSetRawReadKey(Codec* codec, const unsigned char* key);
+
+void CodecSetRawWriteKey(Codec* codec, const unsigned char* key);
+
+int CodecGetKdfHeader(const unsigned char* header, int* iter, unsigned char salt[CODEC_SALT_SIZE]);
+void CodecSetKdf(Codec* codec, int iter, const unsigned char salt[CODEC_SALT_SIZE]);
+void CodecNewKdf(Codec* codec, int iter);
+int CodecUpdateKdf(Codec* codec, const unsigned char* header);
+
+void CodecPbkdf2(const unsigned char* password, int passwordLength,
+                 const unsigned char* salt, int saltLength, int iter,
+                 unsigned char* key, int keyLength);
+
 void CodecEncrypt(Codec* codec, int page, unsigned char* data, int len, int useWriteKey);
 
-void CodecDecrypt(Codec* codec, int page, unsigned char* data, int len);
+int CodecDecrypt(Codec* codec, int page, unsigned char* data, int len, int useWriteKey);
+
+int CodecDecryptShared(Codec* codec, int page, unsigned char* data, int len, int useWriteKey);
+int CodecPageCacheSize(int nPage);
+void CodecShutdown(void);
 
 void CodecCopyKey(Codec* codec, int read2write);
 
+int CodecRekeyUsesWriteKey(Codec* codec, int page, int pending);
+unsigned int CodecRekeyCheck(Codec* codec, unsigned char key[KEYLENGTH]);
+
+void CodecKeyCacheClear(Codec* codec);
+void CodecKeyCacheStat(Codec* codec, int op, int resetFlag, int* pValue);
+
 void CodecSetIsEncrypted(Codec* codec, int isEncrypted);
 void CodecSetHasReadKey(Codec* codec, int hasReadKey);
 void CodecSetHasWriteKey(Codec* codec, int hasWriteKey);
@@ -92,6 +256,7 @@ int CodecHasReadKey(Codec* codec);
 int CodecHasWriteKey(Codec* codec);
 Btree* CodecGetBtree(Codec* codec);
 unsigned char* CodecGetPageBuffer(Codec* codec);
+int CodecSetPageSize(Codec* codec, int pageSize);
 
 void CodecGenerateEncryptionKey(Codec* codec, char* userPassword, int passwordLength, 
                                 unsigned char encryptionKey[KEYLENGTH]);
@@ -104,7 +269,7 @@ void CodecRC4(Codec* codec, unsigned char* key, int keylen,
 
 void CodecGetMD5Binary(Codec* codec, unsigned char* data, int length, unsigned char* digest);
 
-#if CODEC_TYPE == CODEC_TYPE_AES256
+#ifdef CODEC_USE_SHA256
 void CodecGetSHABinary(Codec* codec, unsigned char* data, int length, unsigned char* digest);
 #endif
   
@@ -25,6 +25,85 @@ void sqlite3CodecFree(void *pCodecArg)
 
 void sqlite3CodecSizeChange(void *pArg, int pageSize, int reservedSize)
 {
+  /* A failure is reported by sqlite3Codec when the buffer is needed */
+  CodecSetPageSize((Codec*) pArg, pageSize);
+  ((Codec*) pArg)->m_pageSize = pageSize;
+  ((Codec*) pArg)->m_reserved = reservedSize;
+}
+
+/*
+// Add the key cache or shared page cache hit or miss counter of a codec
+// to *pValue
+// (called from sqlite3_db_status)
+*/
+void sqlite3CodecCacheStat(void *pCodecArg, int op, int resetFlag, int *pValue)
+{
+  CodecKeyCacheStat((Codec*) pCodecArg, op, resetFlag, pValue);
+}
+
+/*
+// Write the state of a stepwise rekey into the header of an encrypted copy
+// of page 1. The header records the last page encrypted with the new key
+// and a check value of the new key, so that an interrupted rekey can be
+// resumed. Both values are cleared by the final rekey step.
+*/
+static void rekeyStampHeader(Codec* codec, unsigned char* data, int pending)
+{
+  if (pending && codec->m_rekeyFinal)
+  {
+    memset(data+CODEC_REKEY_PAGE_OFFSET, 0, 8);
+  }
+  else
+  {
+    sqlite3Put4byte(data+CODEC_REKEY_PAGE_OFFSET,
+                    (pending) ? codec->m_rekeyPending : codec->m_rekeyPage);
+    sqlite3Put4byte(data+CODEC_REKEY_CHECK_OFFSET,
+                    CodecRekeyCheck(codec, codec->m_writeKey));
+  }
+}
+
+/*
+// Check whether a page has been encrypted with the new key by a stepwise
+// rekey of another connection, as recorded in the header of page 1. This
+// connection only has the old key, so it can neither decrypt the page nor
+// overwrite it.
+*/
+static int rekeyForeignPage(Codec* codec, Pgno nPageNum)
+{
+  return !codec->m_rekeyActive && nPageNum != 1 && nPageNum <= (Pgno) codec->m_rekeyPage;
+}
+
+/*
+// Return the error code for a page the codec failed to decode (bDecode) or
+// encode: SQLITE_BUSY for a page encrypted with the new key of a rekey in
+// progress on another connection, SQLITE_READONLY for a page to encode
+// without room for the nonce and tag of the cipher, 0 for a page that
+// failed authentication.
+// (called from the modified code in pager.c)
+*/
+int sqlite3CodecPageError(void* pCodecArg, Pgno nPageNum, int bDecode)
+{
+  Codec* codec = (Codec*) pCodecArg;
+  if (codec == NULL)
+  {
+    return 0;
+  }
+  if (rekeyForeignPage(codec, nPageNum))
+  {
+    sqlite3_log(SQLITE_BUSY, "page %d is encrypted with the new key of a rekey in progress;"
+                             " supply the new key with sqlite3_rekey_init()", nPageNum);
+    return SQLITE_BUSY;
+  }
+  if (!bDecode && codec->m_reserved < CODEC_RESERVED)
+  {
+    /* Backup keeps the page geometry of its source, which may be a */
+    /* plain database without reserved bytes */
+    sqlite3_log(SQLITE_READONLY, "page %d has %d reserved bytes, the cipher needs %d;"
+                                 " the source of a backup to an encrypted database must reserve them too",
+                nPageNum, codec->m_reserved, CODEC_RESERVED);
+    return SQLITE_READONLY;
+  }
+  return 0;
 }
 
 /*
@@ -34,6 +113,7 @@ void* sqlite3Codec(void* pCodecArg, void* data, Pgno nPageNum, int nMode)
 {
   Codec* codec = NULL;
   int pageSize;
+  int useWriteKey;
   if (pCodecArg == NULL)
   {
     return data;
@@ -44,26 +124,104 @@ void* sqlite3Codec(void* pCodecArg, void* data, Pgno nPageNum, int nMode)
     return data;
   }
   
-  pageSize = sqlite3BtreeGetPageSize(CodecGetBtree(codec));
+  /* The pager reports the page size of the file, which differs from the */
+  /* page size of the B-tree while a backup writes a new page geometry */
+  pageSize = codec->m_pageSize;
+  if (pageSize <= 0)
+  {
+    pageSize = sqlite3BtreeGetPageSize(CodecGetBtree(codec));
+  }
 
   switch(nMode)
   {
     case 0: /* Undo a "case 7" journal file encryption */
     case 2: /* Reload a page */
     case 3: /* Load a page */
+      /* A NULL result tells the pager that the page failed authentication, */
+      /* so decoding must not fail for any other reason */
       if (CodecHasReadKey(codec))
       {
-        CodecDecrypt(codec, nPageNum, (unsigned char*) data, pageSize);
+        if (nPageNum == 1)
+        {
+          /* Another connection may have created the database with a different salt */
+          CodecUpdateKdf(codec, (unsigned char*) data);
+        }
+        if (nPageNum == 1 && codec->m_rekeyActive && CodecSetPageSize(codec, pageSize) == SQLITE_OK)
+        {
+          /* During a stepwise rekey page 1 is encrypted with the old key, */
+          /* unless another connection has completed the rekey meanwhile */
+          unsigned char* pageBuffer = CodecGetPageBuffer(codec);
+          memcpy(pageBuffer, data, pageSize);
+          if (!CodecDecrypt(codec, nPageNum, (unsigned char*) data, pageSize, 0))
+          {
+            memcpy(data, pageBuffer, pageSize);
+            if (CodecDecrypt(codec, nPageNum, (unsigned char*) data, pageSize, 1))
+            {
+              CodecCopyKey(codec, 0);
+              codec->m_rekeyActive = 0;
+            }
+          }
+        }
+        else
+        {
+          useWriteKey = codec->m_rekeyActive && CodecRekeyUsesWriteKey(codec, nPageNum, 0);
+          if (nPageNum != 1 && (codec->m_reserved < CODEC_RESERVED || rekeyForeignPage(codec, nPageNum)))
+          {
+            return NULL;
+          }
+          if (!CodecDecryptShared(codec, nPageNum, (unsigned char*) data, pageSize, useWriteKey))
+          {
+            if (nPageNum != 1)
+            {
+              return NULL;
+            }
+            /* Page 1 is not returned as is, since an unauthenticated page */
+            /* might still carry a plain header; SQLite reports an invalid header */
+            memset(data, 0, 16);
+          }
+        }
+        if (nPageNum == 1)
+        {
+          /* Pick up the progress of a stepwise rekey */
+          codec->m_rekeyPage = sqlite3Get4byte((unsigned char*) data+CODEC_REKEY_PAGE_OFFSET);
+          codec->m_rekeyPending = codec->m_rekeyPage;
+          codec->m_rekeyFinal = 0;
+        }
       }
       break;
 
     case 6: /* Encrypt a page for the main database file */
+    case 8: /* Encrypt a copy of a page for the main database file in place */
+      /* Mode 8 is used by the pager to encrypt several pages at once in */
+      /* different threads, so it must not use the page buffer of the codec */
       if (CodecHasWriteKey(codec))
       {
-        unsigned char* pageBuffer = CodecGetPageBuffer(codec);
-        memcpy(pageBuffer, data, pageSize);
-        data = pageBuffer;
-        CodecEncrypt(codec, nPageNum, (unsigned char*) data, pageSize, 1);
+        if (codec->m_reserved < CODEC_RESERVED || rekeyForeignPage(codec, nPageNum))
+        {
+          return NULL;
+        }
+        if (nMode == 6)
+        {
+          unsigned char* pageBuffer;
+          if (CodecSetPageSize(codec, pageSize) != SQLITE_OK)
+          {
+            return NULL;
+          }
+          pageBuffer = CodecGetPageBuffer(codec);
+          memcpy(pageBuffer, data, pageSize);
+          data = pageBuffer;
+        }
+        useWriteKey = 1;
+        if (codec->m_rekeyActive)
+        {
+          /* Pages of the current rekey step get the new key on commit */
+          useWriteKey = CodecRekeyUsesWriteKey(codec, nPageNum, 1);
+          if (nPageNum == 1)
+          {
+            rekeyStampHeader(codec, (unsigned char*) data, 1);
+          }
+        }
+        CodecEncrypt(codec, nPageNum, (unsigned char*) data, pageSize, useWriteKey);
       }
       break;
 
@@ -75,19 +233,136 @@ void* sqlite3Codec(void* pCodecArg, void* data, Pgno nPageNum, int nMode)
          Therefore, for case 7, when the rollback is being written, always encrypt using
          the database's readkey, which is guaranteed to be the same key that was used to
          read the original data.
+         During a stepwise rekey the original key of a page depends on the committed
+         rekey progress.
       */
       if (CodecHasReadKey(codec))
       {
-        unsigned char* pageBuffer = CodecGetPageBuffer(codec);
+        unsigned char* pageBuffer;
+        if (codec->m_reserved < CODEC_RESERVED || rekeyForeignPage(codec, nPageNum) ||
+            CodecSetPageSize(codec, pageSize) != SQLITE_OK)
+        {
+          return NULL;
+        }
+        pageBuffer = CodecGetPageBuffer(codec);
         memcpy(pageBuffer, data, pageSize);
         data = pageBuffer;
-        CodecEncrypt(codec, nPageNum, (unsigned char*) data, pageSize, 0);
+        useWriteKey = 0;
+        if (codec->m_rekeyActive)
+        {
+          useWriteKey = CodecRekeyUsesWriteKey(codec, nPageNum, 0);
+          if (nPageNum == 1)
+          {
+            rekeyStampHeader(codec, pageBuffer, 0);
+          }
+        }
+        CodecEncrypt(codec, nPageNum, (unsigned char*) data, pageSize, useWriteKey);
       }
       break;
   }
   return data;
 }
 
+/*
+// Reserve the bytes per page the cipher needs for its nonce and tag.
+// For a database that already has content this takes effect on VACUUM.
+*/
+static void codecReserveBytes(Btree* pBt)
+{
+#if CODEC_RESERVED > 0
+  sqlite3BtreeSetPageSize(pBt, 0, CODEC_RESERVED, 0);
+#endif
+}
+
+/*
+// Number of iterations of the salted key derivation for new databases
+*/
+static int codecKdfIter = CODEC_KDF_ITER;
+
+/*
+// Set the number of iterations of the salted key derivation used for
+// databases encrypted from now on, if iter >= 0. Returns the current value.
+// (called from PRAGMA kdf_iter)
+*/
+int sqlite3CodecKdfIter(int iter)
+{
+  if (iter >= 0)
+  {
+    if (iter > CODEC_KDF_ITER_MAX)
+    {
+      iter = CODEC_KDF_ITER_MAX;
+    }
+    codecKdfIter = (iter + CODEC_KDF_ITER_UNIT - 1) / CODEC_KDF_ITER_UNIT * CODEC_KDF_ITER_UNIT;
+  }
+  return codecKdfIter;
+}
+
+/*
+// Set the number of decrypted pages kept in the page cache shared by all
+// connections of the process, if nPage >= 0. Returns the current value.
+// (called from PRAGMA codec_page_cache)
+*/
+int sqlite3CodecPageCache(int nPage)
+{
+  return CodecPageCacheSize(nPage);
+}
+
+/*
+// Wipe and free the process-wide codec caches
+// (called from sqlite3_shutdown)
+*/
+void sqlite3CodecShutdown(void)
+{
+  CodecShutdown();
+}
+
+/*
+// Set up the key derivation of a codec from the header of the database
+// file, before the key is generated. An empty database gets a fresh salt
+// if newIter > 0. A codec copied from the main database (newIter < 0)
+// keeps its parameters for an empty database, and derives its keys anew
+// if the database uses a different salt.
+// The header is read from the file directly, since the salt of an
+// encrypted database never changes once it has been written.
+*/
+static void codecLoadKdf(Codec* codec, Btree* pBt, int newIter)
+{
+  sqlite3_file* fd = sqlite3PagerFile(sqlite3BtreePager(pBt));
+  unsigned char header[24];
+  unsigned char salt[CODEC_SALT_SIZE];
+  int isEmpty;
+  int iter;
+  int j;
+
+  memset(header, 0, sizeof(header));
+  if (fd->pMethods != NULL && sqlite3OsRead(fd, header, sizeof(header), 0) != SQLITE_OK)
+  {
+    memset(header, 0, sizeof(header));
+  }
+  for (j = 16; j < 24 && header[j] == 0; j++);
+  isEmpty = (j == 24);
+
+  if (newIter < 0)
+  {
+    if (!isEmpty)
+    {
+      CodecUpdateKdf(codec, header);
+    }
+  }
+  else if (CodecGetKdfHeader(header, &iter, salt))
+  {
+    CodecSetKdf(codec, iter, salt);
+  }
+  else if (isEmpty)
+  {
+    CodecNewKdf(codec, newIter);
+  }
+  else
+  {
+    CodecSetKdf(codec, 0, salt);
+  }
+}
+
 void* mySqlite3PagerGetCodec(
   Pager *pPager
 );
@@ -100,11 +375,19 @@ void mySqlite3PagerSetCodec(
   void *pCodec
 );
 
-int sqlite3CodecAttach(sqlite3* db, int nDb, const void* zKey, int nKey)
+static int codecAttach(sqlite3* db, int nDb, const void* zKey, int nKey, int isRaw)
 {
   /* Attach a key to a database. */
   Codec* codec = (Codec*) sqlite3_malloc(sizeof(Codec));
-  CodecInit(codec);
+  if (codec == NULL)
+  {
+    return SQLITE_NOMEM;
+  }
+  if (CodecInit(codec) != SQLITE_OK)
+  {
+    sqlite3CodecFree(codec);
+    return SQLITE_NOMEM;
+  }
 
   sqlite3_mutex_enter(db->mutex);
 
@@ -120,8 +403,10 @@ int sqlite3CodecAttach(sqlite3* db, int nDb, const void* zKey, int nKey)
       {
         CodecCopy(codec, mainCodec);
         CodecSetBtree(codec, db->aDb[nDb].pBt);
+        codecLoadKdf(codec, db->aDb[nDb].pBt, -1);
 #if (SQLITE_VERSION_NUMBER >= 3006016)
         mySqlite3PagerSetCodec(sqlite3BtreePager(db->aDb[nDb].pBt), sqlite3Codec, sqlite3CodecSizeChange, sqlite3CodecFree, codec);
+        codecReserveBytes(db->aDb[nDb].pBt);
 #else
 #if (SQLITE_VERSION_NUMBER >= 3003014)
         sqlite3PagerSetCodec(sqlite3BtreePager(db->aDb[nDb].pBt), sqlite3Codec, codec);
@@ -135,9 +420,13 @@ int sqlite3CodecAttach(sqlite3* db, int nDb, const void* zKey, int nKey)
       else
       {
         CodecSetIsEncrypted(codec, 0);
-        sqlite3_free(codec);
+        sqlite3CodecFree(codec);
       }
     }
+    else
+    {
+      sqlite3CodecFree(codec);
+    }
   }
   else
   {
@@ -145,11 +434,21 @@ int sqlite3CodecAttach(sqlite3* db, int nDb, const void* zKey, int nKey)
     CodecSetIsEncrypted(codec, 1);
     CodecSetHasReadKey(codec, 1);
     CodecSetHasWriteKey(codec, 1);
-    CodecGenerateReadKey(codec, (char*) zKey, nKey);
+    /* A raw key bypasses the key derivation, the salt is of no use for it */
+    codecLoadKdf(codec, db->aDb[nDb].pBt, (isRaw) ? 0 : codecKdfIter);
+    if (isRaw)
+    {
+      CodecSetRawReadKey(codec, (const unsigned char*) zKey);
+    }
+    else
+    {
+      CodecGenerateReadKey(codec, (char*) zKey, nKey);
+    }
     CodecCopyKey(codec, 1);
     CodecSetBtree(codec, db->aDb[nDb].pBt);
 #if (SQLITE_VERSION_NUMBER >= 3006016)
     mySqlite3PagerSetCodec(sqlite3BtreePager(db->aDb[nDb].pBt), sqlite3Codec, sqlite3CodecSizeChange, sqlite3CodecFree, codec);
+    codecReserveBytes(db->aDb[nDb].pBt);
 #else
 #if (SQLITE_VERSION_NUMBER >= 3003014)
     sqlite3PagerSetCodec(sqlite3BtreePager(db->aDb[nDb].pBt), sqlite3Codec, codec);
@@ -166,6 +465,47 @@ int sqlite3CodecAttach(sqlite3* db, int nDb, const void* zKey, int nKey)
   return SQLITE_OK;
 }
 
+int sqlite3CodecAttach(sqlite3* db, int nDb, const void* zKey, int nKey)
+{
+  return codecAttach(db, nDb, zKey, nKey, 0);
+}
+
+/*
+// Give database nDb of db the keys of database nSrc of dbSrc, so that a
+// private connection can open an encrypted database without the password.
+// (called for the connection of a background checkpointer)
+*/
+int sqlite3CodecShare(sqlite3* db, int nDb, sqlite3* dbSrc, int nSrc)
+{
+  Codec* srcCodec = (Codec*) mySqlite3PagerGetCodec(sqlite3BtreePager(dbSrc->aDb[nSrc].pBt));
+  Codec* codec;
+
+  if (srcCodec == NULL || !CodecIsEncrypted(srcCodec))
+  {
+    return SQLITE_OK;
+  }
+  codec = (Codec*) sqlite3_malloc(sizeof(Codec));
+  if (codec == NULL)
+  {
+    return SQLITE_NOMEM;
+  }
+  if (CodecInit(codec) != SQLITE_OK)
+  {
+    sqlite3CodecFree(codec);
+    return SQLITE_NOMEM;
+  }
+
+  sqlite3_mutex_enter(db->mutex);
+  CodecCopy(codec, srcCodec);
+  CodecSetBtree(codec, db->aDb[nDb].pBt);
+  codecLoadKdf(codec, db->aDb[nDb].pBt, -1);
+  mySqlite3PagerSetCodec(sqlite3BtreePager(db->aDb[nDb].pBt), sqlite3Codec, sqlite3CodecSizeChange, sqlite3CodecFree, codec);
+  codecReserveBytes(db->aDb[nDb].pBt);
+  sqlite3_mutex_leave(db->mutex);
+
+  return SQLITE_OK;
+}
+
 void sqlite3CodecGetKey(sqlite3* db, int nDb, void** zKey, int* nKey)
 {
   /*
@@ -215,6 +555,17 @@ int sqlite3_key_v2(sqlite3 *db, const char *zDbName, const void *zKey, int nKey)
   return sqlite3CodecAttach(db, dbIndex, zKey, nKey);
 }
 
+int sqlite3_key_raw_v2(sqlite3 *db, const char *zDbName, const void *pKey, int nKey)
+{
+  /* The key is used as is, without key derivation */
+  int dbIndex = dbFindIndex(db, zDbName);
+  if (pKey == NULL || nKey != KEYLENGTH)
+  {
+    return SQLITE_ERROR;
+  }
+  return codecAttach(db, dbIndex, pKey, nKey, 1);
+}
+
 int sqlite3_rekey_v2(sqlite3 *db, const char *zDbName, const void *zKey, int nKey)
 {
   /* Changes the encryption key for an existing database. */
@@ -224,6 +575,15 @@ int sqlite3_rekey_v2(sqlite3 *db, const char *zDbName, const void *zKey, int nKe
   Pager* pPager = sqlite3BtreePager(pbt);
   Codec* codec = (Codec*) mySqlite3PagerGetCodec(pPager);
 
+  if (codec != NULL && codec->m_rekeyActive)
+  {
+    /*
+    // A stepwise rekey is in progress,
+    // it has to be completed first
+    */
+    return SQLITE_ERROR;
+  }
+
   if ((zKey == NULL || nKey == 0) && (codec == NULL || !CodecIsEncrypted(codec)))
   {
     /*
@@ -239,19 +599,53 @@ int sqlite3_rekey_v2(sqlite3 *db, const char *zDbName, const void *zKey, int nKe
     // Database not encrypted, but key specified
     // therefore encrypt database
 	*/
+#if CODEC_RESERVED > 0
+    /* Make room for the nonce and tag on every page before the key is set, */
+    /* VACUUM is only available for the main database */
+    rc = SQLITE_OK;
+    sqlite3_mutex_enter(db->mutex);
+    sqlite3BtreeEnter(pbt);
+    if (dbIndex == 0 && sqlite3BtreeGetReserveNoMutex(pbt) < CODEC_RESERVED)
+    {
+      char* zErrMsg = NULL;
+      sqlite3BtreeLeave(pbt);
+      sqlite3BtreeSetPageSize(pbt, 0, CODEC_RESERVED, 0);
+      rc = sqlite3RunVacuum(&zErrMsg, db);
+      sqlite3DbFree(db, zErrMsg);
+    }
+    else
+    {
+      sqlite3BtreeLeave(pbt);
+    }
+    sqlite3_mutex_leave(db->mutex);
+    if (rc != SQLITE_OK)
+    {
+      return rc;
+    }
+#endif
     if (codec == NULL)
     {
       codec = (Codec*) sqlite3_malloc(sizeof(Codec));
-	    CodecInit(codec);
+      if (codec == NULL)
+      {
+        return SQLITE_NOMEM;
+      }
+      if (CodecInit(codec) != SQLITE_OK)
+      {
+        sqlite3CodecFree(codec);
+        return SQLITE_NOMEM;
+      }
     }
 
     CodecSetIsEncrypted(codec, 1);
     CodecSetHasReadKey(codec, 0); /* Original database is not encrypted */
     CodecSetHasWriteKey(codec, 1);
+    CodecNewKdf(codec, codecKdfIter);
     CodecGenerateWriteKey(codec, (char*) zKey, nKey);
     CodecSetBtree(codec, pbt);
 #if (SQLITE_VERSION_NUMBER >= 3006016)
     mySqlite3PagerSetCodec(pPager, sqlite3Codec, sqlite3CodecSizeChange, sqlite3CodecFree, codec);
+    codecReserveBytes(pbt);
 #else
 #if (SQLITE_VERSION_NUMBER >= 3003014)
     sqlite3PagerSetCodec(pPager, sqlite3Codec, codec);
@@ -286,6 +680,18 @@ int sqlite3_rekey_v2(sqlite3 *db, const char *zDbName, const void *zKey, int nKe
 
   /* Start transaction */
   rc = sqlite3BtreeBeginTrans(pbt, 1);
+#if CODEC_RESERVED > 0
+  if (!rc && CodecHasWriteKey(codec))
+  {
+    /* Pages without room for the nonce and tag can't be encrypted */
+    sqlite3BtreeEnter(pbt);
+    if (sqlite3BtreeGetReserveNoMutex(pbt) < CODEC_RESERVED)
+    {
+      rc = SQLITE_ERROR;
+    }
+    sqlite3BtreeLeave(pbt);
+  }
+#endif
   if (!rc)
   {
     int pageSize = sqlite3BtreeGetPageSize(pbt);
@@ -406,6 +812,255 @@ int sqlite3_rekey(sqlite3 *db, const void *zKey, int nKey)
   return sqlite3_rekey_v2(db, "main", zKey, nKey);
 }
 
+/*
+// Stepwise rekey of an encrypted database (see sqlite3_rekey_init)
+*/
+struct sqlite3_rekey_job
+{
+  sqlite3* db;          /* Database connection */
+  Btree*   pBt;         /* B-tree of the database being rekeyed */
+  Codec*   codec;       /* Codec of the database */
+  int      nPagecount;  /* Page count of the database at the last step */
+  int      rc;          /* Error code of the last step */
+};
+
+sqlite3_rekey_job* sqlite3_rekey_init(sqlite3 *db, const char *zDbName, const void *zKey, int nKey)
+{
+  sqlite3_rekey_job* p = NULL;
+  int dbIndex;
+  Btree* pbt;
+  Codec* codec = NULL;
+  unsigned char newSecret[CODEC_SECRET_SIZE];
+  unsigned char newKey[KEYLENGTH];
+  int rc = SQLITE_OK;
+
+  sqlite3_mutex_enter(db->mutex);
+  dbIndex = dbFindIndex(db, zDbName);
+  pbt = db->aDb[dbIndex].pBt;
+  if (pbt != NULL)
+  {
+    codec = (Codec*) mySqlite3PagerGetCodec(sqlite3BtreePager(pbt));
+  }
+  if (codec == NULL || !CodecIsEncrypted(codec) || !CodecHasReadKey(codec) || zKey == NULL || nKey <= 0)
+  {
+    sqlite3ErrorWithMsg(db, SQLITE_ERROR, "stepwise rekey requires an encrypted database and a new key");
+    sqlite3_mutex_leave(db->mutex);
+    return NULL;
+  }
+
+  p = (sqlite3_rekey_job*) sqlite3_malloc(sizeof(sqlite3_rekey_job));
+  if (p == NULL)
+  {
+    sqlite3Error(db, SQLITE_NOMEM);
+    sqlite3_mutex_leave(db->mutex);
+    return NULL;
+  }
+
+  /* Same key derivation as sqlite3_rekey: salted with the salt and */
+  /* iteration count of the database, or the legacy one */
+  CodecGeneratePasswordKey(codec, (char*) zKey, nKey, newSecret, newKey);
+  if (codec->m_rekeyActive)
+  {
+    /* Rekey already in progress on this connection */
+    if (memcmp(newKey, codec->m_writeKey, KEYLENGTH) != 0)
+    {
+      rc = SQLITE_ERROR;
+    }
+  }
+  else
+  {
+    /* Check for an interrupted rekey recorded in the database header */
+    int inTrans = sqlite3BtreeIsInReadTrans(pbt);
+    sqlite3BtreeEnter(pbt);
+    rc = (inTrans) ? SQLITE_OK : sqlite3BtreeBeginTrans(pbt, 0);
+    if (rc == SQLITE_OK)
+    {
+      DbPage* pPage1;
+      rc = sqlite3PagerGet(sqlite3BtreePager(pbt), 1, &pPage1, 0);
+      if (rc == SQLITE_OK)
+      {
+        unsigned char* header = (unsigned char*) sqlite3PagerGetData(pPage1);
+        int rekeyPage = sqlite3Get4byte(header+CODEC_REKEY_PAGE_OFFSET);
+        unsigned int rekeyCheck = sqlite3Get4byte(header+CODEC_REKEY_CHECK_OFFSET);
+        sqlite3PagerUnref(pPage1);
+        if (rekeyPage > 0 && rekeyCheck != CodecRekeyCheck(codec, newKey))
+        {
+          rc = SQLITE_ERROR;
+        }
+        else
+        {
+          memcpy(codec->m_writeKey, newKey, KEYLENGTH);
+          memcpy(codec->m_writeSecret, newSecret, CODEC_SECRET_SIZE);
+          codec->m_writeRaw = 0;
+          CodecKeyCacheClear(codec);
+          CodecSetHasWriteKey(codec, 1);
+          codec->m_rekeyActive  = 1;
+          codec->m_rekeyPage    = rekeyPage;
+          codec->m_rekeyPending = rekeyPage;
+          codec->m_rekeyFinal   = 0;
+        }
+      }
+      if (!inTrans)
+      {
+        sqlite3BtreeCommit(pbt);
+      }
+    }
+    sqlite3BtreeLeave(pbt);
+  }
+
+  if (rc == SQLITE_ERROR)
+  {
+    sqlite3ErrorWithMsg(db, rc, "a rekey with a different key is in progress");
+  }
+  else if (rc != SQLITE_OK)
+  {
+    sqlite3Error(db, rc);
+  }
+  if (rc != SQLITE_OK)
+  {
+    sqlite3_free(p);
+    p = NULL;
+  }
+  else
+  {
+    p->db = db;
+    p->pBt = pbt;
+    p->codec = codec;
+    p->nPagecount = 0;
+    p->rc = SQLITE_OK;
+  }
+  sqlite3_mutex_leave(db->mutex);
+  return p;
+}
+
+int sqlite3_rekey_step(sqlite3_rekey_job *p, int nPage)
+{
+  int rc;
+  Codec* codec = p->codec;
+  Btree* pbt = p->pBt;
+  Pager* pPager = sqlite3BtreePager(pbt);
+
+  sqlite3_mutex_enter(p->db->mutex);
+  sqlite3BtreeEnter(pbt);
+  rc = p->rc;
+  if (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+  {
+    /* Each step commits, so it can't be part of a transaction of the connection */
+    rc = (sqlite3BtreeIsInReadTrans(pbt)) ? SQLITE_LOCKED : sqlite3BtreeBeginTrans(pbt, 1);
+    if (rc == SQLITE_OK && !codec->m_rekeyActive)
+    {
+      /* Another connection completed the rekey */
+      sqlite3BtreeRollback(pbt, SQLITE_OK, 0);
+      rc = SQLITE_DONE;
+    }
+    if (rc == SQLITE_OK)
+    {
+      int pageSize = sqlite3BtreeGetPageSize(pbt);
+      Pgno nSkip = WX_PAGER_MJ_PGNO(pageSize);
+      int nPageCount = 0;
+      int lastPage;
+      int n;
+      DbPage* pPage1 = NULL;
+      DbPage* pPage;
+
+      sqlite3PagerPagecount(pPager, &nPageCount);
+      p->nPagecount = nPageCount;
+      lastPage = codec->m_rekeyPage;
+      if (lastPage < nPageCount)
+      {
+        lastPage = (nPage < 0 || nPage >= nPageCount - lastPage) ? nPageCount : lastPage + nPage;
+      }
+
+      /* Page 1 is written by every step since it records the progress */
+      rc = sqlite3PagerGet(pPager, 1, &pPage1, 0);
+      if (rc == SQLITE_OK)
+      {
+        rc = sqlite3PagerWrite(pPage1);
+      }
+      codec->m_rekeyPending = lastPage;
+      codec->m_rekeyFinal = (lastPage >= nPageCount);
+      for (n = (codec->m_rekeyPage < 2) ? 2 : codec->m_rekeyPage + 1; rc == SQLITE_OK && n <= lastPage; n++)
+      {
+        if (n == nSkip) continue;
+        rc = sqlite3PagerGet(pPager, n, &pPage, 0);
+        if (rc == SQLITE_OK)
+        {
+          rc = sqlite3PagerWrite(pPage);
+          sqlite3PagerUnref(pPage);
+        }
+      }
+      if (rc == SQLITE_OK && codec->m_rekeyFinal)
+      {
+        /* Clear the rekey state in the header of the cached page as well */
+        memset((unsigned char*) sqlite3PagerGetData(pPage1)+CODEC_REKEY_PAGE_OFFSET, 0, 8);
+      }
+      if (pPage1 != NULL)
+      {
+        sqlite3PagerUnref(pPage1);
+      }
+
+      if (rc == SQLITE_OK)
+      {
+        rc = sqlite3BtreeCommit(pbt);
+      }
+      if (rc == SQLITE_OK)
+      {
+        if (codec->m_rekeyFinal)
+        {
+          /* All pages use the new key now */
+          CodecCopyKey(codec, 0);
+          codec->m_rekeyActive = 0;
+          codec->m_rekeyPage = 0;
+          codec->m_rekeyFinal = 0;
+          rc = SQLITE_DONE;
+        }
+        else
+        {
+          codec->m_rekeyPage = lastPage;
+        }
+        codec->m_rekeyPending = codec->m_rekeyPage;
+      }
+      else
+      {
+        sqlite3BtreeRollback(pbt, SQLITE_OK, 0);
+        codec->m_rekeyPending = codec->m_rekeyPage;
+        codec->m_rekeyFinal = 0;
+      }
+    }
+    p->rc = rc;
+  }
+  sqlite3BtreeLeave(pbt);
+  sqlite3_mutex_leave(p->db->mutex);
+  return rc;
+}
+
+int sqlite3_rekey_finish(sqlite3_rekey_job *p)
+{
+  sqlite3* db;
+  int rc;
+  if (p == NULL) return SQLITE_OK;
+  db = p->db;
+  sqlite3_mutex_enter(db->mutex);
+  rc = (p->rc == SQLITE_DONE) ? SQLITE_OK : p->rc;
+  sqlite3Error(db, rc);
+  sqlite3_free(p);
+  sqlite3_mutex_leave(db->mutex);
+  return rc;
+}
+
+int sqlite3_rekey_remaining(sqlite3_rekey_job *p)
+{
+  int nDone;
+  if (!p->codec->m_rekeyActive) return 0;
+  nDone = (p->codec->m_rekeyPage > 1) ? p->codec->m_rekeyPage - 1 : 0;
+  return (p->nPagecount > nDone) ? p->nPagecount - nDone : 0;
+}
+
+int sqlite3_rekey_pagecount(sqlite3_rekey_job *p)
+{
+  return p->nPagecount;
+}
+
 #endif /* SQLITE_HAS_CODEC */
 
 #endif /* SQLITE_OMIT_DISKIO */
@@ -78,6 +78,9 @@ static const char * const azCompileOpt[] = {
 #if SQLITE_ENABLE_COLUMN_METADATA
   "ENABLE_COLUMN_METADATA",
 #endif
+#if SQLITE_ENABLE_COMPUTED_GOTO
+  "ENABLE_COMPUTED_GOTO",
+#endif
 #if SQLITE_ENABLE_DBSTAT_VTAB
   "ENABLE_DBSTAT_VTAB",
 #endif
@@ -129,6 +132,9 @@ static const char * const azCompileOpt[] = {
 #if SQLITE_ENABLE_OVERSIZE_CELL_CHECK
   "ENABLE_OVERSIZE_CELL_CHECK",
 #endif
+#ifdef SQLITE_ENABLE_PCACHE_HUGEPAGE
+  "ENABLE_PCACHE_HUGEPAGE",
+#endif
 #if SQLITE_ENABLE_RTREE
   "ENABLE_RTREE",
 #endif
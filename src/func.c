@@ -1556,6 +1556,139 @@ static void minMaxFinalize(sqlite3_context *context){
   }
 }
 
+/*
+** Return true if pFunc is one of the built-in sum(), total(), avg(),
+** count(), min() or max() aggregates, which sqlite3AggBatchStep() can
+** run over a VdbeBatch.
+*/
+int sqlite3AggBatchable(FuncDef *pFunc){
+  return pFunc->xSFunc==sumStep
+      || pFunc->xSFunc==countStep
+      || pFunc->xSFunc==minmaxStep;
+}
+
+/*
+** Invoke the step function of aggregate pCtx, which must be one for
+** which sqlite3AggBatchable() is true, for the value of vector iVec in
+** each selected row of pBatch.  Or, if iVec is negative, for count(*)
+** over the selected rows.
+**
+** Numeric values are accumulated directly from the arrays of the vector.
+** Text and blob values are passed to the step function one at a time.
+*/
+void sqlite3AggBatchStep(sqlite3_context *pCtx, VdbeBatch *pBatch, int iVec){
+  void (*xSFunc)(sqlite3_context*,int,sqlite3_value**) = pCtx->pFunc->xSFunc;
+  const u8 *aSel = pBatch->aSel;
+  int nRow = pBatch->nRow;
+  VdbeVector *pVec;
+  Mem sArg;
+  Mem *pArg = &sArg;
+  int i;
+
+  if( iVec<0 ){
+    CountCtx *p = sqlite3_aggregate_context(pCtx, sizeof(*p));
+    assert( xSFunc==countStep );
+    if( p ){
+      for(i=0; i<nRow; i++) p->n += aSel[i];
+    }
+    return;
+  }
+  pVec = &pBatch->aVec[iVec];
+  sqlite3VdbeMemInit(&sArg, sqlite3_context_db_handle(pCtx), MEM_Null);
+
+  if( xSFunc==countStep ){
+    CountCtx *p = sqlite3_aggregate_context(pCtx, sizeof(*p));
+    if( p ){
+      for(i=0; i<nRow; i++){
+        p->n += (aSel[i] && pVec->aType[i]!=SQLITE_NULL);
+      }
+    }
+  }else if( xSFunc==sumStep ){
+    SumCtx *p = sqlite3_aggregate_context(pCtx, sizeof(*p));
+    if( p==0 ) return;
+    for(i=0; i<nRow; i++){
+      if( aSel[i]==0 ) continue;
+      switch( pVec->aType[i] ){
+        case SQLITE_INTEGER: {
+          i64 v = pVec->aInt[i];
+          p->cnt++;
+          p->rSum += v;
+          if( (p->approx|p->overflow)==0 && sqlite3AddInt64(&p->iSum, v) ){
+            p->overflow = 1;
+          }
+          break;
+        }
+        case SQLITE_FLOAT: {
+          p->cnt++;
+          p->rSum += pVec->aReal[i];
+          p->approx = 1;
+          break;
+        }
+        case SQLITE_NULL: {
+          break;
+        }
+        default: {
+          sArg.db = pVec->aMem[i].db;
+          sqlite3VdbeMemShallowCopy(&sArg, &pVec->aMem[i], MEM_Ephem);
+          sumStep(pCtx, 1, (sqlite3_value**)&pArg);
+          break;
+        }
+      }
+    }
+  }else{
+    Mem *pBest;
+    int bMax = sqlite3_user_data(pCtx)!=0;
+    int iBest = -1;               /* Row with best numeric value so far */
+
+    assert( xSFunc==minmaxStep );
+    for(i=0; i<nRow; i++){
+      int c;
+      if( aSel[i]==0 ) continue;
+      switch( pVec->aType[i] ){
+        case SQLITE_NULL: {
+          continue;
+        }
+        case SQLITE_TEXT:
+        case SQLITE_BLOB: {
+          sArg.db = pVec->aMem[i].db;
+          sqlite3VdbeMemShallowCopy(&sArg, &pVec->aMem[i], MEM_Ephem);
+          minmaxStep(pCtx, 1, (sqlite3_value**)&pArg);
+          continue;
+        }
+      }
+      if( iBest<0 ){
+        iBest = i;
+        continue;
+      }
+      if( pVec->aType[i]==SQLITE_INTEGER ){
+        if( pVec->aType[iBest]==SQLITE_INTEGER ){
+          c = (pVec->aInt[i]>pVec->aInt[iBest])-(pVec->aInt[i]<pVec->aInt[iBest]);
+        }else{
+          c = sqlite3IntFloatCompare(pVec->aInt[i], pVec->aReal[iBest]);
+        }
+      }else{
+        if( pVec->aType[iBest]==SQLITE_INTEGER ){
+          c = -sqlite3IntFloatCompare(pVec->aInt[iBest], pVec->aReal[i]);
+        }else{
+          c = (pVec->aReal[i]>pVec->aReal[iBest])-(pVec->aReal[i]<pVec->aReal[iBest]);
+        }
+      }
+      if( bMax ? c>0 : c<0 ) iBest = i;
+    }
+
+    /* Merge the best numeric value of the batch into the accumulator in
+    ** the same way as minmaxStep() would. */
+    pBest = (Mem*)sqlite3_aggregate_context(pCtx, sizeof(*pBest));
+    if( pBest==0 || iBest<0 ) return;
+    if( pVec->aType[iBest]==SQLITE_INTEGER ){
+      sqlite3VdbeMemSetInt64(&sArg, pVec->aInt[iBest]);
+    }else{
+      sqlite3VdbeMemSetDouble(&sArg, pVec->aReal[iBest]);
+    }
+    minmaxStep(pCtx, 1, (sqlite3_value**)&pArg);
+  }
+}
+
 /*
 ** group_concat(EXPR, ?SEPARATOR?)
 */
@@ -200,6 +200,12 @@ SQLITE_WSD struct Sqlite3Config sqlite3Config = {
    (void*)0,                  /* pPage */
    0,                         /* szPage */
    SQLITE_DEFAULT_PCACHE_INITSZ, /* nPage */
+   SQLITE_DEFAULT_PCACHE_SHARDS, /* nPcacheShard */
+   SQLITE_DEFAULT_PCACHE_POLICY, /* ePcachePolicy */
+#ifdef SQLITE_ENABLE_PCACHE_HUGEPAGE
+   0,                         /* szHugeSlot */
+   0,                         /* nHugeByte */
+#endif
    0,                         /* mxParserStack */
    0,                         /* sharedCacheEnabled */
    SQLITE_SORTER_PMASZ,       /* szPma */
@@ -785,8 +785,16 @@ void sqlite3Insert(
   /* If this is not a view, open the table and and all indices */
   if( !isView ){
     int nIdx;
+    int addrOpen = sqlite3VdbeCurrentAddr(v);
     nIdx = sqlite3OpenTableAndIndices(pParse, pTab, OP_OpenWrite, 0, -1, 0,
                                       &iDataCur, &iIdxCur);
+    if( pSelect && HasRowid(pTab) && !IsVirtual(pTab) ){
+      /* Rows from a SELECT are normally given ascending rowids, so let the
+      ** b-tree layer append them bottom-up instead of splitting pages. */
+      VdbeOp *pOp = sqlite3VdbeGetOp(v, addrOpen);
+      assert( pOp->opcode==OP_OpenWrite || db->mallocFailed );
+      pOp->p5 = OPFLAG_BULKCSR;
+    }
     aRegIdx = sqlite3DbMallocRawNN(db, sizeof(int)*(nIdx+1));
     if( aRegIdx==0 ){
       goto insert_cleanup;
@@ -2058,6 +2066,7 @@ static int xferOptimization(
   regData = sqlite3GetTempReg(pParse);
   regRowid = sqlite3GetTempReg(pParse);
   sqlite3OpenTable(pParse, iDest, iDbDest, pDest, OP_OpenWrite);
+  if( HasRowid(pDest) ) sqlite3VdbeChangeP5(v, OPFLAG_BULKCSR);
   assert( HasRowid(pDest) || destHasUniqueIdx );
   if( (db->flags & SQLITE_Vacuum)==0 && (
       (pDest->iPKey<0 && pDest->pIndex!=0)          /* (1) */
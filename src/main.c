@@ -313,6 +313,9 @@ int sqlite3_shutdown(void){
 #endif
     sqlite3_os_end();
     sqlite3_reset_auto_extension();
+#ifdef SQLITE_HAS_CODEC
+    sqlite3CodecShutdown();
+#endif
     sqlite3GlobalConfig.isInit = 0;
   }
   if( sqlite3GlobalConfig.isPCacheInit ){
@@ -638,6 +641,34 @@ int sqlite3_config(int op, ...){
       break;
     }
 
+    case SQLITE_CONFIG_PCACHE_SHARDS: {
+      int nShard = va_arg(ap, int);
+      if( nShard<1 ) nShard = 1;
+      if( nShard>SQLITE_MAX_PCACHE_SHARDS ) nShard = SQLITE_MAX_PCACHE_SHARDS;
+      sqlite3GlobalConfig.nPcacheShard = nShard;
+      break;
+    }
+
+    case SQLITE_CONFIG_PCACHE_POLICY: {
+      int ePolicy = va_arg(ap, int);
+      if( ePolicy!=SQLITE_PCACHE_POLICY_LRU
+       && ePolicy!=SQLITE_PCACHE_POLICY_2Q
+      ){
+        rc = SQLITE_MISUSE_BKPT;
+      }else{
+        sqlite3GlobalConfig.ePcachePolicy = ePolicy;
+      }
+      break;
+    }
+
+#ifdef SQLITE_ENABLE_PCACHE_HUGEPAGE
+    case SQLITE_CONFIG_PCACHE_HUGEPAGE: {
+      sqlite3GlobalConfig.szHugeSlot = va_arg(ap, int);
+      sqlite3GlobalConfig.nHugeByte = va_arg(ap, sqlite3_int64);
+      break;
+    }
+#endif
+
     default: {
       rc = SQLITE_ERROR;
       break;
@@ -901,6 +932,14 @@ static int nocaseCollatingFunc(
   return r;
 }
 
+/*
+** Return true if collating sequence p is the built-in NOCASE collation,
+** and has not been overridden by the application.
+*/
+int sqlite3IsNocase(const CollSeq *p){
+  return p!=0 && p->xCmp==nocaseCollatingFunc;
+}
+
 /*
 ** Return the ROWID of the most recent insert
 */
@@ -1121,6 +1160,9 @@ void sqlite3LeaveMutexAndCloseZombie(sqlite3 *db){
   /* Close all database connections */
   for(j=0; j<db->nDb; j++){
     struct Db *pDb = &db->aDb[j];
+#ifndef SQLITE_OMIT_WAL
+    sqlite3WalBackground(db, j, 0);
+#endif
     if( pDb->pBt ){
       sqlite3BtreeClose(pDb->pBt);
       pDb->pBt = 0;
@@ -1923,11 +1965,218 @@ void *sqlite3_rollback_hook(
 }
 
 #ifndef SQLITE_OMIT_WAL
+/*
+** Background checkpoints need real threads, which exist only in
+** threadsafe builds on unix or on the Win32 platforms with _beginthreadex().
+*/
+#if SQLITE_MAX_WORKER_THREADS>0 && SQLITE_THREADSAFE>0 \
+ && (SQLITE_OS_UNIX || (SQLITE_OS_WIN && !SQLITE_OS_WINCE \
+     && !SQLITE_OS_WINRT && !defined(__CYGWIN__)))
+# define SQLITE_WAL_BACKGROUND 1
+#else
+# define SQLITE_WAL_BACKGROUND 0
+#endif
+
+/*
+** The background checkpointer thread looks for work this often (ms).
+*/
+#ifndef SQLITE_WAL_BACKGROUND_POLL
+# define SQLITE_WAL_BACKGROUND_POLL 10
+#endif
+
+/*
+** Unless "PRAGMA wal_checkpoint_limit" says otherwise, a commit that leaves
+** the WAL this many times larger than the wal_autocheckpoint threshold
+** checkpoints synchronously even though a background checkpointer runs.
+*/
+#ifndef SQLITE_WAL_BACKGROUND_LIMIT
+# define SQLITE_WAL_BACKGROUND_LIMIT 4
+#endif
+
+#if SQLITE_WAL_BACKGROUND
+/*
+** A background checkpointer runs PASSIVE checkpoints of one database of
+** a connection on a thread of its own, using a private connection to the
+** same file. It checkpoints when a commit of the owning connection finds
+** the WAL over the wal_autocheckpoint threshold, and at least every
+** nInterval ms otherwise. Commits therefore no longer pay for checkpoints,
+** until the WAL grows past Db.nCkptLimit frames because the checkpointer
+** cannot keep up. Such commits checkpoint synchronously, as they used to.
+*/
+struct Checkpointer {
+  sqlite3 *db;              /* Private connection of the checkpointer */
+  SQLiteThread *pThread;    /* Thread running checkpointerMain() */
+  sqlite3_mutex *mutex;     /* Protects the fields below */
+  int nInterval;            /* Checkpoint at least every nInterval ms */
+  u8 bWake;                 /* True to checkpoint at the next poll */
+  u8 bStop;                 /* True to end the thread */
+};
+
+/*
+** The main routine of the checkpointer thread.
+*/
+static void *checkpointerMain(void *pCtx){
+  Checkpointer *p = (Checkpointer*)pCtx;
+  sqlite3_vfs *pVfs = p->db->pVfs;
+  sqlite3_int64 iLast = 0;        /* Time of the last checkpoint */
+  sqlite3_int64 iNow = 0;         /* Current time */
+  int nDone = -1;                 /* Frames checkpointed by the last run */
+  int bAgain = 0;                 /* True if the last run was incomplete */
+
+  sqlite3OsCurrentTimeInt64(pVfs, &iLast);
+  for(;;){
+    int bRun;
+    int bStop;
+    sqlite3OsSleep(pVfs, SQLITE_WAL_BACKGROUND_POLL*1000);
+    sqlite3OsCurrentTimeInt64(pVfs, &iNow);
+    sqlite3_mutex_enter(p->mutex);
+    bStop = p->bStop;
+    bRun = bAgain || p->bWake || iNow-iLast>=p->nInterval;
+    p->bWake = 0;
+    sqlite3_mutex_leave(p->mutex);
+    if( bStop ) break;
+    if( bRun ){
+      int nLog = -1;
+      int nCkpt = -1;
+      sqlite3_wal_checkpoint_v2(p->db, "main", SQLITE_CHECKPOINT_PASSIVE,
+                                &nLog, &nCkpt);
+      if( nLog<0 ){
+        /* The pager of this connection opens the WAL with its first
+        ** read transaction. Run one, so the next attempt finds it. */
+        sqlite3_exec(p->db, "PRAGMA schema_version", 0, 0, 0);
+      }
+      /* Carry on at the next poll if the checkpoint stopped short of the
+      ** end of the WAL but made progress (wal_checkpoint_step slices).
+      ** Frames pinned by readers are left to the next trigger. */
+      bAgain = nCkpt>=0 && nCkpt<nLog && nCkpt!=nDone;
+      nDone = nCkpt;
+      iLast = iNow;
+    }
+  }
+  sqlite3_close(p->db);
+  return 0;
+}
+
+/*
+** Start a background checkpointer for database iDb of db. Return NULL if
+** that is not possible, for TEMP or in-memory databases for example.
+*/
+static Checkpointer *checkpointerStart(sqlite3 *db, int iDb, int nInterval){
+  Btree *pBt = db->aDb[iDb].pBt;
+  const char *zFile = sqlite3BtreeGetFilename(pBt);
+  Checkpointer *p;
+  int rc;
+
+  if( iDb==1 || zFile==0 || zFile[0]==0 ) return 0;
+  if( sqlite3GlobalConfig.bCoreMutex==0 ) return 0;
+  p = (Checkpointer*)sqlite3MallocZero(sizeof(*p));
+  if( p==0 ) return 0;
+  p->nInterval = nInterval;
+  p->mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_FAST);
+  rc = sqlite3_open_v2(zFile, &p->db,
+      SQLITE_OPEN_READWRITE|SQLITE_OPEN_PRIVATECACHE, db->pVfs->zName);
+#ifdef SQLITE_HAS_CODEC
+  if( rc==SQLITE_OK ){
+    rc = sqlite3CodecShare(p->db, 0, db, iDb);
+  }
+#endif
+  if( rc==SQLITE_OK ){
+    Pager *pPager = sqlite3BtreePager(pBt);
+    Pager *pCkptPager = sqlite3BtreePager(p->db->aDb[0].pBt);
+    sqlite3PagerCkptStep(pCkptPager, sqlite3PagerCkptStep(pPager, -1));
+    sqlite3PagerCkptThreads(pCkptPager, sqlite3PagerCkptThreads(pPager, -1));
+    rc = sqlite3ThreadCreate(&p->pThread, checkpointerMain, (void*)p);
+  }
+  if( rc!=SQLITE_OK ){
+    sqlite3_close(p->db);
+    sqlite3_mutex_free(p->mutex);
+    sqlite3_free(p);
+    return 0;
+  }
+  return p;
+}
+
+/*
+** Stop a background checkpointer. This waits for a checkpoint in progress.
+*/
+static void checkpointerStop(Checkpointer *p){
+  void *pOut;
+  sqlite3_mutex_enter(p->mutex);
+  p->bStop = 1;
+  sqlite3_mutex_leave(p->mutex);
+  sqlite3ThreadJoin(p->pThread, &pOut);
+  sqlite3_mutex_free(p->mutex);
+  sqlite3_free(p);
+}
+
+/*
+** Called by a commit that left nFrame frames in the WAL, more than the
+** wal_autocheckpoint threshold nThreshold. Wake the background
+** checkpointer of pDb, if there is one. Return true if that is all the
+** commit has to do, or false if it must checkpoint itself.
+*/
+static int checkpointerWake(Db *pDb, int nFrame, int nThreshold){
+  Checkpointer *p = pDb->pCkpt;
+  int nLimit = pDb->nCkptLimit;
+  if( p==0 ) return 0;
+  sqlite3_mutex_enter(p->mutex);
+  p->bWake = 1;
+  sqlite3_mutex_leave(p->mutex);
+  if( nLimit<=0 ) nLimit = nThreshold*SQLITE_WAL_BACKGROUND_LIMIT;
+  return nFrame<nLimit;
+}
+#endif /* SQLITE_WAL_BACKGROUND */
+
+/*
+** Start, reconfigure or stop (nInterval==0) the background checkpointer of
+** database iDb, if nInterval>=0. Return the interval of the checkpointer
+** in ms, or 0 if there is none.
+** (called from PRAGMA wal_checkpoint_background and to close a database)
+*/
+int sqlite3WalBackground(sqlite3 *db, int iDb, int nInterval){
+#if SQLITE_WAL_BACKGROUND
+  Db *pDb = &db->aDb[iDb];
+  assert( sqlite3_mutex_held(db->mutex) );
+  if( nInterval>0 && pDb->pCkpt==0 ){
+    pDb->pCkpt = checkpointerStart(db, iDb, nInterval);
+  }else if( nInterval>0 ){
+    sqlite3_mutex_enter(pDb->pCkpt->mutex);
+    pDb->pCkpt->nInterval = nInterval;
+    sqlite3_mutex_leave(pDb->pCkpt->mutex);
+  }else if( nInterval==0 && pDb->pCkpt ){
+    checkpointerStop(pDb->pCkpt);
+    pDb->pCkpt = 0;
+  }
+  return pDb->pCkpt ? pDb->pCkpt->nInterval : 0;
+#else
+  UNUSED_PARAMETER(db);
+  UNUSED_PARAMETER(iDb);
+  UNUSED_PARAMETER(nInterval);
+  return 0;
+#endif
+}
+
+/*
+** Set the WAL size in frames above which commits checkpoint synchronously
+** while database iDb has a background checkpointer, if nLimit>=0. Zero
+** means SQLITE_WAL_BACKGROUND_LIMIT times the wal_autocheckpoint threshold.
+** The limit is kept with the database, so it may be set before the
+** checkpointer is started. Return the current limit.
+** (called from PRAGMA wal_checkpoint_limit)
+*/
+int sqlite3WalBackgroundLimit(sqlite3 *db, int iDb, int nLimit){
+  Db *pDb = &db->aDb[iDb];
+  assert( sqlite3_mutex_held(db->mutex) );
+  if( nLimit>=0 ) pDb->nCkptLimit = nLimit;
+  return pDb->nCkptLimit;
+}
+
 /*
 ** The sqlite3_wal_hook() callback registered by sqlite3_wal_autocheckpoint().
 ** Invoke sqlite3_wal_checkpoint if the number of frames in the log file
 ** is greater than sqlite3.pWalArg cast to an integer (the value configured by
-** wal_autocheckpoint()).
+** wal_autocheckpoint()). A database with a background checkpointer leaves
+** the checkpoint to it, unless the WAL has grown past its limit.
 */ 
 int sqlite3WalDefaultHook(
   void *pClientData,     /* Argument */
@@ -1935,7 +2184,14 @@ int sqlite3WalDefaultHook(
   const char *zDb,       /* Database */
   int nFrame             /* Size of WAL */
 ){
-  if( nFrame>=SQLITE_PTR_TO_INT(pClientData) ){
+  int nThreshold = SQLITE_PTR_TO_INT(pClientData);
+  if( nFrame>=nThreshold ){
+#if SQLITE_WAL_BACKGROUND
+    int iDb = sqlite3FindDbName(db, zDb);
+    if( iDb>=0 && checkpointerWake(&db->aDb[iDb], nFrame, nThreshold) ){
+      return SQLITE_OK;
+    }
+#endif
     sqlite3BeginBenignMalloc();
     sqlite3_wal_checkpoint(db, zDb);
     sqlite3EndBenignMalloc();
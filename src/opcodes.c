@@ -172,6 +172,12 @@ const char *sqlite3OpcodeName(int i){
     /* 159 */ "CursorHint"       OpHelp(""),
     /* 160 */ "Noop"             OpHelp(""),
     /* 161 */ "Explain"          OpHelp(""),
+    /* 162 */ "BatchOpen"        OpHelp(""),
+    /* 163 */ "BatchConst"       OpHelp("vec[P2]=r[P3]"),
+    /* 164 */ "BatchLoad"        OpHelp(""),
+    /* 165 */ "BatchFilter"      OpHelp("where vec[P2] P5 r[P3]"),
+    /* 166 */ "BatchArith"       OpHelp("vec[P4]=vec[P2] P5 vec[P3]"),
+    /* 167 */ "BatchAgg"         OpHelp("accum=r[P3] step(vec[P2])"),
   };
   return azName[i];
 }
@@ -162,6 +162,12 @@
 #define OP_CursorHint    159
 #define OP_Noop          160
 #define OP_Explain       161
+#define OP_BatchOpen     162
+#define OP_BatchConst    163 /* synopsis: vec[P2]=r[P3]                    */
+#define OP_BatchLoad     164
+#define OP_BatchFilter   165 /* synopsis: where vec[P2] P5 r[P3]           */
+#define OP_BatchArith    166 /* synopsis: vec[P4]=vec[P2] P5 vec[P3]       */
+#define OP_BatchAgg      167 /* synopsis: accum=r[P3] step(vec[P2])        */
 
 /* Properties such as "out2" or "jump" that are specified in
 ** comments following the "case" for each opcode in the vdbe.c
@@ -194,4 +200,5 @@
 /* 136 */ 0x01, 0x04, 0x03, 0x1a, 0x03, 0x03, 0x03, 0x00,\
 /* 144 */ 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,\
 /* 152 */ 0x00, 0x00, 0x01, 0x00, 0x10, 0x10, 0x01, 0x00,\
-/* 160 */ 0x00, 0x00,}
+/* 160 */ 0x00, 0x00, 0x00, 0x08, 0x01, 0x08, 0x00, 0x00,\
+}
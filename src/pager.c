@@ -408,6 +408,10 @@ int sqlite3PagerTrace=1;  /* True to enable tracing */
 
 /*
 ** A macro used for invoking the codec if there is one
+**
+** CODEC1 decodes a page in place. The codec returns NULL if the page
+** fails authentication, which is reported as SQLITE_CORRUPT. CODEC2
+** encodes a copy of a page and returns NULL if it runs out of memory.
 */
 #ifdef SQLITE_HAS_CODEC
 # define CODEC1(P,D,N,X,E) \
@@ -420,6 +424,31 @@ int sqlite3PagerTrace=1;  /* True to enable tracing */
 # define CODEC2(P,D,N,X,E,O) O=(char*)D
 #endif
 
+/*
+** True if page N of pager P would leave a hole in an encrypted database
+** file if it was not written, because it lies beyond the end of the file
+*/
+#ifdef SQLITE_HAS_CODEC
+# define CODEC_HOLE(P,N) ((P)->xCodec!=0 && (N)>(P)->dbFileSize)
+#else
+# define CODEC_HOLE(P,N) 0
+#endif
+
+#ifdef SQLITE_HAS_CODEC
+/*
+** The pages written by the pager can be encrypted in parallel by
+** Pager.nCodecThread threads (see "PRAGMA codec_threads"). Up to
+** SQLITE_CODEC_BATCH_PAGES pages per thread are encrypted ahead of being
+** written by the calling thread. The encrypted images are only valid
+** while a single list of pages is written, so the batch is reset at the
+** start and end of each such operation.
+*/
+#ifndef SQLITE_CODEC_BATCH_PAGES
+# define SQLITE_CODEC_BATCH_PAGES 32
+#endif
+typedef struct PagerCodecBatch PagerCodecBatch;
+#endif
+
 /*
 ** The maximum allowed sector size. 64KiB. If the xSectorsize() method 
 ** returns a value larger than this, then MAX_SECTOR_SIZE is used instead.
@@ -684,6 +713,9 @@ struct Pager {
   int pageSize;               /* Number of bytes in a page */
   Pgno mxPgno;                /* Maximum allowed size of the database */
   i64 journalSizeLimit;       /* Size limit for persistent journal files */
+  int nCkptStep;              /* Max frames backfilled by a PASSIVE checkpoint */
+  int nCkptThread;            /* Threads used by checkpoints */
+  u8 bGroupCommit;            /* Share WAL syncs with other connections */
   char *zFilename;            /* Name of the database file */
   char *zJournal;             /* Name of the journal file */
   int (*xBusyHandler)(void*); /* Function to call when busy */
@@ -698,6 +730,9 @@ struct Pager {
   void (*xCodecSizeChng)(void*,int,int); /* Notify of page size changes */
   void (*xCodecFree)(void*);             /* Destructor for the codec */
   void *pCodec;               /* First argument to xCodec... methods */
+  u8 bCodecMmap;              /* Read encrypted pages via the memory map */
+  int nCodecThread;           /* Threads encrypting written pages */
+  PagerCodecBatch *pCodecBatch; /* Pages encrypted in parallel, or NULL */
 #endif
   char *pTmpSpace;            /* Pager.pageSize bytes of space for tmp use */
   PCache *pPCache;            /* Pointer to page cache object */
@@ -798,6 +833,182 @@ static const unsigned char aJournalMagic[] = {
 */
 #define PAGER_MAX_PGNO 2147483647
 
+#if defined(SQLITE_HAS_CODEC) && SQLITE_MAX_WORKER_THREADS>0
+/*
+** Pages of a dirty list encrypted ahead of being written to the database
+** file or the WAL.
+*/
+struct PagerCodecBatch {
+  Pager *pPager;              /* Pager that owns this object */
+  int nAlloc;                 /* Number of pages apPg[] and aBuf[] can hold */
+  int szPage;                 /* Size of each page image in aBuf[] */
+  int nPage;                  /* Number of pages currently in the batch */
+  int iNext;                  /* Index of the next page expected */
+  PgHdr **apPg;               /* Pages in the batch */
+  u8 *aBuf;                   /* Encrypted page images */
+};
+
+/*
+** The part of a batch encrypted by a single thread.
+*/
+typedef struct PagerCodecTask PagerCodecTask;
+struct PagerCodecTask {
+  PagerCodecBatch *pBatch;    /* The batch */
+  int iFirst;                 /* First page to encrypt */
+  int iEnd;                   /* One past the last page to encrypt */
+};
+
+/*
+** Thread routine: encrypt the pages of a PagerCodecTask. Each page is
+** copied into the batch buffer and encrypted there in place (codec mode
+** 8), so that the codec does not need a separate output buffer per thread.
+*/
+static void *pagerCodecBatchTask(void *pCtx){
+  PagerCodecTask *pTask = (PagerCodecTask*)pCtx;
+  PagerCodecBatch *p = pTask->pBatch;
+  Pager *pPager = p->pPager;
+  int i;
+  for(i=pTask->iFirst; i<pTask->iEnd; i++){
+    u8 *aOut = &p->aBuf[i*(i64)p->szPage];
+    memcpy(aOut, p->apPg[i]->pData, p->szPage);
+    if( pPager->xCodec(pPager->pCodec, aOut, p->apPg[i]->pgno, 8)==0 ){
+      return SQLITE_INT_TO_PTR(SQLITE_NOMEM);
+    }
+  }
+  return SQLITE_INT_TO_PTR(SQLITE_OK);
+}
+
+/*
+** Encrypt page pPg and the pages following it on the dirty list in
+** parallel. If the batch cannot be used, because there are too few pages
+** or because of an error, it is left empty and the caller falls back to
+** encrypting the page itself.
+*/
+static void pagerCodecBatchFill(Pager *pPager, PgHdr *pPg){
+  PagerCodecBatch *p = pPager->pCodecBatch;
+  PagerCodecTask aTask[SQLITE_MAX_WORKER_THREADS];
+  SQLiteThread *apThread[SQLITE_MAX_WORKER_THREADS];
+  int nThread = pPager->nCodecThread;
+  int nMax = nThread*SQLITE_CODEC_BATCH_PAGES;
+  int nPer;
+  int rc = SQLITE_OK;
+  int i;
+
+  if( p==0 ){
+    p = (PagerCodecBatch*)sqlite3MallocZero(sizeof(PagerCodecBatch));
+    if( p==0 ) return;
+    p->pPager = pPager;
+    pPager->pCodecBatch = p;
+  }
+  if( p->nAlloc<nMax || p->szPage!=pPager->pageSize ){
+    sqlite3_free(p->apPg);
+    sqlite3_free(p->aBuf);
+    p->apPg = (PgHdr**)sqlite3Malloc(nMax*sizeof(PgHdr*));
+    p->aBuf = (u8*)sqlite3Malloc(nMax*(i64)pPager->pageSize);
+    if( p->apPg==0 || p->aBuf==0 ){
+      sqlite3_free(p->apPg);
+      sqlite3_free(p->aBuf);
+      memset(p, 0, sizeof(PagerCodecBatch));
+      p->pPager = pPager;
+      return;
+    }
+    p->nAlloc = nMax;
+    p->szPage = pPager->pageSize;
+  }
+
+  /* Pages that end up not being written (see pager_write_pagelist()) are
+  ** encrypted needlessly. This is rare and keeps the batch in list order. */
+  p->nPage = 0;
+  p->iNext = 0;
+  for(; pPg && p->nPage<nMax; pPg=pPg->pDirty){
+    p->apPg[p->nPage++] = pPg;
+  }
+  if( p->nPage<2 ){
+    p->nPage = 0;
+    return;
+  }
+
+  if( nThread>p->nPage ) nThread = p->nPage;
+  nPer = (p->nPage + nThread - 1)/nThread;
+  for(i=0; i<nThread; i++){
+    aTask[i].pBatch = p;
+    aTask[i].iFirst = i*nPer;
+    aTask[i].iEnd = MIN((i+1)*nPer, p->nPage);
+  }
+  for(i=1; i<nThread; i++){
+    if( sqlite3ThreadCreate(&apThread[i], pagerCodecBatchTask, &aTask[i]) ){
+      apThread[i] = 0;
+    }
+  }
+  rc = SQLITE_PTR_TO_INT(pagerCodecBatchTask(&aTask[0]));
+  for(i=1; i<nThread; i++){
+    void *pOut = 0;
+    int rc2;
+    if( apThread[i] ){
+      rc2 = sqlite3ThreadJoin(apThread[i], &pOut);
+      if( rc2==SQLITE_OK ) rc2 = SQLITE_PTR_TO_INT(pOut);
+    }else{
+      rc2 = SQLITE_PTR_TO_INT(pagerCodecBatchTask(&aTask[i]));
+    }
+    if( rc==SQLITE_OK ) rc = rc2;
+  }
+  if( rc!=SQLITE_OK ){
+    p->nPage = 0;
+  }
+}
+
+/*
+** Return the encrypted image of page pPg, which is about to be written,
+** from the current batch, filling a new batch if pPg is not part of it.
+** Return NULL if the caller has to encrypt the page itself.
+*/
+static char *pagerCodecBatchGet(Pager *pPager, PgHdr *pPg){
+  PagerCodecBatch *p = pPager->pCodecBatch;
+
+  /* Page 1 is modified just before it is written (the change counter),
+  ** and it is the first page of any sorted list anyway. */
+  if( pPager->nCodecThread<2 || pPager->xCodec==0 || pPg->pgno==1
+   || sqlite3GlobalConfig.bCoreMutex==0
+  ){
+    return 0;
+  }
+  if( p ){
+    while( p->iNext<p->nPage && p->apPg[p->iNext]!=pPg ) p->iNext++;
+  }
+  if( p==0 || p->iNext>=p->nPage ){
+    pagerCodecBatchFill(pPager, pPg);
+    p = pPager->pCodecBatch;
+    if( p==0 || p->nPage==0 ) return 0;
+  }
+  assert( p->apPg[p->iNext]==pPg );
+  return (char*)&p->aBuf[(p->iNext++)*(i64)p->szPage];
+}
+
+/*
+** Discard the pages of the parallel encryption batch of a pager.
+*/
+static void pagerCodecBatchReset(Pager *pPager){
+  if( pPager->pCodecBatch ) pPager->pCodecBatch->nPage = 0;
+}
+
+/*
+** Free the parallel encryption batch of a pager.
+*/
+static void pagerCodecBatchFree(Pager *pPager){
+  PagerCodecBatch *p = pPager->pCodecBatch;
+  if( p ){
+    sqlite3_free(p->apPg);
+    sqlite3_free(p->aBuf);
+    sqlite3_free(p);
+    pPager->pCodecBatch = 0;
+  }
+}
+#else
+# define pagerCodecBatchGet(P,G) 0
+# define pagerCodecBatchReset(P)
+# define pagerCodecBatchFree(P)
+#endif
+
 /*
 ** The argument to this macro is a file descriptor (type sqlite3_file*).
 ** Return 0 if it is not open, or non-zero (but not 1) if it is.
@@ -2016,6 +2227,10 @@ static int pager_end_transaction(Pager *pPager, int hasMaster, int bCommit){
     */
     rc2 = sqlite3WalEndWriteTransaction(pPager->pWal);
     assert( rc2==SQLITE_OK );
+
+    /* With group commit, the WAL is synced once the write-lock is gone */
+    rc2 = sqlite3WalGroupSync(pPager->pWal);
+    if( rc==SQLITE_OK ) rc = rc2;
   }else if( rc==SQLITE_OK && bCommit && pPager->dbFileSize>pPager->dbSize ){
     /* This branch is taken when committing a transaction in rollback-journal
     ** mode if the database file on disk is larger than the database image.
@@ -2132,6 +2347,59 @@ void sqlite3PagerAlignReserve(Pager *pDest, Pager *pSrc){
     pagerReportSize(pDest);
   }
 }
+
+/*
+** Report page size szPage and nReserve reserved bytes per page to the
+** codec of pPager in place of the geometry of pPager itself, or report
+** the geometry of pPager again if szPage is 0. This lets the backup module
+** encode database images with a different page geometry for the file of
+** pPager, see sqlite3PagerCodecPage().
+*/
+void sqlite3PagerCodecSize(Pager *pPager, int szPage, int nReserve){
+  if( szPage==0 ){
+    pagerReportSize(pPager);
+  }else if( pPager->xCodecSizeChng ){
+    pPager->xCodecSizeChng(pPager->pCodec, szPage, nReserve);
+  }
+}
+
+/*
+** Return the error code for page pgno, which the codec of pPager failed
+** to decode (bDecode!=0) or to encode. The codec reports an error of its
+** own for a page it cannot process with the keys it has, such as a page
+** already rekeyed by another connection, or for a page without room for
+** its nonce and tag. Otherwise a page that fails to decode is corrupt and
+** a page that fails to encode ran out of memory.
+*/
+static int pagerCodecError(Pager *pPager, Pgno pgno, int bDecode){
+  int rc = sqlite3CodecPageError(pPager->pCodec, pgno, bDecode);
+  if( rc==SQLITE_OK ){
+    rc = bDecode ? SQLITE_CORRUPT_BKPT : SQLITE_NOMEM_BKPT;
+  }
+  return rc;
+}
+
+/*
+** Encrypt (bEncode!=0) or decrypt (bEncode==0) buffer pData in place with
+** the codec of pPager, as page pgno. The page size is the one last
+** reported to the codec. Except for page 1, this may be called by several
+** threads at once, as long as the geometry reported to the codec does not
+** change meanwhile.
+**
+** Return SQLITE_OK, SQLITE_NOMEM if encryption fails, SQLITE_CORRUPT if
+** the page fails authentication, or the error reported by the codec.
+*/
+int sqlite3PagerCodecPage(Pager *pPager, void *pData, Pgno pgno, int bEncode){
+  int rc = SQLITE_OK;
+  if( bEncode ){
+    if( pPager->xCodec && pPager->xCodec(pPager->pCodec, pData, pgno, 8)==0 ){
+      rc = pagerCodecError(pPager, pgno, 0);
+    }
+  }else{
+    CODEC1(pPager, pData, pgno, 3, rc = pagerCodecError(pPager, pgno, 1));
+  }
+  return rc;
+}
 #endif
 
 /*
@@ -2313,7 +2581,7 @@ static int pager_playback_one_page(
       pPager->dbFileSize = pgno;
     }
     if( pPager->pBackup ){
-      CODEC1(pPager, aData, pgno, 3, rc=SQLITE_NOMEM_BKPT);
+      CODEC1(pPager, aData, pgno, 3, rc=SQLITE_CORRUPT_BKPT);
       sqlite3BackupUpdate(pPager->pBackup, pgno, (u8*)aData);
       CODEC2(pPager, aData, pgno, 7, rc=SQLITE_NOMEM_BKPT, aData);
     }
@@ -2387,7 +2655,7 @@ static int pager_playback_one_page(
     }
 
     /* Decode the page just read from disk */
-    CODEC1(pPager, pData, pPg->pgno, 3, rc=SQLITE_NOMEM_BKPT);
+    CODEC1(pPager, pData, pPg->pgno, 3, rc=SQLITE_CORRUPT_BKPT);
     sqlite3PcacheRelease(pPg);
   }
   return rc;
@@ -2902,6 +3170,9 @@ static int readDbPage(PgHdr *pPg, u32 iFrame){
   Pgno pgno = pPg->pgno;       /* Page number to read */
   int rc = SQLITE_OK;          /* Return code */
   int pgsz = pPager->pageSize; /* Number of bytes to read */
+#ifdef SQLITE_HAS_CODEC
+  int bHole = 0;               /* True if the page lies beyond the file */
+#endif
 
   assert( pPager->eState>=PAGER_READER && !MEMDB );
   assert( isOpen(pPager->fd) );
@@ -2914,9 +3185,36 @@ static int readDbPage(PgHdr *pPg, u32 iFrame){
 #endif
   {
     i64 iOffset = (pgno-1)*(i64)pPager->pageSize;
-    rc = sqlite3OsRead(pPager->fd, pPg->pData, pgsz, iOffset);
-    if( rc==SQLITE_IOERR_SHORT_READ ){
-      rc = SQLITE_OK;
+#ifdef SQLITE_HAS_CODEC
+    void *pMap = 0;
+    if( pPager->bCodecMmap && pPager->xCodec && USEFETCH(pPager) ){
+      /* An encrypted page cannot be used in place within the mapping.
+      ** Copy the ciphertext straight into the cache buffer instead (it
+      ** is decrypted there below), avoiding the read() system call.  If
+      ** the page lies beyond the mapped region, fall back to xRead. */
+      rc = sqlite3OsFetch(pPager->fd, iOffset, pgsz, &pMap);
+      if( pMap ){
+        memcpy(pPg->pData, pMap, pgsz);
+        sqlite3OsUnfetch(pPager->fd, iOffset, pMap);
+      }
+    }
+    if( pMap==0 && rc==SQLITE_OK )
+#endif
+    {
+      rc = sqlite3OsRead(pPager->fd, pPg->pData, pgsz, iOffset);
+      if( rc==SQLITE_IOERR_SHORT_READ ){
+        rc = SQLITE_OK;
+#ifdef SQLITE_HAS_CODEC
+        /* A page that starts at or beyond the end of the file has never
+        ** been written. It reads as zeros and is not decoded. A page that
+        ** is only partly within the file is decoded and fails. */
+        if( pPager->xCodec ){
+          i64 szFile = 0;
+          rc = sqlite3OsFileSize(pPager->fd, &szFile);
+          bHole = (iOffset>=szFile);
+        }
+#endif
+      }
     }
   }
 
@@ -2940,7 +3238,11 @@ static int readDbPage(PgHdr *pPg, u32 iFrame){
       memcpy(&pPager->dbFileVers, dbFileVers, sizeof(pPager->dbFileVers));
     }
   }
-  CODEC1(pPager, pPg->pData, pgno, 3, rc = SQLITE_NOMEM_BKPT);
+#ifdef SQLITE_HAS_CODEC
+  if( !bHole ){
+    CODEC1(pPager, pPg->pData, pgno, 3, rc = pagerCodecError(pPager, pgno, 1));
+  }
+#endif
 
   PAGER_INCR(sqlite3_pager_readdb_count);
   PAGER_INCR(pPager->nRead);
@@ -3097,6 +3399,7 @@ static int pagerWalFrames(
   pPager->aStat[PAGER_STAT_WRITE] += nList;
 
   if( pList->pgno==1 ) pager_write_changecounter(pList);
+  pagerCodecBatchReset(pPager);
   rc = sqlite3WalFrames(pPager->pWal, 
       pPager->pageSize, pList, nTruncate, isCommit, pPager->walSyncFlags
   );
@@ -4050,6 +4353,7 @@ int sqlite3PagerClose(Pager *pPager){
 
 #ifdef SQLITE_HAS_CODEC
   if( pPager->xCodecFree ) pPager->xCodecFree(pPager->pCodec);
+  pagerCodecBatchFree(pPager);
 #endif
 
   assert( !pPager->aSavepoint && !pPager->pInJournal );
@@ -4283,6 +4587,7 @@ static int pager_write_pagelist(Pager *pPager, PgHdr *pList){
     pPager->dbHintSize = pPager->dbSize;
   }
 
+  pagerCodecBatchReset(pPager);
   while( rc==SQLITE_OK && pList ){
     Pgno pgno = pList->pgno;
 
@@ -4292,9 +4597,13 @@ static int pager_write_pagelist(Pager *pPager, PgHdr *pList){
     ** any such pages to the file.
     **
     ** Also, do not write out any page that has the PGHDR_DONT_WRITE flag
-    ** set (set by sqlite3PagerDontWrite()).
+    ** set (set by sqlite3PagerDontWrite()), unless it lies beyond the end
+    ** of an encrypted database file. Skipping it would leave a hole of
+    ** zeros within the file, which the codec rejects when it is read.
     */
-    if( pgno<=pPager->dbSize && 0==(pList->flags&PGHDR_DONT_WRITE) ){
+    if( pgno<=pPager->dbSize
+     && (0==(pList->flags&PGHDR_DONT_WRITE) || CODEC_HOLE(pPager, pgno))
+    ){
       i64 offset = (pgno-1)*(i64)pPager->pageSize;   /* Offset to write */
       char *pData;                                   /* Data to write */    
 
@@ -4302,7 +4611,15 @@ static int pager_write_pagelist(Pager *pPager, PgHdr *pList){
       if( pList->pgno==1 ) pager_write_changecounter(pList);
 
       /* Encode the database */
+#ifdef SQLITE_HAS_CODEC
+      pData = pagerCodecBatchGet(pPager, pList);
+      if( pData==0 ){
+        CODEC2(pPager, pList->pData, pgno, 6,
+               return pagerCodecError(pPager, pgno, 0), pData);
+      }
+#else
       CODEC2(pPager, pList->pData, pgno, 6, return SQLITE_NOMEM_BKPT, pData);
+#endif
 
       /* Write out the page data. */
       rc = sqlite3OsWrite(pPager->fd, pData, pPager->pageSize, offset);
@@ -4392,7 +4709,8 @@ static int subjournalPage(PgHdr *pPg){
       i64 offset = (i64)pPager->nSubRec*(4+pPager->pageSize);
       char *pData2;
   
-      CODEC2(pPager, pData, pPg->pgno, 7, return SQLITE_NOMEM_BKPT, pData2);
+      CODEC2(pPager, pData, pPg->pgno, 7,
+             return pagerCodecError(pPager, pPg->pgno, 0), pData2);
       PAGERTRACE(("STMT-JOURNAL %d page %d\n", PAGERID(pPager), pPg->pgno));
       rc = write32bits(pPager->sjfd, offset, pPg->pgno);
       if( rc==SQLITE_OK ){
@@ -5700,7 +6018,8 @@ static SQLITE_NOINLINE int pagerAddPageToRollbackJournal(PgHdr *pPg){
   assert( pPg->pgno!=PAGER_MJ_PGNO(pPager) );
 
   assert( pPager->journalHdr<=pPager->journalOff );
-  CODEC2(pPager, pPg->pData, pPg->pgno, 7, return SQLITE_NOMEM_BKPT, pData2);
+  CODEC2(pPager, pPg->pData, pPg->pgno, 7,
+         return pagerCodecError(pPager, pPg->pgno, 0), pData2);
   cksum = pager_cksum(pPager, (u8*)pData2);
 
   /* Even if an IO or diskfull error occurs while journalling the
@@ -6743,6 +7062,21 @@ void *sqlite3PagerGetCodec(Pager *pPager){
   return pPager->pCodec;
 }
 
+/*
+** Enable (bMmap>0) or disable (bMmap==0) reading the pages of an encrypted
+** database through the memory mapping configured by "PRAGMA mmap_size".
+** If bMmap is negative, the setting is left unchanged. Return the current
+** setting.
+**
+** Unlike an unencrypted database, the mapped pages are never handed out
+** directly. Each page is copied from the mapping into a page cache buffer
+** and decrypted there, so this is safe within write transactions too.
+*/
+int sqlite3PagerCodecMmap(Pager *pPager, int bMmap){
+  if( bMmap>=0 ) pPager->bCodecMmap = (u8)(bMmap!=0);
+  return pPager->bCodecMmap;
+}
+
 /*
 ** This function is called by the wal module when writing page content
 ** into the log file.
@@ -6751,11 +7085,29 @@ void *sqlite3PagerGetCodec(Pager *pPager){
 ** page content. If a malloc fails, this function may return NULL.
 */
 void *sqlite3PagerCodec(PgHdr *pPg){
-  void *aData = 0;
-  CODEC2(pPg->pPager, pPg->pData, pPg->pgno, 6, return 0, aData);
+  void *aData = pagerCodecBatchGet(pPg->pPager, pPg);
+  if( aData==0 ){
+    CODEC2(pPg->pPager, pPg->pData, pPg->pgno, 6, return 0, aData);
+  }
   return aData;
 }
 
+/*
+** Set the number of threads used to encrypt the pages written to the
+** database file or the WAL, if nThread is positive. Return the current
+** setting. The codec must support encrypting a copy of a page in place
+** (mode 8) for more than one thread to be used.
+*/
+int sqlite3PagerCodecThreads(Pager *pPager, int nThread){
+  if( nThread>0 ){
+    if( nThread>SQLITE_MAX_WORKER_THREADS ) nThread = SQLITE_MAX_WORKER_THREADS;
+    if( nThread<1 ) nThread = 1;
+    pPager->nCodecThread = nThread;
+    if( nThread<2 ) pagerCodecBatchFree(pPager);
+  }
+  return pPager->nCodecThread>1 ? pPager->nCodecThread : 1;
+}
+
 /*
 ** Return the current pager state
 */
@@ -7157,6 +7509,44 @@ int sqlite3PagerCheckpoint(Pager *pPager, int eMode, int *pnLog, int *pnCkpt){
   return rc;
 }
 
+/*
+** Get/set the maximum number of frames backfilled by a single PASSIVE
+** checkpoint (0 for no limit) and the number of threads used by
+** checkpoints (see "PRAGMA wal_checkpoint_step" and "PRAGMA
+** wal_checkpoint_threads"). A negative argument is a no-op.
+*/
+int sqlite3PagerCkptStep(Pager *pPager, int nStep){
+  if( nStep>=0 ){
+    pPager->nCkptStep = nStep;
+    sqlite3WalCheckpointConfig(pPager->pWal,
+        pPager->nCkptStep, pPager->nCkptThread);
+  }
+  return pPager->nCkptStep;
+}
+int sqlite3PagerCkptThreads(Pager *pPager, int nThread){
+  if( nThread>=0 ){
+    pPager->nCkptThread = (nThread>1 && SQLITE_MAX_WORKER_THREADS>0) ? 2 : 1;
+    sqlite3WalCheckpointConfig(pPager->pWal,
+        pPager->nCkptStep, pPager->nCkptThread);
+  }
+  return pPager->nCkptThread>1 ? 2 : 1;
+}
+
+/*
+** Get/set whether commits share WAL syncs with the commits of other
+** connections (see "PRAGMA wal_group_commit"). A negative argument is a
+** no-op.
+*/
+int sqlite3PagerGroupCommit(Pager *pPager, int bEnable){
+  if( bEnable>=0 ){
+    pPager->bGroupCommit = (bEnable!=0);
+    if( sqlite3WalGroupCommit(pPager->pWal, pPager->bGroupCommit) ){
+      pPager->bGroupCommit = 0;
+    }
+  }
+  return pPager->bGroupCommit;
+}
+
 int sqlite3PagerWalCallback(Pager *pPager){
   return sqlite3WalCallback(pPager->pWal);
 }
@@ -7219,6 +7609,13 @@ static int pagerOpenWal(Pager *pPager){
         pPager->journalSizeLimit, &pPager->pWal
     );
   }
+  if( rc==SQLITE_OK ){
+    sqlite3WalCheckpointConfig(pPager->pWal,
+        pPager->nCkptStep, pPager->nCkptThread);
+    if( sqlite3WalGroupCommit(pPager->pWal, pPager->bGroupCommit) ){
+      pPager->bGroupCommit = 0;
+    }
+  }
   pagerFixMaplimit(pPager);
 
   return rc;
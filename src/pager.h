@@ -121,6 +121,10 @@ void sqlite3PagerSetBusyhandler(Pager*, int(*)(void *), void *);
 int sqlite3PagerSetPagesize(Pager*, u32*, int);
 #ifdef SQLITE_HAS_CODEC
 void sqlite3PagerAlignReserve(Pager*,Pager*);
+void sqlite3PagerCodecSize(Pager*, int, int);
+int sqlite3PagerCodecPage(Pager*, void*, Pgno, int);
+int sqlite3PagerCodecMmap(Pager*, int);
+int sqlite3PagerCodecThreads(Pager*, int);
 #endif
 int sqlite3PagerMaxPageCount(Pager*, int);
 void sqlite3PagerSetCachesize(Pager*, int);
@@ -165,6 +169,9 @@ int sqlite3PagerSharedLock(Pager *pPager);
 
 #ifndef SQLITE_OMIT_WAL
   int sqlite3PagerCheckpoint(Pager *pPager, int, int*, int*);
+  int sqlite3PagerCkptStep(Pager*, int);
+  int sqlite3PagerCkptThreads(Pager*, int);
+  int sqlite3PagerGroupCommit(Pager*, int);
   int sqlite3PagerWalSupported(Pager *pPager);
   int sqlite3PagerWalCallback(Pager *pPager);
   int sqlite3PagerOpenWal(Pager *pPager, int *pisOpen);
@@ -82,6 +82,19 @@
 */
 #include "sqliteInt.h"
 
+/*
+** The huge-page slab (see below) needs anonymous memory mappings and
+** atomic operations.
+*/
+#if defined(SQLITE_ENABLE_PCACHE_HUGEPAGE) && SQLITE_OS_UNIX \
+ && defined(__GNUC__)
+# define PCACHE1_HUGEPAGE 1
+# include <sys/mman.h>
+# include <sched.h>
+#else
+# define PCACHE1_HUGEPAGE 0
+#endif
+
 typedef struct PCache1 PCache1;
 typedef struct PgHdr1 PgHdr1;
 typedef struct PgFreeslot PgFreeslot;
@@ -96,9 +109,12 @@ typedef struct PGroup PGroup;
 struct PgHdr1 {
   sqlite3_pcache_page page;      /* Base class. Must be first. pBuf & pExtra */
   unsigned int iKey;             /* Key value (page number) */
+  u32 iLru;                      /* pcache1.iLruClock when last unpinned */
   u8 isPinned;                   /* Page in use, not on the LRU list */
   u8 isBulkLocal;                /* This page from bulk local storage */
   u8 isAnchor;                   /* This is the PGroup.lru element */
+  u8 isProbation;                /* On the PGroup.lruIn list (2Q only) */
+  u8 isHot;                      /* Referenced again since it was loaded */
   PgHdr1 *pNext;                 /* Next in hash table chain */
   PCache1 *pCache;               /* Cache that currently owns this page */
   PgHdr1 *pLruNext;              /* Next in LRU list of unpinned pages */
@@ -123,9 +139,30 @@ struct PgHdr1 {
 ** and is therefore often faster.  Mode 2 requires a mutex in order to be
 ** threadsafe, but recycles pages more efficiently.
 **
-** For mode (1), PGroup.mutex is NULL.  For mode (2) there is only a single
-** PGroup which is the pcache1.grp global variable and its mutex is
-** SQLITE_MUTEX_STATIC_LRU.
+** For mode (1), PGroup.mutex is NULL.  For mode (2) the global pool is
+** striped into pcache1.nGroup PGroups (shards) held in pcache1.aGroup[].
+** Each PCache is assigned to one shard when it is created and only ever
+** recycles pages from the LRU list of that shard, so PCaches in different
+** shards never contend for the same mutex.  The mutex of the first shard
+** is SQLITE_MUTEX_STATIC_LRU, the others are allocated by xInit.  With a
+** single shard (the default) this is the classic unified cache.
+**
+** The unpinned pages of a PGroup are recycled in the order given by the
+** replacement policy set with SQLITE_CONFIG_PCACHE_POLICY:
+**
+**   LRU  All unpinned pages are on the PGroup.lru list, most recently
+**        unpinned first.  Recycling takes the tail of the list.
+**
+**   2Q   A page loaded into the cache is on probation: when unpinned it goes
+**        to the PGroup.lruIn list.  Only once it is fetched again after
+**        being unpinned does it become "hot" and move to PGroup.lru.  Pages
+**        are recycled from the tail of lruIn while lruIn holds more than a
+**        quarter of nMaxPage, otherwise from the tail of lru.  So a scan,
+**        that touches each page once, can only ever displace the pages on
+**        probation and never the hot pages.  The ghost table aGhost[]
+**        remembers (a hash of) pages recently recycled from lruIn.  A page
+**        loaded again while it is remembered there was recycled too early
+**        and is hot from the start.
 */
 struct PGroup {
   sqlite3_mutex *mutex;          /* MUTEX_STATIC_LRU or NULL */
@@ -134,6 +171,11 @@ struct PGroup {
   unsigned int mxPinned;         /* nMaxpage + 10 - nMinPage */
   unsigned int nCurrentPage;     /* Number of purgeable pages allocated */
   PgHdr1 lru;                    /* The beginning and end of the LRU list */
+  PgHdr1 lruIn;                  /* Pages on probation (2Q only) */
+  unsigned int nProbation;       /* Number of pages on lruIn */
+  unsigned int nGhost;           /* Number of slots in aGhost[] */
+  u32 *aGhost;                   /* Hashes of pages recycled from lruIn */
+  u32 nHit, nMiss, nGhostHit;    /* Counts not yet added to sqlite3_status() */
 };
 
 /* Each page cache is an instance of the following object.  Every
@@ -183,7 +225,13 @@ struct PgFreeslot {
 ** Global data used by this cache.
 */
 static SQLITE_WSD struct PCacheGlobal {
-  PGroup grp;                    /* The global PGroup for mode (2) */
+  PGroup aGroup[SQLITE_MAX_PCACHE_SHARDS];  /* PGroup shards for mode (2) */
+  int nGroup;                    /* Number of shards in use in aGroup[] */
+  unsigned int iNextGroup;       /* Shard for the next PCache created */
+  /* Unpin counter of the shards, used to approximate a global LRU order
+  ** when memory is released.  It is incremented without a mutex, so
+  ** concurrent unpins in different shards may share a value. */
+  u32 iLruClock;
 
   /* Variables related to SQLITE_CONFIG_PAGECACHE settings.  The
   ** szSlot, nSlot, pStart, pEnd, nReserve, and isInit values are all
@@ -192,6 +240,7 @@ static SQLITE_WSD struct PCacheGlobal {
   */
   int isInit;                    /* True if initialized */
   int separateCache;             /* Use a new PGroup for each PCache */
+  int ePolicy;                   /* SQLITE_PCACHE_POLICY_LRU or _2Q */
   int nInitPage;                 /* Initial bulk allocation size */   
   int szSlot;                    /* Size of each free slot */
   int nSlot;                     /* The number of pcache slots */
@@ -206,6 +255,28 @@ static SQLITE_WSD struct PCacheGlobal {
   ** (2) even if an incorrect value is read, no great harm is done since this
   ** is really just an optimization. */
   int bUnderPressure;            /* True if low on PAGECACHE memory */
+
+#if PCACHE1_HUGEPAGE
+  /* The huge-page slab.  Fixed at sqlite3_initialize() time except for
+  ** the free list and the chunk states, which are only accessed with
+  ** atomic operations. */
+  struct PCache1Slab {
+    char *pStart, *pEnd;         /* Bounds of the slots */
+    void *pMap;                  /* Start of the mapping, for munmap() */
+    size_t szMap;                /* Size of the mapping */
+    int szSlot;                  /* Size of each slot */
+    int nSlotPerChunk;           /* Slots in each PCACHE1_CHUNK bytes */
+    u32 nSlot;                   /* Total number of slots */
+    u32 nChunk;                  /* Number of chunks */
+    u32 nReserve;                /* Under pressure if fewer slots free */
+    u32 *aNext;                  /* Free list links, one per slot */
+    int *aUsed;                  /* Slots in use per chunk, -1 if releasing */
+    u8 *aReleased;               /* True if chunk memory returned to OS */
+    u64 iHead;                   /* Free list: tag<<32 | (first slot+1) */
+    u32 nFree;                   /* Number of free slots */
+    u32 nEmpty;                  /* Chunks emptied since the last release */
+  } slab;
+#endif
 } pcache1_g;
 
 /*
@@ -228,6 +299,249 @@ static SQLITE_WSD struct PCacheGlobal {
 # define PCACHE1_MIGHT_USE_GROUP_MUTEX 1
 #endif
 
+#ifdef SQLITE_DEBUG
+/*
+** Return true if the calling thread holds none of the PGroup mutexes.
+** Used within assert() statements only.
+*/
+static int pcache1GroupMutexNotHeld(void){
+  int i;
+  for(i=0; i<pcache1.nGroup; i++){
+    if( !sqlite3_mutex_notheld(pcache1.aGroup[i].mutex) ) return 0;
+  }
+  return 1;
+}
+#endif
+
+/******************************************************************************/
+/******** Huge-page Slab ******************************************************/
+
+#if PCACHE1_HUGEPAGE
+/*
+** If SQLite is built with SQLITE_ENABLE_PCACHE_HUGEPAGE and configured with
+** sqlite3_config(SQLITE_CONFIG_PCACHE_HUGEPAGE, sz, nByte), page buffers
+** are carved out of a single anonymous mapping of nByte bytes, backed by
+** huge pages if possible (MAP_HUGETLB, or else transparent huge pages
+** requested with madvise()).  This keeps the TLB footprint of a very large
+** page cache small.
+**
+** The mapping is divided into chunks of PCACHE1_CHUNK bytes (the huge page
+** size) and each chunk into slots of sz bytes.  Free slots are kept on a
+** lock-free stack.  The links of the stack are stored outside of the slots,
+** in aNext[], and the head is tagged with a counter against the ABA problem.
+** Only the SQLITE_STATUS_PAGECACHE_USED counter, which includes the slots
+** of the slab in use, is updated under pcache1.mutex.
+**
+** Each chunk counts the slots in use.  sqlite3PcacheReleaseMemory() returns
+** the memory of chunks without any used slot to the operating system with
+** MADV_DONTNEED.  While it does so the count of the chunk is -1, which
+** makes threads that popped a slot of the chunk wait before using it.
+*/
+#ifndef PCACHE1_CHUNK
+# define PCACHE1_CHUNK (2*1024*1024)
+#endif
+
+/*
+** Pop a slot off the free list.  Return its index plus one, or 0 if the
+** free list is empty.
+*/
+static u32 pcache1SlabPop(void){
+  u64 iOld, iNew;
+  u32 iSlot;
+  do{
+    iOld = __atomic_load_n(&pcache1.slab.iHead, __ATOMIC_ACQUIRE);
+    iSlot = (u32)iOld;
+    if( iSlot==0 ) return 0;
+    iNew = (((iOld>>32)+1)<<32)
+         | __atomic_load_n(&pcache1.slab.aNext[iSlot-1], __ATOMIC_RELAXED);
+  }while( !__atomic_compare_exchange_n(&pcache1.slab.iHead, &iOld, iNew, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) );
+  __atomic_sub_fetch(&pcache1.slab.nFree, 1, __ATOMIC_RELAXED);
+  return iSlot;
+}
+
+/*
+** Push the slot with index iSlot plus one onto the free list.
+*/
+static void pcache1SlabPush(u32 iSlot){
+  u64 iOld, iNew;
+  iOld = __atomic_load_n(&pcache1.slab.iHead, __ATOMIC_ACQUIRE);
+  do{
+    __atomic_store_n(&pcache1.slab.aNext[iSlot-1], (u32)iOld,
+                     __ATOMIC_RELAXED);
+    iNew = (((iOld>>32)+1)<<32) | iSlot;
+  }while( !__atomic_compare_exchange_n(&pcache1.slab.iHead, &iOld, iNew, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) );
+  __atomic_add_fetch(&pcache1.slab.nFree, 1, __ATOMIC_RELAXED);
+}
+
+/*
+** Return a slot of the slab, or NULL if all slots are in use.
+*/
+static void *pcache1SlabAlloc(void){
+  u32 iSlot = pcache1SlabPop();
+  u32 iChunk;
+  int *pUsed;
+  int n;
+  if( iSlot==0 ) return 0;
+  iSlot--;
+  iChunk = iSlot / pcache1.slab.nSlotPerChunk;
+  pUsed = &pcache1.slab.aUsed[iChunk];
+  n = __atomic_load_n(pUsed, __ATOMIC_ACQUIRE);
+  for(;;){
+    if( n<0 ){
+      /* The chunk is being returned to the OS.  Wait until it is done. */
+      sched_yield();
+      n = __atomic_load_n(pUsed, __ATOMIC_ACQUIRE);
+    }else if( __atomic_compare_exchange_n(pUsed, &n, n+1, 0,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) ){
+      break;
+    }
+  }
+  if( n==0 ){
+    __atomic_store_n(&pcache1.slab.aReleased[iChunk], 0, __ATOMIC_RELAXED);
+  }
+  return &pcache1.slab.pStart[(sqlite3_int64)iChunk*PCACHE1_CHUNK
+           + (iSlot % pcache1.slab.nSlotPerChunk)*pcache1.slab.szSlot];
+}
+
+/*
+** Return slot p to the slab.
+*/
+static void pcache1SlabFree(void *p){
+  sqlite3_int64 iOff = (char*)p - pcache1.slab.pStart;
+  u32 iChunk = (u32)(iOff / PCACHE1_CHUNK);
+  u32 iSlot = iChunk*pcache1.slab.nSlotPerChunk
+            + (u32)((iOff % PCACHE1_CHUNK) / pcache1.slab.szSlot);
+  assert( iSlot<pcache1.slab.nSlot );
+  if( __atomic_sub_fetch(&pcache1.slab.aUsed[iChunk], 1, __ATOMIC_ACQ_REL)
+        ==0
+  ){
+    __atomic_add_fetch(&pcache1.slab.nEmpty, 1, __ATOMIC_RELAXED);
+  }
+  pcache1SlabPush(iSlot+1);
+}
+
+#ifdef SQLITE_ENABLE_MEMORY_MANAGEMENT
+/*
+** Return the memory of all chunks without a slot in use to the OS.
+*/
+static void pcache1SlabRelease(void){
+  u32 i;
+  if( __atomic_exchange_n(&pcache1.slab.nEmpty, 0, __ATOMIC_ACQ_REL)==0 ){
+    return;
+  }
+  for(i=0; i<pcache1.slab.nChunk; i++){
+    int *pUsed = &pcache1.slab.aUsed[i];
+    int n = 0;
+    if( __atomic_load_n(&pcache1.slab.aReleased[i], __ATOMIC_RELAXED) ){
+      continue;
+    }
+    if( __atomic_compare_exchange_n(pUsed, &n, -1, 0,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) ){
+      madvise(&pcache1.slab.pStart[(sqlite3_int64)i*PCACHE1_CHUNK],
+              PCACHE1_CHUNK, MADV_DONTNEED);
+      __atomic_store_n(&pcache1.slab.aReleased[i], 1, __ATOMIC_RELAXED);
+      __atomic_store_n(pUsed, 0, __ATOMIC_RELEASE);
+    }
+  }
+}
+#endif /* SQLITE_ENABLE_MEMORY_MANAGEMENT */
+
+/*
+** Map the slab configured with SQLITE_CONFIG_PCACHE_HUGEPAGE, if any.  If
+** the mapping fails, SQLite runs without the slab.
+**
+** This routine is called from pcache1Init() and so it is guaranteed to be
+** serialized already.
+*/
+static void pcache1SlabInit(void){
+  sqlite3_int64 nByte = sqlite3GlobalConfig.nHugeByte;
+  int szSlot = ROUND8(sqlite3GlobalConfig.szHugeSlot);
+  size_t szMap;
+  char *pMap;
+  char *pStart;
+  u32 i;
+
+  if( nByte<=0 || szSlot<=0 || szSlot>PCACHE1_CHUNK ) return;
+  nByte = (nByte + PCACHE1_CHUNK - 1) & ~(sqlite3_int64)(PCACHE1_CHUNK-1);
+  if( nByte/PCACHE1_CHUNK*(PCACHE1_CHUNK/szSlot) >= 0xffffffff ) return;
+  szMap = (size_t)nByte;
+  if( (sqlite3_int64)szMap!=nByte ) return;
+
+#ifdef MAP_HUGETLB
+  /* Without MAP_NORESERVE, this fails unless the system has enough huge
+  ** pages reserved for the whole slab, instead of raising SIGBUS later. */
+  pMap = mmap(0, szMap, PROT_READ|PROT_WRITE,
+              MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+  if( pMap!=MAP_FAILED ){
+    pStart = pMap;
+  }else
+#endif
+  {
+    /* No huge pages reserved with the system.  Map normal pages aligned to
+    ** PCACHE1_CHUNK and ask for transparent huge pages. */
+    szMap += PCACHE1_CHUNK;
+    pMap = mmap(0, szMap, PROT_READ|PROT_WRITE,
+                MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if( pMap==MAP_FAILED ) return;
+    pStart = (char*)(((uptr)pMap + PCACHE1_CHUNK - 1)
+                     & ~(uptr)(PCACHE1_CHUNK-1));
+#ifdef MADV_HUGEPAGE
+    madvise(pStart, (size_t)nByte, MADV_HUGEPAGE);
+#endif
+  }
+
+  pcache1.slab.nChunk = (u32)(nByte/PCACHE1_CHUNK);
+  pcache1.slab.nSlotPerChunk = PCACHE1_CHUNK/szSlot;
+  pcache1.slab.nSlot = pcache1.slab.nChunk*pcache1.slab.nSlotPerChunk;
+  pcache1.slab.aNext = (u32*)sqlite3Malloc(
+      (sizeof(u32)*pcache1.slab.nSlot)
+    + (sizeof(int)+1)*(sqlite3_int64)pcache1.slab.nChunk
+  );
+  if( pcache1.slab.aNext==0 ){
+    munmap(pMap, szMap);
+    memset(&pcache1.slab, 0, sizeof(pcache1.slab));
+    return;
+  }
+  pcache1.slab.aUsed = (int*)&pcache1.slab.aNext[pcache1.slab.nSlot];
+  pcache1.slab.aReleased = (u8*)&pcache1.slab.aUsed[pcache1.slab.nChunk];
+  memset(pcache1.slab.aUsed, 0, (sizeof(int)+1)*pcache1.slab.nChunk);
+  pcache1.slab.pMap = pMap;
+  pcache1.slab.szMap = szMap;
+  pcache1.slab.pStart = pStart;
+  pcache1.slab.pEnd = pStart + nByte;
+  pcache1.slab.szSlot = szSlot;
+  pcache1.slab.nReserve = pcache1.slab.nSlot>90 ? 10
+                                                 : (pcache1.slab.nSlot/10+1);
+
+  /* Put all slots on the free list, lowest address first */
+  for(i=0; i<pcache1.slab.nSlot; i++){
+    pcache1.slab.aNext[i] = (i+1<pcache1.slab.nSlot) ? i+2 : 0;
+  }
+  pcache1.slab.iHead = 1;
+  pcache1.slab.nFree = pcache1.slab.nSlot;
+}
+
+/*
+** Unmap the slab.  Called by pcache1Shutdown().
+*/
+static void pcache1SlabShutdown(void){
+  if( pcache1.slab.pMap ){
+    munmap(pcache1.slab.pMap, pcache1.slab.szMap);
+    sqlite3_free(pcache1.slab.aNext);
+  }
+  memset(&pcache1.slab, 0, sizeof(pcache1.slab));
+}
+
+/*
+** True if p is a slot of the slab
+*/
+# define pcache1InSlab(p) SQLITE_WITHIN(p,pcache1.slab.pStart,pcache1.slab.pEnd)
+#else
+# define pcache1InSlab(p) 0
+#endif /* PCACHE1_HUGEPAGE */
+
 /******************************************************************************/
 /******** Page Allocation/SQLITE_CONFIG_PCACHE Related Functions **************/
 
@@ -311,7 +625,19 @@ static int pcache1InitBulk(PCache1 *pCache){
 */
 static void *pcache1Alloc(int nByte){
   void *p = 0;
-  assert( sqlite3_mutex_notheld(pcache1.grp.mutex) );
+  assert( pcache1GroupMutexNotHeld() );
+#if PCACHE1_HUGEPAGE
+  if( nByte<=pcache1.slab.szSlot ){
+    p = pcache1SlabAlloc();
+    if( p ){
+      sqlite3_mutex_enter(pcache1.mutex);
+      sqlite3StatusHighwater(SQLITE_STATUS_PAGECACHE_SIZE, nByte);
+      sqlite3StatusUp(SQLITE_STATUS_PAGECACHE_USED, 1);
+      sqlite3_mutex_leave(pcache1.mutex);
+      return p;
+    }
+  }
+#endif
   if( nByte<=pcache1.szSlot ){
     sqlite3_mutex_enter(pcache1.mutex);
     p = (PgHdr1 *)pcache1.pFree;
@@ -349,6 +675,15 @@ static void *pcache1Alloc(int nByte){
 */
 static void pcache1Free(void *p){
   if( p==0 ) return;
+#if PCACHE1_HUGEPAGE
+  if( pcache1InSlab(p) ){
+    sqlite3_mutex_enter(pcache1.mutex);
+    sqlite3StatusDown(SQLITE_STATUS_PAGECACHE_USED, 1);
+    sqlite3_mutex_leave(pcache1.mutex);
+    pcache1SlabFree(p);
+    return;
+  }
+#endif
   if( SQLITE_WITHIN(p, pcache1.pStart, pcache1.pEnd) ){
     PgFreeslot *pSlot;
     sqlite3_mutex_enter(pcache1.mutex);
@@ -381,6 +716,9 @@ static void pcache1Free(void *p){
 ** Return the size of a pcache allocation
 */
 static int pcache1MemSize(void *p){
+#if PCACHE1_HUGEPAGE
+  if( pcache1InSlab(p) ) return pcache1.slab.szSlot;
+#endif
   if( p>=pcache1.pStart && p<pcache1.pEnd ){
     return pcache1.szSlot;
   }else{
@@ -412,7 +750,8 @@ static PgHdr1 *pcache1AllocPage(PCache1 *pCache, int benignMalloc){
     ** is because it might call sqlite3_release_memory(), which assumes that 
     ** this mutex is not held. */
     assert( pcache1.separateCache==0 );
-    assert( pCache->pGroup==&pcache1.grp );
+    assert( pCache->pGroup>=pcache1.aGroup
+         && pCache->pGroup<&pcache1.aGroup[pcache1.nGroup] );
     pcache1LeaveMutex(pCache->pGroup);
 #endif
     if( benignMalloc ){ sqlite3BeginBenignMalloc(); }
@@ -500,6 +839,12 @@ void sqlite3PageFree(void *p){
 ** the heap even further.
 */
 static int pcache1UnderMemoryPressure(PCache1 *pCache){
+#if PCACHE1_HUGEPAGE
+  if( pcache1.slab.nSlot && pCache->szAlloc<=pcache1.slab.szSlot ){
+    return __atomic_load_n(&pcache1.slab.nFree, __ATOMIC_RELAXED)
+               < pcache1.slab.nReserve;
+  }
+#endif
   if( pcache1.nSlot && (pCache->szPage+pCache->szExtra)<=pcache1.szSlot ){
     return pcache1.bUnderPressure;
   }else{
@@ -507,6 +852,129 @@ static int pcache1UnderMemoryPressure(PCache1 *pCache){
   }
 }
 
+/*
+** Fetches are counted in the PGroup and added to the SQLITE_STATUS_PAGECACHE_*
+** counters of sqlite3_status() in batches of this many, so that the global
+** pcache1.mutex is rarely taken.
+*/
+#define PCACHE1_STAT_BATCH 256
+
+/*
+** Add the fetch counts of pGroup to the sqlite3_status() counters.
+*/
+static void pcache1FlushStats(PGroup *pGroup){
+  sqlite3_mutex_enter(pcache1.mutex);
+  sqlite3StatusUp(SQLITE_STATUS_PAGECACHE_HIT, (int)pGroup->nHit);
+  sqlite3StatusUp(SQLITE_STATUS_PAGECACHE_MISS, (int)pGroup->nMiss);
+  sqlite3StatusUp(SQLITE_STATUS_PAGECACHE_GHOST, (int)pGroup->nGhostHit);
+  sqlite3_mutex_leave(pcache1.mutex);
+  pGroup->nHit = pGroup->nMiss = pGroup->nGhostHit = 0;
+}
+
+/*
+** Count a fetch that found the page in the cache (bHit) or had to load it.
+*/
+static void pcache1CountFetch(PGroup *pGroup, int bHit){
+  if( bHit ){
+    pGroup->nHit++;
+  }else{
+    pGroup->nMiss++;
+  }
+  if( pGroup->nHit+pGroup->nMiss>=PCACHE1_STAT_BATCH ){
+    pcache1FlushStats(pGroup);
+  }
+}
+
+/*
+** Hash of page iKey of cache pCache for the ghost table.  Never zero,
+** which marks an empty slot.
+*/
+static u32 pcache1GhostHash(PCache1 *pCache, unsigned int iKey){
+  u32 h = (iKey ^ (u32)(((uptr)pCache)>>4)) * 0x9e3779b1;
+  h ^= h>>15;
+  return h ? h : 1;
+}
+
+/*
+** Remember page p, which is about to be recycled, in the ghost table of
+** its PGroup if it is on probation.
+*/
+static void pcache1GhostAdd(PgHdr1 *p){
+  PGroup *pGroup = p->pCache->pGroup;
+  assert( sqlite3_mutex_held(pGroup->mutex) );
+  if( p->isProbation && pGroup->nGhost ){
+    u32 h = pcache1GhostHash(p->pCache, p->iKey);
+    pGroup->aGhost[h & (pGroup->nGhost-1)] = h;
+  }
+}
+
+/*
+** Return true and forget the entry if page iKey of pCache is in the
+** ghost table.
+*/
+static int pcache1GhostTake(PCache1 *pCache, unsigned int iKey){
+  PGroup *pGroup = pCache->pGroup;
+  assert( sqlite3_mutex_held(pGroup->mutex) );
+  if( pGroup->nGhost ){
+    u32 h = pcache1GhostHash(pCache, iKey);
+    u32 *pSlot = &pGroup->aGhost[h & (pGroup->nGhost-1)];
+    if( *pSlot==h ){
+      *pSlot = 0;
+      pGroup->nGhostHit++;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/*
+** Grow the ghost table of pGroup to at least half of nMaxPage slots.
+** The ghost table is only an optimization, so a failed allocation is
+** ignored.
+**
+** The PGroup mutex must not be held when this function is called.
+*/
+static void pcache1GhostResize(PGroup *pGroup){
+  unsigned int nWant;
+  unsigned int nNew = 64;
+  u32 *aNew;
+  if( pcache1.ePolicy!=SQLITE_PCACHE_POLICY_2Q ) return;
+  pcache1EnterMutex(pGroup);
+  nWant = pGroup->nMaxPage/2;
+  if( pGroup->nGhost>=nWant && pGroup->nGhost ) nWant = 0;
+  pcache1LeaveMutex(pGroup);
+  if( nWant==0 ) return;
+  while( nNew<nWant && nNew<0x40000000 ) nNew *= 2;
+  sqlite3BeginBenignMalloc();
+  aNew = (u32*)sqlite3MallocZero(sizeof(u32)*nNew);
+  sqlite3EndBenignMalloc();
+  if( aNew ){
+    pcache1EnterMutex(pGroup);
+    if( nNew>pGroup->nGhost ){
+      u32 *aOld = pGroup->aGhost;
+      pGroup->aGhost = aNew;
+      pGroup->nGhost = nNew;
+      aNew = aOld;
+    }
+    pcache1LeaveMutex(pGroup);
+    sqlite3_free(aNew);
+  }
+}
+
+/*
+** Return the unpinned page that the replacement policy would recycle next
+** from pGroup, or NULL if there are no unpinned pages.
+*/
+static PgHdr1 *pcache1LruVictim(PGroup *pGroup){
+  PgHdr1 *p = pGroup->lru.pLruPrev;
+  if( pGroup->nProbation
+   && (pGroup->nProbation>pGroup->nMaxPage/4 || p->isAnchor)
+  ){
+    p = pGroup->lruIn.pLruPrev;
+  }
+  return (p==0 || p->isAnchor) ? 0 : p;
+}
+
 /******************************************************************************/
 /******** General Implementation Functions ************************************/
 
@@ -571,6 +1039,11 @@ static PgHdr1 *pcache1PinPage(PgHdr1 *pPage){
   pPage->pLruNext = 0;
   pPage->pLruPrev = 0;
   pPage->isPinned = 1;
+  if( pPage->isProbation ){
+    assert( pCache->pGroup->nProbation>0 );
+    pCache->pGroup->nProbation--;
+    pPage->isProbation = 0;
+  }
   assert( pPage->isAnchor==0 );
   assert( pCache->pGroup->lru.isAnchor==1 );
   pCache->nRecyclable--;
@@ -608,10 +1081,11 @@ static void pcache1EnforceMaxPage(PCache1 *pCache){
   PgHdr1 *p;
   assert( sqlite3_mutex_held(pGroup->mutex) );
   while( pGroup->nCurrentPage>pGroup->nMaxPage
-      && (p=pGroup->lru.pLruPrev)->isAnchor==0
+      && (p=pcache1LruVictim(pGroup))!=0
   ){
     assert( p->pCache->pGroup==pGroup );
     assert( p->isPinned==0 );
+    pcache1GhostAdd(p);
     pcache1PinPage(p);
     pcache1RemoveFromHash(p, 1);
   }
@@ -660,6 +1134,7 @@ static void pcache1TruncateUnsafe(
 ** Implementation of the sqlite3_pcache.xInit method.
 */
 static int pcache1Init(void *NotUsed){
+  int i;
   UNUSED_PARAMETER(NotUsed);
   assert( pcache1.isInit==0 );
   memset(&pcache1, 0, sizeof(pcache1));
@@ -668,7 +1143,7 @@ static int pcache1Init(void *NotUsed){
   /*
   ** The pcache1.separateCache variable is true if each PCache has its own
   ** private PGroup (mode-1).  pcache1.separateCache is false if the single
-  ** PGroup in pcache1.grp is used for all page caches (mode-2).
+  ** PGroups in pcache1.aGroup[] are used for all page caches (mode-2).
   **
   **   *  Always use a unified cache (mode-2) if ENABLE_MEMORY_MANAGEMENT
   **
@@ -688,10 +1163,22 @@ static int pcache1Init(void *NotUsed){
   pcache1.separateCache = sqlite3GlobalConfig.pPage==0;
 #endif
 
+  /* Mode-2 is split into the configured number of shards.  Shards are
+  ** only worth their cost if there are mutexes to contend for. */
+  pcache1.nGroup = 1;
 #if SQLITE_THREADSAFE
   if( sqlite3GlobalConfig.bCoreMutex ){
-    pcache1.grp.mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_LRU);
+    pcache1.aGroup[0].mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_LRU);
     pcache1.mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_PMEM);
+    if( pcache1.separateCache==0 ){
+      int nShard = sqlite3GlobalConfig.nPcacheShard;
+      if( nShard>SQLITE_MAX_PCACHE_SHARDS ) nShard = SQLITE_MAX_PCACHE_SHARDS;
+      for(i=1; i<nShard; i++){
+        pcache1.aGroup[i].mutex = sqlite3MutexAlloc(SQLITE_MUTEX_FAST);
+        if( pcache1.aGroup[i].mutex==0 ) break;
+      }
+      pcache1.nGroup = i;
+    }
   }
 #endif
   if( pcache1.separateCache
@@ -702,19 +1189,36 @@ static int pcache1Init(void *NotUsed){
   }else{
     pcache1.nInitPage = 0;
   }
-  pcache1.grp.mxPinned = 10;
+#if PCACHE1_HUGEPAGE
+  /* With the slab, there is no need for per-cache bulk allocations */
+  pcache1SlabInit();
+  if( pcache1.slab.nSlot ) pcache1.nInitPage = 0;
+#endif
+  for(i=0; i<pcache1.nGroup; i++){
+    pcache1.aGroup[i].mxPinned = 10;
+  }
+  pcache1.ePolicy = sqlite3GlobalConfig.ePcachePolicy;
   pcache1.isInit = 1;
   return SQLITE_OK;
 }
 
 /*
 ** Implementation of the sqlite3_pcache.xShutdown method.
-** Note that the static mutex allocated in xInit does 
-** not need to be freed.
+** Note that the static mutexes allocated in xInit do
+** not need to be freed, only those of the second and
+** subsequent shards, the ghost tables and the slab.
 */
 static void pcache1Shutdown(void *NotUsed){
+  int i;
   UNUSED_PARAMETER(NotUsed);
   assert( pcache1.isInit!=0 );
+  for(i=0; i<pcache1.nGroup; i++){
+    if( i>0 ) sqlite3_mutex_free(pcache1.aGroup[i].mutex);
+    sqlite3_free(pcache1.aGroup[i].aGhost);
+  }
+#if PCACHE1_HUGEPAGE
+  pcache1SlabShutdown();
+#endif
   memset(&pcache1, 0, sizeof(pcache1));
 }
 
@@ -741,11 +1245,21 @@ static sqlite3_pcache *pcache1Create(int szPage, int szExtra, int bPurgeable){
       pGroup = (PGroup*)&pCache[1];
       pGroup->mxPinned = 10;
     }else{
-      pGroup = &pcache1.grp;
+      /* Caches are dealt out to the shards in turn, which spreads them
+      ** (and hence the mutex traffic) evenly over the shards. */
+      unsigned int iGroup = 0;
+      if( pcache1.nGroup>1 ){
+        sqlite3_mutex_enter(pcache1.mutex);
+        iGroup = pcache1.iNextGroup++ % (unsigned int)pcache1.nGroup;
+        sqlite3_mutex_leave(pcache1.mutex);
+      }
+      pGroup = &pcache1.aGroup[iGroup];
     }
     if( pGroup->lru.isAnchor==0 ){
       pGroup->lru.isAnchor = 1;
       pGroup->lru.pLruPrev = pGroup->lru.pLruNext = &pGroup->lru;
+      pGroup->lruIn.isAnchor = 1;
+      pGroup->lruIn.pLruPrev = pGroup->lruIn.pLruNext = &pGroup->lruIn;
     }
     pCache->pGroup = pGroup;
     pCache->szPage = szPage;
@@ -784,6 +1298,7 @@ static void pcache1Cachesize(sqlite3_pcache *p, int nMax){
     pCache->n90pct = pCache->nMax*9/10;
     pcache1EnforceMaxPage(pCache);
     pcache1LeaveMutex(pGroup);
+    pcache1GhostResize(pGroup);
   }
 }
 
@@ -854,12 +1369,13 @@ static SQLITE_NOINLINE PgHdr1 *pcache1FetchStage2(
 
   /* Step 4. Try to recycle a page. */
   if( pCache->bPurgeable
-   && !pGroup->lru.pLruPrev->isAnchor
+   && (pGroup->nProbation || !pGroup->lru.pLruPrev->isAnchor)
    && ((pCache->nPage+1>=pCache->nMax) || pcache1UnderMemoryPressure(pCache))
   ){
     PCache1 *pOther;
-    pPage = pGroup->lru.pLruPrev;
+    pPage = pcache1LruVictim(pGroup);
     assert( pPage->isPinned==0 );
+    pcache1GhostAdd(pPage);
     pcache1RemoveFromHash(pPage, 0);
     pcache1PinPage(pPage);
     pOther = pPage->pCache;
@@ -887,6 +1403,9 @@ static SQLITE_NOINLINE PgHdr1 *pcache1FetchStage2(
     pPage->pLruPrev = 0;
     pPage->pLruNext = 0;
     pPage->isPinned = 1;
+    pPage->isProbation = 0;
+    pPage->isHot = (u8)(pcache1.ePolicy==SQLITE_PCACHE_POLICY_2Q
+                         && pcache1GhostTake(pCache, iKey));
     *(void **)pPage->page.pExtra = 0;
     pCache->apHash[h] = pPage;
     if( iKey>pCache->iMaxKey ){
@@ -972,13 +1491,16 @@ static PgHdr1 *pcache1FetchNoMutex(
   ** Otherwise (page not in hash and createFlag!=0) continue with
   ** subsequent steps to try to create the page. */
   if( pPage ){
+    pcache1CountFetch(pCache->pGroup, 1);
     if( !pPage->isPinned ){
+      pPage->isHot = 1;
       return pcache1PinPage(pPage);
     }else{
       return pPage;
     }
   }else if( createFlag ){
     /* Steps 3, 4, and 5 implemented by this subroutine */
+    pcache1CountFetch(pCache->pGroup, 0);
     return pcache1FetchStage2(pCache, iKey, createFlag);
   }else{
     return 0;
@@ -1052,13 +1574,22 @@ static void pcache1Unpin(
   if( reuseUnlikely || pGroup->nCurrentPage>pGroup->nMaxPage ){
     pcache1RemoveFromHash(pPage, 1);
   }else{
-    /* Add the page to the PGroup LRU list. */
-    PgHdr1 **ppFirst = &pGroup->lru.pLruNext;
-    pPage->pLruPrev = &pGroup->lru;
+    /* Add the page to the PGroup LRU list, or to the list of pages on
+    ** probation if it has not been referenced since it was loaded. */
+    PgHdr1 *pAnchor = &pGroup->lru;
+    PgHdr1 **ppFirst;
+    if( pPage->isHot==0 && pcache1.ePolicy==SQLITE_PCACHE_POLICY_2Q ){
+      pAnchor = &pGroup->lruIn;
+      pPage->isProbation = 1;
+      pGroup->nProbation++;
+    }
+    ppFirst = &pAnchor->pLruNext;
+    pPage->pLruPrev = pAnchor;
     (pPage->pLruNext = *ppFirst)->pLruPrev = pPage;
     *ppFirst = pPage;
     pCache->nRecyclable++;
     pPage->isPinned = 0;
+    if( pcache1.nGroup>1 ) pPage->iLru = pcache1.iLruClock++;
   }
 
   pcache1LeaveMutex(pCache->pGroup);
@@ -1134,7 +1665,9 @@ static void pcache1Destroy(sqlite3_pcache *p){
   pGroup->nMinPage -= pCache->nMin;
   pGroup->mxPinned = pGroup->nMaxPage + 10 - pGroup->nMinPage;
   pcache1EnforceMaxPage(pCache);
+  pcache1FlushStats(pGroup);
   pcache1LeaveMutex(pGroup);
+  if( pGroup==(PGroup*)&pCache[1] ) sqlite3_free(pGroup->aGhost);
   sqlite3_free(pCache->pBulk);
   sqlite3_free(pCache->apHash);
   sqlite3_free(pCache);
@@ -1178,6 +1711,35 @@ sqlite3_mutex *sqlite3Pcache1Mutex(void){
 }
 
 #ifdef SQLITE_ENABLE_MEMORY_MANAGEMENT
+/*
+** Free unpinned pages from the tail of the LRU list of pGroup until nFree,
+** the number of bytes released so far, reaches nReq (or until the list is
+** empty if nReq is negative).  If piStop is not NULL, also stop before the
+** first page unpinned after *piStop, though not before at least one page
+** has been freed.  Return the new value of nFree.
+*/
+static int pcache1ReleaseGroup(PGroup *pGroup, int nReq, int nFree, u32 *piStop){
+  PgHdr1 *p;
+  int nPage = 0;
+  pcache1EnterMutex(pGroup);
+  while( (nReq<0 || nFree<nReq)
+     &&  (p=pcache1LruVictim(pGroup))!=0
+     &&  (piStop==0 || nPage==0 || (int)(p->iLru - *piStop)<=0)
+  ){
+    nFree += pcache1MemSize(p->page.pBuf);
+#ifdef SQLITE_PCACHE_SEPARATE_HEADER
+    nFree += sqlite3MemSize(p);
+#endif
+    assert( p->isPinned==0 );
+    pcache1GhostAdd(p);
+    pcache1PinPage(p);
+    pcache1RemoveFromHash(p, 1);
+    nPage++;
+  }
+  pcache1LeaveMutex(pGroup);
+  return nFree;
+}
+
 /*
 ** This function is called to free superfluous dynamically allocated memory
 ** held by the pager system. Memory in use by any SQLite pager allocated
@@ -1186,28 +1748,55 @@ sqlite3_mutex *sqlite3Pcache1Mutex(void){
 ** nReq is the number of bytes of memory required. Once this much has
 ** been released, the function returns. The return value is the total number 
 ** of bytes of memory released.
+**
+** If the global cache is split into shards, pages are released in the
+** approximate order of a single global LRU list: pages are taken from the
+** shard whose least recently used page is the oldest, until the oldest
+** page of that shard is younger than that of the next oldest shard.
 */
 int sqlite3PcacheReleaseMemory(int nReq){
   int nFree = 0;
-  assert( sqlite3_mutex_notheld(pcache1.grp.mutex) );
+  assert( pcache1GroupMutexNotHeld() );
   assert( sqlite3_mutex_notheld(pcache1.mutex) );
   if( sqlite3GlobalConfig.nPage==0 ){
-    PgHdr1 *p;
-    pcache1EnterMutex(&pcache1.grp);
-    while( (nReq<0 || nFree<nReq)
-       &&  (p=pcache1.grp.lru.pLruPrev)!=0
-       &&  p->isAnchor==0
-    ){
-      nFree += pcache1MemSize(p->page.pBuf);
-#ifdef SQLITE_PCACHE_SEPARATE_HEADER
-      nFree += sqlite3MemSize(p);
-#endif
-      assert( p->isPinned==0 );
-      pcache1PinPage(p);
-      pcache1RemoveFromHash(p, 1);
+    if( pcache1.nGroup==1 ){
+      nFree = pcache1ReleaseGroup(&pcache1.aGroup[0], nReq, 0, 0);
+    }else{
+      while( nReq<0 || nFree<nReq ){
+        PGroup *pOldest = 0;      /* Shard with the oldest LRU page */
+        u32 iOldest = 0;          /* Unpin stamp of that page */
+        u32 iNext = 0;            /* Oldest stamp of all other shards */
+        int bNext = 0;            /* True if iNext is valid */
+        int i;
+        for(i=0; i<pcache1.nGroup; i++){
+          PGroup *pGroup = &pcache1.aGroup[i];
+          PgHdr1 *p;
+          u32 iLru = 0;
+          pcache1EnterMutex(pGroup);
+          p = pcache1LruVictim(pGroup);
+          if( p ) iLru = p->iLru;
+          pcache1LeaveMutex(pGroup);
+          if( p==0 ) continue;
+          if( pOldest==0 || (int)(iLru - iOldest)<0 ){
+            if( pOldest ){
+              iNext = iOldest;
+              bNext = 1;
+            }
+            pOldest = pGroup;
+            iOldest = iLru;
+          }else if( bNext==0 || (int)(iLru - iNext)<0 ){
+            iNext = iLru;
+            bNext = 1;
+          }
+        }
+        if( pOldest==0 ) break;
+        nFree = pcache1ReleaseGroup(pOldest, nReq, nFree, bNext?&iNext:0);
+      }
     }
-    pcache1LeaveMutex(&pcache1.grp);
   }
+#if PCACHE1_HUGEPAGE
+  if( pcache1.slab.nSlot ) pcache1SlabRelease();
+#endif
   return nFree;
 }
 #endif /* SQLITE_ENABLE_MEMORY_MANAGEMENT */
@@ -1225,13 +1814,27 @@ void sqlite3PcacheStats(
 ){
   PgHdr1 *p;
   int nRecyclable = 0;
-  for(p=pcache1.grp.lru.pLruNext; p && !p->isAnchor; p=p->pLruNext){
-    assert( p->isPinned==0 );
-    nRecyclable++;
+  int nCurrent = 0;
+  int nMax = 0;
+  int nMin = 0;
+  int i;
+  for(i=0; i<pcache1.nGroup; i++){
+    PGroup *pGroup = &pcache1.aGroup[i];
+    for(p=pGroup->lru.pLruNext; p && !p->isAnchor; p=p->pLruNext){
+      assert( p->isPinned==0 );
+      nRecyclable++;
+    }
+    for(p=pGroup->lruIn.pLruNext; p && !p->isAnchor; p=p->pLruNext){
+      assert( p->isPinned==0 && p->isProbation );
+      nRecyclable++;
+    }
+    nCurrent += pGroup->nCurrentPage;
+    nMax += (int)pGroup->nMaxPage;
+    nMin += (int)pGroup->nMinPage;
   }
-  *pnCurrent = pcache1.grp.nCurrentPage;
-  *pnMax = (int)pcache1.grp.nMaxPage;
-  *pnMin = (int)pcache1.grp.nMinPage;
+  *pnCurrent = nCurrent;
+  *pnMax = nMax;
+  *pnMin = nMin;
   *pnRecyclable = nRecyclable;
 }
 #endif
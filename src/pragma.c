@@ -510,6 +510,26 @@ void sqlite3Pragma(
     break;
   }
 
+  /*
+  **  PRAGMA [schema.]bulk_fill_factor
+  **  PRAGMA [schema.]bulk_fill_factor=N
+  **
+  ** Query or set the percentage (10 to 100) of each page that is filled
+  ** when a b-tree is built bottom-up from sorted input, as by CREATE
+  ** INDEX and VACUUM. Values below 100 leave room for later inserts.
+  */
+  case PragTyp_BULK_FILL_FACTOR: {
+    Btree *pBt = pDb->pBt;
+    int n = -1;
+    assert( pBt!=0 );
+    if( zRight ){
+      sqlite3GetInt32(zRight, &n);
+    }
+    n = sqlite3BtreeBulkFill(pBt, n);
+    returnSingleInt(v, "bulk_fill_factor", n);
+    break;
+  }
+
   /*
   **  PRAGMA [schema.]max_page_count
   **  PRAGMA [schema.]max_page_count=N
@@ -1819,6 +1839,115 @@ void sqlite3Pragma(
   }
   break;
 
+  /*
+  **  PRAGMA [schema.]wal_checkpoint_step
+  **  PRAGMA [schema.]wal_checkpoint_step = N
+  **
+  ** Maximum number of WAL frames copied into the database file by a single
+  ** PASSIVE checkpoint, including automatic checkpoints. A large backlog
+  ** is then checkpointed in slices of N frames by repeated checkpoints,
+  ** whose progress is reported by "PRAGMA wal_checkpoint" and
+  ** sqlite3_wal_checkpoint_v2(). 0, the default, means no limit.
+  */
+  case PragTyp_WAL_CHECKPOINT_STEP: {
+    Btree *pBt = pDb->pBt;
+    int n = -1;
+    if( pBt==0 ) break;
+    if( zRight ){
+      sqlite3GetInt32(zRight, &n);
+      if( n<0 ) n = 0;
+    }
+    n = sqlite3PagerCkptStep(sqlite3BtreePager(pBt), n);
+    returnSingleInt(v, "wal_checkpoint_step", n);
+    break;
+  }
+
+  /*
+  **  PRAGMA [schema.]wal_checkpoint_threads
+  **  PRAGMA [schema.]wal_checkpoint_threads = N
+  **
+  ** If N is 2, checkpoints read the WAL on a helper thread while they
+  ** write the database file. The default is 1.
+  */
+  case PragTyp_WAL_CHECKPOINT_THREADS: {
+    Btree *pBt = pDb->pBt;
+    int n = -1;
+    if( pBt==0 ) break;
+    if( zRight ){
+      sqlite3GetInt32(zRight, &n);
+      if( n<1 ) n = 1;
+    }
+    n = sqlite3PagerCkptThreads(sqlite3BtreePager(pBt), n);
+    returnSingleInt(v, "wal_checkpoint_threads", n);
+    break;
+  }
+
+  /*
+  **  PRAGMA [schema.]wal_group_commit
+  **  PRAGMA [schema.]wal_group_commit = BOOLEAN
+  **
+  ** With synchronous=FULL, let a committing connection release the WAL
+  ** write-lock before it syncs the WAL file, so that one sync makes the
+  ** commits of several connections of this process durable. Other
+  ** connections may see a commit before its sync completes.
+  */
+  case PragTyp_WAL_GROUP_COMMIT: {
+    Btree *pBt = pDb->pBt;
+    int b = -1;
+    if( pBt==0 ) break;
+    if( zRight ){
+      b = sqlite3GetBoolean(zRight, 0);
+    }
+    b = sqlite3PagerGroupCommit(sqlite3BtreePager(pBt), b);
+    returnSingleInt(v, "wal_group_commit", b);
+    break;
+  }
+
+  /*
+  **  PRAGMA [schema.]wal_checkpoint_background
+  **  PRAGMA [schema.]wal_checkpoint_background = N
+  **
+  ** If N>0, run PASSIVE checkpoints of the database on a background
+  ** thread, whenever a commit leaves more than wal_autocheckpoint frames
+  ** in the WAL and at least every N ms. Commits then no longer checkpoint
+  ** themselves, unless the WAL grows past wal_checkpoint_limit. N==0
+  ** stops the background checkpointer. Returns N, or 0 if no background
+  ** checkpointer runs, as for TEMP and in-memory databases.
+  */
+  case PragTyp_WAL_CHECKPOINT_BACKGROUND: {
+    int n = -1;
+    if( pDb->pBt==0 ) break;
+    if( zRight ){
+      sqlite3GetInt32(zRight, &n);
+      if( n<0 ) n = 0;
+    }
+    n = sqlite3WalBackground(db, iDb, n);
+    returnSingleInt(v, "wal_checkpoint_background", n);
+    break;
+  }
+
+  /*
+  **  PRAGMA [schema.]wal_checkpoint_limit
+  **  PRAGMA [schema.]wal_checkpoint_limit = N
+  **
+  ** While a background checkpointer runs, commits that leave more than
+  ** N frames in the WAL checkpoint synchronously, so that the WAL stays
+  ** bounded when the checkpointer falls behind. N==0, the default, means
+  ** four times the wal_autocheckpoint threshold. The limit may be set
+  ** before wal_checkpoint_background starts the checkpointer.
+  */
+  case PragTyp_WAL_CHECKPOINT_LIMIT: {
+    int n = -1;
+    if( pDb->pBt==0 ) break;
+    if( zRight ){
+      sqlite3GetInt32(zRight, &n);
+      if( n<0 ) n = 0;
+    }
+    n = sqlite3WalBackgroundLimit(db, iDb, n);
+    returnSingleInt(v, "wal_checkpoint_limit", n);
+    break;
+  }
+
   /*
   **   PRAGMA wal_autocheckpoint
   **   PRAGMA wal_autocheckpoint = N
@@ -1965,6 +2094,95 @@ void sqlite3Pragma(
     }
     break;
   }
+
+  /*
+  **  PRAGMA [schema.]codec_mmap
+  **  PRAGMA [schema.]codec_mmap = boolean
+  **
+  ** Read the pages of an encrypted database through the memory mapping
+  ** configured by "PRAGMA mmap_size" instead of with read() calls. The
+  ** pages are copied out of the mapping and decrypted in the page cache.
+  */
+  case PragTyp_CODEC_MMAP: {
+    Btree *pBt = pDb->pBt;
+    int b = -1;
+    if( pBt==0 ) break;
+    if( zRight ){
+      b = sqlite3GetBoolean(zRight, 0);
+    }
+    b = sqlite3PagerCodecMmap(sqlite3BtreePager(pBt), b);
+    returnSingleInt(v, "codec_mmap", b);
+    break;
+  }
+
+  /*
+  **  PRAGMA codec_page_cache
+  **  PRAGMA codec_page_cache = N
+  **
+  ** Number of decrypted pages kept in a cache shared by all connections
+  ** of this process to encrypted databases. A page is taken from the cache
+  ** if its encrypted image and the key are those of a page decrypted
+  ** before, so that changes of the database by any connection are seen
+  ** without invalidating the cache. Page 1 is not cached. Each cached page
+  ** takes twice its size in memory. 0 disables the cache, which is the
+  ** default. Changing N empties the cache.
+  */
+  case PragTyp_CODEC_PAGE_CACHE: {
+    int n = -1;
+    if( zRight ){
+      sqlite3GetInt32(zRight, &n);
+      if( n<0 ) n = 0;
+    }
+    returnSingleInt(v, "codec_page_cache", sqlite3CodecPageCache(n));
+    break;
+  }
+
+  /*
+  **  PRAGMA [schema.]codec_threads
+  **  PRAGMA [schema.]codec_threads = N
+  **
+  ** Number of threads, including the calling thread, used to encrypt the
+  ** pages of an encrypted database written on commit, on cache spill and
+  ** into the WAL. The default is 1. N is limited to
+  ** SQLITE_MAX_WORKER_THREADS.
+  **
+  ** If N is greater than 1 for the destination of a backup, pages of an
+  ** encrypted source or destination are transcoded by N threads while the
+  ** backup reads and writes the database files sequentially.
+  */
+  case PragTyp_CODEC_THREADS: {
+    Btree *pBt = pDb->pBt;
+    int n = 0;
+    if( pBt==0 ) break;
+    if( zRight ){
+      sqlite3GetInt32(zRight, &n);
+      if( n<1 ) n = 1;
+    }
+    n = sqlite3PagerCodecThreads(sqlite3BtreePager(pBt), n);
+    returnSingleInt(v, "codec_threads", n);
+    break;
+  }
+
+  /*
+  **  PRAGMA kdf_iter
+  **  PRAGMA kdf_iter = N
+  **
+  ** Number of PBKDF2-HMAC-SHA256 iterations used to derive the key of
+  ** databases encrypted from now on by any connection in this process.
+  ** Such a database stores a random salt and the iteration count in its
+  ** header. N is rounded up to a multiple of 1000. 0 selects the legacy
+  ** unsalted key derivation, which is the default. Existing databases
+  ** keep their key derivation, also when they are rekeyed.
+  */
+  case PragTyp_KDF_ITER: {
+    int n = -1;
+    if( zRight ){
+      sqlite3GetInt32(zRight, &n);
+      if( n<0 ) n = 0;
+    }
+    returnSingleInt(v, "kdf_iter", sqlite3CodecKdfIter(n));
+    break;
+  }
 #endif
 #if defined(SQLITE_HAS_CODEC) || defined(SQLITE_ENABLE_CEROD)
   case PragTyp_ACTIVATE_EXTENSIONS: if( zRight ){
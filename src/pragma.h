@@ -46,6 +46,16 @@
 #define PragTyp_REKEY                         40
 #define PragTyp_LOCK_STATUS                   41
 #define PragTyp_PARSER_TRACE                  42
+#define PragTyp_CODEC_MMAP                    43
+#define PragTyp_CODEC_THREADS                 44
+#define PragTyp_KDF_ITER                      45
+#define PragTyp_CODEC_PAGE_CACHE              46
+#define PragTyp_WAL_CHECKPOINT_STEP           47
+#define PragTyp_WAL_CHECKPOINT_THREADS        48
+#define PragTyp_WAL_CHECKPOINT_BACKGROUND     49
+#define PragTyp_WAL_CHECKPOINT_LIMIT          50
+#define PragTyp_WAL_GROUP_COMMIT              51
+#define PragTyp_BULK_FILL_FACTOR              52
 #define PragFlag_NeedSchema           0x01
 #define PragFlag_ReadOnly             0x02
 static const struct sPragmaNames {
@@ -80,6 +90,10 @@ static const struct sPragmaNames {
     /* iArg:      */ SQLITE_AutoIndex },
 #endif
 #endif
+  { /* zName:     */ "bulk_fill_factor",
+    /* ePragTyp:  */ PragTyp_BULK_FILL_FACTOR,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ 0 },
   { /* zName:     */ "busy_timeout",
     /* ePragTyp:  */ PragTyp_BUSY_TIMEOUT,
     /* ePragFlag: */ 0,
@@ -110,6 +124,20 @@ static const struct sPragmaNames {
     /* ePragFlag: */ 0,
     /* iArg:      */ SQLITE_CkptFullFSync },
 #endif
+#if defined(SQLITE_HAS_CODEC)
+  { /* zName:     */ "codec_mmap",
+    /* ePragTyp:  */ PragTyp_CODEC_MMAP,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ 0 },
+  { /* zName:     */ "codec_page_cache",
+    /* ePragTyp:  */ PragTyp_CODEC_PAGE_CACHE,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ 0 },
+  { /* zName:     */ "codec_threads",
+    /* ePragTyp:  */ PragTyp_CODEC_THREADS,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ 0 },
+#endif
 #if !defined(SQLITE_OMIT_SCHEMA_PRAGMAS)
   { /* zName:     */ "collation_list",
     /* ePragTyp:  */ PragTyp_COLLATION_LIST,
@@ -263,6 +291,10 @@ static const struct sPragmaNames {
     /* iArg:      */ 0 },
 #endif
 #if defined(SQLITE_HAS_CODEC)
+  { /* zName:     */ "kdf_iter",
+    /* ePragTyp:  */ PragTyp_KDF_ITER,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ 0 },
   { /* zName:     */ "key",
     /* ePragTyp:  */ PragTyp_KEY,
     /* ePragFlag: */ 0,
@@ -453,6 +485,26 @@ static const struct sPragmaNames {
     /* ePragTyp:  */ PragTyp_WAL_CHECKPOINT,
     /* ePragFlag: */ PragFlag_NeedSchema,
     /* iArg:      */ 0 },
+  { /* zName:     */ "wal_checkpoint_background",
+    /* ePragTyp:  */ PragTyp_WAL_CHECKPOINT_BACKGROUND,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ 0 },
+  { /* zName:     */ "wal_checkpoint_limit",
+    /* ePragTyp:  */ PragTyp_WAL_CHECKPOINT_LIMIT,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ 0 },
+  { /* zName:     */ "wal_checkpoint_step",
+    /* ePragTyp:  */ PragTyp_WAL_CHECKPOINT_STEP,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ 0 },
+  { /* zName:     */ "wal_checkpoint_threads",
+    /* ePragTyp:  */ PragTyp_WAL_CHECKPOINT_THREADS,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ 0 },
+  { /* zName:     */ "wal_group_commit",
+    /* ePragTyp:  */ PragTyp_WAL_GROUP_COMMIT,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ 0 },
 #endif
 #if !defined(SQLITE_OMIT_FLAG_PRAGMAS)
   { /* zName:     */ "writable_schema",
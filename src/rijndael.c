@@ -53,6 +53,27 @@
 #include <stdlib.h>
 #include <string.h>
 
+/*
+// Hardware AES (AES-NI) support on x86 and x86-64.
+// The instructions are selected at runtime via cpuid, so the library still
+// runs on processors without AES-NI. Define RIJNDAEL_OMIT_AESNI to build
+// the portable table driven implementation only.
+*/
+#if !defined(RIJNDAEL_OMIT_AESNI)
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <wmmintrin.h>
+#define RIJNDAEL_AESNI_TARGET
+#elif (defined(__x86_64__) || defined(__i386__)) && \
+      (defined(__clang__) || (__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#include <cpuid.h>
+#include <wmmintrin.h>
+#define RIJNDAEL_AESNI_TARGET __attribute__((target("aes,sse2")))
+#else
+#define RIJNDAEL_OMIT_AESNI
+#endif
+#endif
+
 
 static UINT8 S[256]=
 {
@@ -969,6 +990,141 @@ static UINT32 rcon[30]=
 };
 
 
+/*
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AES-NI backend
+//
+// The round keys produced by RijndaelKeySched are stored in the byte order
+// expected by the AES instructions, and RijndaelKeyEncToDec applies
+// InvMixColumns to the inner round keys exactly as AESIMC would. Therefore
+// both backends share the expanded key and produce identical results.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+#ifndef RIJNDAEL_OMIT_AESNI
+
+/* Number of blocks decrypted in parallel in CBC mode */
+#define RIJNDAEL_AESNI_PARALLEL 8
+
+static int aesniAvailable = -1;
+
+int RijndaelAesNiAvailable(void)
+{
+  if (aesniAvailable < 0)
+  {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    aesniAvailable = (info[2] & (1 << 25)) != 0;
+#else
+    unsigned int eax, ebx, ecx, edx;
+    aesniAvailable = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & (1 << 25)) != 0;
+#endif
+  }
+  return aesniAvailable;
+}
+
+RIJNDAEL_AESNI_TARGET
+static void RijndaelCbcEncryptAesNi(Rijndael* rijndael, UINT8 *input, int numBlocks, UINT8 *outBuffer)
+{
+  __m128i roundKey[_MAX_ROUNDS+1];
+  __m128i block;
+  int nRounds = (int) rijndael->m_uRounds;
+  int i, r;
+
+  for (r = 0; r <= nRounds; r++)
+  {
+    roundKey[r] = _mm_loadu_si128((__m128i*) rijndael->m_expandedKey[r]);
+  }
+  block = _mm_loadu_si128((__m128i*) rijndael->m_initVector);
+  for (i = 0; i < numBlocks; i++)
+  {
+    block = _mm_xor_si128(block, _mm_loadu_si128((__m128i*) (input + 16*i)));
+    block = _mm_xor_si128(block, roundKey[0]);
+    for (r = 1; r < nRounds; r++)
+    {
+      block = _mm_aesenc_si128(block, roundKey[r]);
+    }
+    block = _mm_aesenclast_si128(block, roundKey[nRounds]);
+    _mm_storeu_si128((__m128i*) (outBuffer + 16*i), block);
+  }
+}
+
+RIJNDAEL_AESNI_TARGET
+static void RijndaelCbcDecryptAesNi(Rijndael* rijndael, UINT8 *input, int numBlocks, UINT8 *outBuffer)
+{
+  __m128i roundKey[_MAX_ROUNDS+1];
+  __m128i cipher[RIJNDAEL_AESNI_PARALLEL];
+  __m128i block[RIJNDAEL_AESNI_PARALLEL];
+  __m128i feedback;
+  int nRounds = (int) rijndael->m_uRounds;
+  int i, k, r;
+
+  for (r = 0; r <= nRounds; r++)
+  {
+    roundKey[r] = _mm_loadu_si128((__m128i*) rijndael->m_expandedKey[r]);
+  }
+  feedback = _mm_loadu_si128((__m128i*) rijndael->m_initVector);
+
+  /* CBC decryption has no dependency between blocks, so several blocks
+  ** are kept in flight to hide the latency of the AESDEC instruction.
+  ** All ciphertext blocks are loaded before anything is stored, which
+  ** keeps in-place decryption correct. */
+  for (i = 0; i + RIJNDAEL_AESNI_PARALLEL <= numBlocks; i += RIJNDAEL_AESNI_PARALLEL)
+  {
+    for (k = 0; k < RIJNDAEL_AESNI_PARALLEL; k++)
+    {
+      cipher[k] = _mm_loadu_si128((__m128i*) (input + 16*(i+k)));
+      block[k] = _mm_xor_si128(cipher[k], roundKey[nRounds]);
+    }
+    for (r = nRounds-1; r > 0; r--)
+    {
+      for (k = 0; k < RIJNDAEL_AESNI_PARALLEL; k++)
+      {
+        block[k] = _mm_aesdec_si128(block[k], roundKey[r]);
+      }
+    }
+    for (k = 0; k < RIJNDAEL_AESNI_PARALLEL; k++)
+    {
+      block[k] = _mm_aesdeclast_si128(block[k], roundKey[0]);
+    }
+    block[0] = _mm_xor_si128(block[0], feedback);
+    for (k = 1; k < RIJNDAEL_AESNI_PARALLEL; k++)
+    {
+      block[k] = _mm_xor_si128(block[k], cipher[k-1]);
+    }
+    feedback = cipher[RIJNDAEL_AESNI_PARALLEL-1];
+    for (k = 0; k < RIJNDAEL_AESNI_PARALLEL; k++)
+    {
+      _mm_storeu_si128((__m128i*) (outBuffer + 16*(i+k)), block[k]);
+    }
+  }
+
+  /* Remaining blocks one at a time */
+  for (; i < numBlocks; i++)
+  {
+    cipher[0] = _mm_loadu_si128((__m128i*) (input + 16*i));
+    block[0] = _mm_xor_si128(cipher[0], roundKey[nRounds]);
+    for (r = nRounds-1; r > 0; r--)
+    {
+      block[0] = _mm_aesdec_si128(block[0], roundKey[r]);
+    }
+    block[0] = _mm_aesdeclast_si128(block[0], roundKey[0]);
+    block[0] = _mm_xor_si128(block[0], feedback);
+    feedback = cipher[0];
+    _mm_storeu_si128((__m128i*) (outBuffer + 16*i), block[0]);
+  }
+}
+
+#else /* RIJNDAEL_OMIT_AESNI */
+
+int RijndaelAesNiAvailable(void)
+{
+  return 0;
+}
+
+#endif /* RIJNDAEL_OMIT_AESNI */
+
 /*
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // API
@@ -1073,6 +1229,13 @@ int RijndaelBlockEncrypt(Rijndael* rijndael, UINT8 *input,int inputLen,UINT8 *ou
       }
     break;
     case RIJNDAEL_Direction_Mode_CBC:
+#ifndef RIJNDAEL_OMIT_AESNI
+      if (RijndaelAesNiAvailable())
+      {
+        RijndaelCbcEncryptAesNi(rijndael, input, numBlocks, outBuffer);
+        break;
+      }
+#endif
       ((UINT32*)block)[0] = ((UINT32*)rijndael->m_initVector)[0] ^ ((UINT32*)input)[0];
       ((UINT32*)block)[1] = ((UINT32*)rijndael->m_initVector)[1] ^ ((UINT32*)input)[1];
       ((UINT32*)block)[2] = ((UINT32*)rijndael->m_initVector)[2] ^ ((UINT32*)input)[2];
@@ -1217,6 +1380,13 @@ int RijndaelBlockDecrypt(Rijndael* rijndael, UINT8 *input, int inputLen, UINT8 *
       }
     break;
     case RIJNDAEL_Direction_Mode_CBC:
+#ifndef RIJNDAEL_OMIT_AESNI
+      if (RijndaelAesNiAvailable())
+      {
+        RijndaelCbcDecryptAesNi(rijndael, input, numBlocks, outBuffer);
+        break;
+      }
+#endif
 #if STRICT_ALIGN 
       memcpy(iv,rijndael->m_initVector,16); 
 #else
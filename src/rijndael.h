@@ -185,6 +185,13 @@ int RijndaelBlockDecrypt(Rijndael* rijndael, UINT8 *input, int inputLen, UINT8 *
 int RijndaelPadDecrypt(Rijndael* rijndael, UINT8 *input, int inputOctets, UINT8 *outBuffer);
 
 void RijndaelInvalidate(Rijndael* rijndael);
+
+/*
+// Returns 1 if the processor supports the AES-NI instructions; in that case
+// RijndaelBlockEncrypt and RijndaelBlockDecrypt process CBC mode in hardware.
+*/
+int RijndaelAesNiAvailable(void);
+
 void RijndaelKeySched(Rijndael* rijndael, UINT8 key[_MAX_KEY_COLUMNS][4]);
 void RijndaelKeyEncToDec(Rijndael* rijndael);
 void RijndaelEncrypt(Rijndael* rijndael, UINT8 a[16], UINT8 b[16]);
@@ -4785,6 +4785,400 @@ static void explainSimpleCount(
 # define explainSimpleCount(a,b,c)
 #endif
 
+/*
+** Maximum number of vectors and of WHERE clause terms in a batch scan.
+*/
+#define BATCH_MAX_VEC 32
+
+/*
+** An instance of the following object describes an aggregate query that
+** is evaluated by a batch scan of its table.  See batchAggregate().
+*/
+typedef struct BatchScan BatchScan;
+struct BatchScan {
+  Parse *pParse;                  /* Parsing context */
+  Table *pTab;                    /* The table scanned */
+  int iCur;                       /* Cursor number for pTab */
+  int nCol;                       /* Number of columns loaded */
+  int nVec;                       /* Number of other vectors */
+  int nTerm;                      /* Number of WHERE clause terms */
+  int aiCol[1+BATCH_MAX_VEC*2];   /* P4 array for OP_BatchLoad */
+  struct BatchTerm {
+    Expr *pCol;                   /* Column on the left of the comparison */
+    Expr *pVal;                   /* Number on the right */
+    u8 op;                        /* TK_EQ, TK_LT etc. */
+    int iReg;                     /* Register holding the value of pVal */
+  } aTerm[BATCH_MAX_VEC];
+};
+
+/*
+** Return true if pExpr is a numeric literal, optionally negated.
+*/
+static int batchIsNumber(Expr *pExpr){
+  if( pExpr->op==TK_UMINUS ) pExpr = pExpr->pLeft;
+  return pExpr->op==TK_INTEGER || pExpr->op==TK_FLOAT;
+}
+
+/*
+** Return the vector into which OP_BatchLoad reads column iCol (which is
+** -1 for the rowid) of the table.  The column must have been added by
+** batchAddColumn().
+*/
+static int batchColumnVector(BatchScan *pScan, int iCol){
+  int i;
+  for(i=0; pScan->aiCol[1+i*2]!=iCol; i++){
+    assert( i<pScan->nCol );
+  }
+  return i;
+}
+
+/*
+** Add the column that pExpr refers to to the set of columns loaded by
+** the batch scan.  Return false if the column cannot be loaded in batches.
+**
+** If bNumeric is true, the column is used in a WHERE clause comparison
+** or as the argument of an aggregate other than count(), and must not
+** have TEXT affinity.  If the column is used as a value, flags includes
+** BATCHCOL_VALUE.
+*/
+static int batchAddColumn(BatchScan *pScan, Expr *pExpr, int flags, int bNumeric){
+  Table *pTab = pScan->pTab;
+  int iCol = pExpr->iColumn;
+  int i;
+
+  if( pExpr->iTable!=pScan->iCur ) return 0;
+  if( iCol==pTab->iPKey ) iCol = -1;
+  if( iCol>=0 ){
+    Column *pCol = &pTab->aCol[iCol];
+    if( pCol->pDflt ) return 0;
+    if( bNumeric && pCol->affinity==SQLITE_AFF_TEXT ) return 0;
+    if( pCol->affinity==SQLITE_AFF_REAL ) flags |= BATCHCOL_REAL;
+  }
+  for(i=0; i<pScan->nCol; i++){
+    if( pScan->aiCol[1+i*2]==iCol ){
+      pScan->aiCol[2+i*2] |= flags;
+      return 1;
+    }
+  }
+  if( pScan->nCol>=BATCH_MAX_VEC ) return 0;
+  pScan->aiCol[1+i*2] = iCol;
+  pScan->aiCol[2+i*2] = flags;
+  pScan->nCol++;
+  return 1;
+}
+
+/*
+** Return true if pExpr, the argument of an aggregate function, can be
+** computed by OP_BatchArith opcodes.  This is the case if it consists only
+** of columns of the table, numeric literals and the operators +, -, *
+** and /.  Columns are added to the set loaded by the scan, and one more
+** vector is counted for each literal and each operator.
+*/
+static int batchExprOk(BatchScan *pScan, Expr *pExpr){
+  switch( pExpr->op ){
+    case TK_COLUMN:
+    case TK_AGG_COLUMN: {
+      return batchAddColumn(pScan, pExpr, BATCHCOL_VALUE, 1);
+    }
+    case TK_PLUS:
+    case TK_MINUS:
+    case TK_STAR:
+    case TK_SLASH: {
+      if( !batchExprOk(pScan, pExpr->pLeft) ) return 0;
+      if( !batchExprOk(pScan, pExpr->pRight) ) return 0;
+      break;
+    }
+    default: {
+      if( !batchIsNumber(pExpr) ) return 0;
+      break;
+    }
+  }
+  pScan->nVec++;
+  return 1;
+}
+
+/*
+** Return true if the WHERE clause pExpr can be evaluated by OP_BatchFilter
+** opcodes, and add its terms to pScan->aTerm[].  This is the case if it is
+** an AND of comparisons between columns and numeric literals, or of BETWEEN
+** expressions on a column with numeric limits.
+**
+** A comparison on the rowid or on the leftmost column of an index is not
+** accepted, as the query planner can most likely do better using it.
+*/
+static int batchWhereOk(BatchScan *pScan, Expr *pExpr){
+  Expr *pCol;
+  Expr *aVal[2];
+  u8 aOp[2];
+  int nVal;
+  int i;
+  Index *pIdx;
+
+  if( ExprHasProperty(pExpr, EP_FromJoin) ) return 0;
+  switch( pExpr->op ){
+    case TK_AND: {
+      return batchWhereOk(pScan, pExpr->pLeft)
+          && batchWhereOk(pScan, pExpr->pRight);
+    }
+    case TK_EQ: case TK_NE: case TK_LT: case TK_LE: case TK_GT: case TK_GE: {
+      static const u8 aCommute[] = { TK_NE, TK_EQ, TK_LT, TK_GE, TK_GT, TK_LE };
+      assert( TK_NE+1==TK_EQ && TK_EQ+1==TK_GT && TK_GT+1==TK_LE
+           && TK_LE+1==TK_LT && TK_LT+1==TK_GE );
+      pCol = pExpr->pLeft;
+      aVal[0] = pExpr->pRight;
+      aOp[0] = pExpr->op;
+      if( pCol->op!=TK_COLUMN ){
+        pCol = pExpr->pRight;
+        aVal[0] = pExpr->pLeft;
+        aOp[0] = aCommute[pExpr->op - TK_NE];
+      }
+      nVal = 1;
+      break;
+    }
+    case TK_BETWEEN: {
+      pCol = pExpr->pLeft;
+      if( ExprHasProperty(pExpr, EP_xIsSelect) ) return 0;
+      aVal[0] = pExpr->x.pList->a[0].pExpr;
+      aVal[1] = pExpr->x.pList->a[1].pExpr;
+      aOp[0] = TK_GE;
+      aOp[1] = TK_LE;
+      nVal = 2;
+      break;
+    }
+    default: {
+      return 0;
+    }
+  }
+
+  if( pCol->op!=TK_COLUMN || pCol->iColumn<0 ) return 0;
+  if( pCol->iColumn==pScan->pTab->iPKey ) return 0;
+  for(pIdx=pScan->pTab->pIndex; pIdx; pIdx=pIdx->pNext){
+    if( pIdx->aiColumn[0]==pCol->iColumn ) return 0;
+  }
+  if( !batchAddColumn(pScan, pCol, 0, 1) ) return 0;
+  for(i=0; i<nVal; i++){
+    if( !batchIsNumber(aVal[i]) || pScan->nTerm>=BATCH_MAX_VEC ) return 0;
+    pScan->aTerm[pScan->nTerm].pCol = pCol;
+    pScan->aTerm[pScan->nTerm].pVal = aVal[i];
+    pScan->aTerm[pScan->nTerm].op = aOp[i];
+    pScan->nTerm++;
+  }
+  return 1;
+}
+
+/*
+** Generate code for the aggregate function argument pExpr, which has been
+** accepted by batchExprOk(), and return the vector that holds its value.
+** *piVec is the next free vector, assigned to literals and operators in
+** the same order on every call.
+**
+** If bConst is true, code OP_BatchConst opcodes for literals, which must
+** run once before the loop.  Otherwise, code OP_BatchArith opcodes.
+*/
+static int batchCodeExpr(BatchScan *pScan, Expr *pExpr, int *piVec, int bConst){
+  Parse *pParse = pScan->pParse;
+  Vdbe *v = pParse->pVdbe;
+  int iLeft, iRight, iVec;
+
+  switch( pExpr->op ){
+    case TK_COLUMN:
+    case TK_AGG_COLUMN: {
+      int iCol = pExpr->iColumn;
+      if( iCol==pScan->pTab->iPKey ) iCol = -1;
+      return batchColumnVector(pScan, iCol);
+    }
+    case TK_PLUS:
+    case TK_MINUS:
+    case TK_STAR:
+    case TK_SLASH: {
+      iLeft = batchCodeExpr(pScan, pExpr->pLeft, piVec, bConst);
+      iRight = batchCodeExpr(pScan, pExpr->pRight, piVec, bConst);
+      iVec = (*piVec)++;
+      if( !bConst ){
+        sqlite3VdbeAddOp4Int(v, OP_BatchArith, pScan->iCur, iLeft, iRight, iVec);
+        sqlite3VdbeChangeP5(v, pExpr->op);
+      }
+      return iVec;
+    }
+    default: {
+      iVec = (*piVec)++;
+      if( bConst ){
+        int r1 = sqlite3GetTempReg(pParse);
+        sqlite3ExprCode(pParse, pExpr, r1);
+        sqlite3VdbeAddOp3(v, OP_BatchConst, pScan->iCur, iVec, r1);
+        sqlite3ReleaseTempReg(pParse, r1);
+      }
+      return iVec;
+    }
+  }
+}
+
+/*
+** Add an OP_Explain instruction for a batch scan of table pTab.
+*/
+#ifndef SQLITE_OMIT_EXPLAIN
+static void explainBatchScan(Parse *pParse, Table *pTab){
+  if( pParse->explain==2 ){
+    char *zEqp = sqlite3MPrintf(pParse->db, "SCAN TABLE %s IN BATCHES",
+        pTab->zName
+    );
+    sqlite3VdbeAddOp4(
+        pParse->pVdbe, OP_Explain, pParse->iSelectId, 0, 0, zEqp, P4_DYNAMIC
+    );
+  }
+}
+#else
+# define explainBatchScan(a,b)
+#endif
+
+/*
+** The SELECT statement p is an aggregate query without a GROUP BY clause.
+** Try to generate code that computes its aggregates with a batch scan of
+** the table, a block of rows at a time, instead of using sqlite3WhereBegin()
+** to visit the table a row at a time.  Return true if the code has been
+** generated, or false if the query is not suitable.
+**
+** A batch scan is possible if:
+**
+**   1. The FROM clause is a single ordinary rowid table without an
+**      INDEXED BY clause.
+**
+**   2. Every aggregate is a built-in sum(), total(), avg(), count(),
+**      min() or max() without DISTINCT, and its argument is an expression
+**      of columns and numeric literals accepted by batchExprOk().  No
+**      column is referred to outside of an aggregate.
+**
+**   3. The WHERE clause, if any, is accepted by batchWhereOk().
+**
+**   4. The query is not "SELECT min(x)" or "SELECT max(x)" for an indexed
+**      column x, which minMaxQuery() handles using the index.
+*/
+static int batchAggregate(
+  Parse *pParse,                  /* Parsing context */
+  Select *p,                      /* The SELECT statement */
+  Expr *pWhere,                   /* The WHERE clause of p */
+  AggInfo *pAggInfo               /* Aggregate information for p */
+){
+  sqlite3 *db = pParse->db;
+  Vdbe *v = pParse->pVdbe;
+  struct SrcList_item *pItem = &p->pSrc->a[0];
+  Table *pTab = pItem->pTab;
+  BatchScan sScan;
+  struct AggInfo_func *pF;
+  ExprList *pMinMax;
+  int iDb;
+  int addrTop;
+  int addrEnd;
+  int iVec;
+  int *aiCol;
+  int i, j;
+
+  if( OptimizationDisabled(db, SQLITE_BatchScan) ) return 0;
+  if( p->pSrc->nSrc!=1 || pItem->pSelect || pItem->fg.isIndexedBy ) return 0;
+  if( IsVirtual(pTab) || !HasRowid(pTab) || pTab->pSelect ) return 0;
+  if( pAggInfo->nAccumulator || pAggInfo->nFunc==0 ) return 0;
+
+  memset(&sScan, 0, sizeof(sScan));
+  sScan.pParse = pParse;
+  sScan.pTab = pTab;
+  sScan.iCur = pItem->iCursor;
+  for(i=0, pF=pAggInfo->aFunc; i<pAggInfo->nFunc; i++, pF++){
+    ExprList *pList = pF->pExpr->x.pList;
+    if( pF->iDistinct>=0 || !sqlite3AggBatchable(pF->pFunc) ) return 0;
+    if( pList==0 ) continue;
+    if( pList->nExpr!=1 ) return 0;
+    if( pList->a[0].pExpr->op==TK_AGG_COLUMN
+     && sqlite3StrICmp(pF->pFunc->zName, "count")==0
+    ){
+      /* count(X) only needs to know which values of X are NULL */
+      if( !batchAddColumn(&sScan, pList->a[0].pExpr, 0, 0) ) return 0;
+      continue;
+    }
+    if( !batchExprOk(&sScan, pList->a[0].pExpr) ) return 0;
+  }
+  if( pWhere && !batchWhereOk(&sScan, pWhere) ) return 0;
+  if( sScan.nCol+sScan.nVec>BATCH_MAX_VEC ) return 0;
+  if( minMaxQuery(pAggInfo, &pMinMax)!=WHERE_ORDERBY_NORMAL ){
+    Expr *pArg = pMinMax->a[0].pExpr;
+    Index *pIdx;
+    if( pArg->iColumn<0 || pArg->iColumn==pTab->iPKey ) return 0;
+    for(pIdx=pTab->pIndex; pIdx; pIdx=pIdx->pNext){
+      if( pIdx->aiColumn[0]==pArg->iColumn ) return 0;
+    }
+  }
+
+  /* Sort the columns in the order in which they appear in each record,
+  ** as OP_BatchLoad requires. */
+  for(i=1; i<sScan.nCol; i++){
+    for(j=i; j>0 && sScan.aiCol[1+j*2]<sScan.aiCol[j*2-1]; j--){
+      int t0 = sScan.aiCol[1+j*2], t1 = sScan.aiCol[2+j*2];
+      sScan.aiCol[1+j*2] = sScan.aiCol[j*2-1];
+      sScan.aiCol[2+j*2] = sScan.aiCol[j*2];
+      sScan.aiCol[j*2-1] = t0;
+      sScan.aiCol[j*2] = t1;
+    }
+  }
+  sScan.aiCol[0] = 1 + sScan.nCol*2;
+  aiCol = sqlite3DbMallocRawNN(db, sizeof(int)*sScan.aiCol[0]);
+  if( aiCol==0 ) return 0;
+  memcpy(aiCol, sScan.aiCol, sizeof(int)*sScan.aiCol[0]);
+
+  /* Open the table and allocate the batch.  Then set up the vectors that
+  ** hold constants, and the registers compared against by OP_BatchFilter. */
+  iDb = sqlite3SchemaToIndex(db, pTab->pSchema);
+  sqlite3CodeVerifySchema(pParse, iDb);
+  resetAccumulator(pParse, pAggInfo);
+  sqlite3OpenTable(pParse, sScan.iCur, iDb, pTab, OP_OpenRead);
+  addrEnd = sqlite3VdbeMakeLabel(v);
+  sqlite3VdbeAddOp2(v, OP_Rewind, sScan.iCur, addrEnd); VdbeCoverage(v);
+  sqlite3VdbeAddOp2(v, OP_BatchOpen, sScan.iCur, sScan.nCol+sScan.nVec);
+  iVec = sScan.nCol;
+  for(i=0, pF=pAggInfo->aFunc; i<pAggInfo->nFunc; i++, pF++){
+    ExprList *pList = pF->pExpr->x.pList;
+    if( pList ) batchCodeExpr(&sScan, pList->a[0].pExpr, &iVec, 1);
+  }
+  for(i=0; i<sScan.nTerm; i++){
+    struct BatchTerm *pTerm = &sScan.aTerm[i];
+    pTerm->iReg = ++pParse->nMem;
+    sqlite3ExprCode(pParse, pTerm->pVal, pTerm->iReg);
+  }
+
+  /* The loop over batches.  Filters run first, so that the arithmetic
+  ** and aggregates only need to consider the rows that remain. */
+  addrTop = sqlite3VdbeAddOp4(v, OP_BatchLoad, sScan.iCur, addrEnd, 0,
+                              (char*)aiCol, P4_INTARRAY);
+  VdbeCoverage(v);
+  for(i=0; i<sScan.nTerm; i++){
+    struct BatchTerm *pTerm = &sScan.aTerm[i];
+    sqlite3VdbeAddOp3(v, OP_BatchFilter, sScan.iCur,
+        batchColumnVector(&sScan, pTerm->pCol->iColumn), pTerm->iReg
+    );
+    sqlite3VdbeChangeP5(v, pTerm->op);
+  }
+  iVec = sScan.nCol;
+  for(i=0, pF=pAggInfo->aFunc; i<pAggInfo->nFunc; i++, pF++){
+    ExprList *pList = pF->pExpr->x.pList;
+    int iArg = -1;
+    if( pList ){
+      iArg = batchCodeExpr(&sScan, pList->a[0].pExpr, &iVec, 0);
+    }
+    if( pF->pFunc->funcFlags & SQLITE_FUNC_NEEDCOLL ){
+      CollSeq *pColl = sqlite3ExprCollSeq(pParse, pList->a[0].pExpr);
+      if( !pColl ) pColl = db->pDfltColl;
+      sqlite3VdbeAddOp4(v, OP_CollSeq, 0, 0, 0, (char *)pColl, P4_COLLSEQ);
+    }
+    sqlite3VdbeAddOp4(v, OP_BatchAgg, sScan.iCur, iArg, pF->iMem,
+                      (void*)pF->pFunc, P4_FUNCDEF);
+    sqlite3VdbeChangeP5(v, pList ? 1 : 0);
+  }
+  sqlite3VdbeGoto(v, addrTop);
+  sqlite3VdbeResolveLabel(v, addrEnd);
+  sqlite3VdbeAddOp1(v, OP_Close, sScan.iCur);
+  explainBatchScan(pParse, pTab);
+  finalizeAggFunctions(pParse, pAggInfo);
+  return 1;
+}
+
 /*
 ** Generate code for the SELECT statement given in the p argument.  
 **
@@ -5550,6 +5944,9 @@ int sqlite3Select(
         explainSimpleCount(pParse, pTab, pBest);
       }else
 #endif /* SQLITE_OMIT_BTREECOUNT */
+      if( batchAggregate(pParse, p, pWhere, &sAggInfo) ){
+        /* Aggregates computed by a batch scan of the table. */
+      }else
       {
         /* Check if the query is of one of the following forms:
         **
@@ -39,6 +39,27 @@
 
 #include "sha2.h"
 
+/*
+ * Hardware SHA-256 (Intel SHA extensions) on x86 and x86-64.
+ * The instructions are selected at runtime via cpuid, so the code still
+ * runs on processors without them. Define SHA2_OMIT_SHANI to build the
+ * portable implementation only.
+ */
+#if !defined(SHA2_OMIT_SHANI)
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define SHA2_SHANI_TARGET
+#elif (defined(__x86_64__) || defined(__i386__)) && \
+      (defined(__clang__) || (__GNUC__ >= 5))
+#include <cpuid.h>
+#include <immintrin.h>
+#define SHA2_SHANI_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+#else
+#define SHA2_OMIT_SHANI
+#endif
+#endif
+
 #define SHFR(x, n)    (x >> n)
 #define ROTR(x, n)   ((x >> n) | (x << ((sizeof(x) << 3) - n)))
 #define ROTL(x, n)   ((x << n) | (x >> ((sizeof(x) << 3) - n)))
@@ -209,6 +230,89 @@ uint64 sha512_k[80] =
 
 /* SHA-256 functions */
 
+#ifndef SHA2_OMIT_SHANI
+
+static int shaniAvailable = -1;
+
+static int sha2_shani_available(void)
+{
+    if (shaniAvailable < 0) {
+#if defined(_MSC_VER)
+        int info[4];
+        int ok;
+        __cpuid(info, 1);
+        ok = (info[2] & (1 << 9)) != 0 && (info[2] & (1 << 19)) != 0;
+        __cpuidex(info, 7, 0);
+        shaniAvailable = ok && (info[1] & (1 << 29)) != 0;
+#else
+        unsigned int eax, ebx, ecx, edx;
+        int ok = __get_cpuid(1, &eax, &ebx, &ecx, &edx) &&
+                 (ecx & (1 << 9)) != 0 && (ecx & (1 << 19)) != 0;
+        shaniAvailable = ok && __get_cpuid_max(0, 0) >= 7;
+        if (shaniAvailable) {
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+            shaniAvailable = (ebx & (1 << 29)) != 0;
+        }
+#endif
+    }
+    return shaniAvailable;
+}
+
+/*
+ * The state is kept as ABEF and CDGH in two registers, as the
+ * SHA256RNDS2 instruction expects. Each iteration of the inner loop
+ * performs four rounds and computes the next four words of the message
+ * schedule from the previous sixteen.
+ */
+SHA2_SHANI_TARGET
+static void sha256_transf_shani(sha256_ctx *ctx, const unsigned char *message,
+                                unsigned int block_nb)
+{
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i state0, state1, msg, tmp, abef, cdgh;
+    __m128i w[4];
+    int g;
+
+    tmp    = _mm_loadu_si128((const __m128i *) &ctx->h[0]);
+    state1 = _mm_loadu_si128((const __m128i *) &ctx->h[4]);
+    tmp    = _mm_shuffle_epi32(tmp, 0xB1);            /* CDAB */
+    state1 = _mm_shuffle_epi32(state1, 0x1B);         /* EFGH */
+    state0 = _mm_alignr_epi8(tmp, state1, 8);         /* ABEF */
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);      /* CDGH */
+
+    for (; block_nb > 0; block_nb--, message += SHA256_BLOCK_SIZE) {
+        abef = state0;
+        cdgh = state1;
+        for (g = 0; g < 16; g++) {
+            if (g < 4) {
+                w[g] = _mm_shuffle_epi8(
+                    _mm_loadu_si128((const __m128i *) (message + (g << 4))), mask);
+            } else {
+                tmp = _mm_alignr_epi8(w[(g - 1) & 3], w[(g - 2) & 3], 4);
+                w[g & 3] = _mm_sha256msg2_epu32(
+                    _mm_add_epi32(_mm_sha256msg1_epu32(w[g & 3], w[(g - 3) & 3]), tmp),
+                    w[(g - 1) & 3]);
+            }
+            msg = _mm_add_epi32(w[g & 3],
+                                _mm_loadu_si128((const __m128i *) &sha256_k[g << 2]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        }
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+    }
+
+    tmp    = _mm_shuffle_epi32(state0, 0x1B);         /* FEBA */
+    state1 = _mm_shuffle_epi32(state1, 0xB1);         /* DCHG */
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);      /* DCBA */
+    state1 = _mm_alignr_epi8(state1, tmp, 8);         /* HGFE */
+    _mm_storeu_si128((__m128i *) &ctx->h[0], state0);
+    _mm_storeu_si128((__m128i *) &ctx->h[4], state1);
+}
+
+#endif /* !SHA2_OMIT_SHANI */
+
 void sha256_transf(sha256_ctx *ctx, const unsigned char *message,
                    unsigned int block_nb)
 {
@@ -222,6 +326,13 @@ void sha256_transf(sha256_ctx *ctx, const unsigned char *message,
     int j;
 #endif
 
+#ifndef SHA2_OMIT_SHANI
+    if (sha2_shani_available()) {
+        sha256_transf_shani(ctx, message, block_nb);
+        return;
+    }
+#endif
+
     for (i = 0; i < (int) block_nb; i++) {
         sub_block = message + (i << 6);
 
@@ -1838,6 +1838,53 @@ struct sqlite3_mem_methods {
 ** I/O required to support statement rollback.
 ** The default value for this setting is controlled by the
 ** [SQLITE_STMTJRNL_SPILL] compile-time option.
+**
+** [[SQLITE_CONFIG_PCACHE_SHARDS]]
+** <dt>SQLITE_CONFIG_PCACHE_SHARDS
+** <dd>^The SQLITE_CONFIG_PCACHE_SHARDS option takes a single integer
+** parameter N.  ^When the default page cache implementation keeps the
+** pages of all database connections in a single shared pool, that pool
+** is split into N shards, each with its own mutex, LRU list and share of
+** the cache_size budget.  ^Every page cache is assigned to one shard, so
+** connections in different shards do not contend for the same mutex.
+** ^Values less than 1 are treated as 1 (a single pool, the default) and
+** values larger than the SQLITE_MAX_PCACHE_SHARDS compile-time limit
+** are reduced to that limit.  ^The setting has no effect if each
+** database connection has a private page cache, which is the case unless
+** SQLite is built with SQLITE_ENABLE_MEMORY_MANAGEMENT or is used
+** single-threaded with [SQLITE_CONFIG_PAGECACHE] memory.
+**
+** [[SQLITE_CONFIG_PCACHE_POLICY]]
+** <dt>SQLITE_CONFIG_PCACHE_POLICY
+** <dd>^The SQLITE_CONFIG_PCACHE_POLICY option takes a single integer
+** parameter that selects the page replacement policy of the default page
+** cache implementation.  ^With [SQLITE_PCACHE_POLICY_LRU] (the default)
+** the least recently used page is recycled first.  ^With
+** [SQLITE_PCACHE_POLICY_2Q] pages read into the cache are kept on
+** probation until they are used a second time, and pages on probation
+** are recycled before the others, so that a large table scan or a
+** [sqlite3_backup] does not flush the frequently used pages out of the
+** cache.  ^Any other value is an error.  The effectiveness of the policy
+** may be measured with [SQLITE_STATUS_PAGECACHE_HIT] and
+** [SQLITE_STATUS_PAGECACHE_MISS].
+**
+** [[SQLITE_CONFIG_PCACHE_HUGEPAGE]]
+** <dt>SQLITE_CONFIG_PCACHE_HUGEPAGE
+** <dd>^The SQLITE_CONFIG_PCACHE_HUGEPAGE option is only available if SQLite
+** is compiled with SQLITE_ENABLE_PCACHE_HUGEPAGE.  It takes two arguments:
+** the size of each page cache line (an int, see [SQLITE_CONFIG_PAGECACHE]
+** for how to compute it) and the total size of the slab in bytes (an
+** sqlite3_int64).  ^On unix, [sqlite3_initialize()] then reserves the slab
+** as a single anonymous memory mapping backed by 2MiB huge pages, if the
+** system has any reserved (MAP_HUGETLB), or by transparent huge pages
+** otherwise, and the default page cache implementation takes its page
+** buffers from the slab without any mutex.  ^Page buffers that do not fit
+** into a slot, or are requested when the slab is exhausted, are obtained
+** from [sqlite3_malloc()] as usual.  ^[sqlite3_release_memory()] returns
+** the memory of every 2MiB chunk of the slab without a page in use to the
+** operating system.  The slab is not included in [SQLITE_STATUS_MEMORY_USED].
+** Its slots in use are counted by [SQLITE_STATUS_PAGECACHE_USED], like the
+** slots of [SQLITE_CONFIG_PAGECACHE].
 ** </dl>
 */
 #define SQLITE_CONFIG_SINGLETHREAD  1  /* nil */
@@ -1866,6 +1913,18 @@ struct sqlite3_mem_methods {
 #define SQLITE_CONFIG_PCACHE_HDRSZ        24  /* int *psz */
 #define SQLITE_CONFIG_PMASZ               25  /* unsigned int szPma */
 #define SQLITE_CONFIG_STMTJRNL_SPILL      26  /* int nByte */
+#define SQLITE_CONFIG_PCACHE_SHARDS       27  /* int nShard */
+#define SQLITE_CONFIG_PCACHE_POLICY       28  /* int ePolicy */
+#define SQLITE_CONFIG_PCACHE_HUGEPAGE     29  /* int sz, sqlite3_int64 N */
+
+/*
+** CAPI3REF: Page Cache Replacement Policies
+**
+** These constants are the page replacement policies that may be
+** selected with [SQLITE_CONFIG_PCACHE_POLICY].
+*/
+#define SQLITE_PCACHE_POLICY_LRU    0
+#define SQLITE_PCACHE_POLICY_2Q     1
 
 /*
 ** CAPI3REF: Database Connection Configuration Options
@@ -4903,6 +4962,19 @@ SQLITE_API int SQLITE_STDCALL sqlite3_key_v2(
   const void *pKey, int nKey     /* The key */
 );
 
+/*
+** Specify the encryption key itself for an encrypted database, instead of
+** a password to derive it from.  The key derivation is skipped, so opening
+** a connection costs no more than opening an unencrypted database.  nKey
+** must be the key length of the cipher: 16 bytes for AES-128, 32 bytes for
+** AES-256 and ChaCha20.  Otherwise SQLITE_ERROR is returned.
+*/
+SQLITE_API int SQLITE_STDCALL sqlite3_key_raw_v2(
+  sqlite3 *db,                   /* Database to be keyed */
+  const char *zDbName,           /* Name of the database */
+  const void *pKey, int nKey     /* The raw key */
+);
+
 /*
 ** Change the key on an open database.  If the current database is not
 ** encrypted, this routine will encrypt it.  If pNew==0 or nNew==0, the
@@ -4921,6 +4993,39 @@ SQLITE_API int SQLITE_STDCALL sqlite3_rekey_v2(
   const void *pKey, int nKey     /* The new key */
 );
 
+/*
+** Change the key of an encrypted database incrementally, in the style of
+** the [sqlite3_backup_init | online backup API].
+**
+** sqlite3_rekey_init() prepares changing the key of database zDbName to
+** the new key.  Each call to sqlite3_rekey_step(P,N) then re-encrypts up
+** to N pages with the new key in a write transaction of its own, or all
+** remaining pages if N is negative.  It returns SQLITE_DONE once the whole
+** database is encrypted with the new key, SQLITE_OK if pages remain, or
+** an error code.  SQLITE_BUSY and SQLITE_LOCKED are not fatal and the step
+** may be retried later.  sqlite3_rekey_finish() releases the rekey object.
+** sqlite3_rekey_remaining() and sqlite3_rekey_pagecount() report the
+** progress as of the last step.
+**
+** The progress is recorded in the database file.  While a rekey is in
+** progress the database is encrypted partly with the old and partly with
+** the new key, so every connection must open it with the old key and then
+** supply the new key by calling sqlite3_rekey_init().  A connection that
+** has only the old key fails with SQLITE_BUSY on the pages already
+** encrypted with the new key.  If the rekey is interrupted, calling
+** sqlite3_rekey_init() with the same new key resumes it.
+*/
+typedef struct sqlite3_rekey_job sqlite3_rekey_job;
+SQLITE_API sqlite3_rekey_job * SQLITE_STDCALL sqlite3_rekey_init(
+  sqlite3 *db,                   /* Database to be rekeyed */
+  const char *zDbName,           /* Name of the database */
+  const void *pKey, int nKey     /* The new key */
+);
+SQLITE_API int SQLITE_STDCALL sqlite3_rekey_step(sqlite3_rekey_job *p, int nPage);
+SQLITE_API int SQLITE_STDCALL sqlite3_rekey_finish(sqlite3_rekey_job *p);
+SQLITE_API int SQLITE_STDCALL sqlite3_rekey_remaining(sqlite3_rekey_job *p);
+SQLITE_API int SQLITE_STDCALL sqlite3_rekey_pagecount(sqlite3_rekey_job *p);
+
 /*
 ** Specify the activation key for a SEE database.  Unless 
 ** activated, none of the SEE routines will work.
@@ -6646,6 +6751,24 @@ SQLITE_API int SQLITE_STDCALL sqlite3_status64(
 ** <dd>The *pHighwater parameter records the deepest parser stack. 
 ** The *pCurrent value is undefined.  The *pHighwater value is only
 ** meaningful if SQLite is compiled with [YYTRACKMAXSTACKDEPTH].</dd>)^
+**
+** [[SQLITE_STATUS_PAGECACHE_HIT]] ^(<dt>SQLITE_STATUS_PAGECACHE_HIT</dt>
+** <dd>This parameter returns the number of times the default page cache
+** found a requested page in the cache.</dd>)^
+**
+** [[SQLITE_STATUS_PAGECACHE_MISS]] ^(<dt>SQLITE_STATUS_PAGECACHE_MISS</dt>
+** <dd>This parameter returns the number of times the default page cache
+** had to make room for a requested page that was not in the cache.
+** Together with SQLITE_STATUS_PAGECACHE_HIT it gives the hit ratio of
+** the page replacement policy set by [SQLITE_CONFIG_PCACHE_POLICY].
+** Both counters are updated in batches, so they may lag behind by up
+** to a few hundred fetches per page cache.</dd>)^
+**
+** [[SQLITE_STATUS_PAGECACHE_GHOST]] ^(<dt>SQLITE_STATUS_PAGECACHE_GHOST</dt>
+** <dd>This parameter returns how many of the misses counted by
+** SQLITE_STATUS_PAGECACHE_MISS were for a page that [SQLITE_PCACHE_POLICY_2Q]
+** had recycled shortly before.  It is always zero with the LRU
+** policy.</dd>)^
 ** </dl>
 **
 ** New status parameters may be added from time to time.
@@ -6660,6 +6783,9 @@ SQLITE_API int SQLITE_STDCALL sqlite3_status64(
 #define SQLITE_STATUS_PAGECACHE_SIZE       7
 #define SQLITE_STATUS_SCRATCH_SIZE         8
 #define SQLITE_STATUS_MALLOC_COUNT         9
+#define SQLITE_STATUS_PAGECACHE_HIT       10
+#define SQLITE_STATUS_PAGECACHE_MISS      11
+#define SQLITE_STATUS_PAGECACHE_GHOST     12
 
 /*
 ** CAPI3REF: Database Connection Status
@@ -6774,6 +6900,34 @@ SQLITE_API int SQLITE_STDCALL sqlite3_db_status(sqlite3*, int op, int *pCur, int
 ** all foreign key constraints (deferred or immediate) have been
 ** resolved.)^  ^The highwater mark is always 0.
 ** </dd>
+**
+** [[SQLITE_DBSTATUS_CODEC_CACHE_HIT]] ^(<dt>SQLITE_DBSTATUS_CODEC_CACHE_HIT</dt>
+** <dd>This parameter returns the number of times the codec of an encrypted
+** database found the derived key, initial vector and expanded round keys
+** of a page in its key cache.)^ ^The highwater mark associated with
+** SQLITE_DBSTATUS_CODEC_CACHE_HIT is always 0.
+** </dd>
+**
+** [[SQLITE_DBSTATUS_CODEC_CACHE_MISS]] ^(<dt>SQLITE_DBSTATUS_CODEC_CACHE_MISS</dt>
+** <dd>This parameter returns the number of times the codec of an encrypted
+** database had to derive the key schedule of a page.)^ ^The highwater mark
+** associated with SQLITE_DBSTATUS_CODEC_CACHE_MISS is always 0.
+** </dd>
+**
+** [[SQLITE_DBSTATUS_CODEC_PAGE_HIT]] ^(<dt>SQLITE_DBSTATUS_CODEC_PAGE_HIT</dt>
+** <dd>This parameter returns the number of pages of an encrypted database
+** that were taken from the decrypted page cache shared by all connections
+** of the process (see "PRAGMA codec_page_cache") instead of being
+** decrypted.)^ ^The highwater mark associated with
+** SQLITE_DBSTATUS_CODEC_PAGE_HIT is always 0.
+** </dd>
+**
+** [[SQLITE_DBSTATUS_CODEC_PAGE_MISS]] ^(<dt>SQLITE_DBSTATUS_CODEC_PAGE_MISS</dt>
+** <dd>This parameter returns the number of pages of an encrypted database
+** that were not found in the shared decrypted page cache while it was
+** enabled.)^ ^The highwater mark associated with
+** SQLITE_DBSTATUS_CODEC_PAGE_MISS is always 0.
+** </dd>
 ** </dl>
 */
 #define SQLITE_DBSTATUS_LOOKASIDE_USED       0
@@ -6787,7 +6941,11 @@ SQLITE_API int SQLITE_STDCALL sqlite3_db_status(sqlite3*, int op, int *pCur, int
 #define SQLITE_DBSTATUS_CACHE_MISS           8
 #define SQLITE_DBSTATUS_CACHE_WRITE          9
 #define SQLITE_DBSTATUS_DEFERRED_FKS        10
-#define SQLITE_DBSTATUS_MAX                 10   /* Largest defined DBSTATUS */
+#define SQLITE_DBSTATUS_CODEC_CACHE_HIT     11
+#define SQLITE_DBSTATUS_CODEC_CACHE_MISS    12
+#define SQLITE_DBSTATUS_CODEC_PAGE_HIT      13
+#define SQLITE_DBSTATUS_CODEC_PAGE_MISS     14
+#define SQLITE_DBSTATUS_MAX                 14   /* Largest defined DBSTATUS */
 
 
 /*
@@ -556,6 +556,40 @@
 # define SQLITE_DEFAULT_PCACHE_INITSZ 100
 #endif
 
+/*
+** The number of shards the global page cache is split into when all page
+** caches share a single pool of pages (see pcache1.c).  Each shard has its
+** own mutex and LRU list.  SQLITE_MAX_PCACHE_SHARDS is the largest value
+** accepted by sqlite3_config(SQLITE_CONFIG_PCACHE_SHARDS).
+*/
+#ifndef SQLITE_MAX_PCACHE_SHARDS
+# define SQLITE_MAX_PCACHE_SHARDS 64
+#endif
+#ifndef SQLITE_DEFAULT_PCACHE_SHARDS
+# define SQLITE_DEFAULT_PCACHE_SHARDS 1
+#endif
+#if SQLITE_DEFAULT_PCACHE_SHARDS>SQLITE_MAX_PCACHE_SHARDS
+# undef SQLITE_MAX_PCACHE_SHARDS
+# define SQLITE_MAX_PCACHE_SHARDS SQLITE_DEFAULT_PCACHE_SHARDS
+#endif
+
+/*
+** The default page replacement policy of the page cache, one of the
+** SQLITE_PCACHE_POLICY_* values of sqlite3_config(SQLITE_CONFIG_PCACHE_POLICY).
+*/
+#ifndef SQLITE_DEFAULT_PCACHE_POLICY
+# define SQLITE_DEFAULT_PCACHE_POLICY SQLITE_PCACHE_POLICY_LRU
+#endif
+
+/*
+** The default percentage of each page filled when a b-tree is built
+** bottom-up from sorted input (CREATE INDEX, VACUUM and INSERT INTO ...
+** SELECT).  See PRAGMA bulk_fill_factor.
+*/
+#ifndef SQLITE_DEFAULT_BULK_FILL
+# define SQLITE_DEFAULT_BULK_FILL 100
+#endif
+
 /*
 ** GCC does not define the offsetof() macro so we'll have to do it
 ** ourselves.
@@ -968,6 +1002,7 @@ typedef struct AutoincInfo AutoincInfo;
 typedef struct Bitvec Bitvec;
 typedef struct CollSeq CollSeq;
 typedef struct Column Column;
+typedef struct Checkpointer Checkpointer;
 typedef struct Db Db;
 typedef struct Schema Schema;
 typedef struct Expr Expr;
@@ -1065,6 +1100,8 @@ struct Db {
   u8 safety_level;     /* How aggressive at syncing data to disk */
   u8 bSyncSet;         /* True if "PRAGMA synchronous=N" has been run */
   Schema *pSchema;     /* Pointer to database schema (possibly shared) */
+  Checkpointer *pCkpt; /* Background checkpointer, or NULL */
+  int nCkptLimit;      /* PRAGMA wal_checkpoint_limit, 0 for the default */
 };
 
 /*
@@ -1394,6 +1431,7 @@ struct sqlite3 {
 #define SQLITE_Transitive     0x0200   /* Transitive constraints */
 #define SQLITE_OmitNoopJoin   0x0400   /* Omit unused tables in joins */
 #define SQLITE_Stat34         0x0800   /* Use STAT3 or STAT4 data */
+#define SQLITE_BatchScan      0x1000   /* Batched aggregate table scans */
 #define SQLITE_CursorHints    0x2000   /* Add OP_CursorHint opcodes */
 #define SQLITE_AllOpts        0xffff   /* All optimizations */
 
@@ -2936,6 +2974,12 @@ struct AuthContext {
 #define OPFLAG_SAVEPOSITION  0x02    /* OP_Delete: keep cursor position */
 #define OPFLAG_AUXDELETE     0x04    /* OP_Delete: index in a DELETE op */
 
+/*
+** Flags for the columns of an OP_BatchLoad.
+*/
+#define BATCHCOL_REAL        0x01    /* Column has REAL affinity */
+#define BATCHCOL_VALUE       0x02    /* Text and blob values are needed */
+
 /*
  * Each trigger present in the database schema is stored as an instance of
  * struct Trigger.
@@ -3105,6 +3149,12 @@ struct Sqlite3Config {
   void *pPage;                      /* Page cache memory */
   int szPage;                       /* Size of each page in pPage[] */
   int nPage;                        /* Number of pages in pPage[] */
+  int nPcacheShard;                 /* Shards of the global page cache */
+  int ePcachePolicy;                /* SQLITE_PCACHE_POLICY_* value */
+#ifdef SQLITE_ENABLE_PCACHE_HUGEPAGE
+  int szHugeSlot;                   /* Slot size of the huge-page slab */
+  sqlite3_int64 nHugeByte;          /* Size of the huge-page slab */
+#endif
   int mxParserStack;                /* maximum depth of the parser stack */
   int sharedCacheEnabled;           /* true if shared-cache mode enabled */
   u32 szPma;                        /* Maximum Sorter PMA size */
@@ -3661,6 +3711,7 @@ FuncDef *sqlite3FindFunction(sqlite3*,const char*,int,u8,u8);
 void sqlite3RegisterBuiltinFunctions(void);
 void sqlite3RegisterDateTimeFunctions(void);
 void sqlite3RegisterPerConnectionBuiltinFunctions(sqlite3*);
+int sqlite3AggBatchable(FuncDef*);
 int sqlite3SafetyCheckOk(sqlite3*);
 int sqlite3SafetyCheckSickOrOk(sqlite3*);
 void sqlite3ChangeCookie(Parse*, int);
@@ -3796,6 +3847,7 @@ Expr *sqlite3ExprAddCollateToken(Parse *pParse, Expr*, const Token*, int);
 Expr *sqlite3ExprAddCollateString(Parse*,Expr*,const char*);
 Expr *sqlite3ExprSkipCollate(Expr*);
 int sqlite3CheckCollSeq(Parse *, CollSeq *);
+int sqlite3IsNocase(const CollSeq*);
 int sqlite3CheckObjectName(Parse *, const char *);
 void sqlite3VdbeSetChanges(sqlite3 *, int);
 int sqlite3AddInt64(i64*,i64);
@@ -3978,6 +4030,8 @@ const char *sqlite3JournalModename(int);
 #ifndef SQLITE_OMIT_WAL
   int sqlite3Checkpoint(sqlite3*, int, int, int*, int*);
   int sqlite3WalDefaultHook(void*,sqlite3*,const char*,int);
+  int sqlite3WalBackground(sqlite3*, int, int);
+  int sqlite3WalBackgroundLimit(sqlite3*, int, int);
 #endif
 #ifndef SQLITE_OMIT_CTE
   With *sqlite3WithAdd(Parse*,With*,Token*,ExprList*,Select*);
@@ -4164,5 +4218,11 @@ void sqlite3PagerSetCodec(
 	void *pCodec
 	);
 void *sqlite3PagerGetCodec(Pager *pPager);
+void sqlite3CodecCacheStat(void *pCodec, int op, int resetFlag, int *pValue);
+int sqlite3CodecKdfIter(int iter);
+int sqlite3CodecPageCache(int nPage);
+void sqlite3CodecShutdown(void);
+int sqlite3CodecShare(sqlite3*, int, sqlite3*, int);
+int sqlite3CodecPageError(void*, Pgno, int);
 #endif /*SQLITE_HAS_CODEC*/
 #endif /* _SQLITEINT_H_ */
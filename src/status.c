@@ -26,8 +26,8 @@ typedef u32 sqlite3StatValueType;
 #endif
 typedef struct sqlite3StatType sqlite3StatType;
 static SQLITE_WSD struct sqlite3StatType {
-  sqlite3StatValueType nowValue[10];  /* Current value */
-  sqlite3StatValueType mxValue[10];   /* Maximum value */
+  sqlite3StatValueType nowValue[13];  /* Current value */
+  sqlite3StatValueType mxValue[13];   /* Maximum value */
 } sqlite3Stat = { {0,}, {0,} };
 
 /*
@@ -45,6 +45,9 @@ static const char statMutex[] = {
   1,  /* SQLITE_STATUS_PAGECACHE_SIZE */
   0,  /* SQLITE_STATUS_SCRATCH_SIZE */
   0,  /* SQLITE_STATUS_MALLOC_COUNT */
+  1,  /* SQLITE_STATUS_PAGECACHE_HIT */
+  1,  /* SQLITE_STATUS_PAGECACHE_MISS */
+  1,  /* SQLITE_STATUS_PAGECACHE_GHOST */
 };
 
 
@@ -337,6 +340,32 @@ int sqlite3_db_status(
       break;
     }
 
+#ifdef SQLITE_HAS_CODEC
+    /*
+    ** Set *pCurrent to the total number of page key cache or shared page
+    ** cache hits or misses of the codecs of all encrypted databases the
+    ** handle is connected to. *pHighwater is always set to zero.
+    */
+    case SQLITE_DBSTATUS_CODEC_CACHE_HIT:
+    case SQLITE_DBSTATUS_CODEC_CACHE_MISS:
+    case SQLITE_DBSTATUS_CODEC_PAGE_HIT:
+    case SQLITE_DBSTATUS_CODEC_PAGE_MISS: {
+      int i;
+      int nRet = 0;
+      sqlite3BtreeEnterAll(db);
+      for(i=0; i<db->nDb; i++){
+        if( db->aDb[i].pBt ){
+          void *pCodec = sqlite3PagerGetCodec(sqlite3BtreePager(db->aDb[i].pBt));
+          if( pCodec ) sqlite3CodecCacheStat(pCodec, op, resetFlag, &nRet);
+        }
+      }
+      sqlite3BtreeLeaveAll(db);
+      *pHighwater = 0;
+      *pCurrent = nRet;
+      break;
+    }
+#endif
+
     default: {
       rc = SQLITE_ERROR;
     }
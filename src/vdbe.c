@@ -141,6 +141,49 @@ int sqlite3_found_count = 0;
   }
 #endif
 
+/*
+** If SQLITE_ENABLE_COMPUTED_GOTO is defined and the compiler supports
+** the "labels as values" extension of GCC and clang, sqlite3VdbeExec()
+** jumps straight to the code for each opcode through a table of label
+** addresses, aOpLabel[], instead of through the switch statement.  With
+** VDBE_DISPATCH below, every opcode ends with its own copy of that
+** indirect jump.  Each copy is predicted separately, which suits the
+** branch predictors of modern CPUs better than the single indirect
+** branch of the switch.
+**
+** VDBE_LABEL() follows each case label in the switch and supplies the
+** label that the table refers to.  A new opcode must be added to
+** aOpLabel[] as well, or it runs the default case in this build.  The
+** switch statement is still used when computed goto is not available.
+*/
+#if defined(SQLITE_ENABLE_COMPUTED_GOTO) && defined(__GNUC__)
+# define VDBE_COMPUTED_GOTO 1
+# define VDBE_LABEL(X) L_##X:
+# define VDBE_OPLABEL(X) [X] = &&L_##X
+#else
+# define VDBE_LABEL(X)
+#endif
+
+/*
+** Opcodes finish with VDBE_DISPATCH instead of "break".  In a build that
+** uses computed goto and does no per-opcode tracing, profiling or test
+** instrumentation at the top and bottom of the loop, VDBE_DISPATCH moves
+** to the next opcode and jumps to its code directly, so that there is one
+** copy of the indirect jump per opcode.  Otherwise it breaks out of the
+** switch statement to the shared code at the bottom of the loop.
+**
+** VDBE_DISPATCH must only be used directly in the body of a case, not
+** inside a nested loop or switch, where "break" would mean something
+** else.
+*/
+#if defined(VDBE_COMPUTED_GOTO) && !defined(SQLITE_DEBUG) \
+ && !defined(VDBE_PROFILE) && !defined(SQLITE_TEST) \
+ && !defined(SQLITE_ENABLE_STMT_SCANSTATUS)
+# define VDBE_DISPATCH { pOp++; nVmStep++; goto *aOpLabel[pOp->opcode]; }
+#else
+# define VDBE_DISPATCH break
+#endif
+
 /*
 ** Convert the given register into a string if it isn't one
 ** already. Return non-zero if a malloc() fails.
@@ -574,6 +617,133 @@ int sqlite3VdbeExec(
   i64 lastRowid = db->lastRowid;  /* Saved value of the last insert ROWID */
 #ifdef VDBE_PROFILE
   u64 start;                 /* CPU clock count at start of opcode */
+#endif
+#ifdef VDBE_COMPUTED_GOTO
+  /* The code of each opcode, indexed by opcode.  Opcodes not listed run
+  ** the default case, as they would in the switch statement. */
+  static const void *const aOpLabel[256] = {
+    [0 ... 255] = &&L_default,
+    VDBE_OPLABEL(OP_Goto), VDBE_OPLABEL(OP_Gosub), VDBE_OPLABEL(OP_Return),
+    VDBE_OPLABEL(OP_InitCoroutine), VDBE_OPLABEL(OP_EndCoroutine),
+    VDBE_OPLABEL(OP_Yield), VDBE_OPLABEL(OP_HaltIfNull), VDBE_OPLABEL(OP_Halt),
+    VDBE_OPLABEL(OP_Integer), VDBE_OPLABEL(OP_Int64),
+#ifndef SQLITE_OMIT_FLOATING_POINT
+    VDBE_OPLABEL(OP_Real),
+#endif
+    VDBE_OPLABEL(OP_String8), VDBE_OPLABEL(OP_String), VDBE_OPLABEL(OP_Null),
+    VDBE_OPLABEL(OP_SoftNull), VDBE_OPLABEL(OP_Blob),
+    VDBE_OPLABEL(OP_Variable), VDBE_OPLABEL(OP_Move), VDBE_OPLABEL(OP_Copy),
+    VDBE_OPLABEL(OP_SCopy), VDBE_OPLABEL(OP_IntCopy),
+    VDBE_OPLABEL(OP_ResultRow), VDBE_OPLABEL(OP_Concat), VDBE_OPLABEL(OP_Add),
+    VDBE_OPLABEL(OP_Subtract), VDBE_OPLABEL(OP_Multiply),
+    VDBE_OPLABEL(OP_Divide), VDBE_OPLABEL(OP_Remainder),
+    VDBE_OPLABEL(OP_CollSeq), VDBE_OPLABEL(OP_Function0),
+    VDBE_OPLABEL(OP_Function), VDBE_OPLABEL(OP_BitAnd), VDBE_OPLABEL(OP_BitOr),
+    VDBE_OPLABEL(OP_ShiftLeft), VDBE_OPLABEL(OP_ShiftRight),
+    VDBE_OPLABEL(OP_AddImm), VDBE_OPLABEL(OP_MustBeInt),
+#ifndef SQLITE_OMIT_FLOATING_POINT
+    VDBE_OPLABEL(OP_RealAffinity),
+#endif
+#ifndef SQLITE_OMIT_CAST
+    VDBE_OPLABEL(OP_Cast),
+#endif
+    VDBE_OPLABEL(OP_Eq), VDBE_OPLABEL(OP_Ne), VDBE_OPLABEL(OP_Lt),
+    VDBE_OPLABEL(OP_Le), VDBE_OPLABEL(OP_Gt), VDBE_OPLABEL(OP_Ge),
+    VDBE_OPLABEL(OP_Permutation), VDBE_OPLABEL(OP_Compare),
+    VDBE_OPLABEL(OP_Jump), VDBE_OPLABEL(OP_And), VDBE_OPLABEL(OP_Or),
+    VDBE_OPLABEL(OP_Not), VDBE_OPLABEL(OP_BitNot), VDBE_OPLABEL(OP_Once),
+    VDBE_OPLABEL(OP_If), VDBE_OPLABEL(OP_IfNot), VDBE_OPLABEL(OP_IsNull),
+    VDBE_OPLABEL(OP_NotNull), VDBE_OPLABEL(OP_Column),
+    VDBE_OPLABEL(OP_Affinity), VDBE_OPLABEL(OP_MakeRecord),
+#ifndef SQLITE_OMIT_BTREECOUNT
+    VDBE_OPLABEL(OP_Count),
+#endif
+    VDBE_OPLABEL(OP_Savepoint), VDBE_OPLABEL(OP_AutoCommit),
+    VDBE_OPLABEL(OP_Transaction), VDBE_OPLABEL(OP_ReadCookie),
+    VDBE_OPLABEL(OP_SetCookie), VDBE_OPLABEL(OP_ReopenIdx),
+    VDBE_OPLABEL(OP_OpenRead), VDBE_OPLABEL(OP_OpenWrite),
+    VDBE_OPLABEL(OP_OpenAutoindex), VDBE_OPLABEL(OP_OpenEphemeral),
+    VDBE_OPLABEL(OP_SorterOpen), VDBE_OPLABEL(OP_SequenceTest),
+    VDBE_OPLABEL(OP_OpenPseudo), VDBE_OPLABEL(OP_Close),
+#ifdef SQLITE_ENABLE_COLUMN_USED_MASK
+    VDBE_OPLABEL(OP_ColumnsUsed),
+#endif
+    VDBE_OPLABEL(OP_SeekLT), VDBE_OPLABEL(OP_SeekLE), VDBE_OPLABEL(OP_SeekGE),
+    VDBE_OPLABEL(OP_SeekGT), VDBE_OPLABEL(OP_NoConflict),
+    VDBE_OPLABEL(OP_NotFound), VDBE_OPLABEL(OP_Found),
+    VDBE_OPLABEL(OP_NotExists), VDBE_OPLABEL(OP_Sequence),
+    VDBE_OPLABEL(OP_NewRowid), VDBE_OPLABEL(OP_Insert),
+    VDBE_OPLABEL(OP_InsertInt), VDBE_OPLABEL(OP_Delete),
+    VDBE_OPLABEL(OP_ResetCount), VDBE_OPLABEL(OP_SorterCompare),
+    VDBE_OPLABEL(OP_SorterData), VDBE_OPLABEL(OP_RowKey),
+    VDBE_OPLABEL(OP_RowData), VDBE_OPLABEL(OP_Rowid), VDBE_OPLABEL(OP_NullRow),
+    VDBE_OPLABEL(OP_Last), VDBE_OPLABEL(OP_SorterSort), VDBE_OPLABEL(OP_Sort),
+    VDBE_OPLABEL(OP_Rewind), VDBE_OPLABEL(OP_SorterNext),
+    VDBE_OPLABEL(OP_PrevIfOpen), VDBE_OPLABEL(OP_NextIfOpen),
+    VDBE_OPLABEL(OP_Prev), VDBE_OPLABEL(OP_Next),
+    VDBE_OPLABEL(OP_SorterInsert), VDBE_OPLABEL(OP_IdxInsert),
+    VDBE_OPLABEL(OP_IdxDelete), VDBE_OPLABEL(OP_Seek),
+    VDBE_OPLABEL(OP_IdxRowid), VDBE_OPLABEL(OP_IdxLE), VDBE_OPLABEL(OP_IdxGT),
+    VDBE_OPLABEL(OP_IdxLT), VDBE_OPLABEL(OP_IdxGE), VDBE_OPLABEL(OP_Destroy),
+    VDBE_OPLABEL(OP_Clear), VDBE_OPLABEL(OP_ResetSorter),
+    VDBE_OPLABEL(OP_CreateIndex), VDBE_OPLABEL(OP_CreateTable),
+    VDBE_OPLABEL(OP_ParseSchema),
+#if !defined(SQLITE_OMIT_ANALYZE)
+    VDBE_OPLABEL(OP_LoadAnalysis),
+#endif
+    VDBE_OPLABEL(OP_DropTable), VDBE_OPLABEL(OP_DropIndex),
+    VDBE_OPLABEL(OP_DropTrigger),
+#ifndef SQLITE_OMIT_INTEGRITY_CHECK
+    VDBE_OPLABEL(OP_IntegrityCk),
+#endif
+    VDBE_OPLABEL(OP_RowSetAdd), VDBE_OPLABEL(OP_RowSetRead),
+    VDBE_OPLABEL(OP_RowSetTest),
+#ifndef SQLITE_OMIT_TRIGGER
+    VDBE_OPLABEL(OP_Program), VDBE_OPLABEL(OP_Param),
+#endif
+#ifndef SQLITE_OMIT_FOREIGN_KEY
+    VDBE_OPLABEL(OP_FkCounter), VDBE_OPLABEL(OP_FkIfZero),
+#endif
+#ifndef SQLITE_OMIT_AUTOINCREMENT
+    VDBE_OPLABEL(OP_MemMax),
+#endif
+    VDBE_OPLABEL(OP_IfPos), VDBE_OPLABEL(OP_OffsetLimit),
+    VDBE_OPLABEL(OP_IfNotZero), VDBE_OPLABEL(OP_DecrJumpZero),
+    VDBE_OPLABEL(OP_JumpZeroIncr), VDBE_OPLABEL(OP_AggStep0),
+    VDBE_OPLABEL(OP_AggStep), VDBE_OPLABEL(OP_AggFinal),
+    VDBE_OPLABEL(OP_BatchOpen), VDBE_OPLABEL(OP_BatchConst),
+    VDBE_OPLABEL(OP_BatchLoad), VDBE_OPLABEL(OP_BatchFilter),
+    VDBE_OPLABEL(OP_BatchArith), VDBE_OPLABEL(OP_BatchAgg),
+#ifndef SQLITE_OMIT_WAL
+    VDBE_OPLABEL(OP_Checkpoint),
+#endif
+#ifndef SQLITE_OMIT_PRAGMA
+    VDBE_OPLABEL(OP_JournalMode),
+#endif
+#if !defined(SQLITE_OMIT_VACUUM) && !defined(SQLITE_OMIT_ATTACH)
+    VDBE_OPLABEL(OP_Vacuum),
+#endif
+#if !defined(SQLITE_OMIT_AUTOVACUUM)
+    VDBE_OPLABEL(OP_IncrVacuum),
+#endif
+    VDBE_OPLABEL(OP_Expire),
+#ifndef SQLITE_OMIT_SHARED_CACHE
+    VDBE_OPLABEL(OP_TableLock),
+#endif
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+    VDBE_OPLABEL(OP_VBegin), VDBE_OPLABEL(OP_VCreate),
+    VDBE_OPLABEL(OP_VDestroy), VDBE_OPLABEL(OP_VOpen),
+    VDBE_OPLABEL(OP_VFilter), VDBE_OPLABEL(OP_VColumn), VDBE_OPLABEL(OP_VNext),
+    VDBE_OPLABEL(OP_VRename), VDBE_OPLABEL(OP_VUpdate),
+#endif
+#ifndef  SQLITE_OMIT_PAGER_PRAGMAS
+    VDBE_OPLABEL(OP_Pagecount), VDBE_OPLABEL(OP_MaxPgcnt),
+#endif
+    VDBE_OPLABEL(OP_Init),
+#ifdef SQLITE_ENABLE_CURSOR_HINTS
+    VDBE_OPLABEL(OP_CursorHint),
+#endif
+  };
 #endif
   /*** INSERT STACK UNION HERE ***/
 
@@ -701,6 +871,9 @@ int sqlite3VdbeExec(
     pOrigOp = pOp;
 #endif
   
+#ifdef VDBE_COMPUTED_GOTO
+    goto *aOpLabel[pOp->opcode];
+#endif
     switch( pOp->opcode ){
 
 /*****************************************************************************
@@ -750,7 +923,7 @@ int sqlite3VdbeExec(
 ** that this Goto is the bottom of a loop and that the lines from P2 down
 ** to the current line should be indented for EXPLAIN output.
 */
-case OP_Goto: {             /* jump */
+case OP_Goto: VDBE_LABEL(OP_Goto) { /* jump */
 jump_to_p2_and_check_for_interrupt:
   pOp = &aOp[pOp->p2 - 1];
 
@@ -783,7 +956,7 @@ check_for_interrupt:
   }
 #endif
   
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode:  Gosub P1 P2 * * *
@@ -791,7 +964,7 @@ check_for_interrupt:
 ** Write the current address onto register P1
 ** and then jump to address P2.
 */
-case OP_Gosub: {            /* jump */
+case OP_Gosub: VDBE_LABEL(OP_Gosub) { /* jump */
   assert( pOp->p1>0 && pOp->p1<=(p->nMem+1 - p->nCursor) );
   pIn1 = &aMem[pOp->p1];
   assert( VdbeMemDynamic(pIn1)==0 );
@@ -804,7 +977,7 @@ case OP_Gosub: {            /* jump */
   ** the pOp pointer. */
 jump_to_p2:
   pOp = &aOp[pOp->p2 - 1];
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode:  Return P1 * * * *
@@ -812,12 +985,12 @@ jump_to_p2:
 ** Jump to the next instruction after the address in register P1.  After
 ** the jump, register P1 becomes undefined.
 */
-case OP_Return: {           /* in1 */
+case OP_Return: VDBE_LABEL(OP_Return) { /* in1 */
   pIn1 = &aMem[pOp->p1];
   assert( pIn1->flags==MEM_Int );
   pOp = &aOp[pIn1->u.i];
   pIn1->flags = MEM_Undefined;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: InitCoroutine P1 P2 P3 * *
@@ -831,7 +1004,7 @@ case OP_Return: {           /* in1 */
 **
 ** See also: EndCoroutine
 */
-case OP_InitCoroutine: {     /* jump */
+case OP_InitCoroutine: VDBE_LABEL(OP_InitCoroutine) { /* jump */
   assert( pOp->p1>0 &&  pOp->p1<=(p->nMem+1 - p->nCursor) );
   assert( pOp->p2>=0 && pOp->p2<p->nOp );
   assert( pOp->p3>=0 && pOp->p3<p->nOp );
@@ -840,7 +1013,7 @@ case OP_InitCoroutine: {     /* jump */
   pOut->u.i = pOp->p3 - 1;
   pOut->flags = MEM_Int;
   if( pOp->p2 ) goto jump_to_p2;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode:  EndCoroutine P1 * * * *
@@ -851,7 +1024,7 @@ case OP_InitCoroutine: {     /* jump */
 **
 ** See also: InitCoroutine
 */
-case OP_EndCoroutine: {           /* in1 */
+case OP_EndCoroutine: VDBE_LABEL(OP_EndCoroutine) { /* in1 */
   VdbeOp *pCaller;
   pIn1 = &aMem[pOp->p1];
   assert( pIn1->flags==MEM_Int );
@@ -861,7 +1034,7 @@ case OP_EndCoroutine: {           /* in1 */
   assert( pCaller->p2>=0 && pCaller->p2<p->nOp );
   pOp = &aOp[pCaller->p2 - 1];
   pIn1->flags = MEM_Undefined;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode:  Yield P1 P2 * * *
@@ -877,7 +1050,7 @@ case OP_EndCoroutine: {           /* in1 */
 **
 ** See also: InitCoroutine
 */
-case OP_Yield: {            /* in1, jump */
+case OP_Yield: VDBE_LABEL(OP_Yield) { /* in1, jump */
   int pcDest;
   pIn1 = &aMem[pOp->p1];
   assert( VdbeMemDynamic(pIn1)==0 );
@@ -886,7 +1059,7 @@ case OP_Yield: {            /* in1, jump */
   pIn1->u.i = (int)(pOp - aOp);
   REGISTER_TRACE(pOp->p1, pIn1);
   pOp = &aOp[pcDest];
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode:  HaltIfNull  P1 P2 P3 P4 P5
@@ -897,7 +1070,7 @@ case OP_Yield: {            /* in1, jump */
 ** value in register P3 is not NULL, then this routine is a no-op.
 ** The P5 parameter should be 1.
 */
-case OP_HaltIfNull: {      /* in3 */
+case OP_HaltIfNull: VDBE_LABEL(OP_HaltIfNull) { /* in3 */
   pIn3 = &aMem[pOp->p3];
   if( (pIn3->flags & MEM_Null)==0 ) break;
   /* Fall through into OP_Halt */
@@ -933,7 +1106,7 @@ case OP_HaltIfNull: {      /* in3 */
 ** every program.  So a jump past the last instruction of the program
 ** is the same as executing Halt.
 */
-case OP_Halt: {
+case OP_Halt: VDBE_LABEL(OP_Halt) {
   const char *zType;
   const char *zLogFmt;
   VdbeFrame *pFrame;
@@ -1005,10 +1178,10 @@ case OP_Halt: {
 **
 ** The 32-bit integer value P1 is written into register P2.
 */
-case OP_Integer: {         /* out2 */
+case OP_Integer: VDBE_LABEL(OP_Integer) { /* out2 */
   pOut = out2Prerelease(p, pOp);
   pOut->u.i = pOp->p1;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Int64 * P2 * P4 *
@@ -1017,11 +1190,11 @@ case OP_Integer: {         /* out2 */
 ** P4 is a pointer to a 64-bit integer value.
 ** Write that value into register P2.
 */
-case OP_Int64: {           /* out2 */
+case OP_Int64: VDBE_LABEL(OP_Int64) { /* out2 */
   pOut = out2Prerelease(p, pOp);
   assert( pOp->p4.pI64!=0 );
   pOut->u.i = *pOp->p4.pI64;
-  break;
+  VDBE_DISPATCH;
 }
 
 #ifndef SQLITE_OMIT_FLOATING_POINT
@@ -1031,12 +1204,12 @@ case OP_Int64: {           /* out2 */
 ** P4 is a pointer to a 64-bit floating point value.
 ** Write that value into register P2.
 */
-case OP_Real: {            /* same as TK_FLOAT, out2 */
+case OP_Real: VDBE_LABEL(OP_Real) { /* same as TK_FLOAT, out2 */
   pOut = out2Prerelease(p, pOp);
   pOut->flags = MEM_Real;
   assert( !sqlite3IsNaN(*pOp->p4.pReal) );
   pOut->u.r = *pOp->p4.pReal;
-  break;
+  VDBE_DISPATCH;
 }
 #endif
 
@@ -1048,7 +1221,7 @@ case OP_Real: {            /* same as TK_FLOAT, out2 */
 ** this transformation, the length of string P4 is computed and stored
 ** as the P1 parameter.
 */
-case OP_String8: {         /* same as TK_STRING, out2 */
+case OP_String8: VDBE_LABEL(OP_String8) { /* same as TK_STRING, out2 */
   assert( pOp->p4.z!=0 );
   pOut = out2Prerelease(p, pOp);
   pOp->opcode = OP_String;
@@ -1090,7 +1263,7 @@ case OP_String8: {         /* same as TK_STRING, out2 */
 ** the same sequence of bytes, it is merely interpreted as a BLOB instead
 ** of a string, as if it had been CAST.
 */
-case OP_String: {          /* out2 */
+case OP_String: VDBE_LABEL(OP_String) { /* out2 */
   assert( pOp->p4.z!=0 );
   pOut = out2Prerelease(p, pOp);
   pOut->flags = MEM_Str|MEM_Static|MEM_Term;
@@ -1107,7 +1280,7 @@ case OP_String: {          /* out2 */
     if( pIn3->u.i ) pOut->flags = MEM_Blob|MEM_Static|MEM_Term;
   }
 #endif
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Null P1 P2 P3 * *
@@ -1122,7 +1295,7 @@ case OP_String: {          /* out2 */
 ** NULL values will not compare equal even if SQLITE_NULLEQ is set on
 ** OP_Ne or OP_Eq.
 */
-case OP_Null: {           /* out2 */
+case OP_Null: VDBE_LABEL(OP_Null) { /* out2 */
   int cnt;
   u16 nullFlag;
   pOut = out2Prerelease(p, pOp);
@@ -1136,7 +1309,7 @@ case OP_Null: {           /* out2 */
     pOut->flags = nullFlag;
     cnt--;
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: SoftNull P1 * * * *
@@ -1147,11 +1320,11 @@ case OP_Null: {           /* out2 */
 ** the register, so that if the value was a string or blob that was
 ** previously copied using OP_SCopy, the copies will continue to be valid.
 */
-case OP_SoftNull: {
+case OP_SoftNull: VDBE_LABEL(OP_SoftNull) {
   assert( pOp->p1>0 && pOp->p1<=(p->nMem+1 - p->nCursor) );
   pOut = &aMem[pOp->p1];
   pOut->flags = (pOut->flags|MEM_Null)&~MEM_Undefined;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Blob P1 P2 * P4 *
@@ -1160,13 +1333,13 @@ case OP_SoftNull: {
 ** P4 points to a blob of data P1 bytes long.  Store this
 ** blob in register P2.
 */
-case OP_Blob: {                /* out2 */
+case OP_Blob: VDBE_LABEL(OP_Blob) { /* out2 */
   assert( pOp->p1 <= SQLITE_MAX_LENGTH );
   pOut = out2Prerelease(p, pOp);
   sqlite3VdbeMemSetStr(pOut, pOp->p4.z, pOp->p1, 0, 0);
   pOut->enc = encoding;
   UPDATE_MAX_BLOBSIZE(pOut);
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Variable P1 P2 * P4 *
@@ -1177,7 +1350,7 @@ case OP_Blob: {                /* out2 */
 ** If the parameter is named, then its name appears in P4.
 ** The P4 value is used by sqlite3_bind_parameter_name().
 */
-case OP_Variable: {            /* out2 */
+case OP_Variable: VDBE_LABEL(OP_Variable) { /* out2 */
   Mem *pVar;       /* Value being transferred */
 
   assert( pOp->p1>0 && pOp->p1<=p->nVar );
@@ -1189,7 +1362,7 @@ case OP_Variable: {            /* out2 */
   pOut = out2Prerelease(p, pOp);
   sqlite3VdbeMemShallowCopy(pOut, pVar, MEM_Static);
   UPDATE_MAX_BLOBSIZE(pOut);
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Move P1 P2 P3 * *
@@ -1201,7 +1374,7 @@ case OP_Variable: {            /* out2 */
 ** P1..P1+P3-1 and P2..P2+P3-1 to overlap.  It is an error
 ** for P3 to be less than 1.
 */
-case OP_Move: {
+case OP_Move: VDBE_LABEL(OP_Move) {
   int n;           /* Number of registers left to copy */
   int p1;          /* Register to copy from */
   int p2;          /* Register to copy to */
@@ -1230,7 +1403,7 @@ case OP_Move: {
     pIn1++;
     pOut++;
   }while( --n );
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Copy P1 P2 P3 * *
@@ -1241,7 +1414,7 @@ case OP_Move: {
 ** This instruction makes a deep copy of the value.  A duplicate
 ** is made of any string or blob constant.  See also OP_SCopy.
 */
-case OP_Copy: {
+case OP_Copy: VDBE_LABEL(OP_Copy) {
   int n;
 
   n = pOp->p3;
@@ -1259,7 +1432,7 @@ case OP_Copy: {
     pOut++;
     pIn1++;
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: SCopy P1 P2 * * *
@@ -1275,7 +1448,7 @@ case OP_Copy: {
 ** during the lifetime of the copy.  Use OP_Copy to make a complete
 ** copy.
 */
-case OP_SCopy: {            /* out2 */
+case OP_SCopy: VDBE_LABEL(OP_SCopy) { /* out2 */
   pIn1 = &aMem[pOp->p1];
   pOut = &aMem[pOp->p2];
   assert( pOut!=pIn1 );
@@ -1283,7 +1456,7 @@ case OP_SCopy: {            /* out2 */
 #ifdef SQLITE_DEBUG
   if( pOut->pScopyFrom==0 ) pOut->pScopyFrom = pIn1;
 #endif
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: IntCopy P1 P2 * * *
@@ -1294,12 +1467,12 @@ case OP_SCopy: {            /* out2 */
 ** This is an optimized version of SCopy that works only for integer
 ** values.
 */
-case OP_IntCopy: {            /* out2 */
+case OP_IntCopy: VDBE_LABEL(OP_IntCopy) { /* out2 */
   pIn1 = &aMem[pOp->p1];
   assert( (pIn1->flags & MEM_Int)!=0 );
   pOut = &aMem[pOp->p2];
   sqlite3VdbeMemSetInt64(pOut, pIn1->u.i);
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: ResultRow P1 P2 * * *
@@ -1311,7 +1484,7 @@ case OP_IntCopy: {            /* out2 */
 ** structure to provide access to the r(P1)..r(P1+P2-1) values as
 ** the result row.
 */
-case OP_ResultRow: {
+case OP_ResultRow: VDBE_LABEL(OP_ResultRow) {
   Mem *pMem;
   int i;
   assert( p->nResColumn==pOp->p2 );
@@ -1396,7 +1569,7 @@ case OP_ResultRow: {
 ** if P3 is the same register as P2, the implementation is able
 ** to avoid a memcpy().
 */
-case OP_Concat: {           /* same as TK_CONCAT, in1, in2, out3 */
+case OP_Concat: VDBE_LABEL(OP_Concat) { /* same as TK_CONCAT, in1, in2, out3 */
   i64 nByte;
 
   pIn1 = &aMem[pOp->p1];
@@ -1428,7 +1601,7 @@ case OP_Concat: {           /* same as TK_CONCAT, in1, in2, out3 */
   pOut->n = (int)nByte;
   pOut->enc = encoding;
   UPDATE_MAX_BLOBSIZE(pOut);
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Add P1 P2 P3 * *
@@ -1469,11 +1642,11 @@ case OP_Concat: {           /* same as TK_CONCAT, in1, in2, out3 */
 ** If the value in register P1 is zero the result is NULL.
 ** If either operand is NULL, the result is NULL.
 */
-case OP_Add:                   /* same as TK_PLUS, in1, in2, out3 */
-case OP_Subtract:              /* same as TK_MINUS, in1, in2, out3 */
-case OP_Multiply:              /* same as TK_STAR, in1, in2, out3 */
-case OP_Divide:                /* same as TK_SLASH, in1, in2, out3 */
-case OP_Remainder: {           /* same as TK_REM, in1, in2, out3 */
+case OP_Add: VDBE_LABEL(OP_Add) /* same as TK_PLUS, in1, in2, out3 */
+case OP_Subtract: VDBE_LABEL(OP_Subtract) /* same as TK_MINUS, in1, in2, out3 */
+case OP_Multiply: VDBE_LABEL(OP_Multiply) /* same as TK_STAR, in1, in2, out3 */
+case OP_Divide: VDBE_LABEL(OP_Divide) /* same as TK_SLASH, in1, in2, out3 */
+case OP_Remainder: VDBE_LABEL(OP_Remainder) { /* same as TK_REM, in1, in2, out3 */
   char bIntint;   /* Started out as two integer operands */
   u16 flags;      /* Combined MEM_* flags from both inputs */
   u16 type1;      /* Numeric type of left operand */
@@ -1551,11 +1724,11 @@ fp_math:
     }
 #endif
   }
-  break;
+  VDBE_DISPATCH;
 
 arithmetic_result_is_null:
   sqlite3VdbeMemSetNull(pOut);
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: CollSeq P1 * * P4
@@ -1573,12 +1746,12 @@ arithmetic_result_is_null:
 ** to retrieve the collation sequence set by this opcode is not available
 ** publicly.  Only built-in functions have access to this feature.
 */
-case OP_CollSeq: {
+case OP_CollSeq: VDBE_LABEL(OP_CollSeq) {
   assert( pOp->p4type==P4_COLLSEQ );
   if( pOp->p1 ){
     sqlite3VdbeMemSetInt64(&aMem[pOp->p1], 0);
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Function0 P1 P2 P3 P4 P5
@@ -1622,7 +1795,7 @@ case OP_CollSeq: {
 **
 ** See also: Function0, AggStep, AggFinal
 */
-case OP_Function0: {
+case OP_Function0: VDBE_LABEL(OP_Function0) {
   int n;
   sqlite3_context *pCtx;
 
@@ -1643,7 +1816,7 @@ case OP_Function0: {
   pOp->opcode = OP_Function;
   /* Fall through into OP_Function */
 }
-case OP_Function: {
+case OP_Function: VDBE_LABEL(OP_Function) {
   int i;
   sqlite3_context *pCtx;
 
@@ -1691,7 +1864,7 @@ case OP_Function: {
 
   REGISTER_TRACE(pOp->p3, pCtx->pOut);
   UPDATE_MAX_BLOBSIZE(pCtx->pOut);
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: BitAnd P1 P2 P3 * *
@@ -1724,10 +1897,10 @@ case OP_Function: {
 ** Store the result in register P3.
 ** If either input is NULL, the result is NULL.
 */
-case OP_BitAnd:                 /* same as TK_BITAND, in1, in2, out3 */
-case OP_BitOr:                  /* same as TK_BITOR, in1, in2, out3 */
-case OP_ShiftLeft:              /* same as TK_LSHIFT, in1, in2, out3 */
-case OP_ShiftRight: {           /* same as TK_RSHIFT, in1, in2, out3 */
+case OP_BitAnd: VDBE_LABEL(OP_BitAnd) /* same as TK_BITAND, in1, in2, out3 */
+case OP_BitOr: VDBE_LABEL(OP_BitOr) /* same as TK_BITOR, in1, in2, out3 */
+case OP_ShiftLeft: VDBE_LABEL(OP_ShiftLeft) /* same as TK_LSHIFT, in1, in2, out3 */
+case OP_ShiftRight: VDBE_LABEL(OP_ShiftRight) { /* same as TK_RSHIFT, in1, in2, out3 */
   i64 iA;
   u64 uA;
   i64 iB;
@@ -1773,7 +1946,7 @@ case OP_ShiftRight: {           /* same as TK_RSHIFT, in1, in2, out3 */
   }
   pOut->u.i = iA;
   MemSetTypeFlag(pOut, MEM_Int);
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: AddImm  P1 P2 * * *
@@ -1784,12 +1957,12 @@ case OP_ShiftRight: {           /* same as TK_RSHIFT, in1, in2, out3 */
 **
 ** To force any register to be an integer, just add 0.
 */
-case OP_AddImm: {            /* in1 */
+case OP_AddImm: VDBE_LABEL(OP_AddImm) { /* in1 */
   pIn1 = &aMem[pOp->p1];
   memAboutToChange(p, pIn1);
   sqlite3VdbeMemIntegerify(pIn1);
   pIn1->u.i += pOp->p2;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: MustBeInt P1 P2 * * *
@@ -1799,7 +1972,7 @@ case OP_AddImm: {            /* in1 */
 ** without data loss, then jump immediately to P2, or if P2==0
 ** raise an SQLITE_MISMATCH exception.
 */
-case OP_MustBeInt: {            /* jump, in1 */
+case OP_MustBeInt: VDBE_LABEL(OP_MustBeInt) { /* jump, in1 */
   pIn1 = &aMem[pOp->p1];
   if( (pIn1->flags & MEM_Int)==0 ){
     applyAffinity(pIn1, SQLITE_AFF_NUMERIC, encoding);
@@ -1814,7 +1987,7 @@ case OP_MustBeInt: {            /* jump, in1 */
     }
   }
   MemSetTypeFlag(pIn1, MEM_Int);
-  break;
+  VDBE_DISPATCH;
 }
 
 #ifndef SQLITE_OMIT_FLOATING_POINT
@@ -1827,12 +2000,12 @@ case OP_MustBeInt: {            /* jump, in1 */
 ** integers, for space efficiency, but after extraction we want them
 ** to have only a real value.
 */
-case OP_RealAffinity: {                  /* in1 */
+case OP_RealAffinity: VDBE_LABEL(OP_RealAffinity) { /* in1 */
   pIn1 = &aMem[pOp->p1];
   if( pIn1->flags & MEM_Int ){
     sqlite3VdbeMemRealify(pIn1);
   }
-  break;
+  VDBE_DISPATCH;
 }
 #endif
 
@@ -1852,7 +2025,7 @@ case OP_RealAffinity: {                  /* in1 */
 **
 ** A NULL value is not changed by this routine.  It remains NULL.
 */
-case OP_Cast: {                  /* in1 */
+case OP_Cast: VDBE_LABEL(OP_Cast) { /* in1 */
   assert( pOp->p2>=SQLITE_AFF_BLOB && pOp->p2<=SQLITE_AFF_REAL );
   testcase( pOp->p2==SQLITE_AFF_TEXT );
   testcase( pOp->p2==SQLITE_AFF_BLOB );
@@ -1865,7 +2038,7 @@ case OP_Cast: {                  /* in1 */
   sqlite3VdbeMemCast(pIn1, pOp->p2, encoding);
   UPDATE_MAX_BLOBSIZE(pIn1);
   if( rc ) goto abort_due_to_error;
-  break;
+  VDBE_DISPATCH;
 }
 #endif /* SQLITE_OMIT_CAST */
 
@@ -1951,12 +2124,12 @@ case OP_Cast: {                  /* in1 */
 ** the content of register P3 is greater than or equal to the content of
 ** register P1.  See the Lt opcode for additional information.
 */
-case OP_Eq:               /* same as TK_EQ, jump, in1, in3 */
-case OP_Ne:               /* same as TK_NE, jump, in1, in3 */
-case OP_Lt:               /* same as TK_LT, jump, in1, in3 */
-case OP_Le:               /* same as TK_LE, jump, in1, in3 */
-case OP_Gt:               /* same as TK_GT, jump, in1, in3 */
-case OP_Ge: {             /* same as TK_GE, jump, in1, in3 */
+case OP_Eq: VDBE_LABEL(OP_Eq) /* same as TK_EQ, jump, in1, in3 */
+case OP_Ne: VDBE_LABEL(OP_Ne) /* same as TK_NE, jump, in1, in3 */
+case OP_Lt: VDBE_LABEL(OP_Lt) /* same as TK_LT, jump, in1, in3 */
+case OP_Le: VDBE_LABEL(OP_Le) /* same as TK_LE, jump, in1, in3 */
+case OP_Gt: VDBE_LABEL(OP_Gt) /* same as TK_GT, jump, in1, in3 */
+case OP_Ge: VDBE_LABEL(OP_Ge) { /* same as TK_GE, jump, in1, in3 */
   int res;            /* Result of the comparison of pIn1 against pIn3 */
   char affinity;      /* Affinity to use for comparison */
   u16 flags1;         /* Copy of initial value of pIn1->flags */
@@ -2066,7 +2239,7 @@ case OP_Ge: {             /* same as TK_GE, jump, in1, in3 */
       goto jump_to_p2;
     }
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Permutation * * * P4 *
@@ -2081,11 +2254,11 @@ case OP_Ge: {             /* same as TK_GE, jump, in1, in3 */
 ** The first integer in the P4 integer array is the length of the array
 ** and does not become part of the permutation.
 */
-case OP_Permutation: {
+case OP_Permutation: VDBE_LABEL(OP_Permutation) {
   assert( pOp->p4type==P4_INTARRAY );
   assert( pOp->p4.ai );
   aPermute = pOp->p4.ai + 1;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Compare P1 P2 P3 P4 P5
@@ -2108,7 +2281,7 @@ case OP_Permutation: {
 ** NULLs are less than numbers, numbers are less than strings,
 ** and strings are less than blobs.
 */
-case OP_Compare: {
+case OP_Compare: VDBE_LABEL(OP_Compare) {
   int n;
   int i;
   int p1;
@@ -2152,7 +2325,7 @@ case OP_Compare: {
     }
   }
   aPermute = 0;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Jump P1 P2 P3 * *
@@ -2161,7 +2334,7 @@ case OP_Compare: {
 ** in the most recent OP_Compare instruction the P1 vector was less than
 ** equal to, or greater than the P2 vector, respectively.
 */
-case OP_Jump: {             /* jump */
+case OP_Jump: VDBE_LABEL(OP_Jump) { /* jump */
   if( iCompare<0 ){
     VdbeBranchTaken(0,3); pOp = &aOp[pOp->p1 - 1];
   }else if( iCompare==0 ){
@@ -2169,7 +2342,7 @@ case OP_Jump: {             /* jump */
   }else{
     VdbeBranchTaken(2,3); pOp = &aOp[pOp->p3 - 1];
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: And P1 P2 P3 * *
@@ -2192,8 +2365,8 @@ case OP_Jump: {             /* jump */
 ** even if the other input is NULL.  A NULL and false or two NULLs
 ** give a NULL output.
 */
-case OP_And:              /* same as TK_AND, in1, in2, out3 */
-case OP_Or: {             /* same as TK_OR, in1, in2, out3 */
+case OP_And: VDBE_LABEL(OP_And) /* same as TK_AND, in1, in2, out3 */
+case OP_Or: VDBE_LABEL(OP_Or) { /* same as TK_OR, in1, in2, out3 */
   int v1;    /* Left operand:  0==FALSE, 1==TRUE, 2==UNKNOWN or NULL */
   int v2;    /* Right operand: 0==FALSE, 1==TRUE, 2==UNKNOWN or NULL */
 
@@ -2223,7 +2396,7 @@ case OP_Or: {             /* same as TK_OR, in1, in2, out3 */
     pOut->u.i = v1;
     MemSetTypeFlag(pOut, MEM_Int);
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Not P1 P2 * * *
@@ -2233,7 +2406,7 @@ case OP_Or: {             /* same as TK_OR, in1, in2, out3 */
 ** boolean complement in register P2.  If the value in register P1 is 
 ** NULL, then a NULL is stored in P2.
 */
-case OP_Not: {                /* same as TK_NOT, in1, out2 */
+case OP_Not: VDBE_LABEL(OP_Not) { /* same as TK_NOT, in1, out2 */
   pIn1 = &aMem[pOp->p1];
   pOut = &aMem[pOp->p2];
   sqlite3VdbeMemSetNull(pOut);
@@ -2241,7 +2414,7 @@ case OP_Not: {                /* same as TK_NOT, in1, out2 */
     pOut->flags = MEM_Int;
     pOut->u.i = !sqlite3VdbeIntValue(pIn1);
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: BitNot P1 P2 * * *
@@ -2251,7 +2424,7 @@ case OP_Not: {                /* same as TK_NOT, in1, out2 */
 ** ones-complement of the P1 value into register P2.  If P1 holds
 ** a NULL then store a NULL in P2.
 */
-case OP_BitNot: {             /* same as TK_BITNOT, in1, out2 */
+case OP_BitNot: VDBE_LABEL(OP_BitNot) { /* same as TK_BITNOT, in1, out2 */
   pIn1 = &aMem[pOp->p1];
   pOut = &aMem[pOp->p2];
   sqlite3VdbeMemSetNull(pOut);
@@ -2259,7 +2432,7 @@ case OP_BitNot: {             /* same as TK_BITNOT, in1, out2 */
     pOut->flags = MEM_Int;
     pOut->u.i = ~sqlite3VdbeIntValue(pIn1);
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Once P1 P2 * * *
@@ -2273,7 +2446,7 @@ case OP_BitNot: {             /* same as TK_BITNOT, in1, out2 */
 ** All "once" flags are initially cleared whenever a prepared statement
 ** first begins to run.
 */
-case OP_Once: {             /* jump */
+case OP_Once: VDBE_LABEL(OP_Once) { /* jump */
   assert( pOp->p1<p->nOnceFlag );
   VdbeBranchTaken(p->aOnceFlag[pOp->p1]!=0, 2);
   if( p->aOnceFlag[pOp->p1] ){
@@ -2281,7 +2454,7 @@ case OP_Once: {             /* jump */
   }else{
     p->aOnceFlag[pOp->p1] = 1;
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: If P1 P2 P3 * *
@@ -2296,8 +2469,8 @@ case OP_Once: {             /* jump */
 ** is considered false if it has a numeric value of zero.  If the value
 ** in P1 is NULL then take the jump if and only if P3 is non-zero.
 */
-case OP_If:                 /* jump, in1 */
-case OP_IfNot: {            /* jump, in1 */
+case OP_If: VDBE_LABEL(OP_If) /* jump, in1 */
+case OP_IfNot: VDBE_LABEL(OP_IfNot) { /* jump, in1 */
   int c;
   pIn1 = &aMem[pOp->p1];
   if( pIn1->flags & MEM_Null ){
@@ -2314,7 +2487,7 @@ case OP_IfNot: {            /* jump, in1 */
   if( c ){
     goto jump_to_p2;
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: IsNull P1 P2 * * *
@@ -2322,13 +2495,13 @@ case OP_IfNot: {            /* jump, in1 */
 **
 ** Jump to P2 if the value in register P1 is NULL.
 */
-case OP_IsNull: {            /* same as TK_ISNULL, jump, in1 */
+case OP_IsNull: VDBE_LABEL(OP_IsNull) { /* same as TK_ISNULL, jump, in1 */
   pIn1 = &aMem[pOp->p1];
   VdbeBranchTaken( (pIn1->flags & MEM_Null)!=0, 2);
   if( (pIn1->flags & MEM_Null)!=0 ){
     goto jump_to_p2;
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: NotNull P1 P2 * * *
@@ -2336,13 +2509,13 @@ case OP_IsNull: {            /* same as TK_ISNULL, jump, in1 */
 **
 ** Jump to P2 if the value in register P1 is not NULL.  
 */
-case OP_NotNull: {            /* same as TK_NOTNULL, jump, in1 */
+case OP_NotNull: VDBE_LABEL(OP_NotNull) { /* same as TK_NOTNULL, jump, in1 */
   pIn1 = &aMem[pOp->p1];
   VdbeBranchTaken( (pIn1->flags & MEM_Null)==0, 2);
   if( (pIn1->flags & MEM_Null)==0 ){
     goto jump_to_p2;
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Column P1 P2 P3 P4 P5
@@ -2370,7 +2543,7 @@ case OP_NotNull: {            /* same as TK_NOTNULL, jump, in1 */
 ** or typeof() function, respectively.  The loading of large blobs can be
 ** skipped for length() and all content loading can be skipped for typeof().
 */
-case OP_Column: {
+case OP_Column: VDBE_LABEL(OP_Column) {
   i64 payloadSize64; /* Number of bytes in the record */
   int p2;            /* column number to retrieve */
   VdbeCursor *pC;    /* The VDBE cursor */
@@ -2619,7 +2792,7 @@ case OP_Column: {
 op_column_out:
   UPDATE_MAX_BLOBSIZE(pDest);
   REGISTER_TRACE(pOp->p3, pDest);
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Affinity P1 P2 * P4 *
@@ -2631,7 +2804,7 @@ op_column_out:
 ** string indicates the column affinity that should be used for the nth
 ** memory cell in the range.
 */
-case OP_Affinity: {
+case OP_Affinity: VDBE_LABEL(OP_Affinity) {
   const char *zAffinity;   /* The affinity to be applied */
   char cAff;               /* A single character of affinity */
 
@@ -2645,7 +2818,7 @@ case OP_Affinity: {
     applyAffinity(pIn1, cAff, encoding);
     pIn1++;
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: MakeRecord P1 P2 P3 P4 *
@@ -2664,7 +2837,7 @@ case OP_Affinity: {
 **
 ** If P4 is NULL then all index fields have the affinity BLOB.
 */
-case OP_MakeRecord: {
+case OP_MakeRecord: VDBE_LABEL(OP_MakeRecord) {
   u8 *zNewRecord;        /* A buffer to hold the data for the new record */
   Mem *pRec;             /* The new record */
   u64 nData;             /* Number of bytes of data space */
@@ -2802,7 +2975,7 @@ case OP_MakeRecord: {
   pOut->enc = SQLITE_UTF8;  /* In case the blob is ever converted to text */
   REGISTER_TRACE(pOp->p3, pOut);
   UPDATE_MAX_BLOBSIZE(pOut);
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Count P1 P2 * * *
@@ -2812,7 +2985,7 @@ case OP_MakeRecord: {
 ** opened by cursor P1 in register P2
 */
 #ifndef SQLITE_OMIT_BTREECOUNT
-case OP_Count: {         /* out2 */
+case OP_Count: VDBE_LABEL(OP_Count) { /* out2 */
   i64 nEntry;
   BtCursor *pCrsr;
 
@@ -2824,7 +2997,7 @@ case OP_Count: {         /* out2 */
   if( rc ) goto abort_due_to_error;
   pOut = out2Prerelease(p, pOp);
   pOut->u.i = nEntry;
-  break;
+  VDBE_DISPATCH;
 }
 #endif
 
@@ -2834,7 +3007,7 @@ case OP_Count: {         /* out2 */
 ** on the value of P1. To open a new savepoint, P1==0. To release (commit) an
 ** existing savepoint, P1==1, or to rollback an existing savepoint P1==2.
 */
-case OP_Savepoint: {
+case OP_Savepoint: VDBE_LABEL(OP_Savepoint) {
   int p1;                         /* Value of P1 operand */
   char *zName;                    /* Name of savepoint */
   int nName;
@@ -3001,7 +3174,7 @@ case OP_Savepoint: {
   }
   if( rc ) goto abort_due_to_error;
 
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: AutoCommit P1 P2 * * *
@@ -3013,7 +3186,7 @@ case OP_Savepoint: {
 **
 ** This instruction causes the VM to halt.
 */
-case OP_AutoCommit: {
+case OP_AutoCommit: VDBE_LABEL(OP_AutoCommit) {
   int desiredAutoCommit;
   int iRollback;
 
@@ -3065,7 +3238,7 @@ case OP_AutoCommit: {
     rc = SQLITE_ERROR;
     goto abort_due_to_error;
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Transaction P1 P2 P3 P4 P5
@@ -3102,7 +3275,7 @@ case OP_AutoCommit: {
 ** halts.  The sqlite3_step() wrapper function might then reprepare the
 ** statement and rerun it from the beginning.
 */
-case OP_Transaction: {
+case OP_Transaction: VDBE_LABEL(OP_Transaction) {
   Btree *pBt;
   int iMeta;
   int iGen;
@@ -3187,7 +3360,7 @@ case OP_Transaction: {
     rc = SQLITE_SCHEMA;
   }
   if( rc ) goto abort_due_to_error;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: ReadCookie P1 P2 P3 * *
@@ -3202,7 +3375,7 @@ case OP_Transaction: {
 ** must be started or there must be an open cursor) before
 ** executing this instruction.
 */
-case OP_ReadCookie: {               /* out2 */
+case OP_ReadCookie: VDBE_LABEL(OP_ReadCookie) { /* out2 */
   int iMeta;
   int iDb;
   int iCookie;
@@ -3218,7 +3391,7 @@ case OP_ReadCookie: {               /* out2 */
   sqlite3BtreeGetMeta(db->aDb[iDb].pBt, iCookie, (u32 *)&iMeta);
   pOut = out2Prerelease(p, pOp);
   pOut->u.i = iMeta;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: SetCookie P1 P2 P3 * *
@@ -3231,7 +3404,7 @@ case OP_ReadCookie: {               /* out2 */
 **
 ** A transaction must be started before executing this opcode.
 */
-case OP_SetCookie: {
+case OP_SetCookie: VDBE_LABEL(OP_SetCookie) {
   Db *pDb;
   assert( pOp->p2<SQLITE_N_BTREE_META );
   assert( pOp->p1>=0 && pOp->p1<db->nDb );
@@ -3257,7 +3430,7 @@ case OP_SetCookie: {
     p->expired = 0;
   }
   if( rc ) goto abort_due_to_error;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: OpenRead P1 P2 P3 P4 P5
@@ -3325,7 +3498,7 @@ case OP_SetCookie: {
 **
 ** See also OpenRead.
 */
-case OP_ReopenIdx: {
+case OP_ReopenIdx: VDBE_LABEL(OP_ReopenIdx) {
   int nField;
   KeyInfo *pKeyInfo;
   int p2;
@@ -3344,8 +3517,8 @@ case OP_ReopenIdx: {
   }
   /* If the cursor is not currently open or is open on a different
   ** index, then fall through into OP_OpenRead to force a reopen */
-case OP_OpenRead:
-case OP_OpenWrite:
+case OP_OpenRead: VDBE_LABEL(OP_OpenRead)
+case OP_OpenWrite: VDBE_LABEL(OP_OpenWrite)
 
   assert( pOp->opcode==OP_OpenWrite || pOp->p5==0 || pOp->p5==OPFLAG_SEEKEQ );
   assert( p->bIsReader );
@@ -3427,7 +3600,7 @@ open_cursor_set_hints:
   sqlite3BtreeCursorHintFlags(pCur->uc.pCursor,
                                (pOp->p5 & (OPFLAG_BULKCSR|OPFLAG_SEEKEQ)));
   if( rc ) goto abort_due_to_error;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: OpenEphemeral P1 P2 * P4 P5
@@ -3456,8 +3629,8 @@ open_cursor_set_hints:
 ** by this opcode will be used for automatically created transient
 ** indices in joins.
 */
-case OP_OpenAutoindex: 
-case OP_OpenEphemeral: {
+case OP_OpenAutoindex: VDBE_LABEL(OP_OpenAutoindex) 
+case OP_OpenEphemeral: VDBE_LABEL(OP_OpenEphemeral) {
   VdbeCursor *pCx;
   KeyInfo *pKeyInfo;
 
@@ -3505,7 +3678,7 @@ case OP_OpenEphemeral: {
   }
   if( rc ) goto abort_due_to_error;
   pCx->isOrdered = (pOp->p5!=BTREE_UNORDERED);
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: SorterOpen P1 P2 P3 P4 *
@@ -3518,7 +3691,7 @@ case OP_OpenEphemeral: {
 ** assume that a stable sort considering the first P3 fields of each
 ** key is sufficient to produce the required results.
 */
-case OP_SorterOpen: {
+case OP_SorterOpen: VDBE_LABEL(OP_SorterOpen) {
   VdbeCursor *pCx;
 
   assert( pOp->p1>=0 );
@@ -3530,7 +3703,7 @@ case OP_SorterOpen: {
   assert( pCx->pKeyInfo->enc==ENC(db) );
   rc = sqlite3VdbeSorterInit(db, pOp->p3, pCx);
   if( rc ) goto abort_due_to_error;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: SequenceTest P1 P2 * * *
@@ -3540,7 +3713,7 @@ case OP_SorterOpen: {
 ** to P2. Regardless of whether or not the jump is taken, increment the
 ** the sequence value.
 */
-case OP_SequenceTest: {
+case OP_SequenceTest: VDBE_LABEL(OP_SequenceTest) {
   VdbeCursor *pC;
   assert( pOp->p1>=0 && pOp->p1<p->nCursor );
   pC = p->apCsr[pOp->p1];
@@ -3548,7 +3721,7 @@ case OP_SequenceTest: {
   if( (pC->seqCount++)==0 ){
     goto jump_to_p2;
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: OpenPseudo P1 P2 P3 * *
@@ -3567,7 +3740,7 @@ case OP_SequenceTest: {
 ** P3 is the number of fields in the records that will be stored by
 ** the pseudo-table.
 */
-case OP_OpenPseudo: {
+case OP_OpenPseudo: VDBE_LABEL(OP_OpenPseudo) {
   VdbeCursor *pCx;
 
   assert( pOp->p1>=0 );
@@ -3578,7 +3751,7 @@ case OP_OpenPseudo: {
   pCx->uc.pseudoTableReg = pOp->p2;
   pCx->isTable = 1;
   assert( pOp->p5==0 );
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Close P1 * * * *
@@ -3586,11 +3759,11 @@ case OP_OpenPseudo: {
 ** Close a cursor previously opened as P1.  If P1 is not
 ** currently open, this instruction is a no-op.
 */
-case OP_Close: {
+case OP_Close: VDBE_LABEL(OP_Close) {
   assert( pOp->p1>=0 && pOp->p1<p->nCursor );
   sqlite3VdbeFreeCursor(p, p->apCsr[pOp->p1]);
   p->apCsr[pOp->p1] = 0;
-  break;
+  VDBE_DISPATCH;
 }
 
 #ifdef SQLITE_ENABLE_COLUMN_USED_MASK
@@ -3604,12 +3777,12 @@ case OP_Close: {
 ** by the cursor.  The high-order bit is set if any column after
 ** the 64th is used.
 */
-case OP_ColumnsUsed: {
+case OP_ColumnsUsed: VDBE_LABEL(OP_ColumnsUsed) {
   VdbeCursor *pC;
   pC = p->apCsr[pOp->p1];
   assert( pC->eCurType==CURTYPE_BTREE );
   pC->maskUsed = *(u64*)pOp->p4.pI64;
-  break;
+  VDBE_DISPATCH;
 }
 #endif
 
@@ -3699,10 +3872,10 @@ case OP_ColumnsUsed: {
 **
 ** See also: Found, NotFound, SeekGt, SeekGe, SeekLt
 */
-case OP_SeekLT:         /* jump, in3 */
-case OP_SeekLE:         /* jump, in3 */
-case OP_SeekGE:         /* jump, in3 */
-case OP_SeekGT: {       /* jump, in3 */
+case OP_SeekLT: VDBE_LABEL(OP_SeekLT) /* jump, in3 */
+case OP_SeekLE: VDBE_LABEL(OP_SeekLE) /* jump, in3 */
+case OP_SeekGE: VDBE_LABEL(OP_SeekGE) /* jump, in3 */
+case OP_SeekGT: VDBE_LABEL(OP_SeekGT) { /* jump, in3 */
   int res;           /* Comparison result */
   int oc;            /* Opcode */
   VdbeCursor *pC;    /* The cursor to seek */
@@ -3863,7 +4036,7 @@ seek_not_found:
     assert( pOp[1].opcode==OP_IdxLT || pOp[1].opcode==OP_IdxGT );
     pOp++; /* Skip the OP_IdxLt or OP_IdxGT that follows */
   }
-  break;
+  VDBE_DISPATCH;
 }
   
 
@@ -3926,9 +4099,9 @@ seek_not_found:
 **
 ** See also: NotFound, Found, NotExists
 */
-case OP_NoConflict:     /* jump, in3 */
-case OP_NotFound:       /* jump, in3 */
-case OP_Found: {        /* jump, in3 */
+case OP_NoConflict: VDBE_LABEL(OP_NoConflict) /* jump, in3 */
+case OP_NotFound: VDBE_LABEL(OP_NotFound) /* jump, in3 */
+case OP_Found: VDBE_LABEL(OP_Found) { /* jump, in3 */
   int alreadyExists;
   int takeJump;
   int ii;
@@ -4006,7 +4179,7 @@ case OP_Found: {        /* jump, in3 */
     VdbeBranchTaken(takeJump||alreadyExists==0,2);
     if( takeJump || !alreadyExists ) goto jump_to_p2;
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: NotExists P1 P2 P3 * *
@@ -4028,7 +4201,7 @@ case OP_Found: {        /* jump, in3 */
 **
 ** See also: Found, NotFound, NoConflict
 */
-case OP_NotExists: {        /* jump, in3 */
+case OP_NotExists: VDBE_LABEL(OP_NotExists) { /* jump, in3 */
   VdbeCursor *pC;
   BtCursor *pCrsr;
   int res;
@@ -4065,7 +4238,7 @@ case OP_NotExists: {        /* jump, in3 */
     }
   }
   if( rc ) goto abort_due_to_error;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Sequence P1 P2 * * *
@@ -4076,13 +4249,13 @@ case OP_NotExists: {        /* jump, in3 */
 ** The sequence number on the cursor is incremented after this
 ** instruction.  
 */
-case OP_Sequence: {           /* out2 */
+case OP_Sequence: VDBE_LABEL(OP_Sequence) { /* out2 */
   assert( pOp->p1>=0 && pOp->p1<p->nCursor );
   assert( p->apCsr[pOp->p1]!=0 );
   assert( p->apCsr[pOp->p1]->eCurType!=CURTYPE_VTAB );
   pOut = out2Prerelease(p, pOp);
   pOut->u.i = p->apCsr[pOp->p1]->seqCount++;
-  break;
+  VDBE_DISPATCH;
 }
 
 
@@ -4101,7 +4274,7 @@ case OP_Sequence: {           /* out2 */
 ** generated record number. This P3 mechanism is used to help implement the
 ** AUTOINCREMENT feature.
 */
-case OP_NewRowid: {           /* out2 */
+case OP_NewRowid: VDBE_LABEL(OP_NewRowid) { /* out2 */
   i64 v;                 /* The new rowid */
   VdbeCursor *pC;        /* Cursor of table to get the new rowid */
   int res;               /* Result of an sqlite3BtreeLast() */
@@ -4218,7 +4391,7 @@ case OP_NewRowid: {           /* out2 */
     pC->cacheStatus = CACHE_STALE;
   }
   pOut->u.i = v;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Insert P1 P2 P3 P4 P5
@@ -4267,8 +4440,8 @@ case OP_NewRowid: {           /* out2 */
 ** This works exactly like OP_Insert except that the key is the
 ** integer value P3, not the value of the integer stored in register P3.
 */
-case OP_Insert: 
-case OP_InsertInt: {
+case OP_Insert: VDBE_LABEL(OP_Insert) 
+case OP_InsertInt: VDBE_LABEL(OP_InsertInt) {
   Mem *pData;       /* MEM cell holding data for the record to be inserted */
   Mem *pKey;        /* MEM cell holding key  for the record */
   i64 iKey;         /* The integer ROWID or key for the record to be inserted */
@@ -4331,7 +4504,7 @@ case OP_InsertInt: {
     db->xUpdateCallback(db->pUpdateArg, op, zDb, zTbl, iKey);
     assert( pC->iDb>=0 );
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Delete P1 P2 * P4 P5
@@ -4363,7 +4536,7 @@ case OP_InsertInt: {
 ** If P4 is not NULL then the P1 cursor must have been positioned
 ** using OP_NotFound prior to invoking this opcode.
 */
-case OP_Delete: {
+case OP_Delete: VDBE_LABEL(OP_Delete) {
   VdbeCursor *pC;
   u8 hasUpdateCallback;
 
@@ -4420,7 +4593,7 @@ case OP_Delete: {
     assert( pC->iDb>=0 );
   }
   if( pOp->p2 & OPFLAG_NCHANGE ) p->nChange++;
-  break;
+  VDBE_DISPATCH;
 }
 /* Opcode: ResetCount * * * * *
 **
@@ -4429,10 +4602,10 @@ case OP_Delete: {
 ** Then the VMs internal change counter resets to 0.
 ** This is used by trigger programs.
 */
-case OP_ResetCount: {
+case OP_ResetCount: VDBE_LABEL(OP_ResetCount) {
   sqlite3VdbeSetChanges(db, p->nChange);
   p->nChange = 0;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: SorterCompare P1 P2 P3 P4
@@ -4450,7 +4623,7 @@ case OP_ResetCount: {
 ** Fall through to next instruction if the two records compare equal to
 ** each other.  Jump to P2 if they are different.
 */
-case OP_SorterCompare: {
+case OP_SorterCompare: VDBE_LABEL(OP_SorterCompare) {
   VdbeCursor *pC;
   int res;
   int nKeyCol;
@@ -4465,7 +4638,7 @@ case OP_SorterCompare: {
   VdbeBranchTaken(res!=0,2);
   if( rc ) goto abort_due_to_error;
   if( res ) goto jump_to_p2;
-  break;
+  VDBE_DISPATCH;
 };
 
 /* Opcode: SorterData P1 P2 P3 * *
@@ -4480,7 +4653,7 @@ case OP_SorterCompare: {
 ** parameter P3.  Clearing the P3 column cache as part of this opcode saves
 ** us from having to issue a separate NullRow instruction to clear that cache.
 */
-case OP_SorterData: {
+case OP_SorterData: VDBE_LABEL(OP_SorterData) {
   VdbeCursor *pC;
 
   pOut = &aMem[pOp->p2];
@@ -4491,7 +4664,7 @@ case OP_SorterData: {
   assert( pOp->p1>=0 && pOp->p1<p->nCursor );
   if( rc ) goto abort_due_to_error;
   p->apCsr[pOp->p3]->cacheStatus = CACHE_STALE;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: RowData P1 P2 * * *
@@ -4516,8 +4689,8 @@ case OP_SorterData: {
 ** If the P1 cursor must be pointing to a valid row (not a NULL row)
 ** of a real table, not a pseudo-table.
 */
-case OP_RowKey:
-case OP_RowData: {
+case OP_RowKey: VDBE_LABEL(OP_RowKey)
+case OP_RowData: VDBE_LABEL(OP_RowData) {
   VdbeCursor *pC;
   BtCursor *pCrsr;
   u32 n;
@@ -4582,7 +4755,7 @@ case OP_RowData: {
   pOut->enc = SQLITE_UTF8;  /* In case the blob is ever cast to text */
   UPDATE_MAX_BLOBSIZE(pOut);
   REGISTER_TRACE(pOp->p2, pOut);
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Rowid P1 P2 * * *
@@ -4595,7 +4768,7 @@ case OP_RowData: {
 ** be a separate OP_VRowid opcode for use with virtual tables, but this
 ** one opcode now works for both table types.
 */
-case OP_Rowid: {                 /* out2 */
+case OP_Rowid: VDBE_LABEL(OP_Rowid) { /* out2 */
   VdbeCursor *pC;
   i64 v;
   sqlite3_vtab *pVtab;
@@ -4634,7 +4807,7 @@ case OP_Rowid: {                 /* out2 */
     assert( rc==SQLITE_OK );  /* Always so because of CursorRestore() above */
   }
   pOut->u.i = v;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: NullRow P1 * * * *
@@ -4643,7 +4816,7 @@ case OP_Rowid: {                 /* out2 */
 ** that occur while the cursor is on the null row will always
 ** write a NULL.
 */
-case OP_NullRow: {
+case OP_NullRow: VDBE_LABEL(OP_NullRow) {
   VdbeCursor *pC;
 
   assert( pOp->p1>=0 && pOp->p1<p->nCursor );
@@ -4655,7 +4828,7 @@ case OP_NullRow: {
     assert( pC->uc.pCursor!=0 );
     sqlite3BtreeClearCursor(pC->uc.pCursor);
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Last P1 P2 P3 * *
@@ -4670,7 +4843,7 @@ case OP_NullRow: {
 ** from the end toward the beginning.  In other words, the cursor is
 ** configured to use Prev, not Next.
 */
-case OP_Last: {        /* jump */
+case OP_Last: VDBE_LABEL(OP_Last) { /* jump */
   VdbeCursor *pC;
   BtCursor *pCrsr;
   int res;
@@ -4695,7 +4868,7 @@ case OP_Last: {        /* jump */
     VdbeBranchTaken(res!=0,2);
     if( res ) goto jump_to_p2;
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 
@@ -4711,8 +4884,8 @@ case OP_Last: {        /* jump */
 ** regression tests can determine whether or not the optimizer is
 ** correctly optimizing out sorts.
 */
-case OP_SorterSort:    /* jump */
-case OP_Sort: {        /* jump */
+case OP_SorterSort: VDBE_LABEL(OP_SorterSort) /* jump */
+case OP_Sort: VDBE_LABEL(OP_Sort) { /* jump */
 #ifdef SQLITE_TEST
   sqlite3_sort_count++;
   sqlite3_search_count--;
@@ -4732,7 +4905,7 @@ case OP_Sort: {        /* jump */
 ** from the beginning toward the end.  In other words, the cursor is
 ** configured to use Next, not Prev.
 */
-case OP_Rewind: {        /* jump */
+case OP_Rewind: VDBE_LABEL(OP_Rewind) { /* jump */
   VdbeCursor *pC;
   BtCursor *pCrsr;
   int res;
@@ -4760,7 +4933,7 @@ case OP_Rewind: {        /* jump */
   assert( pOp->p2>0 && pOp->p2<p->nOp );
   VdbeBranchTaken(res!=0,2);
   if( res ) goto jump_to_p2;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Next P1 P2 P3 P4 P5
@@ -4826,7 +4999,7 @@ case OP_Rewind: {        /* jump */
 ** This opcode works just like Prev except that if cursor P1 is not
 ** open it behaves a no-op.
 */
-case OP_SorterNext: {  /* jump */
+case OP_SorterNext: VDBE_LABEL(OP_SorterNext) { /* jump */
   VdbeCursor *pC;
   int res;
 
@@ -4835,12 +5008,12 @@ case OP_SorterNext: {  /* jump */
   res = 0;
   rc = sqlite3VdbeSorterNext(db, pC, &res);
   goto next_tail;
-case OP_PrevIfOpen:    /* jump */
-case OP_NextIfOpen:    /* jump */
+case OP_PrevIfOpen: VDBE_LABEL(OP_PrevIfOpen) /* jump */
+case OP_NextIfOpen: VDBE_LABEL(OP_NextIfOpen) /* jump */
   if( p->apCsr[pOp->p1]==0 ) break;
   /* Fall through */
-case OP_Prev:          /* jump */
-case OP_Next:          /* jump */
+case OP_Prev: VDBE_LABEL(OP_Prev) /* jump */
+case OP_Next: VDBE_LABEL(OP_Next) /* jump */
   assert( pOp->p1>=0 && pOp->p1<p->nCursor );
   assert( pOp->p5<ArraySize(p->aCounter) );
   pC = p->apCsr[pOp->p1];
@@ -4903,8 +5076,8 @@ next_tail:
 ** This instruction only works for indices.  The equivalent instruction
 ** for tables is OP_Insert.
 */
-case OP_SorterInsert:       /* in2 */
-case OP_IdxInsert: {        /* in2 */
+case OP_SorterInsert: VDBE_LABEL(OP_SorterInsert) /* in2 */
+case OP_IdxInsert: VDBE_LABEL(OP_IdxInsert) { /* in2 */
   VdbeCursor *pC;
   int nKey;
   const char *zKey;
@@ -4932,7 +5105,7 @@ case OP_IdxInsert: {        /* in2 */
     pC->cacheStatus = CACHE_STALE;
   }
   if( rc) goto abort_due_to_error;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: IdxDelete P1 P2 P3 * *
@@ -4942,7 +5115,7 @@ case OP_IdxInsert: {        /* in2 */
 ** an unpacked index key. This opcode removes that entry from the 
 ** index opened by cursor P1.
 */
-case OP_IdxDelete: {
+case OP_IdxDelete: VDBE_LABEL(OP_IdxDelete) {
   VdbeCursor *pC;
   BtCursor *pCrsr;
   int res;
@@ -4969,7 +5142,7 @@ case OP_IdxDelete: {
   }
   assert( pC->deferredMoveto==0 );
   pC->cacheStatus = CACHE_STALE;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Seek P1 * P3 P4 *
@@ -5000,8 +5173,8 @@ case OP_IdxDelete: {
 **
 ** See also: Rowid, MakeRecord.
 */
-case OP_Seek:
-case OP_IdxRowid: {              /* out2 */
+case OP_Seek: VDBE_LABEL(OP_Seek)
+case OP_IdxRowid: VDBE_LABEL(OP_IdxRowid) { /* out2 */
   VdbeCursor *pC;                /* The P1 index cursor */
   VdbeCursor *pTabCur;           /* The P2 table cursor (OP_Seek only) */
   i64 rowid;                     /* Rowid that P1 current points to */
@@ -5052,7 +5225,7 @@ case OP_IdxRowid: {              /* out2 */
     assert( pOp->opcode==OP_IdxRowid );
     sqlite3VdbeMemSetNull(&aMem[pOp->p2]);
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: IdxGE P1 P2 P3 P4 P5
@@ -5099,10 +5272,10 @@ case OP_IdxRowid: {              /* out2 */
 ** If the P1 index entry is less than or equal to the key value then jump
 ** to P2. Otherwise fall through to the next instruction.
 */
-case OP_IdxLE:          /* jump */
-case OP_IdxGT:          /* jump */
-case OP_IdxLT:          /* jump */
-case OP_IdxGE:  {       /* jump */
+case OP_IdxLE: VDBE_LABEL(OP_IdxLE) /* jump */
+case OP_IdxGT: VDBE_LABEL(OP_IdxGT) /* jump */
+case OP_IdxLT: VDBE_LABEL(OP_IdxLT) /* jump */
+case OP_IdxGE: VDBE_LABEL(OP_IdxGE)  {       /* jump */
   VdbeCursor *pC;
   int res;
   UnpackedRecord r;
@@ -5142,7 +5315,7 @@ case OP_IdxGE:  {       /* jump */
   VdbeBranchTaken(res>0,2);
   if( rc ) goto abort_due_to_error;
   if( res>0 ) goto jump_to_p2;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Destroy P1 P2 P3 * *
@@ -5165,7 +5338,7 @@ case OP_IdxGE:  {       /* jump */
 **
 ** See also: Clear
 */
-case OP_Destroy: {     /* out2 */
+case OP_Destroy: VDBE_LABEL(OP_Destroy) { /* out2 */
   int iMoved;
   int iDb;
 
@@ -5194,7 +5367,7 @@ case OP_Destroy: {     /* out2 */
     }
 #endif
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Clear P1 P2 P3
@@ -5215,7 +5388,7 @@ case OP_Destroy: {     /* out2 */
 **
 ** See also: Destroy
 */
-case OP_Clear: {
+case OP_Clear: VDBE_LABEL(OP_Clear) {
   int nChange;
  
   nChange = 0;
@@ -5233,7 +5406,7 @@ case OP_Clear: {
     }
   }
   if( rc ) goto abort_due_to_error;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: ResetSorter P1 * * * *
@@ -5244,7 +5417,7 @@ case OP_Clear: {
 ** This opcode only works for cursors used for sorting and
 ** opened with OP_OpenEphemeral or OP_SorterOpen.
 */
-case OP_ResetSorter: {
+case OP_ResetSorter: VDBE_LABEL(OP_ResetSorter) {
   VdbeCursor *pC;
  
   assert( pOp->p1>=0 && pOp->p1<p->nCursor );
@@ -5258,7 +5431,7 @@ case OP_ResetSorter: {
     rc = sqlite3BtreeClearTableOfCursor(pC->uc.pCursor);
     if( rc ) goto abort_due_to_error;
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: CreateTable P1 P2 * * *
@@ -5285,8 +5458,8 @@ case OP_ResetSorter: {
 **
 ** See documentation on OP_CreateTable for additional information.
 */
-case OP_CreateIndex:            /* out2 */
-case OP_CreateTable: {          /* out2 */
+case OP_CreateIndex: VDBE_LABEL(OP_CreateIndex) /* out2 */
+case OP_CreateTable: VDBE_LABEL(OP_CreateTable) { /* out2 */
   int pgno;
   int flags;
   Db *pDb;
@@ -5307,7 +5480,7 @@ case OP_CreateTable: {          /* out2 */
   rc = sqlite3BtreeCreateTable(pDb->pBt, &pgno, flags);
   if( rc ) goto abort_due_to_error;
   pOut->u.i = pgno;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: ParseSchema P1 * * P4 *
@@ -5318,7 +5491,7 @@ case OP_CreateTable: {          /* out2 */
 ** This opcode invokes the parser to create a new virtual machine,
 ** then runs the new virtual machine.  It is thus a re-entrant opcode.
 */
-case OP_ParseSchema: {
+case OP_ParseSchema: VDBE_LABEL(OP_ParseSchema) {
   int iDb;
   const char *zMaster;
   char *zSql;
@@ -5375,7 +5548,7 @@ case OP_ParseSchema: {
 ** of that table into the internal index hash table.  This will cause
 ** the analysis to be used when preparing all subsequent queries.
 */
-case OP_LoadAnalysis: {
+case OP_LoadAnalysis: VDBE_LABEL(OP_LoadAnalysis) {
   assert( pOp->p1>=0 && pOp->p1<db->nDb );
   rc = sqlite3AnalysisLoad(db, pOp->p1);
   if( rc ) goto abort_due_to_error;
@@ -5391,9 +5564,9 @@ case OP_LoadAnalysis: {
 ** the internal representation of the
 ** schema consistent with what is on disk.
 */
-case OP_DropTable: {
+case OP_DropTable: VDBE_LABEL(OP_DropTable) {
   sqlite3UnlinkAndDeleteTable(db, pOp->p1, pOp->p4.z);
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: DropIndex P1 * * P4 *
@@ -5404,9 +5577,9 @@ case OP_DropTable: {
 ** in order to keep the internal representation of the
 ** schema consistent with what is on disk.
 */
-case OP_DropIndex: {
+case OP_DropIndex: VDBE_LABEL(OP_DropIndex) {
   sqlite3UnlinkAndDeleteIndex(db, pOp->p1, pOp->p4.z);
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: DropTrigger P1 * * P4 *
@@ -5417,9 +5590,9 @@ case OP_DropIndex: {
 ** the internal representation of the
 ** schema consistent with what is on disk.
 */
-case OP_DropTrigger: {
+case OP_DropTrigger: VDBE_LABEL(OP_DropTrigger) {
   sqlite3UnlinkAndDeleteTrigger(db, pOp->p1, pOp->p4.z);
-  break;
+  VDBE_DISPATCH;
 }
 
 
@@ -5443,7 +5616,7 @@ case OP_DropTrigger: {
 **
 ** This opcode is used to implement the integrity_check pragma.
 */
-case OP_IntegrityCk: {
+case OP_IntegrityCk: VDBE_LABEL(OP_IntegrityCk) {
   int nRoot;      /* Number of tables to check.  (Number of root pages.) */
   int *aRoot;     /* Array of rootpage numbers for tables to be checked */
   int nErr;       /* Number of errors reported */
@@ -5475,7 +5648,7 @@ case OP_IntegrityCk: {
   }
   UPDATE_MAX_BLOBSIZE(pIn1);
   sqlite3VdbeChangeEncoding(pIn1, encoding);
-  break;
+  VDBE_DISPATCH;
 }
 #endif /* SQLITE_OMIT_INTEGRITY_CHECK */
 
@@ -5487,7 +5660,7 @@ case OP_IntegrityCk: {
 **
 ** An assertion fails if P2 is not an integer.
 */
-case OP_RowSetAdd: {       /* in1, in2 */
+case OP_RowSetAdd: VDBE_LABEL(OP_RowSetAdd) { /* in1, in2 */
   pIn1 = &aMem[pOp->p1];
   pIn2 = &aMem[pOp->p2];
   assert( (pIn2->flags & MEM_Int)!=0 );
@@ -5496,7 +5669,7 @@ case OP_RowSetAdd: {       /* in1, in2 */
     if( (pIn1->flags & MEM_RowSet)==0 ) goto no_mem;
   }
   sqlite3RowSetInsert(pIn1->u.pRowSet, pIn2->u.i);
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: RowSetRead P1 P2 P3 * *
@@ -5506,7 +5679,7 @@ case OP_RowSetAdd: {       /* in1, in2 */
 ** register P3.  Or, if boolean index P1 is initially empty, leave P3
 ** unchanged and jump to instruction P2.
 */
-case OP_RowSetRead: {       /* jump, in1, out3 */
+case OP_RowSetRead: VDBE_LABEL(OP_RowSetRead) { /* jump, in1, out3 */
   i64 val;
 
   pIn1 = &aMem[pOp->p1];
@@ -5549,7 +5722,7 @@ case OP_RowSetRead: {       /* jump, in1, out3 */
 ** previously inserted as part of set X (only if it was previously
 ** inserted as part of some other set).
 */
-case OP_RowSetTest: {                     /* jump, in1, in3 */
+case OP_RowSetTest: VDBE_LABEL(OP_RowSetTest) { /* jump, in1, in3 */
   int iSet;
   int exists;
 
@@ -5576,7 +5749,7 @@ case OP_RowSetTest: {                     /* jump, in1, in3 */
   if( iSet>=0 ){
     sqlite3RowSetInsert(pIn1->u.pRowSet, pIn3->u.i);
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 
@@ -5597,7 +5770,7 @@ case OP_RowSetTest: {                     /* jump, in1, in3 */
 **
 ** If P5 is non-zero, then recursive program invocation is enabled.
 */
-case OP_Program: {        /* jump */
+case OP_Program: VDBE_LABEL(OP_Program) { /* jump */
   int nMem;               /* Number of memory registers for sub-program */
   int nByte;              /* Bytes of runtime space required for sub-program */
   Mem *pRt;               /* Register to allocate runtime space */
@@ -5713,7 +5886,7 @@ case OP_Program: {        /* jump */
   pOp = &aOp[-1];
   memset(p->aOnceFlag, 0, p->nOnceFlag);
 
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: Param P1 P2 * * *
@@ -5728,14 +5901,14 @@ case OP_Program: {        /* jump */
 ** the value of the P1 argument to the value of the P1 argument to the
 ** calling OP_Program instruction.
 */
-case OP_Param: {           /* out2 */
+case OP_Param: VDBE_LABEL(OP_Param) { /* out2 */
   VdbeFrame *pFrame;
   Mem *pIn;
   pOut = out2Prerelease(p, pOp);
   pFrame = p->pFrame;
   pIn = &pFrame->aMem[pOp->p1 + pFrame->aOp[pFrame->pc].p1];   
   sqlite3VdbeMemShallowCopy(pOut, pIn, MEM_Ephem);
-  break;
+  VDBE_DISPATCH;
 }
 
 #endif /* #ifndef SQLITE_OMIT_TRIGGER */
@@ -5749,7 +5922,7 @@ case OP_Param: {           /* out2 */
 ** (deferred foreign key constraints). Otherwise, if P1 is zero, the 
 ** statement counter is incremented (immediate foreign key constraints).
 */
-case OP_FkCounter: {
+case OP_FkCounter: VDBE_LABEL(OP_FkCounter) {
   if( db->flags & SQLITE_DeferFKs ){
     db->nDeferredImmCons += pOp->p2;
   }else if( pOp->p1 ){
@@ -5757,7 +5930,7 @@ case OP_FkCounter: {
   }else{
     p->nFkConstraint += pOp->p2;
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: FkIfZero P1 P2 * * *
@@ -5772,7 +5945,7 @@ case OP_FkCounter: {
 ** zero, the jump is taken if the statement constraint-counter is zero
 ** (immediate foreign key constraint violations).
 */
-case OP_FkIfZero: {         /* jump */
+case OP_FkIfZero: VDBE_LABEL(OP_FkIfZero) { /* jump */
   if( pOp->p1 ){
     VdbeBranchTaken(db->nDeferredCons==0 && db->nDeferredImmCons==0, 2);
     if( db->nDeferredCons==0 && db->nDeferredImmCons==0 ) goto jump_to_p2;
@@ -5780,7 +5953,7 @@ case OP_FkIfZero: {         /* jump */
     VdbeBranchTaken(p->nFkConstraint==0 && db->nDeferredImmCons==0, 2);
     if( p->nFkConstraint==0 && db->nDeferredImmCons==0 ) goto jump_to_p2;
   }
-  break;
+  VDBE_DISPATCH;
 }
 #endif /* #ifndef SQLITE_OMIT_FOREIGN_KEY */
 
@@ -5796,7 +5969,7 @@ case OP_FkIfZero: {         /* jump */
 ** This instruction throws an error if the memory cell is not initially
 ** an integer.
 */
-case OP_MemMax: {        /* in2 */
+case OP_MemMax: VDBE_LABEL(OP_MemMax) { /* in2 */
   VdbeFrame *pFrame;
   if( p->pFrame ){
     for(pFrame=p->pFrame; pFrame->pParent; pFrame=pFrame->pParent);
@@ -5811,7 +5984,7 @@ case OP_MemMax: {        /* in2 */
   if( pIn1->u.i<pIn2->u.i){
     pIn1->u.i = pIn2->u.i;
   }
-  break;
+  VDBE_DISPATCH;
 }
 #endif /* SQLITE_OMIT_AUTOINCREMENT */
 
@@ -5825,7 +5998,7 @@ case OP_MemMax: {        /* in2 */
 ** If the initial value of register P1 is less than 1, then the
 ** value is unchanged and control passes through to the next instruction.
 */
-case OP_IfPos: {        /* jump, in1 */
+case OP_IfPos: VDBE_LABEL(OP_IfPos) { /* jump, in1 */
   pIn1 = &aMem[pOp->p1];
   assert( pIn1->flags&MEM_Int );
   VdbeBranchTaken( pIn1->u.i>0, 2);
@@ -5833,7 +6006,7 @@ case OP_IfPos: {        /* jump, in1 */
     pIn1->u.i -= pOp->p3;
     goto jump_to_p2;
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: OffsetLimit P1 P2 P3 * *
@@ -5854,14 +6027,14 @@ case OP_IfPos: {        /* jump, in1 */
 **
 ** Otherwise, r[P2] is set to the sum of r[P1] and r[P3].
 */
-case OP_OffsetLimit: {    /* in1, out2, in3 */
+case OP_OffsetLimit: VDBE_LABEL(OP_OffsetLimit) { /* in1, out2, in3 */
   pIn1 = &aMem[pOp->p1];
   pIn3 = &aMem[pOp->p3];
   pOut = out2Prerelease(p, pOp);
   assert( pIn1->flags & MEM_Int );
   assert( pIn3->flags & MEM_Int );
   pOut->u.i = pIn1->u.i<=0 ? -1 : pIn1->u.i+(pIn3->u.i>0?pIn3->u.i:0);
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: IfNotZero P1 P2 P3 * *
@@ -5872,7 +6045,7 @@ case OP_OffsetLimit: {    /* in1, out2, in3 */
 ** jump to P2.  If register P1 is initially zero, leave it unchanged
 ** and fall through.
 */
-case OP_IfNotZero: {        /* jump, in1 */
+case OP_IfNotZero: VDBE_LABEL(OP_IfNotZero) { /* jump, in1 */
   pIn1 = &aMem[pOp->p1];
   assert( pIn1->flags&MEM_Int );
   VdbeBranchTaken(pIn1->u.i<0, 2);
@@ -5880,7 +6053,7 @@ case OP_IfNotZero: {        /* jump, in1 */
      pIn1->u.i -= pOp->p3;
      goto jump_to_p2;
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: DecrJumpZero P1 P2 * * *
@@ -5889,13 +6062,13 @@ case OP_IfNotZero: {        /* jump, in1 */
 ** Register P1 must hold an integer.  Decrement the value in register P1
 ** then jump to P2 if the new value is exactly zero.
 */
-case OP_DecrJumpZero: {      /* jump, in1 */
+case OP_DecrJumpZero: VDBE_LABEL(OP_DecrJumpZero) { /* jump, in1 */
   pIn1 = &aMem[pOp->p1];
   assert( pIn1->flags&MEM_Int );
   pIn1->u.i--;
   VdbeBranchTaken(pIn1->u.i==0, 2);
   if( pIn1->u.i==0 ) goto jump_to_p2;
-  break;
+  VDBE_DISPATCH;
 }
 
 
@@ -5906,12 +6079,12 @@ case OP_DecrJumpZero: {      /* jump, in1 */
 ** zero, then jump to P2.  Increment register P1 regardless of whether or
 ** not the jump is taken.
 */
-case OP_JumpZeroIncr: {        /* jump, in1 */
+case OP_JumpZeroIncr: VDBE_LABEL(OP_JumpZeroIncr) { /* jump, in1 */
   pIn1 = &aMem[pOp->p1];
   assert( pIn1->flags&MEM_Int );
   VdbeBranchTaken(pIn1->u.i==0, 2);
   if( (pIn1->u.i++)==0 ) goto jump_to_p2;
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: AggStep0 * P2 P3 P4 P5
@@ -5942,7 +6115,7 @@ case OP_JumpZeroIncr: {        /* jump, in1 */
 ** sqlite3_context only happens once, instead of on each call to the
 ** step function.
 */
-case OP_AggStep0: {
+case OP_AggStep0: VDBE_LABEL(OP_AggStep0) {
   int n;
   sqlite3_context *pCtx;
 
@@ -5963,7 +6136,7 @@ case OP_AggStep0: {
   pOp->opcode = OP_AggStep;
   /* Fall through into OP_AggStep */
 }
-case OP_AggStep: {
+case OP_AggStep: VDBE_LABEL(OP_AggStep) {
   int i;
   sqlite3_context *pCtx;
   Mem *pMem;
@@ -6010,7 +6183,7 @@ case OP_AggStep: {
     i = pOp[-1].p1;
     if( i ) sqlite3VdbeMemSetInt64(&aMem[i], 1);
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 /* Opcode: AggFinal P1 P2 * P4 *
@@ -6026,7 +6199,7 @@ case OP_AggStep: {
 ** P4 argument is only needed for the degenerate case where
 ** the step function was not previously called.
 */
-case OP_AggFinal: {
+case OP_AggFinal: VDBE_LABEL(OP_AggFinal) {
   Mem *pMem;
   assert( pOp->p1>0 && pOp->p1<=(p->nMem+1 - p->nCursor) );
   pMem = &aMem[pOp->p1];
@@ -6041,7 +6214,154 @@ case OP_AggFinal: {
   if( sqlite3VdbeMemTooBig(pMem) ){
     goto too_big;
   }
-  break;
+  VDBE_DISPATCH;
+}
+
+/* Opcode: BatchOpen P1 P2 * * *
+**
+** Allocate a batch of P2 column vectors for table cursor P1, for use by
+** the OP_Batch* opcodes that follow.  Any batch the cursor already has
+** is discarded.
+*/
+case OP_BatchOpen: VDBE_LABEL(OP_BatchOpen) {
+  VdbeCursor *pC;
+  assert( pOp->p1>=0 && pOp->p1<p->nCursor );
+  pC = p->apCsr[pOp->p1];
+  assert( pC!=0 && pC->eCurType==CURTYPE_BTREE );
+  rc = sqlite3VdbeBatchOpen(db, pC, pOp->p2);
+  if( rc ) goto abort_due_to_error;
+  VDBE_DISPATCH;
+}
+
+/* Opcode: BatchConst P1 P2 P3 * *
+** Synopsis: vec[P2]=r[P3]
+**
+** Set every row of vector P2 of the batch of cursor P1 to the value in
+** register P3, which must be an integer, a real or NULL.
+*/
+case OP_BatchConst: VDBE_LABEL(OP_BatchConst) { /* in3 */
+  VdbeCursor *pC;
+  pC = p->apCsr[pOp->p1];
+  assert( pC!=0 && pC->pBatch!=0 );
+  sqlite3VdbeBatchConst(pC->pBatch, pOp->p2, &aMem[pOp->p3]);
+  VDBE_DISPATCH;
+}
+
+/* Opcode: BatchLoad P1 P2 * P4 *
+**
+** If table cursor P1 is past its last row, jump to P2.  Otherwise read
+** up to SQLITE_BATCH_SIZE rows into the batch of cursor P1, starting
+** with the row the cursor points to, and advance the cursor past them.
+** All rows read are selected.
+**
+** P4 is an array of integers describing the columns to read, as
+** documented for sqlite3VdbeBatchLoad().
+*/
+case OP_BatchLoad: VDBE_LABEL(OP_BatchLoad) { /* jump */
+  VdbeCursor *pC;
+  assert( pOp->p1>=0 && pOp->p1<p->nCursor );
+  assert( pOp->p4type==P4_INTARRAY );
+  pC = p->apCsr[pOp->p1];
+  assert( pC!=0 && pC->pBatch!=0 );
+  assert( pC->deferredMoveto==0 );
+  VdbeBranchTaken(pC->nullRow!=0,2);
+  if( pC->nullRow ) goto jump_to_p2;
+  rc = sqlite3VdbeBatchLoad(p, pC, pOp->p4.ai);
+  if( rc ) goto abort_due_to_error;
+  VDBE_DISPATCH;
+}
+
+/* Opcode: BatchFilter P1 P2 P3 * P5
+** Synopsis: where vec[P2] P5 r[P3]
+**
+** Deselect each row of the batch of cursor P1 for which the comparison
+** between vector P2 and the number in register P3 is not true.  P5 is
+** the comparison operator: one of OP_Eq, OP_Ne, OP_Lt, OP_Le, OP_Gt or
+** OP_Ge.
+*/
+case OP_BatchFilter: VDBE_LABEL(OP_BatchFilter) { /* in3 */
+  VdbeCursor *pC;
+  pC = p->apCsr[pOp->p1];
+  assert( pC!=0 && pC->pBatch!=0 );
+  sqlite3VdbeBatchFilter(pC->pBatch, pOp->p2, &aMem[pOp->p3], pOp->p5);
+  VDBE_DISPATCH;
+}
+
+/* Opcode: BatchArith P1 P2 P3 P4 P5
+** Synopsis: vec[P4]=vec[P2] P5 vec[P3]
+**
+** For each selected row of the batch of cursor P1, compute vector P2
+** plus, minus, times or divided by vector P3 and store the result in
+** vector P4.  P5 is OP_Add, OP_Subtract, OP_Multiply or OP_Divide, and
+** the arithmetic is the same as that done by those opcodes.
+*/
+case OP_BatchArith: VDBE_LABEL(OP_BatchArith) {
+  VdbeCursor *pC;
+  assert( pOp->p4type==P4_INT32 );
+  pC = p->apCsr[pOp->p1];
+  assert( pC!=0 && pC->pBatch!=0 );
+  sqlite3VdbeBatchArith(pC->pBatch, pOp->p2, pOp->p3, pOp->p4.i, pOp->p5);
+  VDBE_DISPATCH;
+}
+
+/* Opcode: BatchAgg P1 P2 P3 P4 P5
+** Synopsis: accum=r[P3] step(vec[P2])
+**
+** Execute the step function of the aggregate in P4, a FuncDef for one
+** of the built-in sum(), total(), avg(), count(), min() or max()
+** functions, once for each selected row of the batch of cursor P1 with
+** the value of vector P2 as the argument.  If P2 is negative the
+** aggregate is count(*).  P3 is the accumulator and P5 the number of
+** arguments.
+**
+** The first time it runs, this opcode replaces the FuncDef in P4 with
+** an sqlite3_context, as OP_AggStep0 does.
+*/
+case OP_BatchAgg: VDBE_LABEL(OP_BatchAgg) {
+  VdbeCursor *pC;
+  VdbeBatch *pBatch;
+  sqlite3_context *pCtx;
+  Mem *pMem;
+  Mem t;
+  int i;
+
+  pC = p->apCsr[pOp->p1];
+  assert( pC!=0 && pC->pBatch!=0 );
+  pBatch = pC->pBatch;
+  if( pOp->p4type==P4_FUNCDEF ){
+    pCtx = sqlite3DbMallocRawNN(db, sizeof(*pCtx));
+    if( pCtx==0 ) goto no_mem;
+    pCtx->pMem = 0;
+    pCtx->pFunc = pOp->p4.pFunc;
+    pCtx->iOp = (int)(pOp - aOp);
+    pCtx->pVdbe = p;
+    pCtx->argc = pOp->p5;
+    pOp->p4type = P4_FUNCCTX;
+    pOp->p4.pCtx = pCtx;
+  }
+  assert( pOp->p4type==P4_FUNCCTX );
+  assert( pOp->p3>0 && pOp->p3<=(p->nMem+1 - p->nCursor) );
+  pCtx = pOp->p4.pCtx;
+  pMem = &aMem[pOp->p3];
+  pCtx->pMem = pMem;
+
+  for(i=0; i<pBatch->nRow; i++) pMem->n += pBatch->aSel[i];
+  sqlite3VdbeMemInit(&t, db, MEM_Null);
+  pCtx->pOut = &t;
+  pCtx->fErrorOrAux = 0;
+  pCtx->skipFlag = 0;
+  sqlite3AggBatchStep(pCtx, pBatch, pOp->p2);
+  if( pCtx->fErrorOrAux ){
+    if( pCtx->isError ){
+      sqlite3VdbeError(p, "%s", sqlite3_value_text(&t));
+      rc = pCtx->isError;
+    }
+    sqlite3VdbeMemRelease(&t);
+    if( rc ) goto abort_due_to_error;
+  }else{
+    assert( t.flags==MEM_Null );
+  }
+  VDBE_DISPATCH;
 }
 
 #ifndef SQLITE_OMIT_WAL
@@ -6056,7 +6376,7 @@ case OP_AggFinal: {
 ** completes into mem[P3+2].  However on an error, mem[P3+1] and
 ** mem[P3+2] are initialized to -1.
 */
-case OP_Checkpoint: {
+case OP_Checkpoint: VDBE_LABEL(OP_Checkpoint) {
   int i;                          /* Loop counter */
   int aRes[3];                    /* Results */
   Mem *pMem;                      /* Write results here */
@@ -6078,7 +6398,7 @@ case OP_Checkpoint: {
   for(i=0, pMem = &aMem[pOp->p3]; i<3; i++, pMem++){
     sqlite3VdbeMemSetInt64(pMem, (i64)aRes[i]);
   }    
-  break;
+  VDBE_DISPATCH;
 };  
 #endif
 
@@ -6094,7 +6414,7 @@ case OP_Checkpoint: {
 **
 ** Write a string containing the final journal-mode to register P2.
 */
-case OP_JournalMode: {    /* out2 */
+case OP_JournalMode: VDBE_LABEL(OP_JournalMode) { /* out2 */
   Btree *pBt;                     /* Btree to change journal mode of */
   Pager *pPager;                  /* Pager associated with pBt */
   int eNew;                       /* New journal mode */
@@ -6183,7 +6503,7 @@ case OP_JournalMode: {    /* out2 */
   pOut->enc = SQLITE_UTF8;
   sqlite3VdbeChangeEncoding(pOut, encoding);
   if( rc ) goto abort_due_to_error;
-  break;
+  VDBE_DISPATCH;
 };
 #endif /* SQLITE_OMIT_PRAGMA */
 
@@ -6194,11 +6514,11 @@ case OP_JournalMode: {    /* out2 */
 ** machines to be created and run.  It may not be called from within
 ** a transaction.
 */
-case OP_Vacuum: {
+case OP_Vacuum: VDBE_LABEL(OP_Vacuum) {
   assert( p->readOnly==0 );
   rc = sqlite3RunVacuum(&p->zErrMsg, db);
   if( rc ) goto abort_due_to_error;
-  break;
+  VDBE_DISPATCH;
 }
 #endif
 
@@ -6209,7 +6529,7 @@ case OP_Vacuum: {
 ** the P1 database. If the vacuum has finished, jump to instruction
 ** P2. Otherwise, fall through to the next instruction.
 */
-case OP_IncrVacuum: {        /* jump */
+case OP_IncrVacuum: VDBE_LABEL(OP_IncrVacuum) { /* jump */
   Btree *pBt;
 
   assert( pOp->p1>=0 && pOp->p1<db->nDb );
@@ -6223,7 +6543,7 @@ case OP_IncrVacuum: {        /* jump */
     rc = SQLITE_OK;
     goto jump_to_p2;
   }
-  break;
+  VDBE_DISPATCH;
 }
 #endif
 
@@ -6237,13 +6557,13 @@ case OP_IncrVacuum: {        /* jump */
 ** If P1 is 0, then all SQL statements become expired. If P1 is non-zero,
 ** then only the currently executing statement is expired.
 */
-case OP_Expire: {
+case OP_Expire: VDBE_LABEL(OP_Expire) {
   if( !pOp->p1 ){
     sqlite3ExpirePreparedStatements(db);
   }else{
     p->expired = 1;
   }
-  break;
+  VDBE_DISPATCH;
 }
 
 #ifndef SQLITE_OMIT_SHARED_CACHE
@@ -6262,7 +6582,7 @@ case OP_Expire: {
 ** P4 contains a pointer to the name of the table being locked. This is only
 ** used to generate an error message if the lock cannot be obtained.
 */
-case OP_TableLock: {
+case OP_TableLock: VDBE_LABEL(OP_TableLock) {
   u8 isWriteLock = (u8)pOp->p3;
   if( isWriteLock || 0==(db->flags&SQLITE_ReadUncommitted) ){
     int p1 = pOp->p1; 
@@ -6278,7 +6598,7 @@ case OP_TableLock: {
       goto abort_due_to_error;
     }
   }
-  break;
+  VDBE_DISPATCH;
 }
 #endif /* SQLITE_OMIT_SHARED_CACHE */
 
@@ -6292,13 +6612,13 @@ case OP_TableLock: {
 ** within a callback to a virtual table xSync() method. If it is, the error
 ** code will be set to SQLITE_LOCKED.
 */
-case OP_VBegin: {
+case OP_VBegin: VDBE_LABEL(OP_VBegin) {
   VTable *pVTab;
   pVTab = pOp->p4.pVtab;
   rc = sqlite3VtabBegin(db, pVTab);
   if( pVTab ) sqlite3VtabImportErrmsg(p, pVTab->pVtab);
   if( rc ) goto abort_due_to_error;
-  break;
+  VDBE_DISPATCH;
 }
 #endif /* SQLITE_OMIT_VIRTUALTABLE */
 
@@ -6308,7 +6628,7 @@ case OP_VBegin: {
 ** P2 is a register that holds the name of a virtual table in database 
 ** P1. Call the xCreate method for that table.
 */
-case OP_VCreate: {
+case OP_VCreate: VDBE_LABEL(OP_VCreate) {
   Mem sMem;          /* For storing the record being decoded */
   const char *zTab;  /* Name of the virtual table */
 
@@ -6327,7 +6647,7 @@ case OP_VCreate: {
   }
   sqlite3VdbeMemRelease(&sMem);
   if( rc ) goto abort_due_to_error;
-  break;
+  VDBE_DISPATCH;
 }
 #endif /* SQLITE_OMIT_VIRTUALTABLE */
 
@@ -6337,12 +6657,12 @@ case OP_VCreate: {
 ** P4 is the name of a virtual table in database P1.  Call the xDestroy method
 ** of that table.
 */
-case OP_VDestroy: {
+case OP_VDestroy: VDBE_LABEL(OP_VDestroy) {
   db->nVDestroy++;
   rc = sqlite3VtabCallDestroy(db, pOp->p1, pOp->p4.z);
   db->nVDestroy--;
   if( rc ) goto abort_due_to_error;
-  break;
+  VDBE_DISPATCH;
 }
 #endif /* SQLITE_OMIT_VIRTUALTABLE */
 
@@ -6353,7 +6673,7 @@ case OP_VDestroy: {
 ** P1 is a cursor number.  This opcode opens a cursor to the virtual
 ** table and stores that cursor in P1.
 */
-case OP_VOpen: {
+case OP_VOpen: VDBE_LABEL(OP_VOpen) {
   VdbeCursor *pCur;
   sqlite3_vtab_cursor *pVCur;
   sqlite3_vtab *pVtab;
@@ -6385,7 +6705,7 @@ case OP_VOpen: {
     pModule->xClose(pVCur);
     goto no_mem;
   }
-  break;
+  VDBE_DISPATCH;
 }
 #endif /* SQLITE_OMIT_VIRTUALTABLE */
 
@@ -6409,7 +6729,7 @@ case OP_VOpen: {
 **
 ** A jump is made to P2 if the result set after filtering would be empty.
 */
-case OP_VFilter: {   /* jump */
+case OP_VFilter: VDBE_LABEL(OP_VFilter) { /* jump */
   int nArg;
   int iQuery;
   const sqlite3_module *pModule;
@@ -6450,7 +6770,7 @@ case OP_VFilter: {   /* jump */
   pCur->nullRow = 0;
   VdbeBranchTaken(res!=0,2);
   if( res ) goto jump_to_p2;
-  break;
+  VDBE_DISPATCH;
 }
 #endif /* SQLITE_OMIT_VIRTUALTABLE */
 
@@ -6462,7 +6782,7 @@ case OP_VFilter: {   /* jump */
 ** the row of the virtual-table that the 
 ** P1 cursor is pointing to into register P3.
 */
-case OP_VColumn: {
+case OP_VColumn: VDBE_LABEL(OP_VColumn) {
   sqlite3_vtab *pVtab;
   const sqlite3_module *pModule;
   Mem *pDest;
@@ -6496,7 +6816,7 @@ case OP_VColumn: {
     goto too_big;
   }
   if( rc ) goto abort_due_to_error;
-  break;
+  VDBE_DISPATCH;
 }
 #endif /* SQLITE_OMIT_VIRTUALTABLE */
 
@@ -6507,7 +6827,7 @@ case OP_VColumn: {
 ** jump to instruction P2.  Or, if the virtual table has reached
 ** the end of its result set, then fall through to the next instruction.
 */
-case OP_VNext: {   /* jump */
+case OP_VNext: VDBE_LABEL(OP_VNext) { /* jump */
   sqlite3_vtab *pVtab;
   const sqlite3_module *pModule;
   int res;
@@ -6549,7 +6869,7 @@ case OP_VNext: {   /* jump */
 ** This opcode invokes the corresponding xRename method. The value
 ** in register P1 is passed as the zName argument to the xRename method.
 */
-case OP_VRename: {
+case OP_VRename: VDBE_LABEL(OP_VRename) {
   sqlite3_vtab *pVtab;
   Mem *pName;
 
@@ -6569,7 +6889,7 @@ case OP_VRename: {
   sqlite3VtabImportErrmsg(p, pVtab);
   p->expired = 0;
   if( rc ) goto abort_due_to_error;
-  break;
+  VDBE_DISPATCH;
 }
 #endif
 
@@ -6601,7 +6921,7 @@ case OP_VRename: {
 ** P5 is the error actions (OE_Replace, OE_Fail, OE_Ignore, etc) to
 ** apply in the case of a constraint failure on an insert or update.
 */
-case OP_VUpdate: {
+case OP_VUpdate: VDBE_LABEL(OP_VUpdate) {
   sqlite3_vtab *pVtab;
   const sqlite3_module *pModule;
   int nArg;
@@ -6651,7 +6971,7 @@ case OP_VUpdate: {
     }
     if( rc ) goto abort_due_to_error;
   }
-  break;
+  VDBE_DISPATCH;
 }
 #endif /* SQLITE_OMIT_VIRTUALTABLE */
 
@@ -6660,10 +6980,10 @@ case OP_VUpdate: {
 **
 ** Write the current number of pages in database P1 to memory cell P2.
 */
-case OP_Pagecount: {            /* out2 */
+case OP_Pagecount: VDBE_LABEL(OP_Pagecount) { /* out2 */
   pOut = out2Prerelease(p, pOp);
   pOut->u.i = sqlite3BtreeLastPage(db->aDb[pOp->p1].pBt);
-  break;
+  VDBE_DISPATCH;
 }
 #endif
 
@@ -6677,7 +6997,7 @@ case OP_Pagecount: {            /* out2 */
 **
 ** Store the maximum page count after the change in register P2.
 */
-case OP_MaxPgcnt: {            /* out2 */
+case OP_MaxPgcnt: VDBE_LABEL(OP_MaxPgcnt) { /* out2 */
   unsigned int newMax;
   Btree *pBt;
 
@@ -6689,7 +7009,7 @@ case OP_MaxPgcnt: {            /* out2 */
     if( newMax < (unsigned)pOp->p3 ) newMax = (unsigned)pOp->p3;
   }
   pOut->u.i = sqlite3BtreeMaxPageCount(pBt, newMax);
-  break;
+  VDBE_DISPATCH;
 }
 #endif
 
@@ -6706,7 +7026,7 @@ case OP_MaxPgcnt: {            /* out2 */
 **
 ** If P2 is not zero, jump to instruction P2.
 */
-case OP_Init: {          /* jump */
+case OP_Init: VDBE_LABEL(OP_Init) { /* jump */
   char *zTrace;
   char *z;
 
@@ -6738,7 +7058,7 @@ case OP_Init: {          /* jump */
 #endif /* SQLITE_DEBUG */
 #endif /* SQLITE_OMIT_TRACE */
   if( pOp->p2 ) goto jump_to_p2;
-  break;
+  VDBE_DISPATCH;
 }
 
 #ifdef SQLITE_ENABLE_CURSOR_HINTS
@@ -6749,7 +7069,7 @@ case OP_Init: {          /* jump */
 ** to values currently held in registers.  TK_COLUMN terms in the P4
 ** expression refer to columns in the b-tree to which cursor P1 is pointing.
 */
-case OP_CursorHint: {
+case OP_CursorHint: VDBE_LABEL(OP_CursorHint) {
   VdbeCursor *pC;
 
   assert( pOp->p1>=0 && pOp->p1<p->nCursor );
@@ -6760,7 +7080,7 @@ case OP_CursorHint: {
     sqlite3BtreeCursorHint(pC->uc.pCursor, BTREE_HINT_RANGE,
                            pOp->p4.pExpr, aMem);
   }
-  break;
+  VDBE_DISPATCH;
 }
 #endif /* SQLITE_ENABLE_CURSOR_HINTS */
 
@@ -6775,9 +7095,9 @@ case OP_CursorHint: {
 ** This opcode records information from the optimizer.  It is the
 ** the same as a no-op.  This opcodesnever appears in a real VM program.
 */
-default: {          /* This is really OP_Noop and OP_Explain */
+default: VDBE_LABEL(default) {  /* This is really OP_Noop and OP_Explain */
   assert( pOp->opcode==OP_Noop || pOp->opcode==OP_Explain );
-  break;
+  VDBE_DISPATCH;
 }
 
 /*****************************************************************************
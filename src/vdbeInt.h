@@ -64,6 +64,41 @@ typedef struct AuxData AuxData;
 #define CURTYPE_VTAB        2
 #define CURTYPE_PSEUDO      3
 
+/*
+** Number of rows read into a VdbeBatch by each OP_BatchLoad.
+*/
+#ifndef SQLITE_BATCH_SIZE
+# define SQLITE_BATCH_SIZE 256
+#endif
+
+/*
+** A VdbeBatch holds the values of some columns of up to SQLITE_BATCH_SIZE
+** consecutive rows of a table b-tree, one VdbeVector per column.  It is
+** filled by OP_BatchLoad and consumed by the other OP_Batch* opcodes, each
+** of which works on all rows of the batch at once.  Vectors beyond those
+** loaded from the table hold constants or intermediate results.
+**
+** aType[i] is one of SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT, SQLITE_BLOB
+** or SQLITE_NULL.  Integer values are in aInt[i] and real values in
+** aReal[i].  Text and blob values are only available, in aMem[i], if the
+** column was loaded with BATCHCOL_VALUE.  Rows with aSel[i]==0 have been
+** rejected by an OP_BatchFilter.  The vdbebatch.c file has the details.
+*/
+typedef struct VdbeBatch VdbeBatch;
+typedef struct VdbeVector VdbeVector;
+struct VdbeVector {
+  u8 *aType;            /* Datatype of each value */
+  i64 *aInt;            /* Integer values */
+  double *aReal;        /* Real values */
+  Mem *aMem;            /* Text and blob values.  Allocated on demand */
+};
+struct VdbeBatch {
+  int nRow;             /* Number of rows in the batch */
+  int nVec;             /* Number of entries in aVec[] */
+  u8 *aSel;             /* True for each row not yet filtered out */
+  VdbeVector aVec[1];   /* One entry for each column or intermediate */
+};
+
 /*
 ** A VdbeCursor is an superclass (a wrapper) for various cursor objects:
 **
@@ -104,6 +139,7 @@ struct VdbeCursor {
   i64 movetoTarget;     /* Argument to the deferred sqlite3BtreeMoveto() */
   VdbeCursor *pAltCursor; /* Associated index cursor from which to read */
   int *aAltMap;           /* Mapping from table to index column numbers */
+  VdbeBatch *pBatch;      /* Column vectors for the OP_Batch* opcodes */
 #ifdef SQLITE_ENABLE_COLUMN_USED_MASK
   u64 maskUsed;         /* Mask of columns used by this cursor */
 #endif
@@ -265,6 +301,15 @@ struct Mem {
 #define VdbeMemDynamic(X)  \
   (((X)->flags&(MEM_Agg|MEM_Dyn|MEM_RowSet|MEM_Frame))!=0)
 
+/* Input "x" is a sequence of unsigned characters that represent a
+** big-endian integer.  Return the equivalent native integer
+*/
+#define ONE_BYTE_INT(x)    ((i8)(x)[0])
+#define TWO_BYTE_INT(x)    (256*(i8)((x)[0])|(x)[1])
+#define THREE_BYTE_INT(x)  (65536*(i8)((x)[0])|((x)[1]<<8)|(x)[2])
+#define FOUR_BYTE_UINT(x)  (((u32)(x)[0]<<24)|((x)[1]<<16)|((x)[2]<<8)|(x)[3])
+#define FOUR_BYTE_INT(x) (16777216*(i8)((x)[0])|((x)[1]<<16)|((x)[2]<<8)|(x)[3])
+
 /*
 ** Clear any existing type flags from a Mem and replace them with f
 */
@@ -444,6 +489,7 @@ u8 sqlite3VdbeOneByteSerialTypeLen(u8);
 u32 sqlite3VdbeSerialType(Mem*, int, u32*);
 u32 sqlite3VdbeSerialPut(unsigned char*, Mem*, u32);
 u32 sqlite3VdbeSerialGet(const unsigned char*, u32, Mem*);
+extern const u8 sqlite3SmallTypeSizes[];
 void sqlite3VdbeDeleteAuxData(sqlite3*, AuxData**, int, int);
 
 int sqlite2BtreeKeyCompare(BtCursor *, const void *, int, int, int *);
@@ -479,6 +525,7 @@ int sqlite3VdbeMemRealify(Mem*);
 int sqlite3VdbeMemNumerify(Mem*);
 void sqlite3VdbeMemCast(Mem*,u8,u8);
 int sqlite3VdbeMemFromBtree(BtCursor*,u32,u32,int,Mem*);
+int sqlite3IntFloatCompare(i64,double);
 void sqlite3VdbeMemRelease(Mem *p);
 int sqlite3VdbeMemFinalize(Mem*, FuncDef*);
 const char *sqlite3OpcodeName(int);
@@ -489,6 +536,14 @@ void sqlite3VdbeFrameDelete(VdbeFrame*);
 int sqlite3VdbeFrameRestore(VdbeFrame *);
 int sqlite3VdbeTransferError(Vdbe *p);
 
+int sqlite3VdbeBatchOpen(sqlite3 *, VdbeCursor *, int);
+void sqlite3VdbeBatchFree(sqlite3 *, VdbeBatch *);
+int sqlite3VdbeBatchLoad(Vdbe *, VdbeCursor *, const int *);
+void sqlite3VdbeBatchConst(VdbeBatch *, int, Mem *);
+void sqlite3VdbeBatchFilter(VdbeBatch *, int, Mem *, int);
+void sqlite3VdbeBatchArith(VdbeBatch *, int, int, int, int);
+void sqlite3AggBatchStep(sqlite3_context *, VdbeBatch *, int);
+
 int sqlite3VdbeSorterInit(sqlite3 *, int, VdbeCursor *);
 void sqlite3VdbeSorterReset(sqlite3 *, VdbeSorter *);
 void sqlite3VdbeSorterClose(sqlite3 *, VdbeCursor *);
@@ -0,0 +1,565 @@
+/*
+** 2026 October 16
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+** This file contains code for the VdbeBatch object, used by the OP_Batch*
+** opcodes to evaluate simple aggregate queries over a full table scan
+** many rows at a time.
+**
+** OP_BatchLoad reads the next SQLITE_BATCH_SIZE rows of a table b-tree
+** and stores the values of the columns that the query uses in one
+** VdbeVector per column.  OP_BatchFilter then clears the aSel[] entries
+** of the rows that fail a WHERE clause term, OP_BatchArith computes
+** intermediate results into further vectors and OP_BatchAgg runs an
+** aggregate step function over the selected rows.  Each opcode is
+** dispatched once per batch rather than once per row, and works on
+** plain integer and floating point arrays instead of Mem objects.
+**
+** The results are the same as those of the equivalent row-at-a-time
+** program.  Text and blob values, which are rare in the numeric columns
+** that batch scans are used for, take slower paths that fall back to
+** the usual Mem based routines.
+*/
+#include "sqliteInt.h"
+#include "vdbeInt.h"
+
+/*
+** Free a VdbeBatch object allocated by sqlite3VdbeBatchOpen().
+*/
+void sqlite3VdbeBatchFree(sqlite3 *db, VdbeBatch *pBatch){
+  int i, j;
+  for(i=0; i<pBatch->nVec; i++){
+    Mem *aMem = pBatch->aVec[i].aMem;
+    if( aMem ){
+      for(j=0; j<SQLITE_BATCH_SIZE; j++) sqlite3VdbeMemRelease(&aMem[j]);
+      sqlite3DbFree(db, aMem);
+    }
+  }
+  sqlite3DbFree(db, pBatch);
+}
+
+/*
+** Allocate a VdbeBatch object with nVec vectors for cursor pC, replacing
+** any batch the cursor already has.  Return SQLITE_OK or SQLITE_NOMEM.
+*/
+int sqlite3VdbeBatchOpen(sqlite3 *db, VdbeCursor *pC, int nVec){
+  VdbeBatch *pBatch;
+  int nHdr;                       /* Bytes of VdbeBatch, rounded up */
+  int i;
+  u8 *z;
+
+  if( nVec<1 ) nVec = 1;
+  if( pC->pBatch ){
+    sqlite3VdbeBatchFree(db, pC->pBatch);
+    pC->pBatch = 0;
+  }
+  nHdr = ROUND8(sizeof(VdbeBatch) + (nVec-1)*sizeof(VdbeVector));
+  pBatch = (VdbeBatch*)sqlite3DbMallocZero(db, nHdr + SQLITE_BATCH_SIZE * (
+        nVec*(sizeof(i64) + sizeof(double) + sizeof(u8)) + sizeof(u8)
+  ));
+  if( pBatch==0 ) return SQLITE_NOMEM_BKPT;
+  pBatch->nVec = nVec;
+  z = &((u8*)pBatch)[nHdr];
+  for(i=0; i<nVec; i++){
+    pBatch->aVec[i].aInt = (i64*)z;
+    z += SQLITE_BATCH_SIZE*sizeof(i64);
+    pBatch->aVec[i].aReal = (double*)z;
+    z += SQLITE_BATCH_SIZE*sizeof(double);
+  }
+  for(i=0; i<nVec; i++){
+    pBatch->aVec[i].aType = z;
+    z += SQLITE_BATCH_SIZE;
+  }
+  pBatch->aSel = z;
+  pC->pBatch = pBatch;
+  return SQLITE_OK;
+}
+
+/*
+** Allocate the aMem[] array of vector pVec, if it has not already been.
+*/
+static int batchAllocMem(sqlite3 *db, VdbeVector *pVec){
+  if( pVec->aMem==0 ){
+    int i;
+    pVec->aMem = sqlite3DbMallocRawNN(db, SQLITE_BATCH_SIZE*sizeof(Mem));
+    if( pVec->aMem==0 ) return SQLITE_NOMEM_BKPT;
+    for(i=0; i<SQLITE_BATCH_SIZE; i++){
+      sqlite3VdbeMemInit(&pVec->aMem[i], db, MEM_Null);
+    }
+  }
+  return SQLITE_OK;
+}
+
+/*
+** Decode the numeric field of serial type t (which must be between 1
+** and 9) at a into *piVal or *prVal.  Return SQLITE_INTEGER, SQLITE_FLOAT
+** or, for a NaN, SQLITE_NULL.  This is the numeric part of
+** sqlite3VdbeSerialGet() without the Mem, as the batch loader calls it
+** for every field it reads.
+*/
+static int batchSerialNumber(const u8 *a, u32 t, i64 *piVal, double *prVal){
+  u64 x;
+  u32 y;
+  switch( t ){
+    case 1: *piVal = ONE_BYTE_INT(a);    return SQLITE_INTEGER;
+    case 2: *piVal = TWO_BYTE_INT(a);    return SQLITE_INTEGER;
+    case 3: *piVal = THREE_BYTE_INT(a);  return SQLITE_INTEGER;
+    case 4: *piVal = FOUR_BYTE_INT(a);   return SQLITE_INTEGER;
+    case 5:
+      *piVal = FOUR_BYTE_UINT(a+2) + (((i64)1)<<32)*TWO_BYTE_INT(a);
+      return SQLITE_INTEGER;
+    case 8: *piVal = 0;                  return SQLITE_INTEGER;
+    case 9: *piVal = 1;                  return SQLITE_INTEGER;
+  }
+  assert( t==6 || t==7 );
+  x = FOUR_BYTE_UINT(a);
+  y = FOUR_BYTE_UINT(a+4);
+  x = (x<<32) | y;
+  if( t==6 ){
+    *piVal = (i64)x;
+    return SQLITE_INTEGER;
+  }
+#ifdef SQLITE_MIXED_ENDIAN_64BIT_FLOAT
+  {
+    Mem sVal;
+    sVal.flags = MEM_Null;
+    sqlite3VdbeSerialGet(a, t, &sVal);
+    if( (sVal.flags & MEM_Real)==0 ) return SQLITE_NULL;
+    *prVal = sVal.u.r;
+  }
+#else
+  /* A NaN has all exponent bits set and a non-zero mantissa */
+  if( (x & (((u64)0x7ff)<<52))==(((u64)0x7ff)<<52)
+   && (x & ((((u64)1)<<52)-1))!=0
+  ){
+    return SQLITE_NULL;
+  }
+  assert( sizeof(x)==8 && sizeof(*prVal)==8 );
+  memcpy(prVal, &x, sizeof(x));
+#endif
+  return SQLITE_FLOAT;
+}
+
+/*
+** Read up to SQLITE_BATCH_SIZE rows into the batch of table cursor pC,
+** starting with the row that the cursor points to.  The cursor is left
+** pointing at the first row that was not read, or with pC->nullRow set
+** if the end of the table was reached.
+**
+** aiCol[] is the P4 array of OP_BatchLoad.  aiCol[0] is one more than
+** twice the number of columns to load.  It is followed by one pair of
+** integers for each column: the index of the column in the table
+** (or -1 for the rowid) and a mask of BATCHCOL_* flags.  Column j is
+** loaded into vector j of the batch.  Pairs are sorted in order of
+** increasing column index, so that the header of each record need only
+** be parsed once.
+*/
+int sqlite3VdbeBatchLoad(Vdbe *p, VdbeCursor *pC, const int *aiCol){
+  sqlite3 *db = p->db;
+  VdbeBatch *pBatch = pC->pBatch;
+  BtCursor *pCrsr = pC->uc.pCursor;
+  int nCol = (aiCol[0]-1)/2;      /* Number of columns to load */
+  u8 enc = ENC(db);
+  int nRow = 0;                   /* Rows loaded so far */
+  int rc = SQLITE_OK;
+  int res = 0;
+  Mem sRec;                       /* Record that is not all on one page */
+
+  assert( pC->eCurType==CURTYPE_BTREE && pC->isTable );
+  assert( pBatch && nCol<=pBatch->nVec );
+  assert( pC->nullRow==0 );
+  sqlite3VdbeMemInit(&sRec, db, MEM_Null);
+
+  while( nRow<SQLITE_BATCH_SIZE ){
+    const u8 *aRow;               /* The record */
+    u32 nPayload;                 /* Size of the record in bytes */
+    u32 nAvail;                   /* Bytes of the record on the leaf page */
+    u32 szHdr = 0;                /* Size of the record header */
+    u32 iHdr = 0;                 /* Offset of the next serial type */
+    u64 iOff;                     /* Offset of the next field */
+    u32 t = 0;                    /* Serial type of a field */
+    int iField = 0;               /* Index of the next field */
+    int j;
+
+    sqlite3BtreeDataSize(pCrsr, &nPayload);
+    aRow = (const u8*)sqlite3BtreeDataFetch(pCrsr, &nAvail);
+    if( nAvail<nPayload ){
+      if( nPayload>(u32)db->aLimit[SQLITE_LIMIT_LENGTH] ){
+        rc = SQLITE_TOOBIG;
+        break;
+      }
+      rc = sqlite3VdbeMemFromBtree(pCrsr, 0, nPayload, 0, &sRec);
+      if( rc ) break;
+      aRow = (const u8*)sRec.z;
+    }
+    if( nPayload>0 ){
+      iHdr = getVarint32(aRow, szHdr);
+      if( szHdr>98307 || szHdr>nPayload || szHdr<iHdr ){
+        rc = SQLITE_CORRUPT_BKPT;
+        break;
+      }
+    }
+    iOff = szHdr;
+
+    for(j=0; j<nCol; j++){
+      int iCol = aiCol[1+j*2];
+      int flags = aiCol[2+j*2];
+      VdbeVector *pVec = &pBatch->aVec[j];
+      u32 len;
+
+      assert( j==0 || iCol>aiCol[j*2-1] );
+      if( iCol<0 ){
+        sqlite3BtreeKeySize(pCrsr, &pVec->aInt[nRow]);
+        pVec->aType[nRow] = SQLITE_INTEGER;
+        continue;
+      }
+      while( iField<iCol && iHdr<szHdr ){
+        iHdr += getVarint32(&aRow[iHdr], t);
+        iOff += t<128 ? sqlite3SmallTypeSizes[t] : (t-12)/2;
+        iField++;
+      }
+      if( iHdr>=szHdr ){
+        /* The record has fewer fields than the table has columns.  This
+        ** happens after ALTER TABLE ADD COLUMN.  Columns with a default
+        ** value other than NULL are not loaded in batches. */
+        pVec->aType[nRow] = SQLITE_NULL;
+        continue;
+      }
+      iHdr += getVarint32(&aRow[iHdr], t);
+      len = t<128 ? sqlite3SmallTypeSizes[t] : (t-12)/2;
+      if( iHdr>szHdr || iOff+len>nPayload ){
+        rc = SQLITE_CORRUPT_BKPT;
+        goto batch_load_out;
+      }
+      if( t<12 ){
+        int eType = SQLITE_NULL;
+        if( t>=1 && t<=9 ){
+          eType = batchSerialNumber(&aRow[iOff], t,
+                                    &pVec->aInt[nRow], &pVec->aReal[nRow]);
+          if( eType==SQLITE_INTEGER && (flags & BATCHCOL_REAL) ){
+            pVec->aReal[nRow] = (double)pVec->aInt[nRow];
+            eType = SQLITE_FLOAT;
+          }
+        }
+        pVec->aType[nRow] = (u8)eType;
+      }else{
+        pVec->aType[nRow] = (t & 1) ? SQLITE_TEXT : SQLITE_BLOB;
+        if( flags & BATCHCOL_VALUE ){
+          rc = batchAllocMem(db, pVec);
+          if( rc==SQLITE_OK ){
+            rc = sqlite3VdbeMemSetStr(&pVec->aMem[nRow], (const char*)&aRow[iOff],
+                len, (t & 1) ? enc : 0, SQLITE_TRANSIENT
+            );
+          }
+          if( rc ) goto batch_load_out;
+          pVec->aMem[nRow].enc = enc;
+        }
+      }
+      iOff += len;
+      iField++;
+    }
+
+    pBatch->aSel[nRow] = 1;
+    nRow++;
+    rc = sqlite3BtreeNext(pCrsr, &res);
+    if( rc ) break;
+    if( res ){
+      pC->nullRow = 1;
+      break;
+    }
+  }
+
+batch_load_out:
+  sqlite3VdbeMemRelease(&sRec);
+  pC->cacheStatus = CACHE_STALE;
+  pBatch->nRow = nRow;
+  p->aCounter[SQLITE_STMTSTATUS_FULLSCAN_STEP] += nRow - pC->nullRow;
+  return rc;
+}
+
+/*
+** Set every row of vector iVec to the value of pVal, which must be
+** an integer, a real or NULL.
+*/
+void sqlite3VdbeBatchConst(VdbeBatch *pBatch, int iVec, Mem *pVal){
+  VdbeVector *pVec = &pBatch->aVec[iVec];
+  int i;
+  assert( iVec>=0 && iVec<pBatch->nVec );
+  assert( (pVal->flags & (MEM_Str|MEM_Blob))==0
+       || (pVal->flags & (MEM_Int|MEM_Real|MEM_Null))!=0 );
+  if( pVal->flags & MEM_Int ){
+    memset(pVec->aType, SQLITE_INTEGER, SQLITE_BATCH_SIZE);
+    for(i=0; i<SQLITE_BATCH_SIZE; i++) pVec->aInt[i] = pVal->u.i;
+  }else if( pVal->flags & MEM_Real ){
+    memset(pVec->aType, SQLITE_FLOAT, SQLITE_BATCH_SIZE);
+    for(i=0; i<SQLITE_BATCH_SIZE; i++) pVec->aReal[i] = pVal->u.r;
+  }else{
+    memset(pVec->aType, SQLITE_NULL, SQLITE_BATCH_SIZE);
+  }
+}
+
+/*
+** Deselect each row of the batch for which the comparison
+** "vector iVec <op> pVal" is not true.  op is one of OP_Eq, OP_Ne,
+** OP_Lt, OP_Le, OP_Gt or OP_Ge and pVal holds a number or NULL.  The
+** comparison is done as for a column of numeric affinity: NULL values
+** never compare true, and text and blob values are greater than any
+** number.
+*/
+void sqlite3VdbeBatchFilter(VdbeBatch *pBatch, int iVec, Mem *pVal, int op){
+  VdbeVector *pVec = &pBatch->aVec[iVec];
+  const u8 *aType = pVec->aType;
+  u8 *aSel = pBatch->aSel;
+  int nRow = pBatch->nRow;
+  u8 mask;                        /* Bit c+1 set if comparison result c ok */
+  i64 iVal = 0;
+  double rVal = 0.0;
+  int bInt;
+  int i;
+
+  switch( op ){
+    case OP_Eq:  mask = 0x02;  break;
+    case OP_Ne:  mask = 0x05;  break;
+    case OP_Lt:  mask = 0x01;  break;
+    case OP_Le:  mask = 0x03;  break;
+    case OP_Gt:  mask = 0x04;  break;
+    default:     mask = 0x06;  assert( op==OP_Ge );  break;
+  }
+  if( pVal->flags & MEM_Null ){
+    memset(aSel, 0, nRow);
+    return;
+  }
+  bInt = (pVal->flags & MEM_Int)!=0;
+  if( bInt ){
+    iVal = pVal->u.i;
+  }else{
+    assert( pVal->flags & MEM_Real );
+    rVal = pVal->u.r;
+  }
+
+  for(i=0; i<nRow; i++){
+    int c;
+    switch( aType[i] ){
+      case SQLITE_INTEGER: {
+        i64 v = pVec->aInt[i];
+        c = bInt ? (v>iVal) - (v<iVal) : sqlite3IntFloatCompare(v, rVal);
+        break;
+      }
+      case SQLITE_FLOAT: {
+        double r = pVec->aReal[i];
+        c = bInt ? -sqlite3IntFloatCompare(iVal, r) : (r>rVal) - (r<rVal);
+        break;
+      }
+      case SQLITE_NULL: {
+        aSel[i] = 0;
+        continue;
+      }
+      default: {
+        c = 1;
+        break;
+      }
+    }
+    aSel[i] &= (mask >> (c+1)) & 1;
+  }
+}
+
+/*
+** Load row i of vector pVec into Mem object pMem, which must have been
+** initialized by the caller.  Text and blob values are shallow copies.
+*/
+static void batchValue(VdbeVector *pVec, int i, Mem *pMem){
+  switch( pVec->aType[i] ){
+    case SQLITE_INTEGER:  sqlite3VdbeMemSetInt64(pMem, pVec->aInt[i]);   break;
+    case SQLITE_FLOAT:    sqlite3VdbeMemSetDouble(pMem, pVec->aReal[i]); break;
+    case SQLITE_NULL:     sqlite3VdbeMemSetNull(pMem);                   break;
+    default: {
+      assert( pVec->aMem!=0 );
+      pMem->db = pVec->aMem[i].db;
+      sqlite3VdbeMemShallowCopy(pMem, &pVec->aMem[i], MEM_Ephem);
+      break;
+    }
+  }
+}
+
+/*
+** Return the numeric type of pMem, as numericType() in vdbe.c does.
+*/
+static u16 batchNumericType(Mem *pMem){
+  if( pMem->flags & (MEM_Int|MEM_Real) ){
+    return pMem->flags & (MEM_Int|MEM_Real);
+  }
+  if( pMem->flags & (MEM_Str|MEM_Blob) ){
+    if( sqlite3AtoF(pMem->z, &pMem->u.r, pMem->n, pMem->enc)==0 ){
+      return 0;
+    }
+    if( sqlite3Atoi64(pMem->z, &pMem->u.i, pMem->n, pMem->enc)==SQLITE_OK ){
+      return MEM_Int;
+    }
+    return MEM_Real;
+  }
+  return 0;
+}
+
+/*
+** Compute row i of vector pOut as "pLeft <op> pRight", where at least one
+** of the operands is text or a blob.  This follows the OP_Add, OP_Subtract,
+** OP_Multiply and OP_Divide opcodes exactly.
+*/
+static void batchArithMem(
+  int op,                         /* OP_Add, OP_Subtract etc. */
+  Mem *pLeft,                     /* Left operand */
+  Mem *pRight,                    /* Right operand */
+  VdbeVector *pOut,               /* Write the result to this vector */
+  int i                           /* Row of pOut to write */
+){
+  u16 type1 = batchNumericType(pRight);
+  u16 type2 = batchNumericType(pLeft);
+  int bIntint = 0;
+  double rA, rB;
+  Mem sOut;
+
+  if( (type1 & type2 & MEM_Int)!=0 ){
+    i64 iA = pRight->u.i;
+    i64 iB = pLeft->u.i;
+    bIntint = 1;
+    switch( op ){
+      case OP_Add:       if( sqlite3AddInt64(&iB,iA) ) goto fp_math;  break;
+      case OP_Subtract:  if( sqlite3SubInt64(&iB,iA) ) goto fp_math;  break;
+      case OP_Multiply:  if( sqlite3MulInt64(&iB,iA) ) goto fp_math;  break;
+      default: {
+        assert( op==OP_Divide );
+        if( iA==0 ) goto arith_null;
+        if( iA==-1 && iB==SMALLEST_INT64 ) goto fp_math;
+        iB /= iA;
+        break;
+      }
+    }
+    pOut->aInt[i] = iB;
+    pOut->aType[i] = SQLITE_INTEGER;
+    return;
+  }
+
+fp_math:
+  rA = sqlite3VdbeRealValue(pRight);
+  rB = sqlite3VdbeRealValue(pLeft);
+  switch( op ){
+    case OP_Add:         rB += rA;       break;
+    case OP_Subtract:    rB -= rA;       break;
+    case OP_Multiply:    rB *= rA;       break;
+    default: {
+      if( rA==(double)0 ) goto arith_null;
+      rB /= rA;
+      break;
+    }
+  }
+  if( sqlite3IsNaN(rB) ) goto arith_null;
+  if( ((type1|type2)&MEM_Real)==0 && !bIntint ){
+    sqlite3VdbeMemInit(&sOut, 0, MEM_Real);
+    sOut.u.r = rB;
+    sqlite3VdbeIntegerAffinity(&sOut);
+    if( sOut.flags & MEM_Int ){
+      pOut->aInt[i] = sOut.u.i;
+      pOut->aType[i] = SQLITE_INTEGER;
+      return;
+    }
+  }
+  pOut->aReal[i] = rB;
+  pOut->aType[i] = SQLITE_FLOAT;
+  return;
+
+arith_null:
+  pOut->aType[i] = SQLITE_NULL;
+}
+
+/*
+** Set each selected row of vector iOut to "vector iLeft <op> vector
+** iRight", where op is one of OP_Add, OP_Subtract, OP_Multiply or OP_Divide.
+** Rows that are not selected are set to NULL.
+*/
+void sqlite3VdbeBatchArith(
+  VdbeBatch *pBatch,
+  int iLeft,
+  int iRight,
+  int iOut,
+  int op
+){
+  VdbeVector *pL = &pBatch->aVec[iLeft];
+  VdbeVector *pR = &pBatch->aVec[iRight];
+  VdbeVector *pOut = &pBatch->aVec[iOut];
+  const u8 *aSel = pBatch->aSel;
+  int nRow = pBatch->nRow;
+  int i;
+
+  assert( op==OP_Add || op==OP_Subtract || op==OP_Multiply || op==OP_Divide );
+  assert( iOut!=iLeft && iOut!=iRight );
+  for(i=0; i<nRow; i++){
+    u8 tL = pL->aType[i];
+    u8 tR = pR->aType[i];
+    double rL, rR;
+    if( aSel[i]==0 || tL==SQLITE_NULL || tR==SQLITE_NULL ){
+      pOut->aType[i] = SQLITE_NULL;
+      continue;
+    }
+    if( tL==SQLITE_INTEGER && tR==SQLITE_INTEGER ){
+      i64 iB = pL->aInt[i];
+      i64 iA = pR->aInt[i];
+      switch( op ){
+        case OP_Add:       if( sqlite3AddInt64(&iB,iA) ) goto int_overflow; break;
+        case OP_Subtract:  if( sqlite3SubInt64(&iB,iA) ) goto int_overflow; break;
+        case OP_Multiply:  if( sqlite3MulInt64(&iB,iA) ) goto int_overflow; break;
+        default: {
+          if( iA==0 ){
+            pOut->aType[i] = SQLITE_NULL;
+            continue;
+          }
+          if( iA==-1 && iB==SMALLEST_INT64 ) goto int_overflow;
+          iB /= iA;
+          break;
+        }
+      }
+      pOut->aInt[i] = iB;
+      pOut->aType[i] = SQLITE_INTEGER;
+      continue;
+ int_overflow:
+      rL = (double)pL->aInt[i];
+      rR = (double)pR->aInt[i];
+    }else if( tL<=SQLITE_FLOAT && tR<=SQLITE_FLOAT ){
+      rL = tL==SQLITE_INTEGER ? (double)pL->aInt[i] : pL->aReal[i];
+      rR = tR==SQLITE_INTEGER ? (double)pR->aInt[i] : pR->aReal[i];
+    }else{
+      Mem sLeft, sRight;
+      sqlite3VdbeMemInit(&sLeft, 0, MEM_Null);
+      sqlite3VdbeMemInit(&sRight, 0, MEM_Null);
+      batchValue(pL, i, &sLeft);
+      batchValue(pR, i, &sRight);
+      batchArithMem(op, &sLeft, &sRight, pOut, i);
+      continue;
+    }
+    switch( op ){
+      case OP_Add:         rL += rR;       break;
+      case OP_Subtract:    rL -= rR;       break;
+      case OP_Multiply:    rL *= rR;       break;
+      default: {
+        if( rR==(double)0 ){
+          pOut->aType[i] = SQLITE_NULL;
+          continue;
+        }
+        rL /= rR;
+        break;
+      }
+    }
+    if( sqlite3IsNaN(rL) ){
+      pOut->aType[i] = SQLITE_NULL;
+    }else{
+      pOut->aReal[i] = rL;
+      pOut->aType[i] = SQLITE_FLOAT;
+    }
+  }
+}
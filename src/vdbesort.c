@@ -75,6 +75,12 @@
 ** and subsequent calls to Rowkey(), Next() and Compare() read records 
 ** directly from main memory.
 **
+** Where the collation sequences allow it, each record is given a fixed
+** width "normalized prefix" of its first one or two key fields, which
+** compares as unsigned integers in the same order as the fields do.  The
+** in-memory sort then sorts an array of these prefixes, and the records
+** themselves are only compared when two prefixes are equal.
+**
 ** If the amount of space used to store records in main memory exceeds the
 ** threshold, then the set of records currently in memory are sorted and
 ** written to a temporary file in "Packed Memory Array" (PMA) format.
@@ -165,6 +171,12 @@ typedef struct SortSubtask SortSubtask;     /* A sub-task in the sort process */
 typedef struct SorterFile SorterFile;       /* Temporary file object wrapper */
 typedef struct SorterList SorterList;       /* In-memory list of records */
 typedef struct IncrMerger IncrMerger;       /* Read & merge multiple PMAs */
+typedef struct SorterKey SorterKey;         /* Normalized prefix of a key */
+
+/*
+** Maximum number of leading key fields with normalized key prefixes
+*/
+#define SORTER_MAX_PREFIX 2
 
 /*
 ** A container for a temp file handle and the current amount of data 
@@ -332,12 +344,47 @@ struct VdbeSorter {
   u8 iPrev;                       /* Previous thread used to flush PMA */
   u8 nTask;                       /* Size of aTask[] array */
   u8 typeMask;
+  u8 nPrefix;                     /* Key fields with normalized prefixes */
+  u8 aPrefix[SORTER_MAX_PREFIX];  /* SORTER_PREFIX_* flags for each field */
   SortSubtask aTask[1];           /* One or more subtasks */
 };
 
 #define SORTER_TYPE_INTEGER 0x01
 #define SORTER_TYPE_TEXT    0x02
 
+/*
+** Flags for the VdbeSorter.aPrefix[] entry of a key field that has a
+** normalized prefix.  See vdbeSorterSortKeys() for details.
+*/
+#define SORTER_PREFIX_DESC   0x01   /* Field sorts in descending order */
+#define SORTER_PREFIX_NOCASE 0x02   /* Text of the field is NOCASE */
+
+/*
+** The normalized prefixes of the first VdbeSorter.nPrefix key fields of
+** record pRec.  An array of these is sorted by vdbeSorterSortKeys(), and
+** each PmaReader of a MergeEngine holds one for its current key, with
+** pRec set to NULL.
+**
+** The normalized prefix of a field is its storage class in aClass[] and
+** a 64-bit key in aKey[].  Comparing two fields by (aClass, aKey), as
+** unsigned integers, gives the same result as comparing the values
+** themselves, except that values with the same prefix may still differ.
+** If bit i of bExact is set, the prefix of field i holds the complete
+** value, so that two values whose prefixes are equal and exact are equal.
+*/
+struct SorterKey {
+  u64 aKey[SORTER_MAX_PREFIX];    /* Normalized keys of the fields */
+  SorterRecord *pRec;             /* The record */
+  u8 aClass[SORTER_MAX_PREFIX];   /* Storage classes of the fields */
+  u8 bExact;                      /* Mask of fields with exact prefixes */
+};
+
+/*
+** Value returned by vdbeSorterPrefixCompare() if the normalized prefixes
+** of two records do not decide how they compare.
+*/
+#define SORTER_PREFIX_TIE 2
+
 /*
 ** An instance of the following object is used to read records out of a
 ** PMA, in sorted order.  The next key to be read is cached in nKey/aKey.
@@ -359,6 +406,7 @@ struct PmaReader {
   int nBuffer;                /* Size of read buffer in bytes */
   u8 *aMap;                   /* Pointer to mapping of entire file */
   IncrMerger *pIncr;          /* Incremental merger */
+  SorterKey key;              /* Normalized prefix of aKey, if in a merger */
 };
 
 /*
@@ -1011,6 +1059,23 @@ int sqlite3VdbeSorterInit(
     ){
       pSorter->typeMask = SORTER_TYPE_INTEGER | SORTER_TYPE_TEXT;
     }
+
+    /* Find the leading key fields that can be given normalized prefixes.
+    ** That is only possible if the text of each is compared using BINARY
+    ** or the built-in NOCASE collation, as UTF-8. */
+    if( ENC(db)==SQLITE_UTF8 ){
+      for(i=0; i<SORTER_MAX_PREFIX && i<pKeyInfo->nField; i++){
+        CollSeq *pColl = pKeyInfo->aColl[i];
+        u8 flags = pKeyInfo->aSortOrder[i] ? SORTER_PREFIX_DESC : 0;
+        if( sqlite3IsNocase(pColl) ){
+          flags |= SORTER_PREFIX_NOCASE;
+        }else if( pColl!=0 && pColl!=db->pDfltColl ){
+          break;
+        }
+        pSorter->aPrefix[i] = flags;
+        pSorter->nPrefix = (u8)(i+1);
+      }
+    }
   }
 
   return rc;
@@ -1380,10 +1445,303 @@ static SorterCompare vdbeSorterGetCompare(VdbeSorter *p){
   return vdbeSorterCompare;
 }
 
+/*
+** Arrays of at most this many SorterKey entries are sorted using an
+** insertion sort by vdbeSorterKeySort().
+*/
+#define SORTER_KEY_INSERTION 12
+
+#ifndef SQLITE_MIXED_ENDIAN_64BIT_FLOAT
+/*
+** Return the normalized key of a REAL value, given the 64 bits of its
+** IEEE 754 representation.  The order of the keys as unsigned integers
+** is the numeric order of the values.
+*/
+static u64 vdbeSorterRealKey(u64 x){
+  if( x==((u64)1)<<63 ) x = 0;    /* -0.0 is equal to +0.0 */
+  return (x & (((u64)1)<<63)) ? ~x : (x | (((u64)1)<<63));
+}
+#endif
+
+/*
+** Fill in the normalized prefix of field iField of pKey.  The serial
+** type of the field is t, its content is at a[].  flags is the
+** SORTER_PREFIX_* flags of the field.
+**
+** Storage classes are numbered in the order in which SQLite sorts them:
+** NULL, numeric, text and blob.  Numeric values are converted to REAL,
+** so that INTEGER and REAL values may be compared.  An INTEGER has an
+** exact key only if the conversion is exact.  Text and blob keys hold
+** the first 7 bytes of the value, followed by a byte set to the size
+** of the value, or to 8 if it is larger than that.  The bytes of NOCASE
+** text are folded to lower case, and bytes after the first 0x00 byte
+** are zero, as sqlite3StrNICmp() ignores them.
+**
+** For a descending field both the storage class and the key are
+** inverted.
+*/
+static void vdbeSorterFieldPrefix(
+  SorterKey *pKey,                /* Set the prefix of this entry */
+  int iField,                     /* Field number */
+  u32 t,                          /* Serial type of the field */
+  const u8 *a,                    /* Content of the field */
+  u8 flags                        /* SORTER_PREFIX_* flags of the field */
+){
+  u64 iKey = 0;
+  u8 eClass;
+  int bExact = 1;
+
+  if( t==0 ){
+    eClass = 0;
+  }else if( t<=9 ){
+    eClass = 1;
+#ifdef SQLITE_MIXED_ENDIAN_64BIT_FLOAT
+    bExact = 0;
+#else
+    if( t==7 ){
+      iKey = vdbeSorterRealKey(
+          ((u64)FOUR_BYTE_UINT(a)<<32) | (u64)FOUR_BYTE_UINT(a+4)
+      );
+    }else{
+      i64 v;
+      double r;
+      u64 x;
+      switch( t ){
+        case 1: v = ONE_BYTE_INT(a);    break;
+        case 2: v = TWO_BYTE_INT(a);    break;
+        case 3: v = THREE_BYTE_INT(a);  break;
+        case 4: v = FOUR_BYTE_INT(a);   break;
+        case 5: v = FOUR_BYTE_UINT(a+2) + (((i64)1)<<32)*TWO_BYTE_INT(a);
+                break;
+        case 6: v = (i64)(((u64)FOUR_BYTE_UINT(a)<<32)|FOUR_BYTE_UINT(a+4));
+                break;
+        default: v = t-8;               break;
+      }
+      r = (double)v;
+      memcpy(&x, &r, sizeof(x));
+      iKey = vdbeSorterRealKey(x);
+      bExact = (v>=-(((i64)1)<<53) && v<=(((i64)1)<<53));
+    }
+#endif
+  }else{
+    int n = (t-12)/2;
+    int nCopy = MIN(n, 7);
+    int i;
+    eClass = (t & 1) ? 2 : 3;
+    if( eClass==2 && (flags & SORTER_PREFIX_NOCASE) ){
+      for(i=0; i<nCopy && a[i]; i++){
+        iKey |= (u64)sqlite3UpperToLower[a[i]] << (56 - 8*i);
+      }
+    }else{
+      for(i=0; i<nCopy; i++){
+        iKey |= (u64)a[i] << (56 - 8*i);
+      }
+    }
+    if( n<=7 ){
+      iKey |= (u64)n;
+    }else{
+      iKey |= 8;
+      bExact = 0;
+    }
+  }
+
+  if( flags & SORTER_PREFIX_DESC ){
+    eClass = ~eClass;
+    iKey = ~iKey;
+  }
+  pKey->aClass[iField] = eClass;
+  pKey->aKey[iField] = iKey;
+  if( bExact ) pKey->bExact |= (u8)(1<<iField);
+}
+
+/*
+** Initialize pKey with the normalized prefixes of record a[].  pKey->pRec
+** is not changed.
+*/
+static void vdbeSorterKeyInit(
+  VdbeSorter *pSorter,            /* Sorter that owns the record */
+  SorterKey *pKey,                /* Entry to initialize */
+  const u8 *a                     /* The record */
+){
+  u32 szHdr;
+  u32 iHdr;
+  u32 iData;
+  int i;
+
+  pKey->bExact = 0;
+  iHdr = getVarint32(a, szHdr);
+  iData = szHdr;
+  for(i=0; i<pSorter->nPrefix; i++){
+    u32 t;
+    iHdr += getVarint32(&a[iHdr], t);
+    vdbeSorterFieldPrefix(pKey, i, t, &a[iData], pSorter->aPrefix[i]);
+    iData += sqlite3VdbeSerialTypeLen(t);
+  }
+}
+
+/*
+** Compare the normalized prefixes p1 and p2 of two records.  Return -1
+** or +1 if the first record is smaller or larger than the second, or 0 if
+** the prefixes show that they are equal.  Return SORTER_PREFIX_TIE if the
+** records themselves must be compared.
+*/
+static int vdbeSorterPrefixCompare(
+  const VdbeSorter *pSorter,      /* Sorter that owns the records */
+  const SorterKey *p1,            /* Left side of comparison */
+  const SorterKey *p2             /* Right side of comparison */
+){
+  int i;
+  for(i=0; i<pSorter->nPrefix; i++){
+    if( p1->aClass[i]!=p2->aClass[i] ){
+      return p1->aClass[i]<p2->aClass[i] ? -1 : +1;
+    }
+    if( p1->aKey[i]!=p2->aKey[i] ){
+      return p1->aKey[i]<p2->aKey[i] ? -1 : +1;
+    }
+    if( ((p1->bExact & p2->bExact) & (1<<i))==0 ) break;
+  }
+  return i==pSorter->pKeyInfo->nField ? 0 : SORTER_PREFIX_TIE;
+}
+
+/*
+** Compare the records of entries p1 and p2.  The records themselves are
+** only compared, using pTask->xCompare, if the normalized prefixes do not
+** decide the comparison.
+**
+** *pbKey2Cached is passed through to pTask->xCompare.
+*/
+static int vdbeSorterKeyCompare(
+  SortSubtask *pTask,             /* Subtask context (for pKeyInfo) */
+  int *pbKey2Cached,              /* True if pTask->pUnpacked is p2 */
+  const SorterKey *p1,            /* Left side of comparison */
+  const SorterKey *p2             /* Right side of comparison */
+){
+  int res = vdbeSorterPrefixCompare(pTask->pSorter, p1, p2);
+  if( res==SORTER_PREFIX_TIE ){
+    res = pTask->xCompare(pTask, pbKey2Cached,
+        SRVAL(p1->pRec), p1->pRec->nVal, SRVAL(p2->pRec), p2->pRec->nVal
+    );
+  }
+  return res;
+}
+
+/*
+** Sort the n entries of array a[] using a stable merge sort.  aTmp[] is
+** space for at least n/2 entries.
+*/
+static void vdbeSorterKeySort(
+  SortSubtask *pTask,             /* Calling thread context */
+  SorterKey *a,                   /* Array to sort */
+  SorterKey *aTmp,                /* Temporary space */
+  int n                           /* Number of entries in a[] */
+){
+  if( n<=SORTER_KEY_INSERTION ){
+    int i, j;
+    for(i=1; i<n; i++){
+      SorterKey x = a[i];
+      int bCached = 0;
+      for(j=i; j>0; j--){
+        if( vdbeSorterKeyCompare(pTask, &bCached, &a[j-1], &x)<=0 ) break;
+        a[j] = a[j-1];
+      }
+      a[j] = x;
+    }
+  }else{
+    int nLeft = n/2;
+    int bCached = 0;
+    vdbeSorterKeySort(pTask, a, aTmp, nLeft);
+    vdbeSorterKeySort(pTask, &a[nLeft], aTmp, n-nLeft);
+
+    /* Merge the two halves, unless they are already in order.  The left
+    ** half is moved to aTmp[] first.  Then the merged output never
+    ** overtakes the unmerged part of the right half. */
+    if( vdbeSorterKeyCompare(pTask, &bCached, &a[nLeft-1], &a[nLeft])>0 ){
+      SorterKey *pL = aTmp;
+      SorterKey *pLEnd = &aTmp[nLeft];
+      SorterKey *pR = &a[nLeft];
+      SorterKey *pREnd = &a[n];
+      SorterKey *pOut = a;
+      memcpy(aTmp, a, nLeft*sizeof(SorterKey));
+      bCached = 0;
+      while( pL<pLEnd && pR<pREnd ){
+        if( vdbeSorterKeyCompare(pTask, &bCached, pL, pR)<=0 ){
+          *pOut++ = *pL++;
+        }else{
+          *pOut++ = *pR++;
+          bCached = 0;
+        }
+      }
+      while( pL<pLEnd ) *pOut++ = *pL++;
+    }
+  }
+}
+
+/*
+** Try to sort the list of records pList by their normalized key
+** prefixes.  The records are copied to an array of SorterKey entries in
+** the order in which they were written to the sorter, the array is
+** sorted, and the records are relinked in order.  As the merge sort is
+** stable, records that compare equal remain in the order they were
+** written in, as they do if vdbeSorterSort() sorts the list itself.
+**
+** Most comparisons are decided by the prefixes alone, held in a compact
+** array, without decoding the records.  Return non-zero if the list was
+** sorted.  Return zero, with the list unchanged, if the sorter's keys
+** have no normalized prefixes or if the array cannot be allocated.
+*/
+static int vdbeSorterSortKeys(SortSubtask *pTask, SorterList *pList){
+  VdbeSorter *pSorter = pTask->pSorter;
+  SorterKey *aKey;
+  SorterRecord *p;
+  i64 nKey = 0;
+  int i;
+
+  if( pSorter->nPrefix==0 ) return 0;
+  for(p=pList->pList; p; nKey++){
+    if( pList->aMemory ){
+      p = ((u8*)p==pList->aMemory) ? 0 :
+          (SorterRecord*)&pList->aMemory[p->u.iNext];
+    }else{
+      p = p->u.pNext;
+    }
+  }
+  if( nKey<2 ) return 0;
+  aKey = (SorterKey*)sqlite3Malloc((nKey + nKey/2) * sizeof(SorterKey));
+  if( aKey==0 ) return 0;
+
+  /* The list is in reverse order of insertion */
+  for(i=(int)nKey-1, p=pList->pList; i>=0; i--){
+    SorterRecord *pNext;
+    if( pList->aMemory ){
+      pNext = ((u8*)p==pList->aMemory) ? 0 :
+              (SorterRecord*)&pList->aMemory[p->u.iNext];
+    }else{
+      pNext = p->u.pNext;
+    }
+    aKey[i].pRec = p;
+    vdbeSorterKeyInit(pSorter, &aKey[i], (const u8*)SRVAL(p));
+    p = pNext;
+  }
+
+  vdbeSorterKeySort(pTask, aKey, &aKey[nKey], (int)nKey);
+
+  p = 0;
+  for(i=(int)nKey-1; i>=0; i--){
+    aKey[i].pRec->u.pNext = p;
+    p = aKey[i].pRec;
+  }
+  pList->pList = p;
+  sqlite3_free(aKey);
+  return 1;
+}
+
 /*
 ** Sort the linked list of records headed at pTask->pList. Return 
 ** SQLITE_OK if successful, or an SQLite error code (i.e. SQLITE_NOMEM) if 
 ** an error occurs.
+**
+** The list is sorted by vdbeSorterSortKeys() if possible.  Otherwise a
+** merge sort of the linked list itself is used.
 */
 static int vdbeSorterSort(SortSubtask *pTask, SorterList *pList){
   int i;
@@ -1396,6 +1754,9 @@ static int vdbeSorterSort(SortSubtask *pTask, SorterList *pList){
 
   p = pList->pList;
   pTask->xCompare = vdbeSorterGetCompare(pTask->pSorter);
+  if( vdbeSorterSortKeys(pTask, pList) ){
+    return pTask->pUnpacked->errCode;
+  }
 
   aSlot = (SorterRecord **)sqlite3MallocZero(64 * sizeof(SorterRecord *));
   if( !aSlot ){
@@ -1437,6 +1798,348 @@ static int vdbeSorterSort(SortSubtask *pTask, SorterList *pList){
   return pTask->pUnpacked->errCode;
 }
 
+#if SQLITE_MAX_WORKER_THREADS>0
+/*
+** Lists of at least this many bytes (in PMA format) are sorted by all
+** of the sorter's threads together when they are sorted in memory by
+** sqlite3VdbeSorterRewind().  Smaller lists are not worth the cost of
+** starting the threads.
+*/
+#ifndef SORTER_MIN_PARALLEL_SORT
+# define SORTER_MIN_PARALLEL_SORT (256*1024)
+#endif
+
+/*
+** One of the jobs of a parallel in-memory sort.  See vdbeSorterSortParallel()
+** for details.
+**
+** All jobs of a sort share aRec[], which holds a pointer to every record
+** being sorted, and the aiSplit[] array.  aiSplit[] has (nJob+1) entries
+** for each of the nJob chunks of aRec[]: entry (c*(nJob+1) + j) is the
+** index in aRec[] of the first record of chunk c that belongs to output
+** range j.  The first entry of each chunk is its first record, and the
+** last entry is one past its last record.
+*/
+typedef struct SortJob SortJob;
+struct SortJob {
+  SortSubtask *pTask;             /* Task that runs this job */
+  SorterRecord **aRec;            /* All records being sorted */
+  int *aiSplit;                   /* Output range boundaries of each chunk */
+  int nJob;                       /* Number of jobs (and chunks and ranges) */
+  int iJob;                       /* Index of this job */
+  SorterRecord *pOut;             /* Sorted output of this job */
+  int rc;                         /* Result of this job */
+};
+
+/*
+** Link records aRec[iFirst] to aRec[iEnd-1] into a list, in that order,
+** and return the head of the list.
+*/
+static SorterRecord *vdbeSorterLinkRecords(
+  SorterRecord **aRec,
+  int iFirst,
+  int iEnd
+){
+  SorterRecord *pHead = 0;
+  int i;
+  for(i=iEnd-1; i>=iFirst; i--){
+    aRec[i]->u.pNext = pHead;
+    pHead = aRec[i];
+  }
+  return pHead;
+}
+
+/*
+** Run the first phase of a parallel sort for job p: sort chunk p->iJob of
+** p->aRec[] in place.
+*/
+static void vdbeSorterSortChunk(SortJob *p){
+  int *aiSplit = &p->aiSplit[p->iJob * (p->nJob+1)];
+  int iFirst = aiSplit[0];
+  int iEnd = aiSplit[p->nJob];
+  SorterList list;
+  SorterRecord *pRec;
+  int i;
+
+  memset(&list, 0, sizeof(list));
+  list.pList = vdbeSorterLinkRecords(p->aRec, iFirst, iEnd);
+  p->rc = vdbeSorterSort(p->pTask, &list);
+  if( p->rc==SQLITE_OK ){
+    for(i=iFirst, pRec=list.pList; pRec; i++, pRec=pRec->u.pNext){
+      p->aRec[i] = pRec;
+    }
+    assert( i==iEnd );
+  }
+}
+
+/*
+** Run the second phase of a parallel sort for job p: merge the records of
+** output range p->iJob from all sorted chunks into list p->pOut.
+**
+** aRec[] is in the order of the sorter's list, newest record first, so
+** the chunks are taken last to first.  As vdbeSorterMerge() takes records
+** that compare equal from its first list first, they come out in the
+** order they were written in, as they do from vdbeSorterSort().
+*/
+static void vdbeSorterMergeRange(SortJob *p){
+  SorterRecord *apList[SORTER_MAX_MERGE_COUNT];
+  int nList = 0;
+  int c;
+
+  assert( p->nJob<=SORTER_MAX_MERGE_COUNT );
+  for(c=p->nJob-1; c>=0; c--){
+    int *aiSplit = &p->aiSplit[c * (p->nJob+1)];
+    int iFirst = aiSplit[p->iJob];
+    int iEnd = aiSplit[p->iJob+1];
+    if( iFirst<iEnd ){
+      apList[nList++] = vdbeSorterLinkRecords(p->aRec, iFirst, iEnd);
+    }
+  }
+
+  /* Merge the lists pairwise, halving their number each round */
+  while( nList>1 ){
+    int i;
+    for(i=0; i<nList; i+=2){
+      if( i+1<nList ){
+        vdbeSorterMerge(p->pTask, apList[i], apList[i+1], &apList[i/2]);
+      }else{
+        apList[i/2] = apList[i];
+      }
+    }
+    nList = (nList+1)/2;
+  }
+  p->pOut = nList ? apList[0] : 0;
+  p->rc = p->pTask->pUnpacked->errCode;
+}
+
+/*
+** The main routines for background threads that run the jobs of a
+** parallel sort.
+*/
+static void *vdbeSorterSortChunkThread(void *pCtx){
+  SortJob *p = (SortJob*)pCtx;
+  assert( p->pTask->bDone==0 );
+  vdbeSorterSortChunk(p);
+  p->pTask->bDone = 1;
+  return SQLITE_INT_TO_PTR(p->rc);
+}
+static void *vdbeSorterMergeRangeThread(void *pCtx){
+  SortJob *p = (SortJob*)pCtx;
+  assert( p->pTask->bDone==0 );
+  vdbeSorterMergeRange(p);
+  p->pTask->bDone = 1;
+  return SQLITE_INT_TO_PTR(p->rc);
+}
+
+/*
+** Run xJob for each of the nJob jobs in aJob[].  All but the last job
+** run in background threads, the last runs in the calling thread.  Return
+** SQLITE_OK if all jobs succeed, or an SQLite error code otherwise.
+*/
+static int vdbeSorterRunJobs(
+  SortJob *aJob,                  /* Jobs to run */
+  int nJob,                       /* Number of jobs in aJob[] */
+  void (*xJob)(SortJob*),         /* Job routine */
+  void *(*xThread)(void*)         /* Thread routine that calls xJob */
+){
+  int rc = SQLITE_OK;
+  int i;
+  for(i=0; i<nJob-1 && rc==SQLITE_OK; i++){
+    rc = vdbeSorterCreateThread(aJob[i].pTask, xThread, (void*)&aJob[i]);
+  }
+  if( rc==SQLITE_OK ){
+    xJob(&aJob[nJob-1]);
+    rc = aJob[nJob-1].rc;
+  }
+  for(i=0; i<nJob-1; i++){
+    int rc2 = vdbeSorterJoinThread(aJob[i].pTask);
+    if( rc==SQLITE_OK ) rc = rc2;
+  }
+  return rc;
+}
+
+/*
+** Sort the in-memory list pList of sorter pSorter using all of its
+** nTask threads.  This is used by sqlite3VdbeSorterRewind() in place of
+** vdbeSorterSort() when the list is large and the sorter has worker
+** threads, none of which can be running at that point.  Records that
+** compare equal keep the order they were written in, so the result is
+** the same as that of vdbeSorterSort() for any number of threads.
+**
+** The sort has two phases, each split into nTask jobs that run at the
+** same time:
+**
+**   1. The records are divided into nTask chunks of about the same size,
+**      and each job sorts one chunk using vdbeSorterSort().
+**
+**   2. nTask-1 splitter keys are sampled from the sorted chunks.  They
+**      divide the output into nTask ranges, and each chunk is divided at
+**      the splitters by binary search.  Each job then merges the parts
+**      of all chunks that fall in one range.  As the ranges are disjoint,
+**      the output of the sort is the output of the jobs, one after the
+**      other.  Records that compare equal always fall in the same range.
+**
+** If an error occurs, the records are left in pList, unsorted, and an
+** SQLite error code is returned.
+*/
+static int vdbeSorterSortParallel(VdbeSorter *pSorter, SorterList *pList){
+  int nJob = pSorter->nTask;      /* Number of jobs in each phase */
+  SortSubtask *pMain = &pSorter->aTask[nJob-1];  /* Task of this thread */
+  SorterCompare xCompare = vdbeSorterGetCompare(pSorter);
+  SorterRecord **aRec = 0;        /* All records */
+  SorterRecord **aSample = 0;     /* Sampled keys, then splitter keys */
+  SortJob *aJob = 0;              /* Jobs */
+  int *aiSplit = 0;               /* Range boundaries of each chunk */
+  int nRec = 0;                   /* Number of records */
+  int nSample = 0;                /* Number of entries in aSample[] */
+  SorterRecord *p;
+  int rc = SQLITE_OK;
+  int i, j, c;
+
+  assert( nJob>1 && nJob<=SORTER_MAX_MERGE_COUNT );
+  for(i=0; i<nJob; i++){
+    SortSubtask *pTask = &pSorter->aTask[i];
+    assert( pTask->pThread==0 );
+    pTask->xCompare = xCompare;
+    if( rc==SQLITE_OK ) rc = vdbeSortAllocUnpacked(pTask);
+  }
+  if( rc!=SQLITE_OK ) return rc;
+
+  /* Count the records.  Then store a pointer to each in aRec[], converting
+  ** the list to use SorterRecord.u.pNext as vdbeSorterSort() does. */
+  for(p=pList->pList; p; nRec++){
+    if( pList->aMemory ){
+      p = ((u8*)p==pList->aMemory) ? 0 :
+          (SorterRecord*)&pList->aMemory[p->u.iNext];
+    }else{
+      p = p->u.pNext;
+    }
+  }
+  aRec = (SorterRecord**)sqlite3Malloc(nRec * sizeof(SorterRecord*));
+  aiSplit = (int*)sqlite3Malloc(nJob * (nJob+1) * sizeof(int));
+  aSample = (SorterRecord**)sqlite3Malloc(nJob*nJob * sizeof(SorterRecord*));
+  aJob = (SortJob*)sqlite3MallocZero(nJob * sizeof(SortJob));
+  if( aRec==0 || aiSplit==0 || aSample==0 || aJob==0 ){
+    sqlite3_free(aRec);
+    sqlite3_free(aiSplit);
+    sqlite3_free(aSample);
+    sqlite3_free(aJob);
+    return SQLITE_NOMEM_BKPT;
+  }
+  for(i=0, p=pList->pList; i<nRec; i++){
+    SorterRecord *pNext;
+    if( pList->aMemory ){
+      pNext = ((u8*)p==pList->aMemory) ? 0 :
+              (SorterRecord*)&pList->aMemory[p->u.iNext];
+    }else{
+      pNext = p->u.pNext;
+    }
+    aRec[i] = p;
+    p = pNext;
+  }
+
+  /* Phase 1: sort each chunk */
+  for(c=0; c<nJob; c++){
+    aJob[c].pTask = &pSorter->aTask[c];
+    aJob[c].aRec = aRec;
+    aJob[c].aiSplit = aiSplit;
+    aJob[c].nJob = nJob;
+    aJob[c].iJob = c;
+    aiSplit[c*(nJob+1)] = (int)(((i64)nRec * c) / nJob);
+    aiSplit[c*(nJob+1) + nJob] = (int)(((i64)nRec * (c+1)) / nJob);
+  }
+  assert( aJob[nJob-1].pTask==pMain );
+  rc = vdbeSorterRunJobs(aJob, nJob, vdbeSorterSortChunk,
+                         vdbeSorterSortChunkThread);
+  if( rc!=SQLITE_OK ) goto sort_parallel_out;
+
+  /* Sample nJob-1 evenly spaced keys from each sorted chunk, sort the
+  ** samples with an insertion sort, and use every nJob-th of them as the
+  ** splitter keys */
+  for(c=0; c<nJob; c++){
+    int iFirst = aiSplit[c*(nJob+1)];
+    int nChunk = aiSplit[c*(nJob+1) + nJob] - iFirst;
+    for(j=1; j<nJob && nChunk>0; j++){
+      SorterRecord *pNew = aRec[iFirst + (int)(((i64)nChunk * j) / nJob)];
+      int bCached = 0;
+      for(i=nSample; i>0; i--){
+        if( xCompare(pMain, &bCached, SRVAL(aSample[i-1]), aSample[i-1]->nVal,
+                     SRVAL(pNew), pNew->nVal)<=0 ){
+          break;
+        }
+        aSample[i] = aSample[i-1];
+      }
+      aSample[i] = pNew;
+      nSample++;
+    }
+  }
+  for(j=1; j<nJob; j++){
+    aSample[j-1] = aSample[(int)(((i64)nSample * j) / nJob)];
+  }
+
+  /* Divide each chunk at the splitter keys.  Range j of a chunk starts
+  ** with its first record that is not less than splitter j-1. */
+  for(c=0; c<nJob; c++){
+    int *ai = &aiSplit[c*(nJob+1)];
+    for(j=1; j<nJob; j++){
+      SorterRecord *pSplit = aSample[j-1];
+      int iLo = ai[j-1];
+      int iHi = ai[nJob];
+      int bCached = 0;
+      while( iLo<iHi ){
+        int iMid = (iLo+iHi)/2;
+        if( xCompare(pMain, &bCached, SRVAL(aRec[iMid]), aRec[iMid]->nVal,
+                     SRVAL(pSplit), pSplit->nVal)<0 ){
+          iLo = iMid+1;
+        }else{
+          iHi = iMid;
+        }
+      }
+      ai[j] = iLo;
+    }
+  }
+  rc = pMain->pUnpacked->errCode;
+  if( rc!=SQLITE_OK ) goto sort_parallel_out;
+
+  /* Phase 2: merge each output range.  Then join the ranges into a
+  ** single list. */
+  rc = vdbeSorterRunJobs(aJob, nJob, vdbeSorterMergeRange,
+                         vdbeSorterMergeRangeThread);
+  if( rc==SQLITE_OK ){
+    SorterRecord **pp = &pList->pList;
+    for(c=0; c<nJob; c++){
+      *pp = aJob[c].pOut;
+      while( *pp ) pp = &(*pp)->u.pNext;
+    }
+  }
+
+ sort_parallel_out:
+  if( rc!=SQLITE_OK ){
+    /* Every record is still in aRec[].  Link them all into pList, so
+    ** that they are freed along with the sorter. */
+    pList->pList = vdbeSorterLinkRecords(aRec, 0, nRec);
+  }
+  sqlite3_free(aRec);
+  sqlite3_free(aiSplit);
+  sqlite3_free(aSample);
+  sqlite3_free(aJob);
+  return rc;
+}
+#endif /* SQLITE_MAX_WORKER_THREADS>0 */
+
+/*
+** Sort the in-memory list of records of sorter pSorter, which has not
+** written any PMAs, so that sqlite3VdbeSorterNext() can read it directly.
+*/
+static int vdbeSorterSortInMemory(VdbeSorter *pSorter){
+#if SQLITE_MAX_WORKER_THREADS>0
+  if( pSorter->bUseThreads && pSorter->list.szPMA>=SORTER_MIN_PARALLEL_SORT ){
+    return vdbeSorterSortParallel(pSorter, &pSorter->list);
+  }
+#endif
+  return vdbeSorterSort(&pSorter->aTask[0], &pSorter->list);
+}
+
 /*
 ** Initialize a PMA-writer object.
 */
@@ -1592,6 +2295,17 @@ static int vdbeSorterListToPMA(SortSubtask *pTask, SorterList *pList){
   return rc;
 }
 
+/*
+** Set the normalized prefix of PmaReader pReadr of merger pMerger to that
+** of its current key, if it is not at EOF.
+*/
+static void vdbeMergeEngineKeyInit(MergeEngine *pMerger, PmaReader *pReadr){
+  VdbeSorter *pSorter = pMerger->pTask->pSorter;
+  if( pReadr->pFd && pSorter->nPrefix ){
+    vdbeSorterKeyInit(pSorter, &pReadr->key, pReadr->aKey);
+  }
+}
+
 /*
 ** Advance the MergeEngine to its next entry.
 ** Set *pbEof to true there is no next entry because
@@ -1609,6 +2323,9 @@ static int vdbeMergeEngineStep(
 
   /* Advance the current PmaReader */
   rc = vdbePmaReaderNext(&pMerger->aReadr[iPrev]);
+  if( rc==SQLITE_OK ){
+    vdbeMergeEngineKeyInit(pMerger, &pMerger->aReadr[iPrev]);
+  }
 
   /* Update contents of aTree[] */
   if( rc==SQLITE_OK ){
@@ -1630,9 +2347,14 @@ static int vdbeMergeEngineStep(
       }else if( pReadr2->pFd==0 ){
         iRes = -1;
       }else{
-        iRes = pTask->xCompare(pTask, &bCached,
-            pReadr1->aKey, pReadr1->nKey, pReadr2->aKey, pReadr2->nKey
+        iRes = vdbeSorterPrefixCompare(
+            pTask->pSorter, &pReadr1->key, &pReadr2->key
         );
+        if( iRes==SORTER_PREFIX_TIE ){
+          iRes = pTask->xCompare(pTask, &bCached,
+              pReadr1->aKey, pReadr1->nKey, pReadr2->aKey, pReadr2->nKey
+          );
+        }
       }
 
       /* If pReadr1 contained the smaller value, set aTree[i] to its index.
@@ -2043,9 +2765,12 @@ static void vdbeMergeEngineCompare(
     int bCached = 0;
     int res;
     assert( pTask->pUnpacked!=0 );  /* from vdbeSortSubtaskMain() */
-    res = pTask->xCompare(
-        pTask, &bCached, p1->aKey, p1->nKey, p2->aKey, p2->nKey
-    );
+    res = vdbeSorterPrefixCompare(pTask->pSorter, &p1->key, &p2->key);
+    if( res==SORTER_PREFIX_TIE ){
+      res = pTask->xCompare(
+          pTask, &bCached, p1->aKey, p1->nKey, p2->aKey, p2->nKey
+      );
+    }
     if( res<=0 ){
       iRes = i1;
     }else{
@@ -2125,6 +2850,9 @@ static int vdbeMergeEngineInit(
     if( rc!=SQLITE_OK ) return rc;
   }
 
+  for(i=0; i<nTree; i++){
+    vdbeMergeEngineKeyInit(pMerger, &pMerger->aReadr[i]);
+  }
   for(i=pMerger->nTree-1; i>0; i--){
     vdbeMergeEngineCompare(pMerger, i);
   }
@@ -2570,7 +3298,7 @@ int sqlite3VdbeSorterRewind(const VdbeCursor *pCsr, int *pbEof){
   if( pSorter->bUsePMA==0 ){
     if( pSorter->list.pList ){
       *pbEof = 0;
-      rc = vdbeSorterSort(&pSorter->aTask[0], &pSorter->list);
+      rc = vdbeSorterSortInMemory(pSorter);
     }else{
       *pbEof = 1;
     }
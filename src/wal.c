@@ -286,6 +286,7 @@ int sqlite3WalTrace = 0;
 /* Object declarations */
 typedef struct WalIndexHdr WalIndexHdr;
 typedef struct WalIterator WalIterator;
+typedef struct WalGroup WalGroup;
 typedef struct WalCkptInfo WalCkptInfo;
 
 
@@ -448,6 +449,16 @@ struct Wal {
   u32 iReCksum;              /* On commit, recalculate checksums from here */
   const char *zWalName;      /* Name of WAL file */
   u32 nCkpt;                 /* Checkpoint sequence counter in the wal-header */
+  u32 nCkptStep;             /* Max frames backfilled by a PASSIVE checkpoint */
+  u8 bCkptThread;            /* Read checkpoint batches on a helper thread */
+  u8 groupSyncFlags;         /* Flags for the group sync of iGroupTicket */
+  u8 *aWriteBuf;             /* Buffer to coalesce frame writes in */
+  WalGroup *pGroup;          /* Group commit state, or NULL */
+  u64 iGroupTicket;          /* Commit waiting for a group sync, or 0 */
+  u64 *aBloom;               /* Bloom filters of full wal-index blocks */
+  int nBloom;                /* Number of blocks with a filter in aBloom */
+  int nBloomAlloc;           /* Number of filters aBloom has room for */
+  u32 aBloomSalt[2];         /* Salt of the WAL the filters belong to */
 #ifdef SQLITE_DEBUG
   u8 lockError;              /* True if a locking error has occurred */
 #endif
@@ -456,6 +467,58 @@ struct Wal {
 #endif
 };
 
+/*
+** Connections of this process that write the same WAL file share one
+** of these when group commit is enabled. Commits are numbered in the
+** order their frames are written. A commit becomes durable with the first
+** sync of the WAL file that starts after its frames were written, so that
+** a single sync makes all commits written while the previous one ran
+** durable together.
+*/
+struct WalGroup {
+  char *zName;               /* Name of the WAL file */
+  int nRef;                  /* Number of Wal objects using this group */
+  sqlite3_mutex *mutex;      /* Protects nWrite and nSync */
+  sqlite3_mutex *syncMutex;  /* Held by the connection syncing for all */
+  u64 nWrite;                /* Number of commits written */
+  u64 nSync;                 /* Commits up to this one are durable */
+  WalGroup *pNext;           /* Next group in the list of all groups */
+};
+
+/*
+** All WalGroup objects of the process, protected by SQLITE_MUTEX_STATIC_MASTER.
+*/
+static WalGroup *SQLITE_WSD walGroupList = 0;
+
+/*
+** Size of the buffer in which sqlite3WalFrames() assembles frames, so that
+** consecutive frame headers and pages go to the file with one write call.
+*/
+#ifndef SQLITE_WAL_WRITE_BUFFER
+# define SQLITE_WAL_WRITE_BUFFER 65536
+#endif
+
+/*
+** A full wal-index block never changes until the WAL is restarted with a
+** new salt (or until a rollback truncates the WAL below it, see
+** walCleanupHash()). Each connection therefore keeps a private Bloom filter
+** of the page numbers in every full block it has searched. A lookup for
+** a page that is not in the WAL then tests one word per block, instead of
+** probing the hash table of every block. The filters are not kept in the
+** wal-index, so that its format stays what other processes expect.
+**
+** Each filter has WAL_BLOOM_NWORD 64-bit words (16 bits per frame). A page
+** number selects one word and sets 3 bits in it, so that a test touches
+** a single word. Word i of the filter of block j is stored at
+** Wal.aBloom[i*Wal.nBloomAlloc + j], so that the words a lookup tests in
+** all blocks are adjacent. Define SQLITE_WAL_BLOOM as 0 to search without
+** filters.
+*/
+#ifndef SQLITE_WAL_BLOOM
+# define SQLITE_WAL_BLOOM 1
+#endif
+#define WAL_BLOOM_NWORD 1024
+
 /*
 ** Candidate values for Wal.exclusiveMode.
 */
@@ -940,6 +1003,11 @@ static void walCleanupHash(Wal *pWal){
   int i;                          /* Used to iterate through aHash[] */
 
   assert( pWal->writeLock );
+
+  /* Blocks no longer full may be written again under the same salt */
+  if( pWal->nBloom>walFramePage(pWal->hdr.mxFrame) ){
+    pWal->nBloom = walFramePage(pWal->hdr.mxFrame);
+  }
   testcase( pWal->hdr.mxFrame==HASHTABLE_NPAGE_ONE-1 );
   testcase( pWal->hdr.mxFrame==HASHTABLE_NPAGE_ONE );
   testcase( pWal->hdr.mxFrame==HASHTABLE_NPAGE_ONE+1 );
@@ -1354,6 +1422,129 @@ void sqlite3WalLimit(Wal *pWal, i64 iLimit){
   if( pWal ) pWal->mxWalSize = iLimit;
 }
 
+/*
+** Configure the checkpoints run through this connection. A PASSIVE
+** checkpoint backfills at most nStep frames (all frames if nStep is 0), so
+** that a large backlog can be checkpointed in slices. If nThread is
+** greater than 1, WAL frames are read by a helper thread while the
+** database file is written.
+*/
+void sqlite3WalCheckpointConfig(Wal *pWal, int nStep, int nThread){
+  if( pWal ){
+    pWal->nCkptStep = (u32)nStep;
+    pWal->bCkptThread = (nThread>1);
+  }
+}
+
+/*
+** Stop using the group commit state of pWal.
+*/
+static void walGroupRelease(Wal *pWal){
+  WalGroup *p = pWal->pGroup;
+  if( p ){
+    sqlite3_mutex *pMaster = sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER);
+    assert( pWal->iGroupTicket==0 );
+    sqlite3_mutex_enter(pMaster);
+    if( --p->nRef==0 ){
+      WalGroup **pp;
+      for(pp=&GLOBAL(WalGroup*,walGroupList); *pp!=p; pp=&(*pp)->pNext){}
+      *pp = p->pNext;
+      sqlite3_mutex_free(p->mutex);
+      sqlite3_mutex_free(p->syncMutex);
+      sqlite3_free(p);
+    }
+    sqlite3_mutex_leave(pMaster);
+    pWal->pGroup = 0;
+  }
+}
+
+/*
+** Enable or disable group commit. While it is enabled, a commit that must
+** sync the WAL file publishes its frames and drops the WAL write-lock
+** first, and leaves the sync to sqlite3WalGroupSync(). The sync is then
+** shared with the commits other connections of this process wrote to the
+** same WAL file in the meantime.
+**
+** Readers may see such a commit before it is durable, as they do with
+** PRAGMA synchronous=NORMAL. Its own connection does not return before
+** it is durable.
+*/
+int sqlite3WalGroupCommit(Wal *pWal, int bEnable){
+  sqlite3_mutex *pMaster;
+  WalGroup *p;
+
+  if( pWal==0 || (bEnable!=0)==(pWal->pGroup!=0) ) return SQLITE_OK;
+  if( bEnable==0 ){
+    walGroupRelease(pWal);
+    return SQLITE_OK;
+  }
+  pMaster = sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER);
+  sqlite3_mutex_enter(pMaster);
+  for(p=GLOBAL(WalGroup*,walGroupList); p; p=p->pNext){
+    if( strcmp(p->zName, pWal->zWalName)==0 ) break;
+  }
+  if( p==0 ){
+    int nName = sqlite3Strlen30(pWal->zWalName);
+    p = (WalGroup*)sqlite3MallocZero(sizeof(WalGroup) + nName + 1);
+    if( p ){
+      p->zName = (char*)&p[1];
+      memcpy(p->zName, pWal->zWalName, nName+1);
+      if( sqlite3GlobalConfig.bCoreMutex ){
+        p->mutex = sqlite3MutexAlloc(SQLITE_MUTEX_FAST);
+        p->syncMutex = sqlite3MutexAlloc(SQLITE_MUTEX_FAST);
+        if( p->mutex==0 || p->syncMutex==0 ){
+          sqlite3_mutex_free(p->mutex);
+          sqlite3_mutex_free(p->syncMutex);
+          sqlite3_free(p);
+          p = 0;
+        }
+      }
+    }
+    if( p ){
+      p->pNext = GLOBAL(WalGroup*,walGroupList);
+      GLOBAL(WalGroup*,walGroupList) = p;
+    }
+  }
+  if( p ){
+    p->nRef++;
+    pWal->pGroup = p;
+  }
+  sqlite3_mutex_leave(pMaster);
+  return p ? SQLITE_OK : SQLITE_NOMEM_BKPT;
+}
+
+/*
+** Make the last commit of this connection durable, if group commit left
+** it waiting for a sync. Connections wait for the sync in progress on
+** WalGroup.syncMutex. Once they hold it, the commit is either durable
+** already, or this connection syncs the WAL file on behalf of all commits
+** written so far.
+*/
+int sqlite3WalGroupSync(Wal *pWal){
+  WalGroup *p = pWal->pGroup;
+  u64 iTicket = pWal->iGroupTicket;
+  u64 iTarget;
+  int rc = SQLITE_OK;
+
+  if( iTicket==0 ) return SQLITE_OK;
+  assert( p!=0 && pWal->writeLock==0 );
+  pWal->iGroupTicket = 0;
+  sqlite3_mutex_enter(p->syncMutex);
+  sqlite3_mutex_enter(p->mutex);
+  iTarget = (p->nSync>=iTicket) ? 0 : p->nWrite;
+  sqlite3_mutex_leave(p->mutex);
+  if( iTarget ){
+    rc = sqlite3OsSync(pWal->pWalFd, pWal->groupSyncFlags);
+    if( rc==SQLITE_OK ){
+      sqlite3_mutex_enter(p->mutex);
+      if( p->nSync<iTarget ) p->nSync = iTarget;
+      sqlite3_mutex_leave(p->mutex);
+    }
+  }
+  sqlite3_mutex_leave(p->syncMutex);
+  return rc;
+}
+
 /*
 ** Find the smallest page number out of all pages held in the WAL that
 ** has not been returned by any prior invocation of this method on the
@@ -1690,6 +1881,230 @@ static void walRestartHdr(Wal *pWal, u32 salt1){
   assert( pInfo->aReadMark[0]==0 );
 }
 
+/*
+** A checkpoint copies the frames of the WAL into the database file in
+** batches of up to SQLITE_WAL_CKPT_BATCH bytes of page data. The frames of
+** a batch are read in WAL order, runs of adjacent frames with a single
+** read call, and the pages are written in database order, runs of
+** adjacent pages with a single write call. If Wal.bCkptThread is set,
+** the next batch is read by a helper thread while the current batch is
+** written.
+*/
+#ifndef SQLITE_WAL_CKPT_BATCH
+# define SQLITE_WAL_CKPT_BATCH (1024*1024)
+#endif
+
+/*
+** Maximum number of bytes read or written by a single call. Runs of
+** adjacent frames or pages are split accordingly, as the built-in VFSes
+** do not expect larger requests.
+*/
+#define WAL_CKPT_MAX_IO 65536
+
+typedef struct WalCkpt WalCkpt;
+typedef struct WalCkptBatch WalCkptBatch;
+
+/*
+** A batch of pages copied by a checkpoint.
+*/
+struct WalCkptBatch {
+  WalCkpt *pCkpt;            /* Checkpoint this batch belongs to */
+  int nPage;                 /* Number of pages in the batch */
+  u32 *aPgno;                /* Database page numbers, in ascending order */
+  u32 *aFrame;               /* aFrame[i] is the frame holding page aPgno[i] */
+  ht_slot *aOrder;           /* Indexes into aPgno[], sorted by frame */
+  u8 *aData;                 /* Content of page aPgno[i] at aData[i*szPage] */
+};
+
+/*
+** State of the copy loop of a checkpoint. Only one batch is read at a
+** time, so that the read buffers are shared by both batches.
+*/
+struct WalCkpt {
+  Wal *pWal;                 /* Wal connection */
+  int szPage;                /* Database page size */
+  int nMax;                  /* Maximum number of pages in a batch */
+  int bEof;                  /* True once the iterator is at its end */
+  ht_slot *aSort;            /* Merge-sort buffer of nMax entries */
+  u8 *aRead;                 /* Buffer of WAL_CKPT_MAX_IO bytes */
+  WalCkptBatch a[2];         /* The batch being written and the next one */
+};
+
+/*
+** Fill batch p with the next pages from iterator pIter whose frames are
+** in the range (nBackfill, mxFrame] and that are part of the database
+** (page number not greater than mxPage). Return the number of pages.
+*/
+static int walCkptBatchFill(
+  WalCkptBatch *p,                /* Batch to fill */
+  WalIterator *pIter,             /* Iterator over the pages in the WAL */
+  u32 nBackfill,                  /* Frames already backfilled */
+  u32 mxFrame,                    /* Last frame to backfill */
+  u32 mxPage                      /* Size of the database in pages */
+){
+  u32 iDbpage = 0;                /* Next database page to write */
+  u32 iFrame = 0;                 /* Wal frame containing data for iDbpage */
+  p->nPage = 0;
+  while( p->nPage<p->pCkpt->nMax && !p->pCkpt->bEof ){
+    if( walIteratorNext(pIter, &iDbpage, &iFrame) ){
+      p->pCkpt->bEof = 1;
+      break;
+    }
+    assert( walFramePgno(p->pCkpt->pWal, iFrame)==iDbpage );
+    if( iFrame<=nBackfill || iFrame>mxFrame || iDbpage>mxPage ){
+      continue;
+    }
+    p->aPgno[p->nPage] = iDbpage;
+    p->aFrame[p->nPage] = iFrame;
+    p->nPage++;
+  }
+  return p->nPage;
+}
+
+/*
+** Read the frames of a batch from the WAL. This is the routine of the
+** helper thread, if one is used. Return an SQLite error code.
+*/
+static void *walCkptBatchRead(void *pCtx){
+  WalCkptBatch *p = (WalCkptBatch*)pCtx;
+  WalCkpt *pCkpt = p->pCkpt;
+  sqlite3_file *pWalFd = pCkpt->pWal->pWalFd;
+  int szPage = pCkpt->szPage;
+  int szFrame = szPage + WAL_FRAME_HDRSIZE;
+  int nRun = szPage<WAL_CKPT_MAX_IO ? (WAL_CKPT_MAX_IO-szPage)/szFrame + 1 : 1;
+  int nOrder = p->nPage;
+  int rc = SQLITE_OK;
+  int i, j, n;
+
+  for(i=0; i<p->nPage; i++) p->aOrder[i] = (ht_slot)i;
+  walMergesort(p->aFrame, pCkpt->aSort, p->aOrder, &nOrder);
+  assert( nOrder==p->nPage );
+
+  for(i=0; rc==SQLITE_OK && i<p->nPage; i+=n){
+    u32 iFrame = p->aFrame[p->aOrder[i]];
+    i64 iOffset = walFrameOffset(iFrame, szPage) + WAL_FRAME_HDRSIZE;
+    /* testcase( IS_BIG_INT(iOffset) ); // requires a 4GiB WAL file */
+    for(n=1; i+n<p->nPage && n<nRun
+          && p->aFrame[p->aOrder[i+n]]==iFrame+n; n++);
+    if( n==1 ){
+      rc = sqlite3OsRead(pWalFd, &p->aData[p->aOrder[i]*(i64)szPage],
+                         szPage, iOffset);
+    }else{
+      /* Read the frames with the headers between them in one go */
+      rc = sqlite3OsRead(pWalFd, pCkpt->aRead, (n-1)*szFrame+szPage, iOffset);
+      for(j=0; rc==SQLITE_OK && j<n; j++){
+        memcpy(&p->aData[p->aOrder[i+j]*(i64)szPage],
+               &pCkpt->aRead[j*(i64)szFrame], szPage);
+      }
+    }
+  }
+  return SQLITE_INT_TO_PTR(rc);
+}
+
+/*
+** Write the pages of a batch into the database file.
+*/
+static int walCkptBatchWrite(WalCkptBatch *p){
+  sqlite3_file *pDbFd = p->pCkpt->pWal->pDbFd;
+  int szPage = p->pCkpt->szPage;
+  int nRun = szPage<WAL_CKPT_MAX_IO ? WAL_CKPT_MAX_IO/szPage : 1;
+  int rc = SQLITE_OK;
+  int i, n;
+  for(i=0; rc==SQLITE_OK && i<p->nPage; i+=n){
+    i64 iOffset = (p->aPgno[i]-1)*(i64)szPage;
+    testcase( IS_BIG_INT(iOffset) );
+    for(n=1; i+n<p->nPage && n<nRun && p->aPgno[i+n]==p->aPgno[i]+n; n++);
+    rc = sqlite3OsWrite(pDbFd, &p->aData[i*(i64)szPage], n*szPage, iOffset);
+  }
+  return rc;
+}
+
+/*
+** Copy the frames in the range (nBackfill, mxFrame] of the WAL into the
+** database file, the latest frame of each page only.
+*/
+static int walCkptCopy(
+  Wal *pWal,                      /* Wal connection */
+  WalIterator *pIter,             /* Iterator over the pages in the WAL */
+  u32 nBackfill,                  /* Frames already backfilled */
+  u32 mxFrame,                    /* Last frame to backfill */
+  u32 mxPage                      /* Size of the database in pages */
+){
+  WalCkpt ck;
+  WalCkptBatch *pCur;             /* Batch being written */
+  WalCkptBatch *pNext;            /* Batch being read */
+  u8 *pAlloc;
+  int szPage = walPagesize(pWal);
+  int nMax = SQLITE_WAL_CKPT_BATCH/szPage;
+  int bThread = 0;
+  int rc = SQLITE_OK;
+  int i;
+
+  if( nMax<1 ) nMax = 1;
+  if( nMax>HASHTABLE_NPAGE ) nMax = HASHTABLE_NPAGE;
+  pAlloc = (u8*)sqlite3Malloc(2*nMax*(i64)szPage + WAL_CKPT_MAX_IO
+    + 2*nMax*(2*sizeof(u32) + sizeof(ht_slot)) + nMax*sizeof(ht_slot)
+  );
+  if( pAlloc==0 ) return SQLITE_NOMEM_BKPT;
+  memset(&ck, 0, sizeof(ck));
+  ck.pWal = pWal;
+  ck.szPage = szPage;
+  ck.nMax = nMax;
+  ck.a[0].aData = pAlloc;
+  ck.a[1].aData = &ck.a[0].aData[nMax*(i64)szPage];
+  ck.aRead = &ck.a[1].aData[nMax*(i64)szPage];
+  ck.a[0].aPgno = (u32*)&ck.aRead[WAL_CKPT_MAX_IO];
+  ck.a[0].aFrame = &ck.a[0].aPgno[nMax];
+  ck.a[1].aPgno = &ck.a[0].aFrame[nMax];
+  ck.a[1].aFrame = &ck.a[1].aPgno[nMax];
+  ck.a[0].aOrder = (ht_slot*)&ck.a[1].aFrame[nMax];
+  ck.a[1].aOrder = &ck.a[0].aOrder[nMax];
+  ck.aSort = &ck.a[1].aOrder[nMax];
+  for(i=0; i<2; i++) ck.a[i].pCkpt = &ck;
+
+#if SQLITE_MAX_WORKER_THREADS>0
+  bThread = pWal->bCkptThread && sqlite3GlobalConfig.bCoreMutex;
+#endif
+
+  pCur = &ck.a[0];
+  pNext = &ck.a[1];
+  if( walCkptBatchFill(pCur, pIter, nBackfill, mxFrame, mxPage) ){
+    rc = SQLITE_PTR_TO_INT(walCkptBatchRead(pCur));
+  }
+  while( rc==SQLITE_OK && pCur->nPage>0 ){
+    WalCkptBatch *pTmp;
+#if SQLITE_MAX_WORKER_THREADS>0
+    SQLiteThread *pThread = 0;
+#endif
+    walCkptBatchFill(pNext, pIter, nBackfill, mxFrame, mxPage);
+#if SQLITE_MAX_WORKER_THREADS>0
+    if( bThread && pNext->nPage>0 ){
+      if( sqlite3ThreadCreate(&pThread, walCkptBatchRead, pNext) ){
+        pThread = 0;
+      }
+    }
+#endif
+    rc = walCkptBatchWrite(pCur);
+#if SQLITE_MAX_WORKER_THREADS>0
+    if( pThread ){
+      void *pOut = 0;
+      int rc2 = sqlite3ThreadJoin(pThread, &pOut);
+      if( rc2==SQLITE_OK ) rc2 = SQLITE_PTR_TO_INT(pOut);
+      if( rc==SQLITE_OK ) rc = rc2;
+    }else
+#endif
+    if( rc==SQLITE_OK && pNext->nPage>0 ){
+      rc = SQLITE_PTR_TO_INT(walCkptBatchRead(pNext));
+    }
+    pTmp = pCur;
+    pCur = pNext;
+    pNext = pTmp;
+  }
+
+  sqlite3_free(pAlloc);
+  return rc;
+}
+
 /*
 ** Copy as much content as we can from the WAL back into the database file
 ** in response to an sqlite3_wal_checkpoint() request or the equivalent.
@@ -1726,14 +2141,11 @@ static int walCheckpoint(
   int eMode,                      /* One of PASSIVE, FULL or RESTART */
   int (*xBusy)(void*),            /* Function to call when busy */
   void *pBusyArg,                 /* Context argument for xBusyHandler */
-  int sync_flags,                 /* Flags for OsSync() (or 0) */
-  u8 *zBuf                        /* Temporary buffer to use */
+  int sync_flags                  /* Flags for OsSync() (or 0) */
 ){
   int rc = SQLITE_OK;             /* Return code */
   int szPage;                     /* Database page-size */
   WalIterator *pIter = 0;         /* Wal iterator context */
-  u32 iDbpage = 0;                /* Next database page to write */
-  u32 iFrame = 0;                 /* Wal frame containing data for iDbpage */
   u32 mxSafeFrame;                /* Max frame that can be backfilled */
   u32 mxPage;                     /* Max database page to write */
   int i;                          /* Loop counter */
@@ -1794,6 +2206,18 @@ static int walCheckpoint(
       i64 nSize;                    /* Current size of database file */
       u32 nBackfill = pInfo->nBackfill;
 
+      /* A PASSIVE checkpoint may be limited to a slice of the frames. The
+      ** read-marks above are only ever set to mxSafeFrame, which is at a
+      ** commit boundary, while nBackfill may end up between commits. This
+      ** is safe: pages whose latest frame is beyond the slice are skipped
+      ** by the iterator, and every reader that could need them has a
+      ** read-mark at or after that frame. */
+      if( eMode==SQLITE_CHECKPOINT_PASSIVE && pWal->nCkptStep>0
+       && mxSafeFrame-nBackfill>pWal->nCkptStep
+      ){
+        mxSafeFrame = nBackfill + pWal->nCkptStep;
+      }
+
       pInfo->nBackfillAttempted = mxSafeFrame;
 
       /* Sync the WAL to disk */
@@ -1814,20 +2238,8 @@ static int walCheckpoint(
 
 
       /* Iterate through the contents of the WAL, copying data to the db file */
-      while( rc==SQLITE_OK && 0==walIteratorNext(pIter, &iDbpage, &iFrame) ){
-        i64 iOffset;
-        assert( walFramePgno(pWal, iFrame)==iDbpage );
-        if( iFrame<=nBackfill || iFrame>mxSafeFrame || iDbpage>mxPage ){
-          continue;
-        }
-        iOffset = walFrameOffset(iFrame, szPage) + WAL_FRAME_HDRSIZE;
-        /* testcase( IS_BIG_INT(iOffset) ); // requires a 4GiB WAL file */
-        rc = sqlite3OsRead(pWal->pWalFd, zBuf, szPage, iOffset);
-        if( rc!=SQLITE_OK ) break;
-        iOffset = (iDbpage-1)*(i64)szPage;
-        testcase( IS_BIG_INT(iOffset) );
-        rc = sqlite3OsWrite(pWal->pDbFd, zBuf, szPage, iOffset);
-        if( rc!=SQLITE_OK ) break;
+      if( rc==SQLITE_OK ){
+        rc = walCkptCopy(pWal, pIter, nBackfill, mxSafeFrame, mxPage);
       }
 
       /* If work was actually accomplished... */
@@ -1942,6 +2354,7 @@ int sqlite3WalClose(
       if( pWal->exclusiveMode==WAL_NORMAL_MODE ){
         pWal->exclusiveMode = WAL_EXCLUSIVE_MODE;
       }
+      pWal->nCkptStep = 0;
       rc = sqlite3WalCheckpoint(
           pWal, SQLITE_CHECKPOINT_PASSIVE, 0, 0, sync_flags, nBuf, zBuf, 0, 0
       );
@@ -1975,6 +2388,9 @@ int sqlite3WalClose(
       sqlite3EndBenignMalloc();
     }
     WALTRACE(("WAL%p: closed\n", pWal));
+    walGroupRelease(pWal);
+    sqlite3_free(pWal->aWriteBuf);
+    sqlite3_free(pWal->aBloom);
     sqlite3_free((void *)pWal->apWiData);
     sqlite3_free(pWal);
   }
@@ -2480,6 +2896,73 @@ void sqlite3WalEndReadTransaction(Wal *pWal){
   }
 }
 
+#if SQLITE_WAL_BLOOM
+/*
+** Return the word of a Bloom filter that page pgno maps to, and set
+** *pMask to the bits of that word it sets.
+*/
+static int walBloomWord(Pgno pgno, u64 *pMask){
+  u64 h = (u64)pgno * ((((u64)0x9e3779b9)<<32) | (u64)0x7f4a7c15);
+  *pMask = ((u64)1<<((h>>34)&63)) | ((u64)1<<((h>>40)&63))
+         | ((u64)1<<((h>>46)&63));
+  return (int)(h>>54);
+}
+
+/*
+** Make sure that the connection has Bloom filters for wal-index blocks
+** 0 to nFull-1, which must all be full in the current snapshot. Return
+** the number of leading blocks that have a filter, which is less than
+** nFull only if memory or the wal-index cannot be had.
+*/
+static int walBloomLoad(Wal *pWal, int nFull){
+  if( pWal->aBloomSalt[0]!=pWal->hdr.aSalt[0]
+   || pWal->aBloomSalt[1]!=pWal->hdr.aSalt[1]
+  ){
+    pWal->nBloom = 0;
+    pWal->aBloomSalt[0] = pWal->hdr.aSalt[0];
+    pWal->aBloomSalt[1] = pWal->hdr.aSalt[1];
+  }
+  if( nFull>pWal->nBloomAlloc ){
+    int nNew = pWal->nBloomAlloc ? pWal->nBloomAlloc*2 : 8;
+    u64 *aNew;
+    while( nNew<nFull ) nNew *= 2;
+    aNew = (u64*)sqlite3_malloc64((sqlite3_int64)nNew*WAL_BLOOM_NWORD*8);
+    if( aNew ){
+      int i;
+      for(i=0; i<WAL_BLOOM_NWORD && pWal->nBloom>0; i++){
+        memcpy(&aNew[i*nNew], &pWal->aBloom[i*pWal->nBloomAlloc],
+               pWal->nBloom*sizeof(u64));
+      }
+      sqlite3_free(pWal->aBloom);
+      pWal->aBloom = aNew;
+      pWal->nBloomAlloc = nNew;
+    }
+  }
+  while( pWal->nBloom<nFull && pWal->nBloom<pWal->nBloomAlloc ){
+    int iHash = pWal->nBloom;
+    int nAlloc = pWal->nBloomAlloc;
+    volatile ht_slot *aHash;
+    volatile u32 *aPgno;
+    u32 iZero;
+    int nEntry;
+    int i;
+
+    if( walHashGet(pWal, iHash, &aHash, &aPgno, &iZero) ) break;
+    nEntry = iHash==0 ? HASHTABLE_NPAGE_ONE : HASHTABLE_NPAGE;
+    for(i=0; i<WAL_BLOOM_NWORD; i++){
+      pWal->aBloom[i*nAlloc + iHash] = 0;
+    }
+    for(i=1; i<=nEntry; i++){
+      u64 mask;
+      int iWord = walBloomWord(aPgno[i], &mask);
+      pWal->aBloom[iWord*nAlloc + iHash] |= mask;
+    }
+    pWal->nBloom++;
+  }
+  return pWal->nBloom<nFull ? pWal->nBloom : nFull;
+}
+#endif /* SQLITE_WAL_BLOOM */
+
 /*
 ** Search the wal file for page pgno. If found, set *piRead to the frame that
 ** contains the page. Otherwise, if pgno is not in the wal file, set *piRead
@@ -2497,6 +2980,11 @@ int sqlite3WalFindFrame(
   u32 iLast = pWal->hdr.mxFrame;  /* Last page in WAL for this reader */
   int iHash;                      /* Used to loop through N hash tables */
   int iMinHash;
+  int nBloom = 0;                 /* Blocks below this have a Bloom filter */
+#if SQLITE_WAL_BLOOM
+  u64 *aBloom = 0;                /* Words of the filters that pgno sets */
+  u64 mBloom = 0;                 /* Bits of those words that pgno sets */
+#endif
 
   /* This routine is only be called from within a read transaction. */
   assert( pWal->readLock>=0 || pWal->lockError );
@@ -2536,8 +3024,20 @@ int sqlite3WalFindFrame(
   **   (iFrame<=iLast): 
   **     This condition filters out entries that were added to the hash
   **     table after the current read-transaction had started.
+  **
+  ** The hash tables of full blocks are only probed if the Bloom filter
+  ** of the block admits the page.
   */
   iMinHash = walFramePage(pWal->minFrame);
+#if SQLITE_WAL_BLOOM
+  if( walFramePage(iLast)>iMinHash ){
+    nBloom = walBloomLoad(pWal, walFramePage(iLast));
+    if( nBloom>0 ){
+      int iWord = walBloomWord(pgno, &mBloom);
+      aBloom = &pWal->aBloom[iWord*pWal->nBloomAlloc];
+    }
+  }
+#endif
   for(iHash=walFramePage(iLast); iHash>=iMinHash && iRead==0; iHash--){
     volatile ht_slot *aHash;      /* Pointer to hash table */
     volatile u32 *aPgno;          /* Pointer to array of page numbers */
@@ -2546,6 +3046,9 @@ int sqlite3WalFindFrame(
     int nCollide;                 /* Number of hash collisions remaining */
     int rc;                       /* Error code */
 
+#if SQLITE_WAL_BLOOM
+    if( iHash<nBloom && (aBloom[iHash]&mBloom)!=mBloom ) continue;
+#endif
     rc = walHashGet(pWal, iHash, &aHash, &aPgno, &iZero);
     if( rc!=SQLITE_OK ){
       return rc;
@@ -2835,8 +3338,50 @@ typedef struct WalWriter {
   sqlite3_int64 iSyncPoint;    /* Fsync at this offset */
   int syncFlags;               /* Flags for the fsync */
   int szPage;                  /* Size of one page */
+  u8 *aBuf;                    /* Buffer for writes not yet issued */
+  int nBuf;                    /* Bytes of content in aBuf */
+  int nAlloc;                  /* Size of aBuf, 0 to write through */
+  sqlite3_int64 iBufOff;       /* Offset in the WAL file of aBuf[0] */
 } WalWriter;
 
+/*
+** Write the content of the WalWriter buffer to the WAL file.
+*/
+static int walWriteFlush(WalWriter *p){
+  int rc = SQLITE_OK;
+  if( p->nBuf>0 ){
+    rc = sqlite3OsWrite(p->pFd, p->aBuf, p->nBuf, p->iBufOff);
+    p->nBuf = 0;
+  }
+  return rc;
+}
+
+/*
+** Write iAmt bytes at iOffset through the WalWriter buffer. Content that
+** continues the buffered content is appended to it, so that the headers
+** and pages of consecutive frames go to the file with a single write.
+*/
+static int walWriteBuffered(
+  WalWriter *p,              /* WAL to write to */
+  void *pContent,            /* Content to be written */
+  int iAmt,                  /* Number of bytes to write */
+  sqlite3_int64 iOffset      /* Start writing at this offset */
+){
+  if( p->nBuf>0
+   && (iOffset!=p->iBufOff+p->nBuf || p->nBuf+iAmt>p->nAlloc)
+  ){
+    int rc = walWriteFlush(p);
+    if( rc ) return rc;
+  }
+  if( iAmt>p->nAlloc ){
+    return sqlite3OsWrite(p->pFd, pContent, iAmt, iOffset);
+  }
+  if( p->nBuf==0 ) p->iBufOff = iOffset;
+  memcpy(&p->aBuf[p->nBuf], pContent, iAmt);
+  p->nBuf += iAmt;
+  return SQLITE_OK;
+}
+
 /*
 ** Write iAmt bytes of content into the WAL file beginning at iOffset.
 ** Do a sync when crossing the p->iSyncPoint boundary.
@@ -2854,7 +3399,8 @@ static int walWriteToLog(
   int rc;
   if( iOffset<p->iSyncPoint && iOffset+iAmt>=p->iSyncPoint ){
     int iFirstAmt = (int)(p->iSyncPoint - iOffset);
-    rc = sqlite3OsWrite(p->pFd, pContent, iFirstAmt, iOffset);
+    rc = walWriteBuffered(p, pContent, iFirstAmt, iOffset);
+    if( rc==SQLITE_OK ) rc = walWriteFlush(p);
     if( rc ) return rc;
     iOffset += iFirstAmt;
     iAmt -= iFirstAmt;
@@ -2863,7 +3409,7 @@ static int walWriteToLog(
     rc = sqlite3OsSync(p->pFd, p->syncFlags & SQLITE_SYNC_MASK);
     if( iAmt==0 || rc ) return rc;
   }
-  rc = sqlite3OsWrite(p->pFd, pContent, iAmt, iOffset);
+  rc = walWriteBuffered(p, pContent, iAmt, iOffset);
   return rc;
 }
 
@@ -2967,6 +3513,7 @@ int sqlite3WalFrames(
   WalWriter w;                    /* The writer */
   u32 iFirst = 0;                 /* First frame that may be overwritten */
   WalIndexHdr *pLive;             /* Pointer to shared header */
+  int bGroup = 0;                 /* True to leave the sync to the group */
 
   assert( pList );
   assert( pWal->writeLock );
@@ -3045,6 +3592,13 @@ int sqlite3WalFrames(
   w.iSyncPoint = 0;
   w.syncFlags = sync_flags;
   w.szPage = szPage;
+  w.nBuf = 0;
+  w.iBufOff = 0;
+  if( pWal->aWriteBuf==0 ){
+    pWal->aWriteBuf = (u8*)sqlite3_malloc(SQLITE_WAL_WRITE_BUFFER);
+  }
+  w.aBuf = pWal->aWriteBuf;
+  w.nAlloc = w.aBuf ? SQLITE_WAL_WRITE_BUFFER : 0;
   iOffset = walFrameOffset(iFrame+1, szPage);
   szFrame = szPage + WAL_FRAME_HDRSIZE;
 
@@ -3087,6 +3641,8 @@ int sqlite3WalFrames(
     iOffset += szFrame;
     p->flags |= PGHDR_WAL_APPEND;
   }
+  rc = walWriteFlush(&w);
+  if( rc ) return rc;
 
   /* Recalculate checksums within the wal file if required. */
   if( isCommit && pWal->iReCksum ){
@@ -3107,9 +3663,15 @@ int sqlite3WalFrames(
   ** boundary is crossed.  Only the part of the WAL prior to the last
   ** sector boundary is synced; the part of the last frame that extends
   ** past the sector boundary is written after the sync.
+  **
+  ** With group commit, the sync is left to sqlite3WalGroupSync(). Not if
+  ** padding is needed though, as the frames of the next transaction could
+  ** then damage the last sector of this one after it has been synced.
   */
   if( isCommit && (sync_flags & WAL_SYNC_TRANSACTIONS)!=0 ){
-    if( pWal->padToSectorBoundary ){
+    if( pWal->pGroup && !pWal->padToSectorBoundary ){
+      bGroup = 1;
+    }else if( pWal->padToSectorBoundary ){
       int sectorSize = sqlite3SectorSize(pWal->pWalFd);
       w.iSyncPoint = ((iOffset+sectorSize-1)/sectorSize)*sectorSize;
       while( iOffset<w.iSyncPoint ){
@@ -3118,6 +3680,8 @@ int sqlite3WalFrames(
         iOffset += szFrame;
         nExtra++;
       }
+      rc = walWriteFlush(&w);
+      if( rc ) return rc;
     }else{
       rc = sqlite3OsSync(w.pFd, sync_flags & SQLITE_SYNC_MASK);
     }
@@ -3168,6 +3732,13 @@ int sqlite3WalFrames(
       walIndexWriteHdr(pWal);
       pWal->iCallback = iFrame;
     }
+    /* Number the commit, to be synced after the write-lock is released */
+    if( bGroup ){
+      sqlite3_mutex_enter(pWal->pGroup->mutex);
+      pWal->iGroupTicket = ++pWal->pGroup->nWrite;
+      sqlite3_mutex_leave(pWal->pGroup->mutex);
+      pWal->groupSyncFlags = (u8)(sync_flags & SQLITE_SYNC_MASK);
+    }
   }
 
   WALTRACE(("WAL%p: frame write %s\n", pWal, rc ? "failed" : "ok"));
@@ -3200,6 +3771,7 @@ int sqlite3WalCheckpoint(
   int eMode2 = eMode;             /* Mode to pass to walCheckpoint() */
   int (*xBusy2)(void*) = xBusy;   /* Busy handler for eMode2 */
 
+  UNUSED_PARAMETER(zBuf);
   assert( pWal->ckptLock==0 );
   assert( pWal->writeLock==0 );
 
@@ -3260,7 +3832,7 @@ int sqlite3WalCheckpoint(
     if( pWal->hdr.mxFrame && walPagesize(pWal)!=nBuf ){
       rc = SQLITE_CORRUPT_BKPT;
     }else{
-      rc = walCheckpoint(pWal, eMode2, xBusy2, pBusyArg, sync_flags, zBuf);
+      rc = walCheckpoint(pWal, eMode2, xBusy2, pBusyArg, sync_flags);
     }
 
     /* If no error occurred, set the output variables. */
@@ -28,6 +28,9 @@
 #ifdef SQLITE_OMIT_WAL
 # define sqlite3WalOpen(x,y,z)                   0
 # define sqlite3WalLimit(x,y)
+# define sqlite3WalCheckpointConfig(x,y,z)
+# define sqlite3WalGroupCommit(x,y)              0
+# define sqlite3WalGroupSync(x)                  0
 # define sqlite3WalClose(w,x,y,z)                0
 # define sqlite3WalBeginReadTransaction(y,z)     0
 # define sqlite3WalEndReadTransaction(z)
@@ -61,6 +64,13 @@ int sqlite3WalClose(Wal *pWal, int sync_flags, int, u8 *);
 /* Set the limiting size of a WAL file. */
 void sqlite3WalLimit(Wal*, i64);
 
+/* Set the slice size and the number of threads of checkpoints. */
+void sqlite3WalCheckpointConfig(Wal*, int, int);
+
+/* Share the syncs of commits between the connections of this process */
+int sqlite3WalGroupCommit(Wal*, int);
+int sqlite3WalGroupSync(Wal*);
+
 /* Used by readers to open (lock) and close (unlock) a snapshot.  A 
 ** snapshot is like a read-transaction.  It is the state of the database
 ** at an instant in time.  sqlite3WalOpenSnapshot gets a read lock and
@@ -0,0 +1,285 @@
+/*
+** 2026 October 17
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+** This file contains a standalone benchmark for aggregate queries that
+** scan a whole table, as run in batches by the OP_Batch* opcodes (see
+** vdbebatch.c) and a row at a time.
+**
+** The database holds a "lineitem" table modelled on the table of the
+** same name of the TPC-H benchmark.  The queries are TPC-H Q1 without
+** its GROUP BY clause, TPC-H Q6 and a query of min(), max() and count()
+** aggregates.  Each query is run with batch scans disabled (using
+** sqlite3_test_control(SQLITE_TESTCTRL_OPTIMIZATIONS)) and enabled, and
+** the benchmark reports the best time of each and checks that the results
+** are the same.
+**
+**    gcc -O2 -DSQLITE_THREADSAFE=1 -Isrc tool/batchbench.c \
+**        src/sqlite3secure.c <SQLite core> -lpthread -ldl -lm
+**
+** Usage:  batchbench ?OPTIONS? ?DIRECTORY?
+**
+**    --rows N         Rows of the lineitem table (default: 1000000)
+**    --runs N         Runs of each query in each mode (default: 5)
+**    --pagesize N     Page size of the database (default: 4096)
+**
+** The database file is created in DIRECTORY (default: the current
+** directory) and deleted afterwards.
+*/
+#if (defined(_WIN32) || defined(WIN32)) && !defined(_CRT_SECURE_NO_WARNINGS)
+/* This needs to come before any includes for MSVC compiler */
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "sqlite3.h"
+
+#if defined(_WIN32) || defined(WIN32)
+# include <windows.h>
+#else
+# include <time.h>
+#endif
+
+/*
+** The SQLITE_BatchScan optimization flag of sqliteInt.h
+*/
+#define BENCH_BATCHSCAN 0x1000
+
+/*
+** Largest number of result columns compared between the two modes
+*/
+#define BENCH_MAX_COLUMN 16
+
+/*
+** Benchmark configuration from the command line
+*/
+typedef struct BenchConfig BenchConfig;
+struct BenchConfig {
+  int nRow;                 /* Rows in the lineitem table */
+  int nRun;                 /* Runs of each query in each mode */
+  int szPage;               /* Page size */
+  char zFile[1024];         /* Name of the database file */
+};
+
+/*
+** The queries of the benchmark
+*/
+static const struct BenchQuery {
+  const char *zName;
+  const char *zSql;
+} aQuery[] = {
+  { "Q1 (no GROUP BY)",
+    "SELECT sum(l_quantity), sum(l_extendedprice),"
+    " sum(l_extendedprice*(1-l_discount)),"
+    " sum(l_extendedprice*(1-l_discount)*(1+l_tax)),"
+    " avg(l_quantity), avg(l_extendedprice), avg(l_discount), count(*)"
+    " FROM lineitem WHERE l_shipdate<=19980902" },
+  { "Q6",
+    "SELECT sum(l_extendedprice*l_discount) FROM lineitem"
+    " WHERE l_shipdate>=19940101 AND l_shipdate<19950101"
+    " AND l_discount BETWEEN 0.05 AND 0.07 AND l_quantity<24" },
+  { "min/max/count",
+    "SELECT min(l_extendedprice), max(l_extendedprice), min(l_shipdate),"
+    " max(l_receiptdate), count(l_comment) FROM lineitem" },
+};
+
+/*
+** Return a monotonic time stamp in nanoseconds
+*/
+static double benchNow(void){
+#if defined(_WIN32) || defined(WIN32)
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER t;
+  if( freq.QuadPart==0 ) QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&t);
+  return (double)t.QuadPart * 1e9 / (double)freq.QuadPart;
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+#endif
+}
+
+/*
+** Print an error message and exit
+*/
+static void benchFatal(const char *zMsg, const char *zDetail){
+  fprintf(stderr, "batchbench: %s%s%s\n", zMsg, zDetail ? ": " : "",
+          zDetail ? zDetail : "");
+  exit(1);
+}
+
+/*
+** Run an SQL statement, exit on error
+*/
+static void benchExec(sqlite3 *db, const char *zSql){
+  char *zErr = 0;
+  if( sqlite3_exec(db, zSql, 0, 0, &zErr)!=SQLITE_OK ){
+    fprintf(stderr, "batchbench: %s\n  in: %s\n", zErr, zSql);
+    exit(1);
+  }
+}
+
+/*
+** Create and fill the lineitem table.  Dates are integers of the form
+** YYYYMMDD between 1992-01-02 and 1998-12-31, as in TPC-H.
+*/
+static void benchCreate(const BenchConfig *p){
+  sqlite3 *db = 0;
+  char *zSql;
+  remove(p->zFile);
+  if( sqlite3_open(p->zFile, &db)!=SQLITE_OK ){
+    benchFatal("cannot open", p->zFile);
+  }
+  zSql = sqlite3_mprintf("PRAGMA page_size=%d; PRAGMA journal_mode=OFF;"
+                         " PRAGMA synchronous=OFF", p->szPage);
+  benchExec(db, zSql);
+  sqlite3_free(zSql);
+  benchExec(db,
+      "CREATE TABLE lineitem("
+      "  l_orderkey INTEGER, l_partkey INTEGER, l_suppkey INTEGER,"
+      "  l_linenumber INTEGER, l_quantity INTEGER, l_extendedprice REAL,"
+      "  l_discount REAL, l_tax REAL, l_returnflag TEXT, l_linestatus TEXT,"
+      "  l_shipdate INTEGER, l_commitdate INTEGER, l_receiptdate INTEGER,"
+      "  l_shipinstruct TEXT, l_shipmode TEXT, l_comment TEXT)"
+  );
+  zSql = sqlite3_mprintf(
+      "WITH RECURSIVE c(i) AS (VALUES(1) UNION ALL SELECT i+1 FROM c"
+      " WHERE i<%d),"
+      " r(i, q, p, d) AS (SELECT i, 1+abs(random())%%50,"
+      "   900+abs(random())%%100000, abs(random())%%2526 FROM c)"
+      " INSERT INTO lineitem SELECT"
+      "  i/4, abs(random())%%200000, abs(random())%%10000, i%%4+1, q,"
+      "  q*p/100.0, (abs(random())%%11)/100.0, (abs(random())%%9)/100.0,"
+      "  substr('RAN', 1+abs(random())%%3, 1), substr('OF', 1+i%%2, 1),"
+      "  CAST(strftime('%%Y%%m%%d', '1992-01-02', '+'||d||' days') AS INT),"
+      "  CAST(strftime('%%Y%%m%%d', '1992-01-02', '+'||(d+30)||' days') AS INT),"
+      "  CAST(strftime('%%Y%%m%%d', '1992-01-02', '+'||(d+15)||' days') AS INT),"
+      "  'DELIVER IN PERSON', 'TRUCK', hex(randomblob(8))"
+      " FROM r", p->nRow);
+  benchExec(db, zSql);
+  sqlite3_free(zSql);
+  sqlite3_close(db);
+}
+
+/*
+** Run query zSql nRun times with batch scans enabled or disabled, and
+** return the best time in ns.  The text of the result row is written
+** to azRes[].
+*/
+static double benchQuery(
+  sqlite3 *db,
+  const char *zSql,
+  int bBatch,
+  int nRun,
+  char **azRes
+){
+  sqlite3_stmt *pStmt = 0;
+  double tBest = 0.0;
+  int i, j;
+
+  sqlite3_test_control(SQLITE_TESTCTRL_OPTIMIZATIONS, db,
+                       bBatch ? 0 : BENCH_BATCHSCAN);
+  if( sqlite3_prepare_v2(db, zSql, -1, &pStmt, 0)!=SQLITE_OK ){
+    benchFatal("cannot prepare", sqlite3_errmsg(db));
+  }
+  for(i=0; i<nRun; i++){
+    double t0 = benchNow();
+    if( sqlite3_step(pStmt)!=SQLITE_ROW ){
+      benchFatal("query failed", sqlite3_errmsg(db));
+    }
+    t0 = benchNow() - t0;
+    if( i==0 || t0<tBest ) tBest = t0;
+    for(j=0; j<sqlite3_column_count(pStmt) && j<BENCH_MAX_COLUMN; j++){
+      sqlite3_free(azRes[j]);
+      azRes[j] = sqlite3_mprintf("%s", sqlite3_column_text(pStmt, j));
+    }
+    sqlite3_reset(pStmt);
+  }
+  sqlite3_finalize(pStmt);
+  return tBest;
+}
+
+int main(int argc, char **argv){
+  BenchConfig cfg;
+  const char *zDir = ".";
+  char *azRow[BENCH_MAX_COLUMN];
+  char *azBatch[BENCH_MAX_COLUMN];
+  sqlite3 *db = 0;
+  int i, j;
+
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.nRow = 1000000;
+  cfg.nRun = 5;
+  cfg.szPage = 4096;
+  for(i=1; i<argc; i++){
+    const char *z = argv[i];
+    if( z[0]=='-' && z[1]=='-' ) z++;
+    if( strcmp(z, "-rows")==0 && i+1<argc ){
+      cfg.nRow = atoi(argv[++i]);
+      if( cfg.nRow<1 ) cfg.nRow = 1;
+    }else if( strcmp(z, "-runs")==0 && i+1<argc ){
+      cfg.nRun = atoi(argv[++i]);
+      if( cfg.nRun<1 ) cfg.nRun = 1;
+    }else if( strcmp(z, "-pagesize")==0 && i+1<argc ){
+      cfg.szPage = atoi(argv[++i]);
+    }else if( z[0]!='-' ){
+      zDir = argv[i];
+    }else{
+      fprintf(stderr, "Usage: %s ?--rows N? ?--runs N? ?--pagesize N?"
+                      " ?DIRECTORY?\n", argv[0]);
+      return 1;
+    }
+  }
+  if( cfg.szPage<512 || cfg.szPage>65536 || (cfg.szPage&(cfg.szPage-1)) ){
+    benchFatal("invalid page size", 0);
+  }
+  sqlite3_snprintf(sizeof(cfg.zFile), cfg.zFile, "%s/batchbench.db", zDir);
+  benchCreate(&cfg);
+  memset(azRow, 0, sizeof(azRow));
+  memset(azBatch, 0, sizeof(azBatch));
+
+  if( sqlite3_open(cfg.zFile, &db)!=SQLITE_OK ){
+    benchFatal("cannot open", cfg.zFile);
+  }
+  /* Keep the whole table in the page cache, so that the benchmark
+  ** measures the VDBE rather than the file system */
+  benchExec(db, "PRAGMA cache_size=-2000000; SELECT count(*) FROM lineitem"
+                " WHERE l_comment IS NULL");
+
+  printf("%d rows, page size %d, best of %d runs\n",
+         cfg.nRow, cfg.szPage, cfg.nRun);
+  printf("\n%-18s %12s %12s %9s\n", "query", "row (ms)", "batch (ms)",
+         "speedup");
+  for(i=0; i<(int)(sizeof(aQuery)/sizeof(aQuery[0])); i++){
+    double tRow = benchQuery(db, aQuery[i].zSql, 0, cfg.nRun, azRow);
+    double tBatch = benchQuery(db, aQuery[i].zSql, 1, cfg.nRun, azBatch);
+    for(j=0; j<BENCH_MAX_COLUMN && azRow[j]; j++){
+      if( azBatch[j]==0 || strcmp(azRow[j], azBatch[j])!=0 ){
+        fprintf(stderr, "batchbench: %s: result %d differs: %s vs %s\n",
+                aQuery[i].zName, j, azRow[j], azBatch[j] ? azBatch[j] : "-");
+        return 1;
+      }
+    }
+    printf("%-18s %12.1f %12.1f %8.2fx\n", aQuery[i].zName,
+           tRow/1e6, tBatch/1e6, tRow/tBatch);
+    for(j=0; j<BENCH_MAX_COLUMN; j++){
+      sqlite3_free(azRow[j]);
+      sqlite3_free(azBatch[j]);
+      azRow[j] = azBatch[j] = 0;
+    }
+  }
+  sqlite3_close(db);
+
+  remove(cfg.zFile);
+  return 0;
+}
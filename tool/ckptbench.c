@@ -0,0 +1,358 @@
+/*
+** 2026 October 16
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+** This file contains a standalone benchmark for WAL checkpoints.
+**
+** A table filling a given number of database pages is created once.  For
+** every write pattern and every checkpoint thread count (see "PRAGMA
+** wal_checkpoint_threads"), transactions updating rows of the table are
+** written into the WAL with automatic checkpoints disabled, until the WAL
+** holds the requested number of frames.  Then the WAL is checkpointed by
+** PASSIVE checkpoints, in slices of --step frames if given (see "PRAGMA
+** wal_checkpoint_step"), and the benchmark reports the frames backfilled
+** per second and the number of checkpoint calls.  The write patterns are:
+**
+**    seq      Each transaction updates a run of adjacent rows, so that
+**             runs of adjacent pages end up in adjacent WAL frames.
+**    random   Each transaction updates rows at random.
+**
+** To compare against a checkpoint that copies one frame at a time, build
+** the library with -DSQLITE_WAL_CKPT_BATCH=512 (one page per batch).
+**
+**    gcc -O2 -DSQLITE_THREADSAFE=1 -Isrc tool/ckptbench.c \
+**        src/sqlite3secure.c <SQLite core> -lpthread -ldl -lm
+**
+** Usage:  ckptbench ?OPTIONS? ?DIRECTORY?
+**
+**    --pages N        Size of the database in pages (default: 20000)
+**    --pagesize N     Page size of the database (default: 4096)
+**    --frames N       Frames in the WAL before each checkpoint
+**                     (default: 20000)
+**    --txn N          Rows updated per transaction (default: 64)
+**    --pattern LIST   Comma separated patterns "seq" and "random"
+**                     (default: seq,random)
+**    --threads LIST   Comma separated checkpoint thread counts 1 and 2
+**                     (default: 1,2)
+**    --step N         Frames per PASSIVE checkpoint, 0 for all
+**                     (default: 0)
+**    --sync           Sync the WAL and the database file, as with
+**                     "PRAGMA synchronous=NORMAL" (default: no syncs)
+**
+** The database file is created in DIRECTORY (default: the current
+** directory) and deleted afterwards.
+*/
+#if (defined(_WIN32) || defined(WIN32)) && !defined(_CRT_SECURE_NO_WARNINGS)
+/* This needs to come before any includes for MSVC compiler */
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "sqlite3.h"
+
+#if defined(_WIN32) || defined(WIN32)
+# include <windows.h>
+#else
+# include <time.h>
+#endif
+
+/*
+** Largest number of entries of a list on the command line
+*/
+#define BENCH_MAX_RUNS 8
+
+/*
+** Benchmark configuration from the command line
+*/
+typedef struct BenchConfig BenchConfig;
+struct BenchConfig {
+  int nPage;                /* Size of the database in pages */
+  int szPage;               /* Page size */
+  int nFrame;               /* Frames in the WAL before a checkpoint */
+  int nTxn;                 /* Rows updated per transaction */
+  int nPattern;             /* Number of entries in aPattern[] */
+  int aPattern[2];          /* 0 for "seq", 1 for "random" */
+  int nThreads;             /* Number of entries in aThread[] */
+  int aThread[BENCH_MAX_RUNS]; /* Checkpoint thread counts to measure */
+  int nStep;                /* Frames per PASSIVE checkpoint, or 0 */
+  int bSync;                /* True to sync */
+  int nRow;                 /* Rows in the table */
+  int szRow;                /* Size of the blob of each row */
+  char zFile[1024];         /* Name of the database file */
+};
+
+/*
+** Return a monotonic time stamp in nanoseconds
+*/
+static double benchNow(void){
+#if defined(_WIN32) || defined(WIN32)
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER t;
+  if( freq.QuadPart==0 ) QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&t);
+  return (double)t.QuadPart * 1e9 / (double)freq.QuadPart;
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+#endif
+}
+
+/*
+** Print an error message and exit
+*/
+static void benchFatal(const char *zMsg, const char *zDetail){
+  fprintf(stderr, "ckptbench: %s%s%s\n", zMsg, zDetail ? ": " : "",
+          zDetail ? zDetail : "");
+  exit(1);
+}
+
+/*
+** Run an SQL statement, exit on error
+*/
+static void benchExec(sqlite3 *db, const char *zSql){
+  char *zErr = 0;
+  if( sqlite3_exec(db, zSql, 0, 0, &zErr)!=SQLITE_OK ){
+    fprintf(stderr, "ckptbench: %s\n  in: %s\n", zErr, zSql);
+    exit(1);
+  }
+}
+
+/*
+** Return the next value of a xorshift random number generator
+*/
+static unsigned int benchRandom(unsigned int *piRand){
+  unsigned int x = *piRand;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *piRand = x;
+  return x;
+}
+
+/*
+** WAL hook: record the number of frames in the WAL
+*/
+static int benchWalHook(void *pArg, sqlite3 *db, const char *zDb, int nFrame){
+  (void)db;
+  (void)zDb;
+  *(int*)pArg = nFrame;
+  return SQLITE_OK;
+}
+
+/*
+** Open the database and configure the connection
+*/
+static sqlite3 *benchOpen(const BenchConfig *p){
+  sqlite3 *db = 0;
+  char *zSql;
+  if( sqlite3_open(p->zFile, &db)!=SQLITE_OK ){
+    benchFatal("cannot open", p->zFile);
+  }
+  zSql = sqlite3_mprintf("PRAGMA page_size=%d; PRAGMA journal_mode=WAL;"
+                         " PRAGMA synchronous=%s; PRAGMA wal_autocheckpoint=0",
+                         p->szPage, p->bSync ? "NORMAL" : "OFF");
+  benchExec(db, zSql);
+  sqlite3_free(zSql);
+  return db;
+}
+
+/*
+** Create the table of the benchmark
+*/
+static void benchCreate(const BenchConfig *p){
+  sqlite3 *db;
+  char *zSql;
+  remove(p->zFile);
+  db = benchOpen(p);
+  benchExec(db, "CREATE TABLE t(id INTEGER PRIMARY KEY, v BLOB)");
+  zSql = sqlite3_mprintf(
+      "WITH RECURSIVE c(i) AS (VALUES(1) UNION ALL SELECT i+1 FROM c"
+      " WHERE i<%d) INSERT INTO t SELECT i, randomblob(%d) FROM c",
+      p->nRow, p->szRow);
+  benchExec(db, zSql);
+  sqlite3_free(zSql);
+  benchExec(db, "PRAGMA wal_checkpoint(TRUNCATE)");
+  sqlite3_close(db);
+}
+
+/*
+** Write transactions into the WAL until it holds at least p->nFrame frames
+*/
+static void benchFill(const BenchConfig *p, sqlite3 *db, int ePattern){
+  sqlite3_stmt *pStmt = 0;
+  unsigned int iRand = 0x12345678;
+  int nFrame = 0;
+  int iRow = 0;
+  int i;
+
+  sqlite3_wal_hook(db, benchWalHook, &nFrame);
+  if( sqlite3_prepare_v2(db, "UPDATE t SET v=randomblob(?2) WHERE id=?1",
+                         -1, &pStmt, 0)!=SQLITE_OK ){
+    benchFatal("cannot prepare", sqlite3_errmsg(db));
+  }
+  while( nFrame<p->nFrame ){
+    benchExec(db, "BEGIN");
+    if( ePattern==0 ) iRow = benchRandom(&iRand) % p->nRow;
+    for(i=0; i<p->nTxn; i++){
+      int iId;
+      if( ePattern==0 ){
+        iId = 1 + (iRow + i) % p->nRow;
+      }else{
+        iId = 1 + benchRandom(&iRand) % p->nRow;
+      }
+      sqlite3_bind_int(pStmt, 1, iId);
+      sqlite3_bind_int(pStmt, 2, p->szRow);
+      sqlite3_step(pStmt);
+      if( sqlite3_reset(pStmt)!=SQLITE_OK ){
+        benchFatal("update failed", sqlite3_errmsg(db));
+      }
+    }
+    benchExec(db, "COMMIT");
+  }
+  sqlite3_finalize(pStmt);
+  sqlite3_wal_hook(db, 0, 0);
+}
+
+/*
+** Measure the checkpoint of one WAL
+*/
+static void benchRun(const BenchConfig *p, int ePattern, int nThread){
+  sqlite3 *db = benchOpen(p);
+  char *zSql;
+  int nLog = 0;
+  int nCkpt = 0;
+  int nCall = 0;
+  double t0, t1;
+
+  benchFill(p, db, ePattern);
+  zSql = sqlite3_mprintf("PRAGMA wal_checkpoint_threads=%d;"
+                         " PRAGMA wal_checkpoint_step=%d", nThread, p->nStep);
+  benchExec(db, zSql);
+  sqlite3_free(zSql);
+
+  t0 = benchNow();
+  do{
+    int rc = sqlite3_wal_checkpoint_v2(db, 0, SQLITE_CHECKPOINT_PASSIVE,
+                                       &nLog, &nCkpt);
+    if( rc!=SQLITE_OK ) benchFatal("checkpoint failed", sqlite3_errmsg(db));
+    nCall++;
+  }while( nCkpt<nLog );
+  t1 = benchNow();
+
+  printf("%7s %7d %9d %12.0f %9.1f %7d\n", ePattern ? "random" : "seq",
+         nThread, nLog, nLog/((t1-t0)/1e9), (t1-t0)/1e6, nCall);
+  benchExec(db, "PRAGMA wal_checkpoint(TRUNCATE)");
+  sqlite3_close(db);
+}
+
+/*
+** Parse a comma separated list of integers
+*/
+static int benchParseList(int *aOut, const char *z){
+  int n = 0;
+  while( *z && n<BENCH_MAX_RUNS ){
+    aOut[n++] = atoi(z);
+    while( *z && *z!=',' ) z++;
+    if( *z==',' ) z++;
+  }
+  return n;
+}
+
+/*
+** Parse a comma separated list of write patterns
+*/
+static void benchParsePatterns(BenchConfig *p, const char *z){
+  p->nPattern = 0;
+  while( *z && p->nPattern<2 ){
+    if( strncmp(z, "seq", 3)==0 ){
+      p->aPattern[p->nPattern++] = 0;
+    }else if( strncmp(z, "random", 6)==0 ){
+      p->aPattern[p->nPattern++] = 1;
+    }else{
+      benchFatal("unknown pattern", z);
+    }
+    while( *z && *z!=',' ) z++;
+    if( *z==',' ) z++;
+  }
+}
+
+int main(int argc, char **argv){
+  BenchConfig cfg;
+  const char *zDir = ".";
+  int i, j;
+
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.nPage = 20000;
+  cfg.szPage = 4096;
+  cfg.nFrame = 20000;
+  cfg.nTxn = 64;
+  benchParsePatterns(&cfg, "seq,random");
+  cfg.nThreads = benchParseList(cfg.aThread, "1,2");
+  for(i=1; i<argc; i++){
+    const char *z = argv[i];
+    if( z[0]=='-' && z[1]=='-' ) z++;
+    if( strcmp(z, "-pages")==0 && i+1<argc ){
+      cfg.nPage = atoi(argv[++i]);
+      if( cfg.nPage<16 ) cfg.nPage = 16;
+    }else if( strcmp(z, "-pagesize")==0 && i+1<argc ){
+      cfg.szPage = atoi(argv[++i]);
+    }else if( strcmp(z, "-frames")==0 && i+1<argc ){
+      cfg.nFrame = atoi(argv[++i]);
+      if( cfg.nFrame<1 ) cfg.nFrame = 1;
+    }else if( strcmp(z, "-txn")==0 && i+1<argc ){
+      cfg.nTxn = atoi(argv[++i]);
+      if( cfg.nTxn<1 ) cfg.nTxn = 1;
+    }else if( strcmp(z, "-pattern")==0 && i+1<argc ){
+      benchParsePatterns(&cfg, argv[++i]);
+    }else if( strcmp(z, "-threads")==0 && i+1<argc ){
+      cfg.nThreads = benchParseList(cfg.aThread, argv[++i]);
+    }else if( strcmp(z, "-step")==0 && i+1<argc ){
+      cfg.nStep = atoi(argv[++i]);
+      if( cfg.nStep<0 ) cfg.nStep = 0;
+    }else if( strcmp(z, "-sync")==0 ){
+      cfg.bSync = 1;
+    }else if( z[0]!='-' ){
+      zDir = argv[i];
+    }else{
+      fprintf(stderr, "Usage: %s ?--pages N? ?--pagesize N? ?--frames N?"
+                      " ?--txn N? ?--pattern LIST? ?--threads LIST?"
+                      " ?--step N? ?--sync? ?DIRECTORY?\n", argv[0]);
+      return 1;
+    }
+  }
+  if( cfg.szPage<512 || cfg.szPage>65536 || (cfg.szPage&(cfg.szPage-1)) ){
+    benchFatal("invalid page size", 0);
+  }
+  /* Rows of about a quarter page, so that three rows fill a page */
+  cfg.szRow = cfg.szPage/4;
+  cfg.nRow = cfg.nPage*3;
+  sqlite3_snprintf(sizeof(cfg.zFile), cfg.zFile, "%s/ckptbench.db", zDir);
+  benchCreate(&cfg);
+
+  printf("%d pages of %d bytes, %d frames per checkpoint, %d rows per"
+         " transaction, %s\n", cfg.nPage, cfg.szPage, cfg.nFrame, cfg.nTxn,
+         cfg.bSync ? "synchronous=NORMAL" : "no syncs");
+  if( cfg.nStep ){
+    printf("PASSIVE checkpoints of %d frames\n", cfg.nStep);
+  }
+  printf("\n%7s %7s %9s %12s %9s %7s\n", "pattern", "threads", "frames",
+         "frames/s", "ms", "calls");
+  for(i=0; i<cfg.nPattern; i++){
+    for(j=0; j<cfg.nThreads; j++){
+      benchRun(&cfg, cfg.aPattern[i], cfg.aThread[j]);
+    }
+  }
+
+  remove(cfg.zFile);
+  return 0;
+}
@@ -0,0 +1,818 @@
+/*
+** 2026 October 16
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+** This file contains a standalone benchmark for the page codec of
+** encrypted databases.
+**
+** The first part measures the AES-CBC throughput of the Rijndael cipher
+** in GB/s, for AES-128 and AES-256 keys and every page size, using the
+** backend selected at runtime: AES-NI if the processor supports it, the
+** portable tables otherwise.  To measure the tables on a processor with
+** AES-NI, build with -DRIJNDAEL_OMIT_AESNI.
+**
+** The second part drives CodecEncrypt() and CodecDecrypt() directly and
+** reports the cost per page in nanoseconds and the throughput in MB/s,
+** both with the page keys in the key cache of the codec ("hot") and with
+** a key derivation for every page ("cold").
+**
+** The third part runs SQL workloads (bulk insert, point lookup, range
+** scan, VACUUM, rekey and stepwise rekey) against a plain and an
+** encrypted database of the same content.  For every workload it reports
+** the time on both, the number of pages read and written
+** (SQLITE_DBSTATUS_CACHE_MISS and SQLITE_DBSTATUS_CACHE_WRITE), the
+** overhead of the encrypted database and the share of the encrypted run
+** the codec accounts for, estimated from the page counts and the per-page
+** cost measured in the second part.  The encrypted databases use the
+** salted key derivation ("PRAGMA kdf_iter").  After the stepwise rekey
+** the database is reopened with the new key and checked, and the
+** benchmark exits if that fails.
+**
+** The fourth part compares reading an encrypted database with read()
+** calls and through the memory map ("PRAGMA codec_mmap"), for a range
+** scan followed by point lookups on a fresh connection.  The "cold" runs
+** evict the file from the operating system cache first, the "warm" runs
+** find it there.  Evicting the file is not supported on Windows, where
+** both runs are warm.
+**
+** The fifth part measures the commit throughput of an encrypted database
+** with 1, 2, 4 and 8 threads encrypting the written pages ("PRAGMA
+** codec_threads"), for a bulk insert and an update of every row, each in
+** one transaction.  The thread count is limited by SQLITE_MAX_WORKER_THREADS
+** and the times only improve with the number of processors available.
+**
+** The cipher is selected at compile time, so build the benchmark once per
+** cipher, with the same options as the library:
+**
+**    gcc -O2 -DSQLITE_HAS_CODEC -DSQLITE_THREADSAFE=1 [-DCODEC_TYPE=2] -Isrc \
+**        tool/codecbench.c src/sqlite3secure.c <SQLite core> \
+**        -lpthread -ldl -lm
+**
+** Usage:  codecbench ?OPTIONS? ?DIRECTORY?
+**
+**    --pagesize N     Only run with page size N (default: 512 to 65536)
+**    --rows N         Number of rows of the SQL workloads (default: 20000)
+**    --cache N        Page cache size in KiB (default: 2048)
+**    --aes            Only run the AES benchmark
+**    --micro          Only run the per-page benchmark
+**    --sql            Only run the SQL workloads
+**    --mmap           Only run the memory map comparison
+**    --threads        Only run the codec thread comparison
+**
+** The database files are created in DIRECTORY (default: the current
+** directory) and deleted afterwards.
+*/
+#if (defined(_WIN32) || defined(WIN32)) && !defined(_CRT_SECURE_NO_WARNINGS)
+/* This needs to come before any includes for MSVC compiler */
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "codec.h"
+
+#if defined(_WIN32) || defined(WIN32)
+# include <windows.h>
+#else
+# include <time.h>
+# include <unistd.h>
+# include <fcntl.h>
+#endif
+
+/*
+** Number of pages processed by one timing run of the per-page benchmark
+*/
+#define BENCH_MICRO_PAGES 2000
+
+/*
+** Bytes processed by one timing run of the AES benchmark
+*/
+#define BENCH_AES_BYTES   (64*1024*1024)
+
+/*
+** Page number range of the "cold" per-page benchmark.  Pages are taken
+** from it in a scrambled order, so that the key cache neither hits nor
+** detects an ascending run of pages.
+*/
+#define BENCH_COLD_RANGE  1000003
+
+/*
+** Per-page cost of the codec for one page size, in nanoseconds
+*/
+typedef struct BenchCost BenchCost;
+struct BenchCost {
+  double encHot;            /* Encrypt, page key cached */
+  double decHot;            /* Decrypt, page key cached */
+  double encCold;           /* Encrypt, page key derived */
+  double decCold;           /* Decrypt, page key derived */
+};
+
+/*
+** Command line settings
+*/
+typedef struct BenchConfig BenchConfig;
+struct BenchConfig {
+  int iPageSize;            /* Only this page size, or 0 for all */
+  int nRow;                 /* Rows of the SQL workloads */
+  int nCacheKiB;            /* Page cache size */
+  int bAes;                 /* Run the AES benchmark */
+  int bMicro;               /* Run the per-page benchmark */
+  int bSql;                 /* Run the SQL workloads */
+  int bMmap;                /* Run the memory map comparison */
+  int bThreads;             /* Run the codec thread comparison */
+  const char *zDir;         /* Directory of the database files */
+};
+
+/*
+** Return a monotonic time stamp in nanoseconds
+*/
+static double benchNow(void){
+#if defined(_WIN32) || defined(WIN32)
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER t;
+  if( freq.QuadPart==0 ) QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&t);
+  return (double)t.QuadPart * 1e9 / (double)freq.QuadPart;
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+#endif
+}
+
+/*
+** Print an error message and exit
+*/
+static void benchFatal(const char *zMsg, const char *zDetail){
+  fprintf(stderr, "codecbench: %s%s%s\n", zMsg, zDetail ? ": " : "",
+          zDetail ? zDetail : "");
+  exit(1);
+}
+
+/*
+** Set up a codec with the same key for reading and writing, as
+** sqlite3CodecAttach() does for a keyed database
+*/
+static Codec *benchCodecNew(int szPage){
+  Codec *pCodec = (Codec*)sqlite3_malloc(sizeof(Codec));
+  if( pCodec==0 || CodecInit(pCodec)!=SQLITE_OK ){
+    benchFatal("out of memory", 0);
+  }
+  CodecSetIsEncrypted(pCodec, 1);
+  CodecSetHasReadKey(pCodec, 1);
+  CodecSetHasWriteKey(pCodec, 1);
+  CodecGenerateReadKey(pCodec, "codecbench", 10);
+  CodecCopyKey(pCodec, 1);
+  CodecSetPageSize(pCodec, szPage);
+  pCodec->m_reserved = CODEC_RESERVED;
+  return pCodec;
+}
+
+static void benchCodecFree(Codec *pCodec){
+  CodecTerm(pCodec);
+  sqlite3_free(pCodec);
+}
+
+/*
+** Page number of the i-th page of a timing run
+*/
+static int benchPageno(int i, int bCold){
+  if( bCold ){
+    return 2 + (int)(((sqlite3_uint64)i * 7919 + 17) % BENCH_COLD_RANGE);
+  }
+  return 2 + (i & 15);
+}
+
+/*
+** Measure the cost of encrypting or decrypting one page.  Decryption
+** works in place, so each run starts from a copy of an encrypted page;
+** the time of the copy is measured separately and subtracted.
+*/
+static double benchMicroRun(int szPage, int bEncrypt, int bCold){
+  Codec *pCodec = benchCodecNew(szPage);
+  unsigned char *aPlain = (unsigned char*)sqlite3_malloc(szPage);
+  unsigned char *aPage = (unsigned char*)sqlite3_malloc(szPage);
+  unsigned char **apCipher;
+  double tStart, tCodec, tCopy;
+  int i;
+
+  apCipher = (unsigned char**)sqlite3_malloc(16*sizeof(unsigned char*));
+  if( aPlain==0 || aPage==0 || apCipher==0 ) benchFatal("out of memory", 0);
+  sqlite3_randomness(szPage, aPlain);
+
+  /* Encrypted images of the 16 pages used by the hot runs */
+  for(i=0; i<16; i++){
+    apCipher[i] = (unsigned char*)sqlite3_malloc(szPage);
+    if( apCipher[i]==0 ) benchFatal("out of memory", 0);
+    memcpy(apCipher[i], aPlain, szPage);
+    CodecEncrypt(pCodec, benchPageno(i, 0), apCipher[i], szPage, 1);
+  }
+
+  /* Warm up the key cache for the hot runs */
+  for(i=0; i<16; i++){
+    memcpy(aPage, apCipher[i], szPage);
+    CodecDecrypt(pCodec, benchPageno(i, 0), aPage, szPage, 0);
+  }
+
+  tStart = benchNow();
+  for(i=0; i<BENCH_MICRO_PAGES; i++){
+    int pgno = benchPageno(i, bCold);
+    if( bEncrypt ){
+      memcpy(aPage, aPlain, szPage);
+      CodecEncrypt(pCodec, pgno, aPage, szPage, 1);
+    }else{
+      /* A cold run decrypts the image of another page, which authenticated
+      ** ciphers reject early; it is only used with the unauthenticated AES */
+      memcpy(aPage, apCipher[i & 15], szPage);
+      CodecDecrypt(pCodec, pgno, aPage, szPage, 0);
+    }
+  }
+  tCodec = benchNow() - tStart;
+
+  tStart = benchNow();
+  for(i=0; i<BENCH_MICRO_PAGES; i++){
+    memcpy(aPage, bEncrypt ? aPlain : apCipher[i & 15], szPage);
+  }
+  tCopy = benchNow() - tStart;
+
+  for(i=0; i<16; i++) sqlite3_free(apCipher[i]);
+  sqlite3_free(apCipher);
+  sqlite3_free(aPage);
+  sqlite3_free(aPlain);
+  benchCodecFree(pCodec);
+  tCodec -= tCopy;
+  return (tCodec>0.0 ? tCodec : 0.0) / BENCH_MICRO_PAGES;
+}
+
+/*
+** Measure the per-page cost of the codec for one page size
+*/
+static void benchMicro(int szPage, BenchCost *pCost, int bPrint){
+  pCost->encHot = benchMicroRun(szPage, 1, 0);
+  pCost->decHot = benchMicroRun(szPage, 0, 0);
+  pCost->encCold = benchMicroRun(szPage, 1, 1);
+#if CODEC_RESERVED > 0
+  /* The authenticated cipher derives no per-page keys */
+  pCost->decCold = pCost->decHot;
+#else
+  pCost->decCold = benchMicroRun(szPage, 0, 1);
+#endif
+  if( bPrint ){
+    printf("%8d %10.0f %9.1f %10.0f %9.1f %10.0f %10.0f\n", szPage,
+           pCost->encHot, szPage*1e3/pCost->encHot,
+           pCost->decHot, szPage*1e3/pCost->decHot,
+           pCost->encCold, pCost->decCold);
+  }
+}
+
+/*
+** Measure the AES-CBC throughput of the Rijndael cipher, in GB/s, when
+** encrypting or decrypting pages of szPage bytes.  The cipher is set up
+** once for each page, as the codec does for a cached page key.
+*/
+static double benchAesRun(int szPage, int keyLen, int bEncrypt){
+  Rijndael aes;
+  UINT8 aKey[32];
+  UINT8 aIv[16];
+  unsigned char *aPage = (unsigned char*)sqlite3_malloc(szPage);
+  int nPage = BENCH_AES_BYTES / szPage;
+  double tStart, tElapsed;
+  int i;
+
+  if( aPage==0 ) benchFatal("out of memory", 0);
+  sqlite3_randomness(sizeof(aKey), aKey);
+  sqlite3_randomness(sizeof(aIv), aIv);
+  sqlite3_randomness(szPage, aPage);
+  RijndaelCreate(&aes);
+
+  tStart = benchNow();
+  for(i=0; i<nPage; i++){
+    if( bEncrypt ){
+      RijndaelInit(&aes, RIJNDAEL_Direction_Mode_CBC,
+                   RIJNDAEL_Direction_Encrypt, aKey, keyLen, aIv);
+      RijndaelBlockEncrypt(&aes, aPage, szPage*8, aPage);
+    }else{
+      RijndaelInit(&aes, RIJNDAEL_Direction_Mode_CBC,
+                   RIJNDAEL_Direction_Decrypt, aKey, keyLen, aIv);
+      RijndaelBlockDecrypt(&aes, aPage, szPage*8, aPage);
+    }
+  }
+  tElapsed = benchNow() - tStart;
+
+  sqlite3_free(aPage);
+  return (double)nPage * szPage / tElapsed;
+}
+
+/*
+** Print the AES-CBC throughput for one page size
+*/
+static void benchAes(int szPage){
+  printf("%8d %10.2f %10.2f %10.2f %10.2f\n", szPage,
+         benchAesRun(szPage, RIJNDAEL_Direction_KeyLength_Key16Bytes, 1),
+         benchAesRun(szPage, RIJNDAEL_Direction_KeyLength_Key16Bytes, 0),
+         benchAesRun(szPage, RIJNDAEL_Direction_KeyLength_Key32Bytes, 1),
+         benchAesRun(szPage, RIJNDAEL_Direction_KeyLength_Key32Bytes, 0));
+}
+
+/*
+** Run an SQL statement, exit on error
+*/
+static void benchExec(sqlite3 *db, const char *zSql){
+  char *zErr = 0;
+  if( sqlite3_exec(db, zSql, 0, 0, &zErr)!=SQLITE_OK ){
+    fprintf(stderr, "codecbench: %s\n  in: %s\n", zErr, zSql);
+    exit(1);
+  }
+}
+
+/*
+** Open one of the two benchmark databases, encrypted if bKey is true
+*/
+static sqlite3 *benchOpen(const char *zFile, int bKey, int nCacheKiB){
+  sqlite3 *db = 0;
+  char *zSql;
+  if( sqlite3_open(zFile, &db)!=SQLITE_OK ){
+    benchFatal("cannot open", zFile);
+  }
+  if( bKey ){
+    /* Salted key derivation for a database encrypted by this connection */
+    benchExec(db, "PRAGMA kdf_iter=1000");
+    sqlite3_key(db, "codecbench", 10);
+  }
+  zSql = sqlite3_mprintf("PRAGMA cache_size=-%d", nCacheKiB);
+  benchExec(db, zSql);
+  sqlite3_free(zSql);
+  return db;
+}
+
+/*
+** Pages read and written by a connection since the last call
+*/
+static void benchPages(sqlite3 *db, int *pnRead, int *pnWrite){
+  int iCur = 0, iHi = 0;
+  sqlite3_db_status(db, SQLITE_DBSTATUS_CACHE_MISS, &iCur, &iHi, 1);
+  *pnRead = iCur;
+  sqlite3_db_status(db, SQLITE_DBSTATUS_CACHE_WRITE, &iCur, &iHi, 1);
+  *pnWrite = iCur;
+}
+
+/*
+** Look up nRow rows by rowid, in a scrambled order
+*/
+static void benchLookup(sqlite3 *db, int nRow){
+  sqlite3_stmt *pStmt = 0;
+  int i;
+  if( sqlite3_prepare_v2(db, "SELECT length(v) FROM t WHERE id=?1",
+                         -1, &pStmt, 0)!=SQLITE_OK ){
+    benchFatal("cannot prepare", sqlite3_errmsg(db));
+  }
+  for(i=0; i<nRow; i++){
+    sqlite3_bind_int(pStmt, 1, 1 + (int)(((sqlite3_uint64)i*7919) % nRow));
+    while( sqlite3_step(pStmt)==SQLITE_ROW ){}
+    sqlite3_reset(pStmt);
+  }
+  sqlite3_finalize(pStmt);
+}
+
+/*
+** Check that a database reopens with the key of a stepwise rekey, and
+** give it back its original key
+*/
+static void benchCheckRekey(const char *zFile){
+  sqlite3 *db = 0;
+  sqlite3_stmt *pStmt = 0;
+  if( sqlite3_open(zFile, &db)!=SQLITE_OK ){
+    benchFatal("cannot open", zFile);
+  }
+  sqlite3_key(db, "codecbench2", 11);
+  if( sqlite3_prepare_v2(db, "PRAGMA quick_check", -1, &pStmt, 0)!=SQLITE_OK
+   || sqlite3_step(pStmt)!=SQLITE_ROW
+   || strcmp((const char*)sqlite3_column_text(pStmt, 0), "ok")!=0 ){
+    benchFatal("database unreadable after stepwise rekey", sqlite3_errmsg(db));
+  }
+  sqlite3_finalize(pStmt);
+  if( sqlite3_rekey(db, "codecbench", 10)!=SQLITE_OK ){
+    benchFatal("cannot rekey", sqlite3_errmsg(db));
+  }
+  sqlite3_close(db);
+}
+
+/*
+** The SQL workloads
+*/
+#define BENCH_INSERT  0
+#define BENCH_LOOKUP  1
+#define BENCH_SCAN    2
+#define BENCH_VACUUM  3
+#define BENCH_REKEY   4
+#define BENCH_STEP    5
+#define BENCH_NWORK   6
+
+static const char *azWorkload[BENCH_NWORK] = {
+  "insert", "lookup", "scan", "vacuum", "rekey", "step"
+};
+
+/*
+** Run one workload on a fresh connection.  Returns the elapsed time in
+** nanoseconds, or a negative value if the workload does not apply.
+*/
+static double benchWorkload(
+  const char *zFile,
+  int bKey,
+  int eWork,
+  int szPage,
+  const BenchConfig *p,
+  int *pnRead,
+  int *pnWrite
+){
+  sqlite3 *db;
+  double tStart, tElapsed;
+  char *zSql;
+
+  if( (eWork==BENCH_REKEY || eWork==BENCH_STEP) && !bKey ) return -1.0;
+  if( eWork==BENCH_INSERT ) remove(zFile);
+  db = benchOpen(zFile, bKey, p->nCacheKiB);
+  if( eWork==BENCH_INSERT ){
+    zSql = sqlite3_mprintf("PRAGMA page_size=%d", szPage);
+    benchExec(db, zSql);
+    sqlite3_free(zSql);
+  }
+  benchPages(db, pnRead, pnWrite);
+
+  tStart = benchNow();
+  switch( eWork ){
+    case BENCH_INSERT: {
+      zSql = sqlite3_mprintf(
+        "CREATE TABLE t(id INTEGER PRIMARY KEY, k INTEGER, v BLOB);"
+        "CREATE INDEX tk ON t(k);"
+        "BEGIN;"
+        "WITH RECURSIVE c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<%d)"
+        " INSERT INTO t SELECT i, abs(random())%%1000000, randomblob(200) FROM c;"
+        "COMMIT;", p->nRow);
+      benchExec(db, zSql);
+      sqlite3_free(zSql);
+      break;
+    }
+    case BENCH_LOOKUP: {
+      benchLookup(db, p->nRow);
+      break;
+    }
+    case BENCH_SCAN: {
+      benchExec(db, "SELECT sum(length(v)) FROM t;"
+                    "SELECT count(*) FROM t WHERE k>500000;");
+      break;
+    }
+    case BENCH_VACUUM: {
+      benchExec(db, "VACUUM");
+      break;
+    }
+    case BENCH_REKEY: {
+      /* Change the key and back, so that the file keeps its key */
+      sqlite3_rekey(db, "codecbench2", 11);
+      sqlite3_rekey(db, "codecbench", 10);
+      break;
+    }
+    case BENCH_STEP: {
+      sqlite3_rekey_job *pJob = sqlite3_rekey_init(db, "main", "codecbench2", 11);
+      int rc;
+      if( pJob==0 ) benchFatal("cannot start rekey", sqlite3_errmsg(db));
+      while( (rc = sqlite3_rekey_step(pJob, 100))==SQLITE_OK ){}
+      if( sqlite3_rekey_finish(pJob)!=SQLITE_OK ){
+        benchFatal("stepwise rekey failed", sqlite3_errstr(rc));
+      }
+      break;
+    }
+  }
+  tElapsed = benchNow() - tStart;
+  benchPages(db, pnRead, pnWrite);
+  sqlite3_close(db);
+  if( eWork==BENCH_STEP ){
+    benchCheckRekey(zFile);
+  }
+  return tElapsed;
+}
+
+/*
+** Run the SQL workloads for one page size
+*/
+static void benchSql(int szPage, const BenchCost *pCost, const BenchConfig *p){
+  char *zPlain = sqlite3_mprintf("%s/codecbench-plain.db", p->zDir);
+  char *zCrypt = sqlite3_mprintf("%s/codecbench-crypt.db", p->zDir);
+  int eWork;
+
+  for(eWork=0; eWork<BENCH_NWORK; eWork++){
+    int nReadP = 0, nWriteP = 0, nRead = 0, nWrite = 0;
+    double tPlain = benchWorkload(zPlain, 0, eWork, szPage, p, &nReadP, &nWriteP);
+    double tCrypt = benchWorkload(zCrypt, 1, eWork, szPage, p, &nRead, &nWrite);
+    double tCodec;
+
+    /* A page that is read is decrypted; a page that is written is
+    ** encrypted, and also once more for the rollback journal, on average
+    ** at most once per page written */
+    tCodec = nRead*pCost->decHot + nWrite*(pCost->encHot*2);
+    printf("%8d %-7s", szPage, azWorkload[eWork]);
+    if( tPlain>=0.0 ){
+      printf(" %10.1f", tPlain/1e6);
+    }else{
+      printf(" %10s", "-");
+    }
+    printf(" %10.1f %8d %8d", tCrypt/1e6, nRead, nWrite);
+    if( tPlain>=0.0 ){
+      printf(" %8.1f%%", (tCrypt-tPlain)*100.0/tCrypt);
+    }else{
+      printf(" %9s", "-");
+    }
+    printf(" %8.1f%%\n", tCodec*100.0/tCrypt);
+  }
+
+  remove(zPlain);
+  remove(zCrypt);
+  sqlite3_free(zPlain);
+  sqlite3_free(zCrypt);
+}
+
+/*
+** Drop the pages of a file from the operating system cache
+*/
+static void benchEvict(const char *zFile){
+#if !defined(_WIN32) && !defined(WIN32)
+  int fd = open(zFile, O_RDONLY);
+  if( fd<0 ) benchFatal("cannot open", zFile);
+  fsync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+#endif
+}
+
+/*
+** Scan and look up the rows of the encrypted database on a fresh
+** connection, reading the pages with read() calls or through the memory
+** map.  Returns the elapsed time in nanoseconds.
+*/
+static double benchMmapRun(
+  const char *zFile,
+  int bMmap,
+  int bCold,
+  const BenchConfig *p,
+  int *pnRead
+){
+  sqlite3 *db;
+  double tStart, tElapsed;
+  int nWrite = 0;
+
+  if( bCold ) benchEvict(zFile);
+  db = benchOpen(zFile, 1, p->nCacheKiB);
+  if( bMmap ){
+    benchExec(db, "PRAGMA mmap_size=1073741824; PRAGMA codec_mmap=1;");
+  }else{
+    benchExec(db, "PRAGMA mmap_size=0; PRAGMA codec_mmap=0;");
+  }
+  benchPages(db, pnRead, &nWrite);
+
+  tStart = benchNow();
+  benchExec(db, "SELECT sum(length(v)) FROM t;");
+  benchLookup(db, p->nRow);
+  tElapsed = benchNow() - tStart;
+  benchPages(db, pnRead, &nWrite);
+  sqlite3_close(db);
+  return tElapsed;
+}
+
+/*
+** Compare read() calls and the memory map for one page size
+*/
+static void benchMmap(int szPage, const BenchConfig *p){
+  char *zCrypt = sqlite3_mprintf("%s/codecbench-mmap.db", p->zDir);
+  double aTime[4];
+  int nRead = 0, nWrite = 0;
+  int i;
+
+  benchWorkload(zCrypt, 1, BENCH_INSERT, szPage, p, &nRead, &nWrite);
+  /* Cold read(), cold mmap, warm read(), warm mmap */
+  for(i=0; i<4; i++){
+    aTime[i] = benchMmapRun(zCrypt, i&1, i<2, p, &nRead);
+  }
+  printf("%8d %8d %10.1f %10.1f %8.1f%% %10.1f %10.1f %8.1f%%\n",
+         szPage, nRead,
+         aTime[0]/1e6, aTime[1]/1e6, (aTime[0]-aTime[1])*100.0/aTime[0],
+         aTime[2]/1e6, aTime[3]/1e6, (aTime[2]-aTime[3])*100.0/aTime[2]);
+
+  remove(zCrypt);
+  sqlite3_free(zCrypt);
+}
+
+/*
+** Bulk insert into and update of a fresh encrypted database with nThread
+** threads encrypting the written pages.  Returns the elapsed time in
+** nanoseconds and the thread count actually used in *pnThread.
+*/
+static double benchThreadsRun(
+  const char *zFile,
+  int nThread,
+  int szPage,
+  const BenchConfig *p,
+  int *pnThread,
+  int *pnWrite
+){
+  sqlite3 *db;
+  sqlite3_stmt *pStmt = 0;
+  double tStart, tElapsed;
+  char *zSql;
+  int nRead = 0;
+
+  remove(zFile);
+  db = benchOpen(zFile, 1, p->nCacheKiB);
+  zSql = sqlite3_mprintf("PRAGMA page_size=%d; PRAGMA codec_threads=%d;"
+                         "CREATE TABLE t(id INTEGER PRIMARY KEY, v BLOB);",
+                         szPage, nThread);
+  benchExec(db, zSql);
+  sqlite3_free(zSql);
+  if( sqlite3_prepare_v2(db, "PRAGMA codec_threads", -1, &pStmt, 0)!=SQLITE_OK
+   || sqlite3_step(pStmt)!=SQLITE_ROW ){
+    benchFatal("cannot query codec_threads", sqlite3_errmsg(db));
+  }
+  *pnThread = sqlite3_column_int(pStmt, 0);
+  sqlite3_finalize(pStmt);
+  benchPages(db, &nRead, pnWrite);
+
+  tStart = benchNow();
+  zSql = sqlite3_mprintf(
+    "BEGIN;"
+    "WITH RECURSIVE c(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM c WHERE i<%d)"
+    " INSERT INTO t SELECT i, randomblob(200) FROM c;"
+    "COMMIT;"
+    "UPDATE t SET v=randomblob(200);", p->nRow);
+  benchExec(db, zSql);
+  sqlite3_free(zSql);
+  tElapsed = benchNow() - tStart;
+  benchPages(db, &nRead, pnWrite);
+  sqlite3_close(db);
+  return tElapsed;
+}
+
+/*
+** Compare the commit throughput with 1 to 8 codec threads for one page
+** size
+*/
+static void benchThreads(int szPage, const BenchConfig *p){
+  char *zCrypt = sqlite3_mprintf("%s/codecbench-threads.db", p->zDir);
+  double tOne = 0.0;
+  int nThread;
+
+  for(nThread=1; nThread<=8; nThread*=2){
+    int nUsed = 0, nWrite = 0;
+    double t = benchThreadsRun(zCrypt, nThread, szPage, p, &nUsed, &nWrite);
+    if( nUsed!=nThread ) break;
+    if( nThread==1 ) tOne = t;
+    printf("%8d %7d %10.1f %8d %10.1f %8.2f\n", szPage, nThread, t/1e6,
+           nWrite, (double)nWrite*szPage/t*1e3, tOne/t);
+  }
+
+  remove(zCrypt);
+  sqlite3_free(zCrypt);
+}
+
+static const char *benchCipherName(void){
+#if CODEC_TYPE == CODEC_TYPE_CHACHA20
+  return "ChaCha20-Poly1305";
+#elif CODEC_TYPE == CODEC_TYPE_AES256
+  return "AES-256";
+#else
+  return "AES-128";
+#endif
+}
+
+int main(int argc, char **argv){
+  BenchConfig cfg;
+  BenchCost aCost[8];
+  int i;
+  int szPage;
+
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.nRow = 20000;
+  cfg.nCacheKiB = 2048;
+  cfg.bAes = 1;
+  cfg.bMicro = 1;
+  cfg.bSql = 1;
+  cfg.bMmap = 1;
+  cfg.bThreads = 1;
+  cfg.zDir = ".";
+  for(i=1; i<argc; i++){
+    const char *z = argv[i];
+    if( z[0]=='-' && z[1]=='-' ) z++;
+    if( strcmp(z, "-pagesize")==0 && i+1<argc ){
+      cfg.iPageSize = atoi(argv[++i]);
+      if( cfg.iPageSize<512 || cfg.iPageSize>65536
+       || (cfg.iPageSize & (cfg.iPageSize-1))!=0 ){
+        benchFatal("page size must be a power of two from 512 to 65536", 0);
+      }
+    }else if( strcmp(z, "-rows")==0 && i+1<argc ){
+      cfg.nRow = atoi(argv[++i]);
+      if( cfg.nRow<1 ) cfg.nRow = 1;
+    }else if( strcmp(z, "-cache")==0 && i+1<argc ){
+      cfg.nCacheKiB = atoi(argv[++i]);
+      if( cfg.nCacheKiB<1 ) cfg.nCacheKiB = 1;
+    }else if( strcmp(z, "-aes")==0 ){
+      cfg.bMicro = 0;
+      cfg.bSql = 0;
+      cfg.bMmap = 0;
+      cfg.bThreads = 0;
+    }else if( strcmp(z, "-micro")==0 ){
+      cfg.bAes = 0;
+      cfg.bSql = 0;
+      cfg.bMmap = 0;
+      cfg.bThreads = 0;
+    }else if( strcmp(z, "-sql")==0 ){
+      cfg.bAes = 0;
+      cfg.bMicro = 0;
+      cfg.bMmap = 0;
+      cfg.bThreads = 0;
+    }else if( strcmp(z, "-mmap")==0 ){
+      cfg.bAes = 0;
+      cfg.bMicro = 0;
+      cfg.bSql = 0;
+      cfg.bThreads = 0;
+    }else if( strcmp(z, "-threads")==0 ){
+      cfg.bAes = 0;
+      cfg.bMicro = 0;
+      cfg.bSql = 0;
+      cfg.bMmap = 0;
+    }else if( z[0]!='-' ){
+      cfg.zDir = argv[i];
+    }else{
+      fprintf(stderr, "Usage: %s ?--pagesize N? ?--rows N? ?--cache KiB?"
+                      " ?--aes|--micro|--sql|--mmap|--threads? ?DIRECTORY?\n", argv[0]);
+      return 1;
+    }
+  }
+  sqlite3_initialize();
+
+  if( cfg.bAes ){
+    printf("AES-CBC backend: %s; throughput in GB/s\n",
+           RijndaelAesNiAvailable() ? "AES-NI" : "tables");
+    printf("%8s %10s %10s %10s %10s\n", "pagesize",
+           "128 enc", "128 dec", "256 enc", "256 dec");
+    for(szPage=512; szPage<=65536; szPage*=2){
+      if( cfg.iPageSize && szPage!=cfg.iPageSize ) continue;
+      benchAes(szPage);
+    }
+    printf("\n");
+  }
+
+  if( cfg.bMicro || cfg.bSql || cfg.bMmap || cfg.bThreads ){
+    printf("Cipher: %s, reserved bytes per page: %d\n\n",
+           benchCipherName(), CODEC_RESERVED);
+  }
+  if( cfg.bMicro ){
+    printf("%8s %10s %9s %10s %9s %10s %10s\n", "pagesize",
+           "enc ns/pg", "enc MB/s", "dec ns/pg", "dec MB/s",
+           "enc cold", "dec cold");
+  }
+  for(i=0, szPage=512; szPage<=65536; i++, szPage*=2){
+    if( cfg.iPageSize && szPage!=cfg.iPageSize ) continue;
+    if( cfg.bMicro || cfg.bSql ) benchMicro(szPage, &aCost[i], cfg.bMicro);
+  }
+
+  if( cfg.bSql ){
+    printf("\n%d rows, %d KiB page cache; times in ms\n", cfg.nRow, cfg.nCacheKiB);
+    printf("%8s %-7s %10s %10s %8s %8s %9s %9s\n", "pagesize", "work",
+           "plain", "encrypted", "read", "written", "overhead", "codec");
+    for(i=0, szPage=512; szPage<=65536; i++, szPage*=2){
+      if( cfg.iPageSize && szPage!=cfg.iPageSize ) continue;
+      benchSql(szPage, &aCost[i], &cfg);
+    }
+  }
+
+  if( cfg.bMmap ){
+    printf("\nEncrypted scan and lookups, read() against memory map;"
+           " times in ms\n");
+    printf("%8s %8s %10s %10s %9s %10s %10s %9s\n", "pagesize", "read",
+           "pread cold", "mmap cold", "gain", "pread warm", "mmap warm",
+           "gain");
+    for(szPage=512; szPage<=65536; szPage*=2){
+      if( cfg.iPageSize && szPage!=cfg.iPageSize ) continue;
+      benchMmap(szPage, &cfg);
+    }
+  }
+
+  if( cfg.bThreads ){
+    printf("\nEncrypted bulk insert and update by codec threads;"
+           " times in ms\n");
+    printf("%8s %7s %10s %8s %10s %8s\n", "pagesize", "threads", "time",
+           "written", "MB/s", "speedup");
+    for(szPage=512; szPage<=65536; szPage*=2){
+      if( cfg.iPageSize && szPage!=cfg.iPageSize ) continue;
+      benchThreads(szPage, &cfg);
+    }
+  }
+  sqlite3_shutdown();
+  return 0;
+}
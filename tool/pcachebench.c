@@ -0,0 +1,488 @@
+/*
+** 2026 October 16
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+** This file contains a standalone benchmark for the global page cache
+** with a concurrent read workload.
+**
+** A table of random rows is created once.  Then, for every shard count
+** of the page cache (see SQLITE_CONFIG_PCACHE_SHARDS) and every page
+** replacement policy (see SQLITE_CONFIG_PCACHE_POLICY), the library is
+** re-initialized and a number of threads, each with its own read-only
+** connection, run point lookups on random rows for a fixed time.  With
+** --scan, each thread also reads all of a second, larger table after
+** every N lookups, as a reporting query or a backup would.  For every run
+** the benchmark reports the lookups per second, the speedup over the
+** first run, the number of pages the connections had to read from the
+** file (SQLITE_DBSTATUS_CACHE_MISS) and the hit ratio of the page cache
+** (SQLITE_STATUS_PAGECACHE_HIT and _MISS), which show how well the
+** replacement policy keeps the hot pages.
+**
+** The page caches of all connections only share one pool of pages (and
+** hence the shards only matter) if the library is built with
+** SQLITE_ENABLE_MEMORY_MANAGEMENT:
+**
+**    gcc -O2 -DSQLITE_THREADSAFE=1 -DSQLITE_ENABLE_MEMORY_MANAGEMENT -Isrc \
+**        tool/pcachebench.c src/sqlite3secure.c <SQLite core> \
+**        -lpthread -ldl -lm
+**
+** Usage:  pcachebench ?OPTIONS? ?DIRECTORY?
+**
+**    --threads N      Number of reader threads (default: 8)
+**    --shards LIST    Comma separated shard counts (default: 1,2,4,8,16)
+**    --policy LIST    Comma separated policies "lru" and "2q" (default: lru)
+**    --rows N         Number of rows in the table (default: 200000)
+**    --scan N         Scan the second table after every N lookups
+**                     (default: 0, no scans)
+**    --scanrows N     Number of rows in the second table (default: 4 times
+**                     the rows of the first)
+**    --cache N        Page cache size of each connection in KiB
+**                     (default: 2048)
+**    --heap N         Soft heap limit in KiB, 0 for none (default: 0)
+**    --hugepage N     Take the page buffers from a huge-page slab of N MiB
+**                     (SQLITE_CONFIG_PCACHE_HUGEPAGE, needs a library built
+**                     with SQLITE_ENABLE_PCACHE_HUGEPAGE)
+**    --seconds N      Duration of each run (default: 3)
+**
+** For example, to compare the policies on a workload whose hot rows fit
+** into the page cache, but the scanned ones do not:
+**
+**    pcachebench --shards 1 --policy lru,2q --rows 5000 --scan 2000
+**
+** The database file is created in DIRECTORY (default: the current
+** directory) and deleted afterwards.
+*/
+#if (defined(_WIN32) || defined(WIN32)) && !defined(_CRT_SECURE_NO_WARNINGS)
+/* This needs to come before any includes for MSVC compiler */
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "sqlite3.h"
+
+#if defined(_WIN32) || defined(WIN32)
+# include <windows.h>
+#else
+# include <time.h>
+# include <unistd.h>
+# include <pthread.h>
+#endif
+
+/*
+** Largest number of reader threads and of shard counts on the command line
+*/
+#define BENCH_MAX_THREADS 256
+#define BENCH_MAX_RUNS    32
+
+/*
+** Benchmark configuration from the command line
+*/
+typedef struct BenchConfig BenchConfig;
+struct BenchConfig {
+  int nThread;              /* Number of reader threads */
+  int nRun;                 /* Number of entries in aShard[] */
+  int aShard[BENCH_MAX_RUNS];  /* Shard counts to measure */
+  int nPolicy;              /* Number of entries in aPolicy[] */
+  int aPolicy[2];           /* SQLITE_PCACHE_POLICY_* values to measure */
+  int nRow;                 /* Rows in the table */
+  int nScan;                /* Lookups between two scans, or 0 */
+  int nScanRow;             /* Rows in the scanned table */
+  int nCacheKiB;            /* Cache size of each connection */
+  int nHeapKiB;             /* Soft heap limit, or 0 */
+  int nHugeMiB;             /* Size of the huge-page slab, or 0 */
+  int nSecond;              /* Duration of each run */
+  char zFile[1024];         /* Name of the database file */
+};
+
+/*
+** State of one reader thread
+*/
+typedef struct BenchThread BenchThread;
+struct BenchThread {
+  const BenchConfig *pCfg;  /* Benchmark configuration */
+  volatile int *pbStop;     /* Set by the main thread to end the run */
+  unsigned int iRand;       /* State of the random number generator */
+  sqlite3_int64 nLookup;    /* OUT: Number of lookups done */
+  int nScanDone;            /* OUT: Number of scans done */
+  int nMiss;                /* OUT: Pages read from the file */
+  int rc;                   /* OUT: First error, or SQLITE_OK */
+};
+
+/*
+** Return a monotonic time stamp in nanoseconds
+*/
+static double benchNow(void){
+#if defined(_WIN32) || defined(WIN32)
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER t;
+  if( freq.QuadPart==0 ) QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&t);
+  return (double)t.QuadPart * 1e9 / (double)freq.QuadPart;
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+#endif
+}
+
+/*
+** Sleep for the given number of milliseconds
+*/
+static void benchSleep(int ms){
+#if defined(_WIN32) || defined(WIN32)
+  Sleep(ms);
+#else
+  usleep(ms*1000);
+#endif
+}
+
+/*
+** Print an error message and exit
+*/
+static void benchFatal(const char *zMsg, const char *zDetail){
+  fprintf(stderr, "pcachebench: %s%s%s\n", zMsg, zDetail ? ": " : "",
+          zDetail ? zDetail : "");
+  exit(1);
+}
+
+/*
+** Run an SQL statement, exit on error
+*/
+static void benchExec(sqlite3 *db, const char *zSql){
+  char *zErr = 0;
+  if( sqlite3_exec(db, zSql, 0, 0, &zErr)!=SQLITE_OK ){
+    fprintf(stderr, "pcachebench: %s\n  in: %s\n", zErr, zSql);
+    exit(1);
+  }
+}
+
+/*
+** Create the table of the benchmark
+*/
+static void benchCreate(const BenchConfig *p){
+  sqlite3 *db = 0;
+  char *zSql;
+  remove(p->zFile);
+  if( sqlite3_open(p->zFile, &db)!=SQLITE_OK ){
+    benchFatal("cannot open", p->zFile);
+  }
+  benchExec(db, "PRAGMA journal_mode=OFF; PRAGMA synchronous=OFF");
+  benchExec(db, "CREATE TABLE t(id INTEGER PRIMARY KEY, v BLOB)");
+  zSql = sqlite3_mprintf(
+      "WITH RECURSIVE c(i) AS (VALUES(1) UNION ALL SELECT i+1 FROM c"
+      " WHERE i<%d) INSERT INTO t SELECT i, randomblob(200) FROM c", p->nRow);
+  benchExec(db, zSql);
+  sqlite3_free(zSql);
+  if( p->nScan ){
+    benchExec(db, "CREATE TABLE s(id INTEGER PRIMARY KEY, v BLOB)");
+    zSql = sqlite3_mprintf(
+        "WITH RECURSIVE c(i) AS (VALUES(1) UNION ALL SELECT i+1 FROM c"
+        " WHERE i<%d) INSERT INTO s SELECT i, randomblob(200) FROM c",
+        p->nScanRow);
+    benchExec(db, zSql);
+    sqlite3_free(zSql);
+  }
+  sqlite3_close(db);
+}
+
+/*
+** Return the next value of a xorshift random number generator
+*/
+static unsigned int benchRandom(unsigned int *piRand){
+  unsigned int x = *piRand;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *piRand = x;
+}
+
+/*
+** Body of a reader thread: look up random rows until told to stop
+*/
+static void benchReader(BenchThread *pThread){
+  const BenchConfig *pCfg = pThread->pCfg;
+  sqlite3 *db = 0;
+  sqlite3_stmt *pStmt = 0;
+  char *zSql;
+  int iHi = 0;
+  int rc;
+
+  rc = sqlite3_open_v2(pCfg->zFile, &db,
+                       SQLITE_OPEN_READONLY|SQLITE_OPEN_NOMUTEX, 0);
+  if( rc==SQLITE_OK ){
+    zSql = sqlite3_mprintf("PRAGMA cache_size=-%d", pCfg->nCacheKiB);
+    rc = sqlite3_exec(db, zSql, 0, 0, 0);
+    sqlite3_free(zSql);
+  }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3_prepare_v2(db, "SELECT length(v) FROM t WHERE id=?1",
+                            -1, &pStmt, 0);
+  }
+  /* Hold a read transaction for the whole run, so that the page cache is
+  ** not discarded between lookups */
+  if( rc==SQLITE_OK ) rc = sqlite3_exec(db, "BEGIN", 0, 0, 0);
+  if( rc==SQLITE_OK ) rc = sqlite3_exec(db, "SELECT 1 FROM t LIMIT 1", 0,0,0);
+  while( rc==SQLITE_OK && *pThread->pbStop==0 ){
+    int iRow = (int)(benchRandom(&pThread->iRand) % (unsigned)pCfg->nRow) + 1;
+    sqlite3_bind_int(pStmt, 1, iRow);
+    rc = sqlite3_step(pStmt);
+    if( rc==SQLITE_ROW ) rc = SQLITE_OK;
+    if( sqlite3_reset(pStmt)!=SQLITE_OK && rc==SQLITE_OK ){
+      rc = sqlite3_errcode(db);
+    }
+    pThread->nLookup++;
+    if( rc==SQLITE_OK && pCfg->nScan && (pThread->nLookup % pCfg->nScan)==0 ){
+      rc = sqlite3_exec(db, "SELECT sum(length(v)) FROM s", 0, 0, 0);
+      pThread->nScanDone++;
+    }
+  }
+  if( db ){
+    sqlite3_db_status(db, SQLITE_DBSTATUS_CACHE_MISS, &pThread->nMiss, &iHi,0);
+  }
+  sqlite3_finalize(pStmt);
+  sqlite3_close(db);
+  pThread->rc = rc;
+}
+
+#if defined(_WIN32) || defined(WIN32)
+static DWORD WINAPI benchReaderMain(LPVOID pArg){
+  benchReader((BenchThread*)pArg);
+  return 0;
+}
+#else
+static void *benchReaderMain(void *pArg){
+  benchReader((BenchThread*)pArg);
+  return 0;
+}
+#endif
+
+/*
+** Return the current value of a counter of sqlite3_status()
+*/
+static sqlite3_int64 benchStatus(int op){
+  sqlite3_int64 iCur = 0, iHi = 0;
+  sqlite3_status64(op, &iCur, &iHi, 0);
+  return iCur;
+}
+
+/*
+** Run the workload once with nShard page cache shards and the page
+** replacement policy ePolicy
+*/
+static void benchRun(
+  const BenchConfig *p,
+  int nShard,
+  int ePolicy,
+  double *pRate1
+){
+  static BenchThread aThread[BENCH_MAX_THREADS];
+#if defined(_WIN32) || defined(WIN32)
+  HANDLE aHandle[BENCH_MAX_THREADS];
+#else
+  pthread_t aHandle[BENCH_MAX_THREADS];
+#endif
+  volatile int bStop = 0;
+  sqlite3_int64 nLookup = 0;
+  sqlite3_int64 nHit, nFetch;
+  int nMiss = 0;
+  int nScanDone = 0;
+  double tStart, tRun, rRate;
+  int i;
+
+  sqlite3_shutdown();
+  if( sqlite3_config(SQLITE_CONFIG_PCACHE_SHARDS, nShard)!=SQLITE_OK ){
+    benchFatal("SQLITE_CONFIG_PCACHE_SHARDS not supported", 0);
+  }
+  if( sqlite3_config(SQLITE_CONFIG_PCACHE_POLICY, ePolicy)!=SQLITE_OK ){
+    benchFatal("SQLITE_CONFIG_PCACHE_POLICY not supported", 0);
+  }
+  if( p->nHugeMiB ){
+    int szHdr = 0;
+    sqlite3_config(SQLITE_CONFIG_PCACHE_HDRSZ, &szHdr);
+    if( sqlite3_config(SQLITE_CONFIG_PCACHE_HUGEPAGE, 4096+szHdr,
+                       (sqlite3_int64)p->nHugeMiB*1024*1024)!=SQLITE_OK ){
+      benchFatal("SQLITE_CONFIG_PCACHE_HUGEPAGE not supported", 0);
+    }
+  }
+  sqlite3_initialize();
+  nHit = benchStatus(SQLITE_STATUS_PAGECACHE_HIT);
+  nFetch = nHit + benchStatus(SQLITE_STATUS_PAGECACHE_MISS);
+  if( p->nHeapKiB ) sqlite3_soft_heap_limit64((sqlite3_int64)p->nHeapKiB*1024);
+
+  memset(aThread, 0, sizeof(aThread));
+  tStart = benchNow();
+  for(i=0; i<p->nThread; i++){
+    aThread[i].pCfg = p;
+    aThread[i].pbStop = &bStop;
+    aThread[i].iRand = 0x9e3779b9u * (unsigned)(i+1);
+#if defined(_WIN32) || defined(WIN32)
+    aHandle[i] = CreateThread(0, 0, benchReaderMain, &aThread[i], 0, 0);
+    if( aHandle[i]==0 ) benchFatal("cannot start thread", 0);
+#else
+    if( pthread_create(&aHandle[i], 0, benchReaderMain, &aThread[i]) ){
+      benchFatal("cannot start thread", 0);
+    }
+#endif
+  }
+  benchSleep(p->nSecond*1000);
+  bStop = 1;
+  for(i=0; i<p->nThread; i++){
+#if defined(_WIN32) || defined(WIN32)
+    WaitForSingleObject(aHandle[i], INFINITE);
+    CloseHandle(aHandle[i]);
+#else
+    pthread_join(aHandle[i], 0);
+#endif
+    if( aThread[i].rc!=SQLITE_OK ){
+      benchFatal("lookup failed", sqlite3_errstr(aThread[i].rc));
+    }
+    nLookup += aThread[i].nLookup;
+    nMiss += aThread[i].nMiss;
+    nScanDone += aThread[i].nScanDone;
+  }
+  tRun = (benchNow() - tStart) / 1e9;
+  nHit = benchStatus(SQLITE_STATUS_PAGECACHE_HIT) - nHit;
+  nFetch = benchStatus(SQLITE_STATUS_PAGECACHE_HIT)
+         + benchStatus(SQLITE_STATUS_PAGECACHE_MISS) - nFetch;
+
+  rRate = (double)nLookup / tRun;
+  if( *pRate1==0.0 ) *pRate1 = rRate;
+  printf("%6d %6s %12.0f %12.0f %8.2fx %12d %6.2f%% %6d\n", nShard,
+         ePolicy==SQLITE_PCACHE_POLICY_2Q ? "2q" : "lru", rRate,
+         rRate / p->nThread, rRate / *pRate1, nMiss,
+         nFetch ? 100.0*(double)nHit/(double)nFetch : 0.0, nScanDone);
+  fflush(stdout);
+}
+
+/*
+** Parse the comma separated list of replacement policies
+*/
+static void benchParsePolicies(BenchConfig *p, const char *z){
+  p->nPolicy = 0;
+  while( *z ){
+    int ePolicy;
+    if( strncmp(z, "lru", 3)==0 ){
+      ePolicy = SQLITE_PCACHE_POLICY_LRU;
+    }else if( strncmp(z, "2q", 2)==0 ){
+      ePolicy = SQLITE_PCACHE_POLICY_2Q;
+    }else{
+      benchFatal("unknown policy", z);
+    }
+    if( p->nPolicy>=2 ) benchFatal("too many policies", 0);
+    p->aPolicy[p->nPolicy++] = ePolicy;
+    while( *z && *z!=',' ) z++;
+    if( *z==',' ) z++;
+  }
+}
+
+/*
+** Parse the comma separated list of shard counts
+*/
+static void benchParseShards(BenchConfig *p, const char *z){
+  p->nRun = 0;
+  while( *z ){
+    int n = atoi(z);
+    if( n<1 ) benchFatal("bad shard count", z);
+    if( p->nRun>=BENCH_MAX_RUNS ) benchFatal("too many shard counts", 0);
+    p->aShard[p->nRun++] = n;
+    while( *z && *z!=',' ) z++;
+    if( *z==',' ) z++;
+  }
+}
+
+int main(int argc, char **argv){
+  BenchConfig cfg;
+  const char *zDir = ".";
+  double rRate1 = 0.0;
+  int i, j;
+
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.nThread = 8;
+  cfg.nRow = 200000;
+  cfg.nCacheKiB = 2048;
+  cfg.nSecond = 3;
+  benchParseShards(&cfg, "1,2,4,8,16");
+  benchParsePolicies(&cfg, "lru");
+  for(i=1; i<argc; i++){
+    const char *z = argv[i];
+    if( z[0]=='-' && z[1]=='-' ) z++;
+    if( strcmp(z, "-threads")==0 && i+1<argc ){
+      cfg.nThread = atoi(argv[++i]);
+      if( cfg.nThread<1 ) cfg.nThread = 1;
+      if( cfg.nThread>BENCH_MAX_THREADS ) cfg.nThread = BENCH_MAX_THREADS;
+    }else if( strcmp(z, "-shards")==0 && i+1<argc ){
+      benchParseShards(&cfg, argv[++i]);
+    }else if( strcmp(z, "-policy")==0 && i+1<argc ){
+      benchParsePolicies(&cfg, argv[++i]);
+    }else if( strcmp(z, "-rows")==0 && i+1<argc ){
+      cfg.nRow = atoi(argv[++i]);
+      if( cfg.nRow<1 ) cfg.nRow = 1;
+    }else if( strcmp(z, "-scan")==0 && i+1<argc ){
+      cfg.nScan = atoi(argv[++i]);
+      if( cfg.nScan<0 ) cfg.nScan = 0;
+    }else if( strcmp(z, "-scanrows")==0 && i+1<argc ){
+      cfg.nScanRow = atoi(argv[++i]);
+      if( cfg.nScanRow<1 ) cfg.nScanRow = 1;
+    }else if( strcmp(z, "-cache")==0 && i+1<argc ){
+      cfg.nCacheKiB = atoi(argv[++i]);
+      if( cfg.nCacheKiB<1 ) cfg.nCacheKiB = 1;
+    }else if( strcmp(z, "-heap")==0 && i+1<argc ){
+      cfg.nHeapKiB = atoi(argv[++i]);
+      if( cfg.nHeapKiB<0 ) cfg.nHeapKiB = 0;
+    }else if( strcmp(z, "-hugepage")==0 && i+1<argc ){
+      cfg.nHugeMiB = atoi(argv[++i]);
+      if( cfg.nHugeMiB<0 ) cfg.nHugeMiB = 0;
+    }else if( strcmp(z, "-seconds")==0 && i+1<argc ){
+      cfg.nSecond = atoi(argv[++i]);
+      if( cfg.nSecond<1 ) cfg.nSecond = 1;
+    }else if( z[0]!='-' ){
+      zDir = argv[i];
+    }else{
+      fprintf(stderr, "Usage: %s ?--threads N? ?--shards LIST?"
+                      " ?--policy LIST? ?--rows N? ?--scan N? ?--scanrows N?"
+                      " ?--cache KiB? ?--heap KiB? ?--hugepage MiB?"
+                      " ?--seconds N?"
+                      " ?DIRECTORY?\n", argv[0]);
+      return 1;
+    }
+  }
+  sqlite3_initialize();
+  if( !sqlite3_compileoption_used("ENABLE_MEMORY_MANAGEMENT") ){
+    printf("Note: built without SQLITE_ENABLE_MEMORY_MANAGEMENT, every"
+           " connection has a private page cache and the shard count has"
+           " no effect\n");
+  }
+  if( cfg.nScanRow==0 ) cfg.nScanRow = 4*cfg.nRow;
+  sqlite3_snprintf(sizeof(cfg.zFile), cfg.zFile, "%s/pcachebench.db", zDir);
+  benchCreate(&cfg);
+
+  printf("%d threads, %d rows, %d KiB page cache per connection,"
+         " soft heap limit %d KiB, %d s per run\n", cfg.nThread, cfg.nRow,
+         cfg.nCacheKiB, cfg.nHeapKiB, cfg.nSecond);
+  if( cfg.nHugeMiB ){
+    printf("Page buffers from a %d MiB huge-page slab\n", cfg.nHugeMiB);
+  }
+  if( cfg.nScan ){
+    printf("Scan of %d rows after every %d lookups\n", cfg.nScanRow, cfg.nScan);
+  }
+  printf("\n%6s %6s %12s %12s %9s %12s %7s %6s\n", "shards", "policy",
+         "lookups/s", "per thread", "speedup", "cache miss", "hit", "scans");
+  for(i=0; i<cfg.nRun; i++){
+    for(j=0; j<cfg.nPolicy; j++){
+      benchRun(&cfg, cfg.aShard[i], cfg.aPolicy[j], &rRate1);
+    }
+  }
+
+  sqlite3_shutdown();
+  remove(cfg.zFile);
+  return 0;
+}
@@ -0,0 +1,273 @@
+/*
+** 2026 October 17
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+** This file contains a standalone benchmark for the multi-threaded sorter
+** of vdbesort.c.  It fills a table with random integer and text values,
+** then times CREATE INDEX on the integer column and on the text column,
+** and SELECT statements that read the whole table with ORDER BY clauses
+** on text, NOCASE text and multiple columns, with each of a list of
+** thread counts (set with "PRAGMA threads").
+**
+** The sorter keeps as much data in memory as the page cache may hold, up
+** to 512MiB.  With a large enough --cache the whole sort runs in memory
+** and is done by vdbeSorterSortParallel() using all threads.  Otherwise
+** the records are sorted in PMAs by worker threads and merged from
+** temporary files.
+**
+** Up to 16 threads are possible (the main thread and 15 workers) if the
+** library is built with -DSQLITE_MAX_WORKER_THREADS=15.  The default
+** build allows up to 8 workers.  The thread count in effect is reported.
+**
+**    gcc -O2 -DSQLITE_THREADSAFE=1 -DSQLITE_MAX_WORKER_THREADS=15 -Isrc \
+**        tool/sortbench.c src/sqlite3secure.c <SQLite core> \
+**        -lpthread -ldl -lm
+**
+** Usage:  sortbench ?OPTIONS? ?DIRECTORY?
+**
+**    --rows N         Rows of the table (default: 100000000)
+**    --threads LIST   Comma separated thread counts (default: 1,2,4,8,16)
+**    --cache N        Page cache size in pages (default: 131072)
+**
+** The database file is created in DIRECTORY (default: the current
+** directory) and deleted afterwards.  Temporary files of the sorter go
+** to the usual temporary directory.
+*/
+#if (defined(_WIN32) || defined(WIN32)) && !defined(_CRT_SECURE_NO_WARNINGS)
+/* This needs to come before any includes for MSVC compiler */
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "sqlite3.h"
+
+#if defined(_WIN32) || defined(WIN32)
+# include <windows.h>
+#else
+# include <time.h>
+#endif
+
+/*
+** Largest number of entries of a list on the command line
+*/
+#define BENCH_MAX_RUNS 16
+
+/*
+** Benchmark configuration from the command line
+*/
+typedef struct BenchConfig BenchConfig;
+struct BenchConfig {
+  int nRow;                 /* Rows in the table */
+  int nThread;              /* Number of entries in aThread[] */
+  int aThread[BENCH_MAX_RUNS];  /* Thread counts to measure */
+  int nCache;               /* Page cache size in pages */
+  char zFile[1024];         /* Name of the database file */
+};
+
+/*
+** The statements timed by the benchmark.  CREATE INDEX statements are
+** followed by "DROP INDEX ti", which is not timed.  The rows returned by
+** SELECT statements are read and discarded.
+*/
+static const struct BenchIndex {
+  const char *zName;
+  const char *zSql;
+} aIndex[] = {
+  { "integer", "CREATE INDEX ti ON t(a)" },
+  { "text",    "CREATE INDEX ti ON t(b)" },
+  { "ob-text", "SELECT b FROM t ORDER BY b" },
+  { "ob-nocase", "SELECT b FROM t ORDER BY b COLLATE NOCASE DESC" },
+  { "ob-multi", "SELECT c, b, a FROM t ORDER BY c, b DESC, a" },
+};
+
+/*
+** Return a monotonic time stamp in nanoseconds
+*/
+static double benchNow(void){
+#if defined(_WIN32) || defined(WIN32)
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER t;
+  if( freq.QuadPart==0 ) QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&t);
+  return (double)t.QuadPart * 1e9 / (double)freq.QuadPart;
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+#endif
+}
+
+/*
+** Print an error message and exit
+*/
+static void benchFatal(const char *zMsg, const char *zDetail){
+  fprintf(stderr, "sortbench: %s%s%s\n", zMsg, zDetail ? ": " : "",
+          zDetail ? zDetail : "");
+  exit(1);
+}
+
+/*
+** Run an SQL statement, exit on error
+*/
+static void benchExec(sqlite3 *db, const char *zSql){
+  char *zErr = 0;
+  if( sqlite3_exec(db, zSql, 0, 0, &zErr)!=SQLITE_OK ){
+    fprintf(stderr, "sortbench: %s\n  in: %s\n", zErr, zSql);
+    exit(1);
+  }
+}
+
+/*
+** Run an SQL statement.  If it is a SELECT, read all of its rows.  Exit
+** on error.
+*/
+static void benchRun(sqlite3 *db, const char *zSql){
+  sqlite3_stmt *pStmt = 0;
+  if( sqlite3_prepare_v2(db, zSql, -1, &pStmt, 0)!=SQLITE_OK ){
+    benchFatal("cannot prepare", sqlite3_errmsg(db));
+  }
+  while( sqlite3_step(pStmt)==SQLITE_ROW ){}
+  if( sqlite3_finalize(pStmt)!=SQLITE_OK ){
+    fprintf(stderr, "sortbench: %s\n  in: %s\n", sqlite3_errmsg(db), zSql);
+    exit(1);
+  }
+}
+
+/*
+** Return the integer result of an SQL statement
+*/
+static int benchInt(sqlite3 *db, const char *zSql){
+  sqlite3_stmt *pStmt = 0;
+  int iRet = 0;
+  if( sqlite3_prepare_v2(db, zSql, -1, &pStmt, 0)!=SQLITE_OK ){
+    benchFatal("cannot prepare", sqlite3_errmsg(db));
+  }
+  if( sqlite3_step(pStmt)==SQLITE_ROW ) iRet = sqlite3_column_int(pStmt, 0);
+  sqlite3_finalize(pStmt);
+  return iRet;
+}
+
+/*
+** Parse a comma separated list of positive integers into aOut[].  Return
+** the number of entries, or 0 if the list is invalid.
+*/
+static int benchParseList(const char *z, int *aOut){
+  int n = 0;
+  while( *z ){
+    int v = atoi(z);
+    if( v<1 || n>=BENCH_MAX_RUNS ) return 0;
+    aOut[n++] = v;
+    while( *z && *z!=',' ) z++;
+    if( *z==',' ) z++;
+  }
+  return n;
+}
+
+/*
+** Create and fill the table.  Column a holds random integers, column b
+** random text of 8 to 23 characters, and column c one of 16 short text
+** values, mixed case.
+*/
+static void benchCreate(const BenchConfig *p){
+  sqlite3 *db = 0;
+  char *zSql;
+  remove(p->zFile);
+  if( sqlite3_open(p->zFile, &db)!=SQLITE_OK ){
+    benchFatal("cannot open", p->zFile);
+  }
+  benchExec(db, "PRAGMA journal_mode=OFF; PRAGMA synchronous=OFF;"
+                " CREATE TABLE t(a INTEGER, b TEXT, c TEXT)");
+  zSql = sqlite3_mprintf(
+      "WITH RECURSIVE c(i) AS (VALUES(1) UNION ALL SELECT i+1 FROM c"
+      " WHERE i<%d)"
+      " INSERT INTO t SELECT random(),"
+      "  substr(hex(randomblob(12)), 1, 8+abs(random())%%16),"
+      "  substr('abcdABCDefghEFGH', 1+abs(random())%%16, 3) FROM c",
+      p->nRow);
+  benchExec(db, zSql);
+  sqlite3_free(zSql);
+  sqlite3_close(db);
+}
+
+int main(int argc, char **argv){
+  BenchConfig cfg;
+  const char *zDir = ".";
+  sqlite3 *db = 0;
+  double aBase[sizeof(aIndex)/sizeof(aIndex[0])];
+  int i, j;
+
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.nRow = 100000000;
+  cfg.nCache = 131072;
+  cfg.nThread = benchParseList("1,2,4,8,16", cfg.aThread);
+  for(i=1; i<argc; i++){
+    const char *z = argv[i];
+    if( z[0]=='-' && z[1]=='-' ) z++;
+    if( strcmp(z, "-rows")==0 && i+1<argc ){
+      cfg.nRow = atoi(argv[++i]);
+      if( cfg.nRow<1 ) cfg.nRow = 1;
+    }else if( strcmp(z, "-threads")==0 && i+1<argc ){
+      cfg.nThread = benchParseList(argv[++i], cfg.aThread);
+      if( cfg.nThread==0 ) benchFatal("invalid thread list", argv[i]);
+    }else if( strcmp(z, "-cache")==0 && i+1<argc ){
+      cfg.nCache = atoi(argv[++i]);
+      if( cfg.nCache<10 ) cfg.nCache = 10;
+    }else if( z[0]!='-' ){
+      zDir = argv[i];
+    }else{
+      fprintf(stderr, "Usage: %s ?--rows N? ?--threads LIST? ?--cache N?"
+                      " ?DIRECTORY?\n", argv[0]);
+      return 1;
+    }
+  }
+  sqlite3_snprintf(sizeof(cfg.zFile), cfg.zFile, "%s/sortbench.db", zDir);
+  benchCreate(&cfg);
+
+  if( sqlite3_open(cfg.zFile, &db)!=SQLITE_OK ){
+    benchFatal("cannot open", cfg.zFile);
+  }
+  {
+    char *zSql = sqlite3_mprintf("PRAGMA cache_size=%d; PRAGMA temp_store=FILE;"
+                                 " PRAGMA journal_mode=OFF;"
+                                 " PRAGMA synchronous=OFF", cfg.nCache);
+    benchExec(db, zSql);
+    sqlite3_free(zSql);
+  }
+  /* Read the table once so that the first run is not penalized */
+  benchExec(db, "SELECT count(*) FROM t WHERE b IS NULL");
+
+  printf("%d rows, cache_size %d\n", cfg.nRow, cfg.nCache);
+  printf("\n%8s", "threads");
+  for(j=0; j<(int)(sizeof(aIndex)/sizeof(aIndex[0])); j++){
+    printf(" %10s(ms) %7s", aIndex[j].zName, "speedup");
+  }
+  printf("\n");
+  for(i=0; i<cfg.nThread; i++){
+    char *zSql = sqlite3_mprintf("PRAGMA threads=%d", cfg.aThread[i]-1);
+    int nThread = benchInt(db, zSql) + 1;
+    sqlite3_free(zSql);
+    printf("%8d", nThread);
+    for(j=0; j<(int)(sizeof(aIndex)/sizeof(aIndex[0])); j++){
+      double t0 = benchNow();
+      benchRun(db, aIndex[j].zSql);
+      t0 = benchNow() - t0;
+      if( aIndex[j].zSql[0]=='C' ) benchExec(db, "DROP INDEX ti");
+      if( i==0 ) aBase[j] = t0;
+      printf(" %14.1f %6.2fx", t0/1e6, aBase[j]/t0);
+    }
+    printf("\n");
+  }
+  sqlite3_close(db);
+
+  remove(cfg.zFile);
+  return 0;
+}
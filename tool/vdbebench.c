@@ -0,0 +1,304 @@
+/*
+** 2026 October 17
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+** This file contains a standalone benchmark for the opcode dispatch of
+** sqlite3VdbeExec().  It runs three kinds of statement against an
+** in-memory database, so that nearly all of the time is spent in the
+** VDBE:
+**
+**    loop      A recursive common table expression that counts to N, a
+**              tight loop of cheap opcodes.
+**    column    A scan that compares every column of a ten column table
+**              with a constant, dominated by OP_Column.
+**    expr      A scan that evaluates an arithmetic expression over the
+**              columns of each row.
+**
+** For each statement the benchmark reports the best time, the number of
+** VDBE opcodes run (SQLITE_STMTSTATUS_VM_STEP) and the time per opcode.
+** On Linux, if the kernel allows it, it also reads the hardware counters
+** for instructions, cycles and branch misses of the best run and reports
+** the instructions per cycle.
+**
+** Batched aggregate scans are disabled, so that the aggregates run one
+** row at a time.  To compare the dispatch of the switch statement with
+** computed goto, build the benchmark twice, with and without
+** -DSQLITE_ENABLE_COMPUTED_GOTO:
+**
+**    gcc -O2 -DSQLITE_THREADSAFE=1 -Isrc tool/vdbebench.c \
+**        src/sqlite3secure.c <SQLite core> -lpthread -ldl -lm
+**
+** Usage:  vdbebench ?OPTIONS?
+**
+**    --rows N         Rows of the table and loop count (default: 1000000)
+**    --runs N         Runs of each statement (default: 5)
+*/
+#if (defined(_WIN32) || defined(WIN32)) && !defined(_CRT_SECURE_NO_WARNINGS)
+/* This needs to come before any includes for MSVC compiler */
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "sqlite3.h"
+
+#if defined(_WIN32) || defined(WIN32)
+# include <windows.h>
+#else
+# include <time.h>
+#endif
+#ifdef __linux__
+# include <unistd.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <linux/perf_event.h>
+#endif
+
+/*
+** The SQLITE_BatchScan optimization flag of sqliteInt.h
+*/
+#define BENCH_BATCHSCAN 0x1000
+
+/*
+** Hardware counters read for each run.  They are only available on
+** Linux.
+*/
+#define BENCH_INSTRUCTIONS 0
+#define BENCH_CYCLES       1
+#define BENCH_BRANCHMISS   2
+#define BENCH_NCOUNTER     3
+
+typedef struct BenchCounters BenchCounters;
+struct BenchCounters {
+  int aFd[BENCH_NCOUNTER];  /* perf_event file descriptors, or -1 */
+  long long aVal[BENCH_NCOUNTER]; /* Counts of the last run */
+};
+
+/*
+** The statements of the benchmark.  %d is replaced by the row count.
+*/
+static const struct BenchQuery {
+  const char *zName;
+  const char *zSql;
+} aQuery[] = {
+  { "loop",
+    "WITH RECURSIVE c(x) AS (VALUES(1) UNION ALL SELECT x+1 FROM c"
+    " WHERE x<%d) SELECT count(*) FROM c" },
+  { "column",
+    "SELECT count(*) FROM t WHERE c0>=0 AND c1>=0 AND c2>=0 AND c3>=0"
+    " AND c4>=0 AND c5>=0 AND c6>=0 AND c7>=0 AND c8>=0 AND c9>=0" },
+  { "expr",
+    "SELECT sum((c0*3+c1)%%7 + (c2-c3)*2 - (c4<<2) + (c5&c6)"
+    " + CASE WHEN c7>c8 THEN c9 ELSE -c9 END) FROM t" },
+};
+
+/*
+** Return a monotonic time stamp in nanoseconds
+*/
+static double benchNow(void){
+#if defined(_WIN32) || defined(WIN32)
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER t;
+  if( freq.QuadPart==0 ) QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&t);
+  return (double)t.QuadPart * 1e9 / (double)freq.QuadPart;
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+#endif
+}
+
+/*
+** Open the hardware counters of the calling thread.  Counters that
+** cannot be opened are left at -1.
+*/
+static void benchCountersOpen(BenchCounters *p){
+  int i;
+  for(i=0; i<BENCH_NCOUNTER; i++) p->aFd[i] = -1;
+#ifdef __linux__
+  {
+    static const unsigned long long aConfig[BENCH_NCOUNTER] = {
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_BRANCH_MISSES,
+    };
+    for(i=0; i<BENCH_NCOUNTER; i++){
+      struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = aConfig[i];
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      p->aFd[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+  }
+#endif
+}
+
+static void benchCountersClose(BenchCounters *p){
+#ifdef __linux__
+  int i;
+  for(i=0; i<BENCH_NCOUNTER; i++){
+    if( p->aFd[i]>=0 ) close(p->aFd[i]);
+  }
+#endif
+}
+
+/*
+** Reset and start, or stop and read, the hardware counters
+*/
+static void benchCountersStart(BenchCounters *p){
+#ifdef __linux__
+  int i;
+  for(i=0; i<BENCH_NCOUNTER; i++){
+    if( p->aFd[i]<0 ) continue;
+    ioctl(p->aFd[i], PERF_EVENT_IOC_RESET, 0);
+    ioctl(p->aFd[i], PERF_EVENT_IOC_ENABLE, 0);
+  }
+#endif
+}
+static void benchCountersStop(BenchCounters *p){
+  int i;
+  for(i=0; i<BENCH_NCOUNTER; i++){
+    p->aVal[i] = -1;
+#ifdef __linux__
+    if( p->aFd[i]>=0 ){
+      long long v = 0;
+      ioctl(p->aFd[i], PERF_EVENT_IOC_DISABLE, 0);
+      if( read(p->aFd[i], &v, sizeof(v))==sizeof(v) ) p->aVal[i] = v;
+    }
+#endif
+  }
+}
+
+/*
+** Print an error message and exit
+*/
+static void benchFatal(const char *zMsg, const char *zDetail){
+  fprintf(stderr, "vdbebench: %s%s%s\n", zMsg, zDetail ? ": " : "",
+          zDetail ? zDetail : "");
+  exit(1);
+}
+
+/*
+** Run an SQL statement, exit on error
+*/
+static void benchExec(sqlite3 *db, const char *zSql){
+  char *zErr = 0;
+  if( sqlite3_exec(db, zSql, 0, 0, &zErr)!=SQLITE_OK ){
+    fprintf(stderr, "vdbebench: %s\n  in: %s\n", zErr, zSql);
+    exit(1);
+  }
+}
+
+/*
+** Print a count in millions, or "n/a" if it is not available
+*/
+static void benchPrintCount(long long n){
+  if( n<0 ){
+    printf(" %9s", "n/a");
+  }else{
+    printf(" %9.1f", (double)n/1e6);
+  }
+}
+
+int main(int argc, char **argv){
+  sqlite3 *db = 0;
+  BenchCounters cnt;
+  int nRow = 1000000;
+  int nRun = 5;
+  int i, j;
+  char *zSql;
+
+  for(i=1; i<argc; i++){
+    const char *z = argv[i];
+    if( z[0]=='-' && z[1]=='-' ) z++;
+    if( strcmp(z, "-rows")==0 && i+1<argc ){
+      nRow = atoi(argv[++i]);
+      if( nRow<1 ) nRow = 1;
+    }else if( strcmp(z, "-runs")==0 && i+1<argc ){
+      nRun = atoi(argv[++i]);
+      if( nRun<1 ) nRun = 1;
+    }else{
+      fprintf(stderr, "Usage: %s ?--rows N? ?--runs N?\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if( sqlite3_open(":memory:", &db)!=SQLITE_OK ){
+    benchFatal("cannot open", ":memory:");
+  }
+  sqlite3_test_control(SQLITE_TESTCTRL_OPTIMIZATIONS, db, BENCH_BATCHSCAN);
+  benchExec(db, "CREATE TABLE t(c0 INT, c1 INT, c2 INT, c3 INT, c4 INT,"
+                " c5 INT, c6 INT, c7 INT, c8 INT, c9 INT)");
+  zSql = sqlite3_mprintf(
+      "WITH RECURSIVE c(i) AS (VALUES(1) UNION ALL SELECT i+1 FROM c"
+      " WHERE i<%d) INSERT INTO t SELECT i, i%%1000, i%%77, i%%5000, i%%300,"
+      " i%%65536, i%%127, i%%999, i%%1001, i%%13 FROM c", nRow);
+  benchExec(db, zSql);
+  sqlite3_free(zSql);
+  benchCountersOpen(&cnt);
+
+  printf("%d rows, best of %d runs, %s dispatch\n", nRow, nRun,
+         sqlite3_compileoption_used("ENABLE_COMPUTED_GOTO") ?
+             "computed goto" : "switch");
+  printf("\n%-8s %9s %9s %8s %9s %9s %9s %6s\n", "query", "time(ms)",
+         "ops(M)", "ns/op", "insn(M)", "cycle(M)", "bmiss(M)", "IPC");
+  for(i=0; i<(int)(sizeof(aQuery)/sizeof(aQuery[0])); i++){
+    sqlite3_stmt *pStmt = 0;
+    long long aBest[BENCH_NCOUNTER] = {0};
+    double tBest = 0.0;
+    int nStep = 0;
+
+    zSql = sqlite3_mprintf(aQuery[i].zSql, nRow);
+    if( sqlite3_prepare_v2(db, zSql, -1, &pStmt, 0)!=SQLITE_OK ){
+      benchFatal("cannot prepare", sqlite3_errmsg(db));
+    }
+    sqlite3_free(zSql);
+    for(j=0; j<nRun; j++){
+      double t0;
+      int rc;
+      sqlite3_stmt_status(pStmt, SQLITE_STMTSTATUS_VM_STEP, 1);
+      benchCountersStart(&cnt);
+      t0 = benchNow();
+      rc = sqlite3_step(pStmt);
+      t0 = benchNow() - t0;
+      benchCountersStop(&cnt);
+      if( rc!=SQLITE_ROW ) benchFatal("query failed", sqlite3_errmsg(db));
+      if( j==0 || t0<tBest ){
+        tBest = t0;
+        memcpy(aBest, cnt.aVal, sizeof(aBest));
+      }
+      nStep = sqlite3_stmt_status(pStmt, SQLITE_STMTSTATUS_VM_STEP, 0);
+      sqlite3_reset(pStmt);
+    }
+    sqlite3_finalize(pStmt);
+
+    printf("%-8s %9.1f %9.1f %8.2f", aQuery[i].zName, tBest/1e6,
+           (double)nStep/1e6, nStep ? tBest/nStep : 0.0);
+    benchPrintCount(aBest[BENCH_INSTRUCTIONS]);
+    benchPrintCount(aBest[BENCH_CYCLES]);
+    benchPrintCount(aBest[BENCH_BRANCHMISS]);
+    if( aBest[BENCH_INSTRUCTIONS]>0 && aBest[BENCH_CYCLES]>0 ){
+      printf(" %6.2f\n",
+             (double)aBest[BENCH_INSTRUCTIONS]/(double)aBest[BENCH_CYCLES]);
+    }else{
+      printf(" %6s\n", "n/a");
+    }
+  }
+
+  benchCountersClose(&cnt);
+  sqlite3_close(db);
+  return 0;
+}
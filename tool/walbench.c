@@ -0,0 +1,331 @@
+/*
+** 2026 October 16
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+** This file contains a standalone benchmark for reads from a database in
+** WAL mode, as a function of the size of the WAL.
+**
+** The database holds a "cold" table that is checkpointed into the database
+** file once, and a small "hot" table.  For every WAL size, transactions
+** updating rows of the hot table are written into the WAL with automatic
+** checkpoints disabled, until the WAL holds the requested number of frames.
+** Then a new connection with a tiny page cache reads random rows of both
+** tables.  Every read of a cold row has to make sure that its page is not
+** in the WAL (see sqlite3WalFindFrame()), every read of a hot row finds its
+** page in the WAL.  The benchmark reports the time of the first read and
+** the mean latency of cold and hot reads.
+**
+** To compare against lookups that probe the hash table of every wal-index
+** block, build the library with -DSQLITE_WAL_BLOOM=0.
+**
+**    gcc -O2 -DSQLITE_THREADSAFE=1 -Isrc tool/walbench.c \
+**        src/sqlite3secure.c <SQLite core> -lpthread -ldl -lm
+**
+** Usage:  walbench ?OPTIONS? ?DIRECTORY?
+**
+**    --frames LIST    Comma separated WAL sizes in frames
+**                     (default: 1000,10000,100000,1000000)
+**    --pagesize N     Page size of the database (default: 1024)
+**    --pages N        Size of the cold table in pages (default: 20000)
+**    --reads N        Reads of each kind per WAL size (default: 100000)
+**
+** The database file is created in DIRECTORY (default: the current
+** directory) and deleted afterwards.
+*/
+#if (defined(_WIN32) || defined(WIN32)) && !defined(_CRT_SECURE_NO_WARNINGS)
+/* This needs to come before any includes for MSVC compiler */
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "sqlite3.h"
+
+#if defined(_WIN32) || defined(WIN32)
+# include <windows.h>
+#else
+# include <time.h>
+#endif
+
+/*
+** Largest number of entries of a list on the command line
+*/
+#define BENCH_MAX_RUNS 8
+
+/*
+** Rows of the hot table, and rows updated per transaction
+*/
+#define BENCH_HOT_ROWS 3000
+#define BENCH_TXN_ROWS 256
+
+/*
+** Benchmark configuration from the command line
+*/
+typedef struct BenchConfig BenchConfig;
+struct BenchConfig {
+  int nFrames;              /* Number of entries in aFrame[] */
+  int aFrame[BENCH_MAX_RUNS]; /* WAL sizes to measure */
+  int szPage;               /* Page size */
+  int nPage;                /* Pages of the cold table */
+  int nRead;                /* Reads of each kind */
+  int nRow;                 /* Rows in the cold table */
+  int szRow;                /* Size of the blob of each row */
+  char zFile[1024];         /* Name of the database file */
+};
+
+/*
+** Return a monotonic time stamp in nanoseconds
+*/
+static double benchNow(void){
+#if defined(_WIN32) || defined(WIN32)
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER t;
+  if( freq.QuadPart==0 ) QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&t);
+  return (double)t.QuadPart * 1e9 / (double)freq.QuadPart;
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+#endif
+}
+
+/*
+** Print an error message and exit
+*/
+static void benchFatal(const char *zMsg, const char *zDetail){
+  fprintf(stderr, "walbench: %s%s%s\n", zMsg, zDetail ? ": " : "",
+          zDetail ? zDetail : "");
+  exit(1);
+}
+
+/*
+** Run an SQL statement, exit on error
+*/
+static void benchExec(sqlite3 *db, const char *zSql){
+  char *zErr = 0;
+  if( sqlite3_exec(db, zSql, 0, 0, &zErr)!=SQLITE_OK ){
+    fprintf(stderr, "walbench: %s\n  in: %s\n", zErr, zSql);
+    exit(1);
+  }
+}
+
+/*
+** Return the next value of a xorshift random number generator
+*/
+static unsigned int benchRandom(unsigned int *piRand){
+  unsigned int x = *piRand;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *piRand = x;
+  return x;
+}
+
+/*
+** WAL hook: record the number of frames in the WAL
+*/
+static int benchWalHook(void *pArg, sqlite3 *db, const char *zDb, int nFrame){
+  (void)db;
+  (void)zDb;
+  *(int*)pArg = nFrame;
+  return SQLITE_OK;
+}
+
+/*
+** Open the database and configure the connection
+*/
+static sqlite3 *benchOpen(const BenchConfig *p){
+  sqlite3 *db = 0;
+  char *zSql;
+  if( sqlite3_open(p->zFile, &db)!=SQLITE_OK ){
+    benchFatal("cannot open", p->zFile);
+  }
+  zSql = sqlite3_mprintf("PRAGMA page_size=%d; PRAGMA journal_mode=WAL;"
+                         " PRAGMA synchronous=OFF; PRAGMA wal_autocheckpoint=0",
+                         p->szPage);
+  benchExec(db, zSql);
+  sqlite3_free(zSql);
+  return db;
+}
+
+/*
+** Create the tables of the benchmark, with an empty WAL
+*/
+static void benchCreate(const BenchConfig *p){
+  sqlite3 *db;
+  char *zSql;
+  remove(p->zFile);
+  db = benchOpen(p);
+  benchExec(db, "CREATE TABLE cold(id INTEGER PRIMARY KEY, v BLOB);"
+                "CREATE TABLE hot(id INTEGER PRIMARY KEY, v BLOB)");
+  zSql = sqlite3_mprintf(
+      "WITH RECURSIVE c(i) AS (VALUES(1) UNION ALL SELECT i+1 FROM c"
+      " WHERE i<%d) INSERT INTO cold SELECT i, randomblob(%d) FROM c;"
+      "WITH RECURSIVE c(i) AS (VALUES(1) UNION ALL SELECT i+1 FROM c"
+      " WHERE i<%d) INSERT INTO hot SELECT i, randomblob(%d) FROM c",
+      p->nRow, p->szRow, BENCH_HOT_ROWS, p->szRow);
+  benchExec(db, zSql);
+  sqlite3_free(zSql);
+  benchExec(db, "PRAGMA wal_checkpoint(TRUNCATE)");
+  sqlite3_close(db);
+}
+
+/*
+** Write transactions into the WAL until it holds at least nTarget frames.
+** Return the number of frames in the WAL.
+*/
+static int benchFill(sqlite3 *db, int nTarget){
+  sqlite3_stmt *pStmt = 0;
+  unsigned int iRand = 0x12345678;
+  int nFrame = 0;
+  int i;
+
+  sqlite3_wal_hook(db, benchWalHook, &nFrame);
+  if( sqlite3_prepare_v2(db, "UPDATE hot SET v=randomblob(length(v))"
+                             " WHERE id=?1", -1, &pStmt, 0)!=SQLITE_OK ){
+    benchFatal("cannot prepare", sqlite3_errmsg(db));
+  }
+  while( nFrame<nTarget ){
+    benchExec(db, "BEGIN");
+    for(i=0; i<BENCH_TXN_ROWS; i++){
+      sqlite3_bind_int(pStmt, 1, 1 + benchRandom(&iRand) % BENCH_HOT_ROWS);
+      sqlite3_step(pStmt);
+      if( sqlite3_reset(pStmt)!=SQLITE_OK ){
+        benchFatal("update failed", sqlite3_errmsg(db));
+      }
+    }
+    benchExec(db, "COMMIT");
+  }
+  sqlite3_finalize(pStmt);
+  sqlite3_wal_hook(db, 0, 0);
+  return nFrame;
+}
+
+/*
+** Read nRead random rows of a table, return the mean time per read in ns
+*/
+static double benchRead(sqlite3 *db, const char *zSql, int nRow, int nRead){
+  sqlite3_stmt *pStmt = 0;
+  unsigned int iRand = 0x9abcdef1;
+  double t0;
+  int i;
+
+  if( sqlite3_prepare_v2(db, zSql, -1, &pStmt, 0)!=SQLITE_OK ){
+    benchFatal("cannot prepare", sqlite3_errmsg(db));
+  }
+  t0 = benchNow();
+  for(i=0; i<nRead; i++){
+    sqlite3_bind_int(pStmt, 1, 1 + benchRandom(&iRand) % nRow);
+    if( sqlite3_step(pStmt)!=SQLITE_ROW ){
+      benchFatal("read failed", sqlite3_errmsg(db));
+    }
+    sqlite3_reset(pStmt);
+  }
+  t0 = (benchNow() - t0)/nRead;
+  sqlite3_finalize(pStmt);
+  return t0;
+}
+
+/*
+** Measure reads with a WAL of nFrame frames
+*/
+static void benchRun(const BenchConfig *p, sqlite3 *db, int nFrame){
+  sqlite3 *dbRead;
+  double t0, tFirst, tCold, tHot;
+  int nLog;
+
+  nLog = benchFill(db, nFrame);
+
+  /* A new connection, so that nothing is cached from the writes */
+  if( sqlite3_open(p->zFile, &dbRead)!=SQLITE_OK ){
+    benchFatal("cannot open", p->zFile);
+  }
+  t0 = benchNow();
+  benchExec(dbRead, "PRAGMA cache_size=10; PRAGMA mmap_size=0;"
+                    " SELECT length(v) FROM cold WHERE id=1");
+  tFirst = benchNow() - t0;
+  tCold = benchRead(dbRead, "SELECT length(v) FROM cold WHERE id=?1",
+                    p->nRow, p->nRead);
+  tHot = benchRead(dbRead, "SELECT length(v) FROM hot WHERE id=?1",
+                   BENCH_HOT_ROWS, p->nRead);
+  sqlite3_close(dbRead);
+
+  printf("%9d %12.1f %12.0f %12.0f\n", nLog, tFirst/1e3, tCold, tHot);
+}
+
+/*
+** Parse a comma separated list of integers
+*/
+static int benchParseList(int *aOut, const char *z){
+  int n = 0;
+  while( *z && n<BENCH_MAX_RUNS ){
+    aOut[n++] = atoi(z);
+    while( *z && *z!=',' ) z++;
+    if( *z==',' ) z++;
+  }
+  return n;
+}
+
+int main(int argc, char **argv){
+  BenchConfig cfg;
+  const char *zDir = ".";
+  sqlite3 *db;
+  int i;
+
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.nFrames = benchParseList(cfg.aFrame, "1000,10000,100000,1000000");
+  cfg.szPage = 1024;
+  cfg.nPage = 20000;
+  cfg.nRead = 100000;
+  for(i=1; i<argc; i++){
+    const char *z = argv[i];
+    if( z[0]=='-' && z[1]=='-' ) z++;
+    if( strcmp(z, "-frames")==0 && i+1<argc ){
+      cfg.nFrames = benchParseList(cfg.aFrame, argv[++i]);
+    }else if( strcmp(z, "-pagesize")==0 && i+1<argc ){
+      cfg.szPage = atoi(argv[++i]);
+    }else if( strcmp(z, "-pages")==0 && i+1<argc ){
+      cfg.nPage = atoi(argv[++i]);
+      if( cfg.nPage<16 ) cfg.nPage = 16;
+    }else if( strcmp(z, "-reads")==0 && i+1<argc ){
+      cfg.nRead = atoi(argv[++i]);
+      if( cfg.nRead<1 ) cfg.nRead = 1;
+    }else if( z[0]!='-' ){
+      zDir = argv[i];
+    }else{
+      fprintf(stderr, "Usage: %s ?--frames LIST? ?--pagesize N? ?--pages N?"
+                      " ?--reads N? ?DIRECTORY?\n", argv[0]);
+      return 1;
+    }
+  }
+  if( cfg.szPage<512 || cfg.szPage>65536 || (cfg.szPage&(cfg.szPage-1)) ){
+    benchFatal("invalid page size", 0);
+  }
+  /* Rows of about a quarter page, so that three rows fill a page */
+  cfg.szRow = cfg.szPage/4;
+  cfg.nRow = cfg.nPage*3;
+  sqlite3_snprintf(sizeof(cfg.zFile), cfg.zFile, "%s/walbench.db", zDir);
+  benchCreate(&cfg);
+
+  printf("%d cold pages of %d bytes, %d reads of each kind\n",
+         cfg.nPage, cfg.szPage, cfg.nRead);
+  printf("\n%9s %12s %12s %12s\n", "frames", "first (us)", "cold (ns)",
+         "hot (ns)");
+  db = benchOpen(&cfg);
+  for(i=0; i<cfg.nFrames; i++){
+    benchRun(&cfg, db, cfg.aFrame[i]);
+  }
+  sqlite3_close(db);
+
+  remove(cfg.zFile);
+  return 0;
+}